@@ -0,0 +1,397 @@
+/***************************************************************************/
+/**
+ * @file bench.c
+ * @brief Throughput benchmark of the cache simulator.
+ *
+ * The benchmark simulates every given trace on a fixed matrix of cache
+ * geometries and measures the accesses simulated per second, including
+ * decoding the trace. Every combination is run several times and the fastest
+ * run counts, which filters out most of the noise of the host. The results are
+ * written as JSON and can be compared with a baseline written by an earlier
+ * run, so changes to the parser or the layout of the cache that slow down the
+ * hot path are caught before they are merged.
+ *
+ * Usage:
+ * `calc-bench [--repeat <runs>] [--output <file>] [--baseline <file>]
+ *  [--threshold <percent>] <trace>...`
+ * - `--repeat <runs>`: Number of runs of every combination. Default is 10.
+ * - `--output <file>`: Write the results as JSON to the file.
+ * - `--baseline <file>`: Compare the results with a JSON file written by
+ *     `--output` and exit with a failure if a combination got slower by more
+ *     than the threshold or its misses changed.
+ * - `--threshold <percent>`: Largest tolerated slowdown. Default is 10.
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/cache.h"
+#include "../src/trace.h"
+
+/**
+ * @brief Defaults and limits of the benchmark.
+ */
+enum {
+    BENCH_DEFAULT_REPEAT = 10,      // Default number of runs of every combination
+    BENCH_DEFAULT_THRESHOLD = 10,   // Default largest tolerated slowdown in percent
+    BENCH_MAX_NAME = 64,            // Maximum length of a trace or geometry name including the terminating NUL
+    BENCH_MISS_PENALTY = 30,        // Miss penalty of the benchmarked caches in cycles
+    BENCH_DIRTY_WB_PENALTY = 2,     // Dirty write-back penalty of the benchmarked caches in cycles
+};
+
+/**
+ * @brief A cache geometry of the benchmark matrix.
+ */
+typedef struct BenchGeometry {
+    const char *name;           // Name of the geometry in the results
+    int associativity;          // Ways per set, 0 for fully associative
+    int cache_size;             // Cache size in KB
+    int line_size;              // Cache line size in bytes
+} BenchGeometry;
+
+/**
+ * @brief The fixed matrix of geometries, all with 32 KB and 64-byte lines.
+ * The fully associative cache exercises the line index of wide caches.
+ */
+static const BenchGeometry bench_geometries[] = {
+    {"dm", 1, 32, 64},
+    {"4-way", 4, 32, 64},
+    {"16-way", 16, 32, 64},
+    {"fa", 0, 32, 64},
+};
+
+/**
+ * @brief Number of geometries of the benchmark matrix.
+ */
+#define BENCH_NUM_GEOMETRIES (int)(sizeof(bench_geometries) / sizeof(bench_geometries[0]))
+
+/**
+ * @brief The result of a trace on a geometry.
+ */
+typedef struct BenchResult {
+    char trace[BENCH_MAX_NAME];     // Name of the trace (file name without directory and extension)
+    char geometry[BENCH_MAX_NAME];  // Name of the geometry
+    uint64_t accesses;              // Number of simulated accesses
+    uint64_t misses;                // Number of misses, identical in every run
+    double seconds;                 // Duration of the fastest run
+    double accesses_per_second;     // Throughput of the fastest run
+} BenchResult;
+
+// --- Helper Functions ---
+
+/**
+ * @brief Prints the usage of the benchmark.
+ *
+ * @param prog The name of the executable.
+ */
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--repeat <runs>] [--output <file>] [--baseline <file>] [--threshold <percent>] <trace>...\n"
+           "  --repeat <runs>: runs of every trace and geometry, the fastest counts (default: %d)\n"
+           "  --output <file>: write the results as JSON\n"
+           "  --baseline <file>: compare with the JSON results of an earlier run\n"
+           "  --threshold <percent>: largest tolerated slowdown against the baseline (default: %d)\n",
+           prog, BENCH_DEFAULT_REPEAT, BENCH_DEFAULT_THRESHOLD);
+}
+
+/**
+ * @brief Parses a positive integer option or terminates the program.
+ *
+ * @param prog The name of the executable.
+ * @param option The option.
+ * @param arg The value of the option.
+ * @return The value.
+ */
+static int parse_positive(const char *prog, const char *option, const char *arg) {
+    char *endptr;
+    const long value = strtol(arg, &endptr, 10);
+    if (endptr == arg || *endptr != '\0' || value <= 0 || value > 1000000) {
+        fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+        print_usage(prog);
+        exit(EXIT_FAILURE);
+    }
+    return (int)value;
+}
+
+/**
+ * @brief Returns the current time of the monotonic clock in seconds.
+ *
+ * @return The time in seconds.
+ */
+static double get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Copies the name of a trace file without directory and extension.
+ *
+ * @param path Path of the trace file.
+ * @param name Buffer of BENCH_MAX_NAME characters receiving the name.
+ */
+static void get_trace_name(const char *path, char *name) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const size_t length = strcspn(base, ".");
+    snprintf(name, BENCH_MAX_NAME, "%.*s", (int)(length < BENCH_MAX_NAME ? length : BENCH_MAX_NAME - 1), base);
+}
+
+/**
+ * @brief Simulates a trace once on a cache, like a run of the simulator without sampling.
+ *
+ * @param cache Pointer to the empty Cache object.
+ * @param trace_file Path of the trace file.
+ * @param accesses Pointer receiving the number of simulated accesses.
+ * @return The duration of the run in seconds.
+ */
+static double run_trace(Cache *cache, const char *trace_file, uint64_t *accesses) {
+    const double start = get_time();
+
+    TraceReader *reader = open_trace(trace_file);
+    CacheOp cache_op;
+    uint64_t count = 0;
+    while (read_trace_operation(reader, &cache_op)) {
+        access_cache(cache, &cache_op);
+        count++;
+    }
+    close_trace(reader);
+
+    *accesses = count;
+    return get_time() - start;
+}
+
+/**
+ * @brief Measures a trace on a geometry with several runs.
+ * Terminates the program if the runs disagree on the misses.
+ *
+ * @param trace_file Path of the trace file.
+ * @param geometry Pointer to the BenchGeometry object.
+ * @param repeat Number of runs.
+ * @param result Pointer to the BenchResult object receiving the fastest run.
+ */
+static void measure(const char *trace_file, const BenchGeometry *geometry, const int repeat, BenchResult *result) {
+    Cache *cache = initialize_cache(geometry->associativity, geometry->cache_size, geometry->line_size,
+                                    BENCH_MISS_PENALTY, BENCH_DIRTY_WB_PENALTY, REPLACEMENT_LRU, 1);
+
+    get_trace_name(trace_file, result->trace);
+    snprintf(result->geometry, sizeof(result->geometry), "%s", geometry->name);
+    for (int run = 0; run < repeat; run++) {
+        reset_cache(cache);
+        uint64_t accesses;
+        const double seconds = run_trace(cache, trace_file, &accesses);
+        if (run > 0 && get_cache_misses(cache) != result->misses) {
+            fprintf(stderr, "Runs of %s on %s disagree on the misses.\n", result->trace, geometry->name);
+            exit(EXIT_FAILURE);
+        }
+        if (run == 0 || seconds < result->seconds) {
+            result->seconds = seconds;
+        }
+        result->accesses = accesses;
+        result->misses = get_cache_misses(cache);
+    }
+    result->accesses_per_second = result->seconds > 0 ? (double)result->accesses / result->seconds : 0;
+
+    free_cache(cache);
+}
+
+/**
+ * @brief Writes the results as JSON with one result per line.
+ * Terminates the program if the file can't be written.
+ *
+ * @param path Path of the JSON file.
+ * @param results The results.
+ * @param num_results Number of results.
+ * @param repeat Number of runs of every combination.
+ */
+static void write_results(const char *path, const BenchResult *results, const int num_results, const int repeat) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror("Failed to open result file");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "{\n  \"repeat\": %d,\n  \"results\": [\n", repeat);
+    for (int i = 0; i < num_results; i++) {
+        const BenchResult *result = &results[i];
+        fprintf(file, "    {\"trace\": \"%s\", \"geometry\": \"%s\", \"accesses\": %" PRIu64 ", \"misses\": %" PRIu64
+                ", \"seconds\": %.6f, \"accesses_per_second\": %.0f}%s\n", result->trace, result->geometry,
+                result->accesses, result->misses, result->seconds, result->accesses_per_second,
+                i + 1 < num_results ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if (fclose(file) != 0) {
+        perror("Failed to write result file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Reads the results of a JSON file written by write_results.
+ * Terminates the program if the file can't be read.
+ *
+ * @param path Path of the JSON file.
+ * @param num_results Pointer receiving the number of results.
+ * @return The results, to be freed by the caller.
+ */
+static BenchResult* read_results(const char *path, int *num_results) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Failed to open baseline file");
+        exit(EXIT_FAILURE);
+    }
+
+    int capacity = 64;
+    BenchResult *results = (BenchResult *)malloc((size_t)capacity * sizeof(BenchResult));
+    *num_results = 0;
+    char line[512];
+    while (results && fgets(line, sizeof(line), file)) {
+        if (*num_results == capacity) {
+            capacity *= 2;
+            results = (BenchResult *)realloc(results, (size_t)capacity * sizeof(BenchResult));
+            if (!results) {
+                break;
+            }
+        }
+        BenchResult *result = &results[*num_results];
+        if (sscanf(line, " {\"trace\": \"%63[^\"]\", \"geometry\": \"%63[^\"]\", \"accesses\": %" SCNu64
+                   ", \"misses\": %" SCNu64 ", \"seconds\": %lf, \"accesses_per_second\": %lf", result->trace,
+                   result->geometry, &result->accesses, &result->misses, &result->seconds,
+                   &result->accesses_per_second) == 6) {
+            (*num_results)++;
+        }
+    }
+    if (!results) {
+        fprintf(stderr, "Failed to allocate memory for baseline.\n");
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+    return results;
+}
+
+/**
+ * @brief Compares the results with a baseline and prints the change of every combination.
+ *
+ * @param results The results.
+ * @param num_results Number of results.
+ * @param baseline_path Path of the JSON file of the baseline.
+ * @param threshold Largest tolerated slowdown in percent.
+ * @return `true` if no combination got slower than the threshold or changed its misses, `false` otherwise.
+ */
+static bool compare_results(const BenchResult *results, const int num_results, const char *baseline_path,
+                            const int threshold) {
+    int num_baseline;
+    BenchResult *baseline = read_results(baseline_path, &num_baseline);
+
+    printf("\nCOMPARISON WITH %s (THRESHOLD %d%%)\n", baseline_path, threshold);
+    printf("%-10s %-8s %16s %16s %9s\n", "Trace", "Geometry", "Baseline acc/s", "Current acc/s", "Change");
+    bool is_ok = true;
+    double log_ratio_sum = 0;
+    int num_compared = 0;
+    for (int i = 0; i < num_results; i++) {
+        const BenchResult *result = &results[i];
+        const BenchResult *reference = NULL;
+        for (int j = 0; j < num_baseline && !reference; j++) {
+            if (strcmp(baseline[j].trace, result->trace) == 0 && strcmp(baseline[j].geometry, result->geometry) == 0) {
+                reference = &baseline[j];
+            }
+        }
+
+        printf("%-10s %-8s ", result->trace, result->geometry);
+        if (!reference) {
+            printf("%16s %16.0f %9s\n", "-", result->accesses_per_second, "new");
+            continue;
+        }
+
+        const double change = reference->accesses_per_second > 0
+                              ? (result->accesses_per_second / reference->accesses_per_second - 1) * 100 : 0;
+        printf("%16.0f %16.0f %+8.1f%%", reference->accesses_per_second, result->accesses_per_second, change);
+        if (reference->accesses_per_second > 0 && result->accesses_per_second > 0) {
+            log_ratio_sum += log(result->accesses_per_second / reference->accesses_per_second);
+            num_compared++;
+        }
+        if (reference->accesses != result->accesses || reference->misses != result->misses) {
+            printf("  MISSES CHANGED (%" PRIu64 " -> %" PRIu64 ")", reference->misses, result->misses);
+            is_ok = false;
+        } else if (change < -threshold) {
+            printf("  REGRESSION");
+            is_ok = false;
+        }
+        printf("\n");
+    }
+    if (num_compared > 0) {
+        printf("%-19s %16s %16s %+8.1f%%\n", "Geometric mean", "", "", (exp(log_ratio_sum / num_compared) - 1) * 100);
+    }
+
+    free(baseline);
+    return is_ok;
+}
+
+// --- Main Function ---
+
+/**
+ * @brief Runs the benchmark.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments.
+ * @return `EXIT_SUCCESS` if there is no regression against the baseline, `EXIT_FAILURE` otherwise.
+ */
+int main(const int argc, const char *argv[]) {
+    int repeat = BENCH_DEFAULT_REPEAT;
+    int threshold = BENCH_DEFAULT_THRESHOLD;
+    const char *output = NULL;
+    const char *baseline = NULL;
+
+    int first_trace = 1;
+    while (first_trace + 1 < argc && strncmp(argv[first_trace], "--", 2) == 0) {
+        const char *option = argv[first_trace];
+        const char *arg = argv[first_trace + 1];
+        if (strcmp(option, "--repeat") == 0) {
+            repeat = parse_positive(argv[0], option, arg);
+        } else if (strcmp(option, "--threshold") == 0) {
+            threshold = parse_positive(argv[0], option, arg);
+        } else if (strcmp(option, "--output") == 0) {
+            output = arg;
+        } else if (strcmp(option, "--baseline") == 0) {
+            baseline = arg;
+        } else {
+            break;
+        }
+        first_trace += 2;
+    }
+    if (first_trace >= argc || strncmp(argv[first_trace], "--", 2) == 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const int num_results = (argc - first_trace) * BENCH_NUM_GEOMETRIES;
+    BenchResult *results = (BenchResult *)calloc((size_t)num_results, sizeof(BenchResult));
+    if (!results) {
+        fprintf(stderr, "Failed to allocate memory for results.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-10s %-8s %10s %10s %10s %16s\n", "Trace", "Geometry", "Accesses", "Misses", "Seconds", "Accesses/s");
+    for (int i = 0; i < num_results; i++) {
+        BenchResult *result = &results[i];
+        measure(argv[first_trace + i / BENCH_NUM_GEOMETRIES], &bench_geometries[i % BENCH_NUM_GEOMETRIES], repeat,
+                result);
+        printf("%-10s %-8s %10" PRIu64 " %10" PRIu64 " %10.4f %16.0f\n", result->trace, result->geometry,
+               result->accesses, result->misses, result->seconds, result->accesses_per_second);
+    }
+
+    if (output) {
+        write_results(output, results, num_results, repeat);
+    }
+    const bool is_ok = !baseline || compare_results(results, num_results, baseline, threshold);
+
+    free(results);
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1830 @@
+/***************************************************************************/
+/**
+ * @file check.c
+ * @brief Golden-result regression suite of the cache simulator.
+ *
+ * The suite simulates traces with a plain reference model of a cache and
+ * compares every fast engine of the simulator with it. The reference keeps
+ * one array entry per line and searches the sets linearly, without recency
+ * matrices, line indices, vector tag comparisons or batching, so it is slow
+ * but obviously correct. Its write-combining buffer is an array in FIFO
+ * order, and the sectors of a line are two bitmaps next to the line. The
+ * engines must match its hits, misses, sector misses, dirty write-backs,
+ * memory writes and cycles exactly:
+ * - `kernel`: access_cache (specialized, generic and fully associative kernels
+ *     with the tag comparison selected by ARCHFLAGS), additionally compared
+ *     access by access,
+ * - `batch`: access_cache_batch, also compared access by access,
+ * - `library`: the interface of libcachesim, compared access by access, with
+ *     the second half of the trace simulated by a clone of the half-warmed
+ *     cache and by the original, and again after a reset (skipped for traces
+ *     with warming records, which the library doesn't distinguish, for
+ *     write policies other than write-back, write-allocate and for sectored
+ *     caches),
+ * - `partitioned`: simulate_partitioned on several threads (skipped for the
+ *     random and BRRIP policies, whose partitions draw other random numbers),
+ * - `sweep`: simulate_sweep of all configurations of a trace on several
+ *     threads,
+ * - `mrc`: the misses of the stack distance engine (LRU, write-allocate and
+ *     unsectored only, without trace sampling),
+ * - `classify`: the miss classes of classify_cache_access, against a fully
+ *     associative LRU reference and the exact set of the lines seen so far
+ *     (caches of up to CHECK_CLASSIFY_LINES lines, unsectored only). The
+ *     Bloom filter may only count compulsory misses as capacity misses. The
+ *     sweep must reproduce the classes of classify_cache_access exactly,
+ * - `prefetch`: access_cache_batch of a cache with a prefetcher, against
+ *     access_cache of the same cache and prefetcher instead of the reference,
+ *     access by access and including the prefetch counts, on every geometry.
+ *     On traces without warming records, every prefetch must be useful, late,
+ *     useless or still pending at the end,
+ * - `timing`: access_cache_timed with one MSHR and a window of one
+ *     instruction, access by access, whose cycles and miss cycles must equal
+ *     the serialized ones except for the one instruction run behind a miss
+ *     (write-back, write-allocate only),
+ * - `multicore`: simulate_multicore with one core per bundled trace, against
+ *     the reference model of every private and of the shared cache, with the
+ *     requests of the cores merged serially in instruction order. With a
+ *     coherence protocol, the reference keeps the MESI or MOESI state in every
+ *     way and finds the other copies of a line by searching the other private
+ *     caches instead of using a directory.
+ *
+ * The bundled traces run on a fixed matrix of geometries, replacement and write
+ * policies and sectors. The fuzzer adds random traces, each simulated on random
+ * geometries and policies, some with a write-combining buffer or sectors, and,
+ * for some of them, with a random warmup and random sampling intervals.
+ *
+ * Usage: `calc-check [--fuzz <traces>] [--seed <seed>] [<trace>...]`
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/cache.h"
+#include "../src/cachesim.h"
+#include "../src/classify.h"
+#include "../src/multicore.h"
+#include "../src/prefetch.h"
+#include "../src/sweep.h"
+#include "../src/timing.h"
+#include "../src/trace.h"
+
+/**
+ * @brief Parameters of the suite.
+ */
+enum {
+    CHECK_MISS_PENALTY = 30,        // Miss penalty of all checked caches in cycles
+    CHECK_DIRTY_WB_PENALTY = 2,     // Dirty write-back penalty of all checked caches in cycles
+    CHECK_NUM_THREADS = 4,          // Threads of the partitioned and sweep engines
+    CHECK_BATCH_SIZE = 4096,        // Largest batch given to access_cache_batch
+    CHECK_MAX_CONFIGS = 64,         // Largest number of configurations checked on one trace
+    CHECK_SHARED_LATENCY = 20,      // Latency of the shared cache of the checked multi-core systems
+    CHECK_CLASSIFY_LINES = 1024,    // Largest cache whose miss classes are compared with the reference
+    FUZZ_CONFIGS = 8,               // Random configurations checked on every fuzzed trace
+    FUZZ_MIN_RECORDS = 20000,       // Smallest number of records of a fuzzed trace
+    FUZZ_MAX_RECORDS = 60000,       // Largest number of records of a fuzzed trace
+    REFERENCE_RRPV_DISTANT = 3,     // Largest re-reference prediction of SRRIP and BRRIP
+    REFERENCE_BRRIP_LONG_RATE = 32, // BRRIP inserts one in this many lines with a long prediction
+};
+
+/**
+ * @brief A cache configuration checked on a trace.
+ */
+typedef struct CheckConfig {
+    int associativity;          // Ways per set, 0 for fully associative, 1 for direct mapped
+    int cache_size;             // Cache size in KB
+    int line_size;              // Cache line size in bytes
+    ReplacementPolicy policy;   // Replacement policy
+    WritePolicy write_policy;   // Write policy, write-back, write-allocate if not given
+    int combining_entries;      // Lines of the write-combining buffer, 0 without a buffer
+    int sectors;                // Sectors per line, 0 or 1 for lines without sectors
+} CheckConfig;
+
+/**
+ * @brief The results of a configuration that every engine has to reproduce.
+ */
+typedef struct CheckResult {
+    CacheStats stats;           // Hits, misses, dirty write-backs and store writes of the measured records
+    uint64_t memory_writes;     // Writes to memory, including the pending writes of the write-combining buffer
+    uint64_t memory_write_bytes; // Bytes written to memory, including the pending writes
+    uint64_t cycles;            // Instructions plus the miss and memory write penalties
+} CheckResult;
+
+/**
+ * @brief A decoded trace with its sampling.
+ */
+typedef struct CheckTrace {
+    const char *path;           // Path of the trace file, read again by the file-based engines
+    CacheOp *ops;               // All records of the trace
+    size_t num_ops;             // Number of records
+    bool *is_measured;          // Indicates for every record whether it is measured or only warms
+    TraceSampling sampling;     // Selection of the measured records
+    uint64_t instruction_count; // Number of instructions of the measured records
+} CheckTrace;
+
+/**
+ * @brief The plain reference model of a cache.
+ * Lines are identified by their full line address, so the tag and set
+ * extraction of the simulator are checked as well.
+ */
+typedef struct ReferenceCache {
+    int ways;                   // Lines per set
+    int num_sets;               // Number of sets
+    int log_line_size;          // log2 of the line size
+    int log_sector_size;        // log2 of the sector size, log_line_size for lines without sectors
+    ReplacementPolicy policy;   // Replacement policy
+    uint64_t *lines;            // Line address of every way
+    bool *valid;                // Valid flag of every way
+    bool *dirty;                // Dirty flag of every way
+    uint64_t *sector_valid;     // Bitmap of the valid sectors of every way
+    uint64_t *sector_dirty;     // Bitmap of the modified sectors of every way
+    uint64_t *last_use;         // Time of the last access of every way (LRU)
+    uint8_t *rrpv;              // Re-reference prediction of every way (SRRIP, BRRIP)
+    uint8_t *plru;              // Tree bits of every set, node n of a set at index n (PLRU)
+    int *fifo_next;             // Next victim of every set (FIFO)
+    uint64_t random_state;      // State of the random number generator (random, BRRIP)
+    uint64_t time;              // Number of accesses so far
+    uint64_t victim_line;       // Line replaced by the most recent access
+    bool victim_dirty;          // Indicates if the most recent access replaced a modified line
+    uint8_t *state;             // CoherenceState of every way (coherent systems)
+    uint64_t *lost;             // Cores that lost the line of every way to an invalidation, equal in all copies
+    WritePolicy write_policy;   // Write policy
+    int store_size;             // Bytes written to memory by a store without write-combining
+    int chunk_size;             // Bytes covered by a bit of a write-combining entry
+    int combining_capacity;     // Lines of the write-combining buffer, 0 without a buffer
+    int combining_count;        // Pending lines of the write-combining buffer
+    uint64_t *combining_lines;  // Pending lines, the oldest first
+    uint64_t *combining_chunks; // Written chunks of every pending line
+    CacheStats stats;           // Statistics of the counted accesses
+} ReferenceCache;
+
+/**
+ * @brief State of the fuzzer's random number generator.
+ */
+static uint64_t fuzz_state = 1;
+
+// --- Helper Functions ---
+
+/**
+ * @brief Allocates zero-initialized memory or terminates the program if that fails.
+ *
+ * @param count Number of elements.
+ * @param size Size of an element in bytes.
+ * @return Pointer to the allocated memory.
+ */
+static void* allocate_check_memory(const size_t count, const size_t size) {
+    void *memory = calloc(count > 0 ? count : 1, size);
+    if (!memory) {
+        fprintf(stderr, "Failed to allocate memory for the checks.\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+/**
+ * @brief Advances a xorshift64* random number generator.
+ *
+ * @param state Pointer to the state of the generator.
+ * @return The next pseudo-random number.
+ */
+static uint64_t next_check_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Returns a random number of the fuzzer in a range.
+ *
+ * @param low Smallest value.
+ * @param high Largest value.
+ * @return A pseudo-random number between `low` and `high`.
+ */
+static long fuzz_range(const long low, const long high) {
+    return low + (long)((next_check_random(&fuzz_state) >> 16) % (uint64_t)(high - low + 1));
+}
+
+/**
+ * @brief Returns log2 of a power of two.
+ *
+ * @param n The power of two.
+ * @return log2(n).
+ */
+static int log2_check(const int n) {
+    return __builtin_ctz((unsigned)n);
+}
+
+/**
+ * @brief Creates an empty cache of the simulator for a configuration.
+ *
+ * @param config Pointer to the CheckConfig object.
+ * @return Pointer to the initialized Cache object.
+ */
+static Cache* create_cache(const CheckConfig *config) {
+    Cache *cache = initialize_cache(config->associativity, config->cache_size, config->line_size, CHECK_MISS_PENALTY,
+                                    CHECK_DIRTY_WB_PENALTY, config->policy, 1);
+    if (config->sectors > 1) {
+        set_cache_sectors(cache, config->sectors);
+    }
+    if (config->write_policy != WRITE_BACK_ALLOCATE || config->combining_entries > 0) {
+        set_write_policy(cache, config->write_policy, config->combining_entries);
+    }
+    return cache;
+}
+
+/**
+ * @brief Formats a configuration for messages.
+ *
+ * @param config Pointer to the CheckConfig object.
+ * @param text Buffer receiving the description.
+ * @param size Size of the buffer.
+ */
+static void describe_config(const CheckConfig *config, char *text, const size_t size) {
+    char ways[16];
+    if (config->associativity == 0) {
+        snprintf(ways, sizeof(ways), "fa");
+    } else if (config->associativity == 1) {
+        snprintf(ways, sizeof(ways), "dm");
+    } else {
+        snprintf(ways, sizeof(ways), "%d-way", config->associativity);
+    }
+    snprintf(text, size, "%s %d KB %d B %s %s wc %d sectors %d", ways, config->cache_size, config->line_size,
+             get_replacement_policy_name(config->policy), get_write_policy_name(config->write_policy),
+             config->combining_entries, config->sectors > 1 ? config->sectors : 1);
+}
+
+/**
+ * @brief Collects the results of a cache of the simulator.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param cache Pointer to the simulated Cache object.
+ * @return The statistics and memory writes of the cache, with the cycles of the serialized model.
+ */
+static CheckResult get_cache_result(const CheckTrace *trace, const Cache *cache) {
+    const uint64_t memory_writes = get_memory_writes(cache);
+    return (CheckResult){cache->stats, memory_writes, get_memory_write_bytes(cache),
+                         trace->instruction_count + cache->stats.misses * CHECK_MISS_PENALTY
+                         + memory_writes * CHECK_DIRTY_WB_PENALTY};
+}
+
+/**
+ * @brief Compares the result of an engine with the reference and reports a difference.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param engine Name of the engine.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @param actual Pointer to the CheckResult object of the engine.
+ * @return `true` if the results are identical, `false` otherwise.
+ */
+static bool compare_result(const CheckTrace *trace, const CheckConfig *config, const char *engine,
+                           const CheckResult *expected, const CheckResult *actual) {
+    if (expected->stats.hits == actual->stats.hits && expected->stats.misses == actual->stats.misses
+        && expected->stats.sector_misses == actual->stats.sector_misses
+        && expected->stats.dirty_write_backs == actual->stats.dirty_write_backs
+        && expected->stats.combined_writes == actual->stats.combined_writes
+        && expected->memory_writes == actual->memory_writes
+        && expected->memory_write_bytes == actual->memory_write_bytes && expected->cycles == actual->cycles) {
+        return true;
+    }
+
+    char text[96];
+    describe_config(config, text, sizeof(text));
+    fprintf(stderr, "%s, %s: %s differs from the reference\n"
+            "  hits %" PRIu64 " (expected %" PRIu64 "), misses %" PRIu64 " (expected %" PRIu64 "),\n"
+            "  dirty write-backs %" PRIu64 " (expected %" PRIu64 "), cycles %" PRIu64 " (expected %" PRIu64 "),\n"
+            "  memory writes %" PRIu64 " (expected %" PRIu64 "), bytes %" PRIu64 " (expected %" PRIu64 "),"
+            " combined %" PRIu64 " (expected %" PRIu64 "), sector misses %" PRIu64 " (expected %" PRIu64 ")\n",
+            trace->path, text, engine, actual->stats.hits, expected->stats.hits, actual->stats.misses,
+            expected->stats.misses, actual->stats.dirty_write_backs, expected->stats.dirty_write_backs,
+            actual->cycles, expected->cycles, actual->memory_writes, expected->memory_writes,
+            actual->memory_write_bytes, expected->memory_write_bytes, actual->stats.combined_writes,
+            expected->stats.combined_writes, actual->stats.sector_misses, expected->stats.sector_misses);
+    return false;
+}
+
+/**
+ * @brief Reports the first access on which an engine disagrees with the reference.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param engine Name of the engine.
+ * @param record Index of the record.
+ * @param is_hit Result of the engine.
+ */
+static void report_access(const CheckTrace *trace, const CheckConfig *config, const char *engine,
+                          const size_t record, const bool is_hit) {
+    char text[96];
+    describe_config(config, text, sizeof(text));
+    fprintf(stderr, "%s, %s: %s reports a %s for record %zu (%c 0x%" PRIx64 "), the reference a %s\n",
+            trace->path, text, engine, is_hit ? "hit" : "miss", record, trace->ops[record].access_type,
+            trace->ops[record].address, is_hit ? "miss" : "hit");
+}
+
+// --- Reference Model ---
+
+/**
+ * @brief Creates an empty reference cache for a configuration.
+ *
+ * @param config Pointer to the CheckConfig object.
+ * @return Pointer to the initialized ReferenceCache object.
+ */
+static ReferenceCache* create_reference(const CheckConfig *config) {
+    ReferenceCache *reference = allocate_check_memory(1, sizeof(ReferenceCache));
+    const int num_lines = config->cache_size * 1024 / config->line_size;
+    reference->ways = config->associativity == 0 ? num_lines : config->associativity;
+    reference->num_sets = num_lines / reference->ways;
+    reference->log_line_size = log2_check(config->line_size);
+    reference->log_sector_size = reference->log_line_size - (config->sectors > 1 ? log2_check(config->sectors) : 0);
+    reference->policy = config->policy;
+    reference->write_policy = config->write_policy;
+    reference->store_size = config->line_size < CACHE_STORE_SIZE ? config->line_size : CACHE_STORE_SIZE;
+    reference->chunk_size = config->line_size / 64 > reference->store_size ? config->line_size / 64
+                                                                           : reference->store_size;
+    reference->combining_capacity = config->combining_entries;
+
+    reference->lines = allocate_check_memory((size_t)num_lines, sizeof(uint64_t));
+    reference->valid = allocate_check_memory((size_t)num_lines, sizeof(bool));
+    reference->dirty = allocate_check_memory((size_t)num_lines, sizeof(bool));
+    reference->sector_valid = allocate_check_memory((size_t)num_lines, sizeof(uint64_t));
+    reference->sector_dirty = allocate_check_memory((size_t)num_lines, sizeof(uint64_t));
+    reference->last_use = allocate_check_memory((size_t)num_lines, sizeof(uint64_t));
+    reference->rrpv = allocate_check_memory((size_t)num_lines, sizeof(uint8_t));
+    reference->plru = allocate_check_memory((size_t)num_lines, sizeof(uint8_t));
+    reference->fifo_next = allocate_check_memory((size_t)reference->num_sets, sizeof(int));
+    reference->state = allocate_check_memory((size_t)num_lines, sizeof(uint8_t));
+    reference->lost = allocate_check_memory((size_t)num_lines, sizeof(uint64_t));
+    reference->combining_lines = allocate_check_memory((size_t)config->combining_entries, sizeof(uint64_t));
+    reference->combining_chunks = allocate_check_memory((size_t)config->combining_entries, sizeof(uint64_t));
+    memset(reference->rrpv, REFERENCE_RRPV_DISTANT, (size_t)num_lines);
+
+    // Start from the same seed as the simulator
+    Cache *cache = create_cache(config);
+    reference->random_state = cache->random_state;
+    free_cache(cache);
+    return reference;
+}
+
+/**
+ * @brief Frees a reference cache.
+ *
+ * @param reference Pointer to the ReferenceCache object.
+ */
+static void free_reference(ReferenceCache *reference) {
+    free(reference->lines);
+    free(reference->valid);
+    free(reference->dirty);
+    free(reference->sector_valid);
+    free(reference->sector_dirty);
+    free(reference->last_use);
+    free(reference->rrpv);
+    free(reference->plru);
+    free(reference->fifo_next);
+    free(reference->state);
+    free(reference->lost);
+    free(reference->combining_lines);
+    free(reference->combining_chunks);
+    free(reference);
+}
+
+/**
+ * @brief Points the tree-PLRU bits of a set away from a way.
+ *
+ * @param tree Tree bits of the set.
+ * @param ways Lines per set.
+ * @param way The accessed way.
+ */
+static void touch_reference_plru(uint8_t *tree, const int ways, const int way) {
+    int node = 1;
+    for (int level = log2_check(ways) - 1; level >= 0; level--) {
+        const int direction = (way >> level) & 1;
+        tree[node] = (uint8_t)!direction;
+        node = 2 * node + direction;
+    }
+}
+
+/**
+ * @brief Chooses the way of a full set that a miss replaces.
+ *
+ * @param reference Pointer to the ReferenceCache object.
+ * @param first Index of the first way of the set.
+ * @param set Index of the set.
+ * @return The way to replace.
+ */
+static int choose_reference_victim(ReferenceCache *reference, const size_t first, const int set) {
+    const int ways = reference->ways;
+    int victim = 0;
+    switch (reference->policy) {
+        case REPLACEMENT_LRU:
+            for (int way = 1; way < ways; way++) {
+                if (reference->last_use[first + way] < reference->last_use[first + victim]) {
+                    victim = way;
+                }
+            }
+            return victim;
+        case REPLACEMENT_PLRU: {
+            int node = 1;
+            while (node < ways) {
+                node = 2 * node + reference->plru[first + node];
+            }
+            return node - ways;
+        }
+        case REPLACEMENT_SRRIP:
+        case REPLACEMENT_BRRIP:
+            // Age all lines until one has the distant prediction, the first such line is replaced
+            for (;;) {
+                for (int way = 0; way < ways; way++) {
+                    if (reference->rrpv[first + way] == REFERENCE_RRPV_DISTANT) {
+                        return way;
+                    }
+                }
+                for (int way = 0; way < ways; way++) {
+                    reference->rrpv[first + way]++;
+                }
+            }
+        case REPLACEMENT_FIFO:
+            return reference->fifo_next[set];
+        default:
+            return (int)((next_check_random(&reference->random_state) >> 32) % (uint64_t)ways);
+    }
+}
+
+/**
+ * @brief Writes a store that bypasses the lines of the reference cache to memory.
+ *
+ * @param reference Pointer to the ReferenceCache object.
+ * @param address The address of the store.
+ * @param is_counted Indicates if the write counts in the statistics, `false` for warming records.
+ */
+static void write_reference_store(ReferenceCache *reference, const uint64_t address, const bool is_counted) {
+    if (reference->combining_capacity == 0) {
+        if (is_counted) {
+            reference->stats.memory_writes++;
+            reference->stats.memory_write_bytes += (uint64_t)reference->store_size;
+        }
+        return;
+    }
+
+    const uint64_t line = address >> reference->log_line_size;
+    const uint64_t offset = address & (((uint64_t)1 << reference->log_line_size) - 1);
+    const uint64_t chunk = (uint64_t)1 << (offset / (uint64_t)reference->chunk_size);
+    for (int e = 0; e < reference->combining_count; e++) {
+        if (reference->combining_lines[e] == line) {
+            reference->combining_chunks[e] |= chunk;
+            if (is_counted) {
+                reference->stats.combined_writes++;
+            }
+            return;
+        }
+    }
+
+    // A full buffer writes its oldest line to memory first
+    if (reference->combining_count == reference->combining_capacity) {
+        if (is_counted) {
+            reference->stats.memory_writes++;
+            for (uint64_t chunks = reference->combining_chunks[0]; chunks != 0; chunks >>= 1) {
+                reference->stats.memory_write_bytes += (chunks & 1) * (uint64_t)reference->chunk_size;
+            }
+        }
+        reference->combining_count--;
+        memmove(reference->combining_lines, &reference->combining_lines[1],
+                (size_t)reference->combining_count * sizeof(uint64_t));
+        memmove(reference->combining_chunks, &reference->combining_chunks[1],
+                (size_t)reference->combining_count * sizeof(uint64_t));
+    }
+    reference->combining_lines[reference->combining_count] = line;
+    reference->combining_chunks[reference->combining_count] = chunk;
+    reference->combining_count++;
+}
+
+/**
+ * @brief Collects the results of a reference cache.
+ * The lines left in the write-combining buffer count as written.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param reference Pointer to the ReferenceCache object.
+ * @return The statistics and memory writes of the reference, with the cycles of the serialized model.
+ */
+static CheckResult get_reference_result(const CheckTrace *trace, const ReferenceCache *reference) {
+    CheckResult result = {reference->stats, 0, 0, 0};
+    result.memory_writes = reference->stats.dirty_write_backs + reference->stats.memory_writes
+                           + (uint64_t)reference->combining_count;
+    result.memory_write_bytes = reference->stats.write_back_bytes + reference->stats.memory_write_bytes;
+    for (int e = 0; e < reference->combining_count; e++) {
+        for (uint64_t chunks = reference->combining_chunks[e]; chunks != 0; chunks >>= 1) {
+            result.memory_write_bytes += (chunks & 1) * (uint64_t)reference->chunk_size;
+        }
+    }
+    result.cycles = trace->instruction_count + reference->stats.misses * CHECK_MISS_PENALTY
+                    + result.memory_writes * CHECK_DIRTY_WB_PENALTY;
+    return result;
+}
+
+/**
+ * @brief Simulates an access to the reference cache.
+ *
+ * @param reference Pointer to the ReferenceCache object.
+ * @param cache_op Pointer to the CacheOp object of the access.
+ * @param is_counted Indicates if the access counts in the statistics, `false` for warming records.
+ * @return `true` if the access is a hit, `false` if it's a miss.
+ */
+static bool access_reference(ReferenceCache *reference, const CacheOp *cache_op, const bool is_counted) {
+    const uint64_t line = cache_op->address >> reference->log_line_size;
+    const int set = (int)(line % (uint64_t)reference->num_sets);
+    const size_t first = (size_t)set * reference->ways;
+    const bool is_store = cache_op->access_type == 's';
+    const bool has_policy = reference->ways > 1;
+    const uint64_t offset = cache_op->address & (((uint64_t)1 << reference->log_line_size) - 1);
+    const uint64_t sector = (uint64_t)1 << (offset >> reference->log_sector_size);
+    const bool is_write_back = reference->write_policy == WRITE_BACK_ALLOCATE
+                               || reference->write_policy == WRITE_BACK_NO_ALLOCATE;
+    const bool is_write_allocate = reference->write_policy == WRITE_BACK_ALLOCATE
+                                   || reference->write_policy == WRITE_THROUGH_ALLOCATE;
+    reference->time++;
+    reference->victim_dirty = false;
+
+    for (int way = 0; way < reference->ways; way++) {
+        if (reference->valid[first + way] && reference->lines[first + way] == line) {
+            // A cached line without the accessed sector misses, but fills the sector in place
+            const bool is_hit = (reference->sector_valid[first + way] & sector) != 0;
+            if (is_counted) {
+                reference->stats.hits += is_hit;
+                reference->stats.misses += !is_hit;
+                reference->stats.sector_misses += !is_hit;
+            }
+            if (!is_hit && is_store && !is_write_allocate) {
+                write_reference_store(reference, cache_op->address, is_counted);
+                return false;
+            }
+            reference->sector_valid[first + way] |= sector;
+            reference->dirty[first + way] |= is_store && is_write_back;
+            reference->sector_dirty[first + way] |= is_store && is_write_back ? sector : 0;
+            if (is_store && !is_write_back) {
+                write_reference_store(reference, cache_op->address, is_counted);
+            }
+            reference->last_use[first + way] = reference->time;
+            if (has_policy && reference->policy == REPLACEMENT_PLRU) {
+                touch_reference_plru(&reference->plru[first], reference->ways, way);
+            }
+            reference->rrpv[first + way] = 0;
+            return is_hit;
+        }
+    }
+
+    // Store misses of no-write-allocate caches go to memory
+    if (is_store && !is_write_allocate) {
+        write_reference_store(reference, cache_op->address, is_counted);
+        if (is_counted) {
+            reference->stats.misses++;
+        }
+        return false;
+    }
+
+    // Fill the first invalid way, or replace the victim of the policy
+    int victim = -1;
+    for (int way = 0; way < reference->ways && victim < 0; way++) {
+        if (!reference->valid[first + way]) {
+            victim = way;
+        }
+    }
+    if (victim < 0) {
+        victim = has_policy ? choose_reference_victim(reference, first, set) : 0;
+        if (reference->dirty[first + victim] && is_counted) {
+            reference->stats.dirty_write_backs++;
+            reference->stats.write_back_bytes +=
+                reference->log_sector_size < reference->log_line_size
+                ? (uint64_t)__builtin_popcountll(reference->sector_dirty[first + victim]) << reference->log_sector_size
+                : (uint64_t)1 << reference->log_line_size;
+        }
+        reference->victim_line = reference->lines[first + victim];
+        reference->victim_dirty = reference->dirty[first + victim];
+    }
+
+    reference->lines[first + victim] = line;
+    reference->valid[first + victim] = true;
+    reference->dirty[first + victim] = is_store && is_write_back;
+    reference->sector_valid[first + victim] = sector;
+    reference->sector_dirty[first + victim] = is_store && is_write_back ? sector : 0;
+    reference->last_use[first + victim] = reference->time;
+    if (is_store && !is_write_back) {
+        write_reference_store(reference, cache_op->address, is_counted);
+    }
+    if (has_policy) {
+        switch (reference->policy) {
+            case REPLACEMENT_PLRU:
+                touch_reference_plru(&reference->plru[first], reference->ways, victim);
+                break;
+            case REPLACEMENT_SRRIP:
+                reference->rrpv[first + victim] = REFERENCE_RRPV_DISTANT - 1;
+                break;
+            case REPLACEMENT_BRRIP:
+                reference->rrpv[first + victim] =
+                    (next_check_random(&reference->random_state) >> 32) % REFERENCE_BRRIP_LONG_RATE == 0
+                    ? REFERENCE_RRPV_DISTANT - 1 : REFERENCE_RRPV_DISTANT;
+                break;
+            case REPLACEMENT_FIFO:
+                if (victim == reference->fifo_next[set]) {
+                    reference->fifo_next[set] = (victim + 1) % reference->ways;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (is_counted) {
+        reference->stats.misses++;
+    }
+    return false;
+}
+
+/**
+ * @brief Finds the way of the reference cache holding a line.
+ *
+ * @param reference Pointer to the ReferenceCache object.
+ * @param line The line number.
+ * @return Index of the way, -1 if the line isn't cached.
+ */
+static long find_reference_way(const ReferenceCache *reference, const uint64_t line) {
+    const size_t first = (size_t)(line % (uint64_t)reference->num_sets) * reference->ways;
+    for (int way = 0; way < reference->ways; way++) {
+        if (reference->valid[first + way] && reference->lines[first + way] == line) {
+            return (long)(first + way);
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Simulates an access of a core to its private reference cache and keeps the other copies coherent.
+ *
+ * @param privates The private reference caches of all cores.
+ * @param num_cores Number of cores.
+ * @param core Number of the accessing core.
+ * @param protocol The coherence protocol.
+ * @param cache_op Pointer to the CacheOp object of the access.
+ * @param stats Pointer to the CoherenceStats object of the accessing core.
+ * @return The result of the access with the requests to the shared cache.
+ */
+static CoherenceAccess access_coherent_reference(ReferenceCache *const *privates, const int num_cores,
+                                                 const int core, const CoherenceProtocol protocol,
+                                                 const CacheOp *cache_op, CoherenceStats *stats) {
+    ReferenceCache *reference = privates[core];
+    const bool is_store = cache_op->access_type == 's';
+    const uint64_t line = cache_op->address >> reference->log_line_size;
+    const long previous_way = find_reference_way(reference, line);
+    const uint8_t previous_state = previous_way >= 0 ? reference->state[previous_way] : COHERENCE_SHARED;
+
+    CoherenceAccess access = {access_reference(reference, cache_op, true), false, 0, {0, 0}};
+    if (access.is_hit && !is_store) {
+        return access;
+    }
+    if (!access.is_hit && reference->victim_dirty) {
+        access.write_backs[access.num_write_backs++] = reference->victim_line << reference->log_line_size;
+    }
+
+    // Collect the copies of the other cores
+    long ways[MULTICORE_MAX_CORES];
+    uint64_t lost = previous_way >= 0 ? reference->lost[previous_way] : 0;
+    int dirty_owner = -1;
+    int clean_owner = -1;
+    bool has_copies = false;
+    for (int c = 0; c < num_cores; c++) {
+        ways[c] = c == core ? -1 : find_reference_way(privates[c], line);
+        if (ways[c] < 0) {
+            continue;
+        }
+        has_copies = true;
+        lost = privates[c]->lost[ways[c]];
+        const uint8_t state = privates[c]->state[ways[c]];
+        if (state == COHERENCE_MODIFIED || state == COHERENCE_OWNED) {
+            dirty_owner = c;
+        } else if (state == COHERENCE_EXCLUSIVE) {
+            clean_owner = c;
+        }
+    }
+    const long way = find_reference_way(reference, line);
+    if (!access.is_hit && (lost & (1ULL << core))) {
+        stats->coherence_misses++;
+        lost &= ~(1ULL << core);
+    }
+
+    if (is_store) {
+        if (access.is_hit && (previous_state == COHERENCE_SHARED || previous_state == COHERENCE_OWNED)) {
+            stats->upgrades++;
+        } else if (!access.is_hit && dirty_owner >= 0) {
+            stats->transfers++;
+        } else if (!access.is_hit) {
+            access.needs_fill = true;
+        }
+        for (int c = 0; c < num_cores; c++) {
+            if (ways[c] >= 0) {
+                privates[c]->valid[ways[c]] = false;
+                lost |= 1ULL << c;
+                stats->invalidations++;
+            }
+        }
+        reference->state[way] = COHERENCE_MODIFIED;
+        reference->lost[way] = lost;
+        return access;
+    }
+
+    if (dirty_owner >= 0) {
+        stats->transfers++;
+        ReferenceCache *owner = privates[dirty_owner];
+        if (owner->state[ways[dirty_owner]] == COHERENCE_MODIFIED) {
+            stats->downgrades++;
+            if (protocol == COHERENCE_MOESI) {
+                owner->state[ways[dirty_owner]] = COHERENCE_OWNED;
+            } else {
+                owner->state[ways[dirty_owner]] = COHERENCE_SHARED;
+                owner->dirty[ways[dirty_owner]] = false;
+                stats->write_backs++;
+                access.write_backs[access.num_write_backs++] = line << reference->log_line_size;
+            }
+        }
+    } else {
+        if (clean_owner >= 0) {
+            stats->downgrades++;
+            privates[clean_owner]->state[ways[clean_owner]] = COHERENCE_SHARED;
+        }
+        access.needs_fill = true;
+    }
+
+    reference->state[way] = has_copies ? COHERENCE_SHARED : COHERENCE_EXCLUSIVE;
+    reference->lost[way] = lost;
+    for (int c = 0; c < num_cores; c++) {
+        if (ways[c] >= 0) {
+            privates[c]->lost[ways[c]] = lost;
+        }
+    }
+    return access;
+}
+
+// --- Engines ---
+
+/**
+ * @brief Runs the reference model over a trace.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param hits Array receiving for every record whether it hits.
+ * @param result Pointer to the CheckResult object receiving the results.
+ */
+static void run_reference(const CheckTrace *trace, const CheckConfig *config, bool *hits, CheckResult *result) {
+    ReferenceCache *reference = create_reference(config);
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        hits[i] = access_reference(reference, &trace->ops[i], trace->is_measured[i]);
+    }
+    *result = get_reference_result(trace, reference);
+    free_reference(reference);
+}
+
+/**
+ * @brief Checks access_cache against the reference, access by access.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param hits Results of the reference for every record.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the engine matches the reference, `false` otherwise.
+ */
+static bool check_kernel(const CheckTrace *trace, const CheckConfig *config, const bool *hits,
+                         const CheckResult *expected) {
+    Cache *cache = create_cache(config);
+    bool is_ok = true;
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        if (!trace->is_measured[i]) {
+            warm_cache(cache, &trace->ops[i]);
+        } else if (access_cache(cache, &trace->ops[i]) != hits[i] && is_ok) {
+            report_access(trace, config, "kernel", i, !hits[i]);
+            is_ok = false;
+        }
+    }
+
+    const CheckResult actual = get_cache_result(trace, cache);
+    free_cache(cache);
+    return compare_result(trace, config, "kernel", expected, &actual) && is_ok;
+}
+
+/**
+ * @brief Checks access_cache_batch against the reference, access by access.
+ * Consecutive records of the same sampling phase form a batch.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param hits Results of the reference for every record.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the engine matches the reference, `false` otherwise.
+ */
+static bool check_batch(const CheckTrace *trace, const CheckConfig *config, const bool *hits,
+                        const CheckResult *expected) {
+    Cache *cache = create_cache(config);
+    uint8_t hit_bitmap[(CHECK_BATCH_SIZE + 7) / 8];
+    bool is_ok = true;
+    for (size_t start = 0; start < trace->num_ops;) {
+        size_t count = 1;
+        while (start + count < trace->num_ops && count < CHECK_BATCH_SIZE
+               && trace->is_measured[start + count] == trace->is_measured[start]) {
+            count++;
+        }
+
+        if (!trace->is_measured[start]) {
+            warm_cache_batch(cache, &trace->ops[start], count);
+        } else {
+            access_cache_batch(cache, &trace->ops[start], count, hit_bitmap);
+            for (size_t i = 0; i < count && is_ok; i++) {
+                const bool is_hit = (hit_bitmap[i / 8] >> (i % 8)) & 1;
+                if (is_hit != hits[start + i]) {
+                    report_access(trace, config, "batch", start + i, is_hit);
+                    is_ok = false;
+                }
+            }
+        }
+        start += count;
+    }
+
+    const CheckResult actual = get_cache_result(trace, cache);
+    free_cache(cache);
+    return compare_result(trace, config, "batch", expected, &actual) && is_ok;
+}
+
+/**
+ * @brief Compares the statistics of a library cache with the reference.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param engine Name of the engine.
+ * @param cache The library cache.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the results are identical, `false` otherwise.
+ */
+static bool compare_library_result(const CheckTrace *trace, const CheckConfig *config, const char *engine,
+                                   const CachesimCache *cache, const CheckResult *expected) {
+    CachesimStats stats;
+    cachesim_get_stats(cache, &stats, sizeof(stats));
+    CheckResult actual = {{0}, stats.dirty_write_backs, stats.dirty_write_backs * (uint64_t)config->line_size,
+                          stats.cycles};
+    actual.stats.hits = stats.hits;
+    actual.stats.misses = stats.misses;
+    actual.stats.dirty_write_backs = stats.dirty_write_backs;
+    return compare_result(trace, config, engine, expected, &actual);
+}
+
+/**
+ * @brief Checks the library interface against the reference.
+ * The first half of the trace is simulated in batches. The second half runs on
+ * a clone in batches and on the original access by access, so both must end
+ * with the statistics of the reference. Finally, the original is reset and
+ * simulates the whole trace again.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param hits Results of the reference for every record.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the library matches the reference or is skipped, `false` otherwise.
+ */
+static bool check_library(const CheckTrace *trace, const CheckConfig *config, const bool *hits,
+                          const CheckResult *expected) {
+    if (config->write_policy != WRITE_BACK_ALLOCATE || config->sectors > 1) {
+        return true;
+    }
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        if (!trace->is_measured[i]) {
+            return true;
+        }
+    }
+
+    CachesimAccess *accesses = allocate_check_memory(trace->num_ops, sizeof(CachesimAccess));
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        accesses[i] = (CachesimAccess){trace->ops[i].address, (uint32_t)trace->ops[i].instructions,
+                                       (uint8_t)trace->ops[i].access_type, {0}};
+    }
+    uint8_t *hit_bitmap = allocate_check_memory((trace->num_ops + 7) / 8, sizeof(uint8_t));
+
+    CachesimConfig library_config;
+    cachesim_config_init(&library_config);
+    library_config.associativity = config->associativity;
+    library_config.cache_size = config->cache_size;
+    library_config.line_size = config->line_size;
+    library_config.miss_penalty = CHECK_MISS_PENALTY;
+    library_config.dirty_wb_penalty = CHECK_DIRTY_WB_PENALTY;
+    library_config.replacement = (int32_t)config->policy;
+    CachesimCache *cache;
+    const int32_t status = cachesim_create(&library_config, sizeof(library_config), &cache);
+    if (status != CACHESIM_OK) {
+        char text[96];
+        describe_config(config, text, sizeof(text));
+        fprintf(stderr, "%s, %s: library rejects the configuration: %s\n", trace->path, text,
+                cachesim_get_status_message(status));
+        free(accesses);
+        free(hit_bitmap);
+        return false;
+    }
+
+    // The half is a multiple of 8, so the clone writes whole bytes of the bitmap
+    const size_t half = trace->num_ops / 16 * 8;
+    cachesim_access_batch(cache, accesses, half, hit_bitmap);
+    CachesimCache *clone = cachesim_clone(cache);
+    cachesim_access_batch(clone, &accesses[half], trace->num_ops - half, &hit_bitmap[half / 8]);
+    bool is_ok = true;
+    for (size_t i = 0; i < trace->num_ops && is_ok; i++) {
+        const bool is_hit = (hit_bitmap[i / 8] >> (i % 8)) & 1;
+        const bool is_single_hit = i >= half && cachesim_access(cache, &accesses[i]);
+        if (is_hit != hits[i] || (i >= half && is_single_hit != hits[i])) {
+            report_access(trace, config, "library", i, is_hit != hits[i] ? is_hit : is_single_hit);
+            is_ok = false;
+        }
+    }
+    is_ok = is_ok && compare_library_result(trace, config, "library clone", clone, expected);
+    is_ok = is_ok && compare_library_result(trace, config, "library", cache, expected);
+
+    cachesim_reset(cache);
+    cachesim_access_batch(cache, accesses, trace->num_ops, NULL);
+    is_ok = is_ok && compare_library_result(trace, config, "library after reset", cache, expected);
+
+    cachesim_destroy(clone);
+    cachesim_destroy(cache);
+    free(accesses);
+    free(hit_bitmap);
+    return is_ok;
+}
+
+/**
+ * @brief Checks simulate_partitioned against the reference.
+ * Skipped for caches that can't be partitioned and for the random and BRRIP
+ * policies, whose partitions draw their own random numbers.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the engine matches the reference or is skipped, `false` otherwise.
+ */
+static bool check_partitioned(const CheckTrace *trace, const CheckConfig *config, const CheckResult *expected) {
+    if (config->policy == REPLACEMENT_RANDOM || config->policy == REPLACEMENT_BRRIP) {
+        return true;
+    }
+    Cache *cache = create_cache(config);
+    if (get_max_cache_partitions(cache) <= 1) {
+        free_cache(cache);
+        return true;
+    }
+
+    TraceStats trace_stats = {0, 0, 0, 0, 0, 0};
+    simulate_partitioned(cache, trace->path, &trace_stats, &trace->sampling, CHECK_NUM_THREADS);
+    CheckResult actual = get_cache_result(trace, cache);
+    actual.cycles = trace_stats.cycle_count + actual.memory_writes * CHECK_DIRTY_WB_PENALTY;
+    free_cache(cache);
+    return compare_result(trace, config, "partitioned", expected, &actual);
+}
+
+/**
+ * @brief Compares miss classes with the expected ones and reports a difference.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param engine Name of the engine.
+ * @param expected Pointer to the expected MissClassStats object.
+ * @param actual Pointer to the MissClassStats object of the engine.
+ * @param is_exact Indicates if the compulsory misses must match exactly, otherwise they may be fewer.
+ * @return `true` if the classes match, `false` otherwise.
+ */
+static bool compare_classes(const CheckTrace *trace, const CheckConfig *config, const char *engine,
+                            const MissClassStats *expected, const MissClassStats *actual, const bool is_exact) {
+    const bool is_compulsory_ok = is_exact ? actual->compulsory == expected->compulsory
+                                           : actual->compulsory <= expected->compulsory;
+    if (is_compulsory_ok && actual->conflict == expected->conflict
+        && actual->compulsory + actual->capacity == expected->compulsory + expected->capacity) {
+        return true;
+    }
+    char text[96];
+    describe_config(config, text, sizeof(text));
+    fprintf(stderr, "%s, %s: %s differs from the reference\n"
+            "  compulsory %" PRIu64 " (expected %" PRIu64 ")\n"
+            "  capacity   %" PRIu64 " (expected %" PRIu64 ")\n"
+            "  conflict   %" PRIu64 " (expected %" PRIu64 ")\n",
+            trace->path, text, engine, actual->compulsory, expected->compulsory, actual->capacity,
+            expected->capacity, actual->conflict, expected->conflict);
+    return false;
+}
+
+/**
+ * @brief Checks the miss classes of classify_cache_access against the reference.
+ * The reference keeps every line seen so far in a hash set and runs a fully
+ * associative LRU reference cache next to the classified cache. The exact
+ * classes are only computed for caches of up to CHECK_CLASSIFY_LINES
+ * lines, whose reference is fast enough. Sectored caches aren't classified.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param hits Results of the reference for every record.
+ * @param classes Pointer to the MissClassStats object receiving the classes of the engine.
+ * @return `true` if the engine matches the reference or is skipped, `false` otherwise.
+ */
+static bool check_classify(const CheckTrace *trace, const CheckConfig *config, const bool *hits,
+                           MissClassStats *classes) {
+    if (config->sectors > 1) {
+        return true;
+    }
+    const ClassifyOptions options = {true, CLASSIFY_DEFAULT_FILTER_SIZE};
+    Cache *cache = create_cache(config);
+    MissClassifier *classifier = initialize_classifier(&options, cache);
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        if (trace->is_measured[i]) {
+            classify_cache_access(classifier, &trace->ops[i], hits[i]);
+        } else {
+            warm_classifier(classifier, &trace->ops[i]);
+        }
+    }
+    *classes = classifier->stats;
+    free_classifier(classifier);
+    free_cache(cache);
+
+    if (config->cache_size * 1024 / config->line_size > CHECK_CLASSIFY_LINES) {
+        return true;
+    }
+
+    // The seen lines are kept in an open-addressing set of line number + 1, at most half full
+    ReferenceCache *shadow = create_reference(&(CheckConfig){0, config->cache_size, config->line_size,
+                                                             REPLACEMENT_LRU, config->write_policy, 0});
+    size_t capacity = 1;
+    while (capacity < trace->num_ops * 2) {
+        capacity *= 2;
+    }
+    uint64_t *seen = allocate_check_memory(capacity, sizeof(uint64_t));
+    MissClassStats expected = {0, 0, 0};
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        const uint64_t key = (trace->ops[i].address >> shadow->log_line_size) + 1;
+        size_t slot = (size_t)(key * 0x9E3779B97F4A7C15ULL) & (capacity - 1);
+        while (seen[slot] != 0 && seen[slot] != key) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        const bool is_first = seen[slot] == 0;
+        seen[slot] = key;
+
+        const bool is_shadow_hit = access_reference(shadow, &trace->ops[i], false);
+        if (!trace->is_measured[i] || hits[i]) {
+            continue;
+        }
+        if (is_shadow_hit) {
+            expected.conflict++;
+        } else if (is_first) {
+            expected.compulsory++;
+        } else {
+            expected.capacity++;
+        }
+    }
+    free(seen);
+    free_reference(shadow);
+    return compare_classes(trace, config, "classify", &expected, classes, false);
+}
+
+/**
+ * @brief Checks simulate_sweep of all configurations of a trace against the reference.
+ * Every unsectored point also classifies its misses, which must match classify_cache_access.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param configs The configurations.
+ * @param expected The results of the reference for every configuration.
+ * @param classes The classes of classify_cache_access for every configuration.
+ * @param num_configs Number of configurations.
+ * @return `true` if the engine matches the reference for all configurations, `false` otherwise.
+ */
+static bool check_sweep(const CheckTrace *trace, const CheckConfig *configs, const CheckResult *expected,
+                        const MissClassStats *classes, const int num_configs) {
+    const ClassifyOptions options = {true, CLASSIFY_DEFAULT_FILTER_SIZE};
+    SweepPoint points[CHECK_MAX_CONFIGS];
+    for (int c = 0; c < num_configs; c++) {
+        points[c] = (SweepPoint){create_cache(&configs[c]), 0, NULL};
+        if (configs[c].sectors <= 1) {
+            points[c].classifier = initialize_classifier(&options, points[c].cache);
+        }
+    }
+
+    TraceStats trace_stats = {0, 0, 0, 0, 0, 0};
+    simulate_sweep(points, num_configs, trace->path, &trace_stats, &trace->sampling, CHECK_NUM_THREADS);
+
+    bool is_ok = true;
+    for (int c = 0; c < num_configs; c++) {
+        CheckResult actual = get_cache_result(trace, points[c].cache);
+        actual.cycles = points[c].cycle_count;
+        is_ok = compare_result(trace, &configs[c], "sweep", &expected[c], &actual) && is_ok;
+        if (points[c].classifier) {
+            is_ok = compare_classes(trace, &configs[c], "classify sweep", &classes[c],
+                                    &points[c].classifier->stats, true) && is_ok;
+            free_classifier(points[c].classifier);
+        }
+        free_cache(points[c].cache);
+    }
+    return is_ok;
+}
+
+/**
+ * @brief Checks the misses of the stack distance engine against the reference.
+ * Only LRU caches of traces without sampling are checked, as the engine has no
+ * warming records. The store misses of no-write-allocate caches don't fill a
+ * line and sector misses don't move one, so their misses aren't those of the
+ * stack either.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the engine matches the reference or is skipped, `false` otherwise.
+ */
+static bool check_stack_distance(const CheckTrace *trace, const CheckConfig *config, const CheckResult *expected) {
+    if (config->policy != REPLACEMENT_LRU || trace->sampling.warmup_records != 0
+        || trace->sampling.detail_records != 0 || config->write_policy == WRITE_BACK_NO_ALLOCATE
+        || config->write_policy == WRITE_THROUGH_NO_ALLOCATE || config->sectors > 1) {
+        return true;
+    }
+
+    const int num_lines = config->cache_size * 1024 / config->line_size;
+    const int ways = config->associativity == 0 ? num_lines : config->associativity;
+    StackDistance *stack_distance = initialize_stack_distance(num_lines / ways, config->line_size);
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        access_stack_distance(stack_distance, &trace->ops[i]);
+    }
+    const uint64_t misses = get_stack_distance_misses(stack_distance, ways);
+    free_stack_distance(stack_distance);
+
+    if (misses == expected->stats.misses) {
+        return true;
+    }
+    char text[96];
+    describe_config(config, text, sizeof(text));
+    fprintf(stderr, "%s, %s: mrc differs from the reference\n  misses %" PRIu64 " (expected %" PRIu64 ")\n",
+            trace->path, text, misses, expected->stats.misses);
+    return false;
+}
+
+/**
+ * @brief Counts the prefetched lines that no demand access has used or replaced yet.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @return The number of pending lines.
+ */
+static uint64_t count_pending_prefetches(const Prefetcher *prefetcher) {
+    uint64_t pending = 0;
+    for (size_t i = 0; i < prefetcher->capacity; i++) {
+        pending += prefetcher->pending_lines[i].key != 0;
+    }
+    return pending;
+}
+
+/**
+ * @brief Simulates a trace through a cache with a prefetcher, access by access or in batches.
+ * Consecutive records of the same sampling phase form a batch.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param cache Pointer to the Cache object with the prefetcher.
+ * @param is_batched Indicates whether the records are given to access_cache_batch and warm_cache_batch.
+ * @param hits Array receiving the result of every measured record.
+ */
+static void run_prefetching(const CheckTrace *trace, Cache *cache, const bool is_batched, bool *hits) {
+    uint8_t hit_bitmap[(CHECK_BATCH_SIZE + 7) / 8];
+    for (size_t start = 0; start < trace->num_ops;) {
+        size_t count = 1;
+        while (is_batched && start + count < trace->num_ops && count < CHECK_BATCH_SIZE
+               && trace->is_measured[start + count] == trace->is_measured[start]) {
+            count++;
+        }
+
+        if (!trace->is_measured[start]) {
+            if (is_batched) {
+                warm_cache_batch(cache, &trace->ops[start], count);
+            } else {
+                warm_cache(cache, &trace->ops[start]);
+            }
+        } else if (!is_batched) {
+            hits[start] = access_cache(cache, &trace->ops[start]);
+        } else {
+            access_cache_batch(cache, &trace->ops[start], count, hit_bitmap);
+            for (size_t i = 0; i < count; i++) {
+                hits[start + i] = (hit_bitmap[i / 8] >> (i % 8)) & 1;
+            }
+        }
+        start += count;
+    }
+}
+
+/**
+ * @brief Checks the batch kernel of a prefetcher against its single-access kernel and checks its accounting.
+ * Prefetched lines differ from the demand lines of the reference, so the
+ * batches are compared with access_cache on a cache with the same
+ * prefetcher, access by access and including the prefetch counts. Every
+ * configuration gets one of the models with its own degree and distance.
+ * Without warming records, every prefetch must end up useful, late, useless
+ * or still pending; warming trains the prefetcher without counting.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param index Index of the configuration, selecting the prefetcher.
+ * @return `true` if the kernels agree and the counts add up, `false` otherwise.
+ */
+static bool check_prefetch(const CheckTrace *trace, const CheckConfig *config, const int index) {
+    const PrefetchOptions options = {(PrefetchPolicy)(PREFETCH_NEXT_LINE + index % 3), 1 + index % 4,
+                                     1 + index / 3 % 3};
+    Cache *single = create_cache(config);
+    Cache *batched = create_cache(config);
+    attach_prefetcher(single, &options);
+    attach_prefetcher(batched, &options);
+    bool *expected_hits = allocate_check_memory(trace->num_ops, sizeof(bool));
+    bool *hits = allocate_check_memory(trace->num_ops, sizeof(bool));
+    run_prefetching(trace, single, false, expected_hits);
+    run_prefetching(trace, batched, true, hits);
+
+    char engine[64];
+    snprintf(engine, sizeof(engine), "prefetch %s degree %d distance %d", get_prefetch_policy_name(options.policy),
+             options.degree, options.distance);
+    bool is_ok = true;
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        if (trace->is_measured[i] && hits[i] != expected_hits[i]) {
+            char text[96];
+            describe_config(config, text, sizeof(text));
+            fprintf(stderr, "%s, %s: %s batch reports a %s for record %zu (%c 0x%" PRIx64 "), access_cache a %s\n",
+                    trace->path, text, engine, hits[i] ? "hit" : "miss", i, trace->ops[i].access_type,
+                    trace->ops[i].address, hits[i] ? "miss" : "hit");
+            is_ok = false;
+            break;
+        }
+    }
+
+    const CheckResult expected = get_cache_result(trace, single);
+    const CheckResult actual = get_cache_result(trace, batched);
+    is_ok = compare_result(trace, config, engine, &expected, &actual) && is_ok;
+    const CacheStats *a = &batched->stats;
+    const CacheStats *e = &single->stats;
+    if (a->prefetches != e->prefetches || a->useful_prefetches != e->useful_prefetches
+        || a->late_prefetches != e->late_prefetches || a->useless_prefetches != e->useless_prefetches
+        || a->prefetch_wait_cycles != e->prefetch_wait_cycles) {
+        char text[96];
+        describe_config(config, text, sizeof(text));
+        fprintf(stderr, "%s, %s: %s batch differs from access_cache\n"
+                "  prefetches %" PRIu64 " (expected %" PRIu64 "), useful %" PRIu64 " (expected %" PRIu64 "),"
+                " late %" PRIu64 " (expected %" PRIu64 "), useless %" PRIu64 " (expected %" PRIu64 "),"
+                " wait cycles %" PRIu64 " (expected %" PRIu64 ")\n",
+                trace->path, text, engine, a->prefetches, e->prefetches, a->useful_prefetches,
+                e->useful_prefetches, a->late_prefetches, e->late_prefetches, a->useless_prefetches,
+                e->useless_prefetches, a->prefetch_wait_cycles, e->prefetch_wait_cycles);
+        is_ok = false;
+    }
+
+    bool is_measured = true;
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        is_measured = is_measured && trace->is_measured[i];
+    }
+    const uint64_t pending = count_pending_prefetches(single->prefetcher);
+    if (is_measured && e->prefetches != e->useful_prefetches + e->late_prefetches + e->useless_prefetches + pending) {
+        char text[96];
+        describe_config(config, text, sizeof(text));
+        fprintf(stderr, "%s, %s: %s loses prefetches\n"
+                "  prefetches %" PRIu64 ", useful %" PRIu64 ", late %" PRIu64 ", useless %" PRIu64
+                ", pending %" PRIu64 "\n",
+                trace->path, text, engine, e->prefetches, e->useful_prefetches, e->late_prefetches,
+                e->useless_prefetches, pending);
+        is_ok = false;
+    }
+
+    free(expected_hits);
+    free(hits);
+    free_cache(single);
+    free_cache(batched);
+    return is_ok;
+}
+
+/**
+ * @brief Checks the timing model with one MSHR and a window of one instruction against the serialized cycles.
+ * Such a core still waits for every fill, only the first instruction after
+ * a miss runs while the fill is in flight. Free write-backs leave out the
+ * write buffer, so the model must take the instructions plus the miss
+ * penalties of the reference, less one cycle for every miss followed by an
+ * instruction before the next one, and report one full penalty per miss
+ * (write-back, write-allocate without write-combining buffer only, like the
+ * command line).
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param config Pointer to the CheckConfig object.
+ * @param hits Results of the reference for every record.
+ * @param expected Pointer to the CheckResult object of the reference.
+ * @return `true` if the model matches the reference or is skipped, `false` otherwise.
+ */
+static bool check_timing(const CheckTrace *trace, const CheckConfig *config, const bool *hits,
+                         const CheckResult *expected) {
+    if (config->write_policy != WRITE_BACK_ALLOCATE || config->combining_entries > 0) {
+        return true;
+    }
+
+    Cache *cache = create_cache(config);
+    TimingModel *timing = initialize_timing_model(&(TimingOptions){1, 1, 1}, cache);
+    timing->dirty_wb_penalty = 0;
+    bool is_ok = true;
+    bool is_fill_pending = false;   // A miss hasn't been followed by an instruction yet
+    uint64_t overlapped = 0;        // Misses followed by an instruction before the next miss
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        if (!trace->is_measured[i]) {
+            warm_cache(cache, &trace->ops[i]);
+            continue;
+        }
+        if (is_fill_pending && trace->ops[i].instructions > 0) {
+            overlapped++;
+            is_fill_pending = false;
+        }
+        if (access_cache_timed(timing, cache, &trace->ops[i]) != hits[i] && is_ok) {
+            report_access(trace, config, "timing", i, !hits[i]);
+            is_ok = false;
+        }
+        is_fill_pending = is_fill_pending || !hits[i];
+    }
+
+    const uint64_t cycles = finish_timing_model(timing);
+    const CheckResult actual = get_cache_result(trace, cache);
+    is_ok = compare_result(trace, config, "timing", expected, &actual) && is_ok;
+    const uint64_t misses = expected->stats.misses;
+    const uint64_t expected_cycles = trace->instruction_count + misses * CHECK_MISS_PENALTY - overlapped;
+    if (cycles != expected_cycles || timing->stats.issued_misses != misses
+        || timing->stats.miss_cycles != misses * CHECK_MISS_PENALTY) {
+        char text[96];
+        describe_config(config, text, sizeof(text));
+        fprintf(stderr, "%s, %s: timing differs from the serialized model\n"
+                "  cycles %" PRIu64 " (expected %" PRIu64 "), issued misses %" PRIu64 " (expected %" PRIu64 "),"
+                " miss cycles %" PRIu64 " (expected %" PRIu64 ")\n",
+                trace->path, text, cycles, expected_cycles, timing->stats.issued_misses, misses,
+                timing->stats.miss_cycles, misses * CHECK_MISS_PENALTY);
+        is_ok = false;
+    }
+
+    free_timing_model(timing);
+    free_cache(cache);
+    return is_ok;
+}
+
+/**
+ * @brief A multi-core system of the suite: the configuration of the private and of the shared caches.
+ */
+typedef struct CheckMulticoreConfig {
+    CheckConfig private_config;     // Configuration of the private cache of every core
+    CheckConfig shared_config;      // Configuration of the shared cache
+    CoherenceProtocol protocol;     // Protocol keeping the private caches coherent
+} CheckMulticoreConfig;
+
+/**
+ * @brief Checks simulate_multicore against the reference on a system with one core per trace.
+ * The reference picks the core with the lowest instruction count after its
+ * next record (the lower core on ties) and forwards the dirty write-back and
+ * the miss of the record to the shared cache right away, which is the order
+ * in which the engine merges its queues. Coherent systems also forward the
+ * write-back of a downgraded copy and compare the coherence traffic.
+ *
+ * @param traces The traces, one per core.
+ * @param num_traces Number of traces, at most MULTICORE_MAX_CORES.
+ * @param config Pointer to the CheckMulticoreConfig object.
+ * @return `true` if the engine matches the reference, `false` otherwise.
+ */
+static bool check_multicore(const CheckTrace *traces, const int num_traces, const CheckMulticoreConfig *config) {
+    ReferenceCache *privates[MULTICORE_MAX_CORES];
+    size_t next_ops[MULTICORE_MAX_CORES] = {0};
+    uint64_t instructions[MULTICORE_MAX_CORES] = {0};
+    uint64_t shared_hits[MULTICORE_MAX_CORES] = {0};
+    uint64_t memory_writes[MULTICORE_MAX_CORES] = {0};
+    CoherenceStats coherence[MULTICORE_MAX_CORES] = {0};
+    ReferenceCache *shared = create_reference(&config->shared_config);
+    for (int c = 0; c < num_traces; c++) {
+        privates[c] = create_reference(&config->private_config);
+    }
+
+    for (;;) {
+        int core = -1;
+        for (int c = 0; c < num_traces; c++) {
+            if (next_ops[c] < traces[c].num_ops
+                && (core < 0 || instructions[c] + (uint64_t)traces[c].ops[next_ops[c]].instructions
+                                < instructions[core] + (uint64_t)traces[core].ops[next_ops[core]].instructions)) {
+                core = c;
+            }
+        }
+        if (core < 0) {
+            break;
+        }
+
+        const CacheOp *cache_op = &traces[core].ops[next_ops[core]++];
+        instructions[core] += (uint64_t)cache_op->instructions;
+        ReferenceCache *reference = privates[core];
+        CoherenceAccess access = {false, true, 0, {0, 0}};
+        if (config->protocol != COHERENCE_NONE) {
+            access = access_coherent_reference(privates, num_traces, core, config->protocol, cache_op,
+                                               &coherence[core]);
+        } else if (access_reference(reference, cache_op, true)) {
+            continue;
+        } else if (reference->victim_dirty) {
+            access.write_backs[access.num_write_backs++] = reference->victim_line << reference->log_line_size;
+        }
+
+        // Write-backs only install the line, they are neither hits nor misses
+        for (int i = 0; i < access.num_write_backs; i++) {
+            const CacheOp write_back = initialize_cache_operation('s', access.write_backs[i], 0);
+            access_reference(shared, &write_back, false);
+            memory_writes[core] += shared->victim_dirty;
+        }
+        if (!access.needs_fill) {
+            continue;
+        }
+        const CacheOp fill_op = initialize_cache_operation('l', cache_op->address, 0);
+        shared_hits[core] += access_reference(shared, &fill_op, true);
+        memory_writes[core] += shared->victim_dirty;
+    }
+
+    Multicore *multicore = initialize_multicore(create_cache(&config->shared_config), 0, CHECK_SHARED_LATENCY,
+                                                CHECK_MISS_PENALTY, CHECK_DIRTY_WB_PENALTY, config->protocol);
+    for (int c = 0; c < num_traces; c++) {
+        add_multicore_core(multicore, traces[c].path, create_cache(&config->private_config));
+    }
+    simulate_multicore(multicore);
+
+    bool is_ok = true;
+    char text[96];
+    describe_config(&config->private_config, text, sizeof(text));
+    for (int c = 0; c < num_traces; c++) {
+        const MulticoreCore *actual = &multicore->cores[c];
+        const CacheStats *expected = &privates[c]->stats;
+        const CoherenceStats *expected_coherence = &coherence[c];
+        const uint64_t fills = expected->misses - expected_coherence->transfers;
+        const uint64_t shared_misses = fills - shared_hits[c];
+        const uint64_t cycles = traces[c].instruction_count
+                                + (expected->misses + expected_coherence->upgrades) * CHECK_SHARED_LATENCY
+                                + shared_misses * CHECK_MISS_PENALTY + memory_writes[c] * CHECK_DIRTY_WB_PENALTY;
+        if (actual->cache->stats.hits != expected->hits || actual->cache->stats.misses != expected->misses
+            || actual->cache->stats.dirty_write_backs != expected->dirty_write_backs
+            || actual->shared_hits != shared_hits[c] || actual->shared_misses != shared_misses
+            || actual->memory_writes != memory_writes[c] || actual->trace_stats.cycle_count != cycles
+            || memcmp(&actual->coherence, expected_coherence, sizeof(CoherenceStats)) != 0) {
+            fprintf(stderr, "%s, %s, %s: multicore differs from the reference on core %d\n"
+                    "  misses %" PRIu64 " (expected %" PRIu64 "), shared misses %" PRIu64 " (expected %" PRIu64
+                    "),\n  memory writes %" PRIu64 " (expected %" PRIu64 "), cycles %" PRIu64 " (expected %"
+                    PRIu64 "),\n  coherence misses %" PRIu64 " (expected %" PRIu64 "), invalidations %" PRIu64
+                    " (expected %" PRIu64 ")\n", traces[c].path, text,
+                    get_coherence_protocol_name(config->protocol), c, actual->cache->stats.misses,
+                    expected->misses, actual->shared_misses, shared_misses, actual->memory_writes,
+                    memory_writes[c], actual->trace_stats.cycle_count, cycles, actual->coherence.coherence_misses,
+                    expected_coherence->coherence_misses, actual->coherence.invalidations,
+                    expected_coherence->invalidations);
+            is_ok = false;
+        }
+        free_reference(privates[c]);
+    }
+
+    const CacheStats *actual_shared = &multicore->shared_cache->stats;
+    if (actual_shared->hits != shared->stats.hits || actual_shared->misses != shared->stats.misses) {
+        describe_config(&config->shared_config, text, sizeof(text));
+        fprintf(stderr, "%s: multicore differs from the reference in the shared cache\n"
+                "  hits %" PRIu64 " (expected %" PRIu64 "), misses %" PRIu64 " (expected %" PRIu64 ")\n",
+                text, actual_shared->hits, shared->stats.hits, actual_shared->misses, shared->stats.misses);
+        is_ok = false;
+    }
+
+    free_reference(shared);
+    free_multicore(multicore);
+    return is_ok;
+}
+
+// --- Traces ---
+
+/**
+ * @brief Decodes a trace file and selects its measured records.
+ *
+ * @param path Path of the trace file.
+ * @param sampling Pointer to the TraceSampling object selecting the measured records.
+ * @param trace Pointer to the CheckTrace object receiving the trace.
+ */
+static void load_check_trace(const char *path, const TraceSampling *sampling, CheckTrace *trace) {
+    size_t capacity = 1 << 16;
+    *trace = (CheckTrace){path, allocate_check_memory(capacity, sizeof(CacheOp)), 0, NULL, *sampling, 0};
+
+    TraceReader *reader = open_trace(path);
+    CacheOp cache_op;
+    while (read_trace_operation(reader, &cache_op)) {
+        if (trace->num_ops == capacity) {
+            capacity *= 2;
+            trace->ops = (CacheOp *)realloc(trace->ops, capacity * sizeof(CacheOp));
+            if (!trace->ops) {
+                fprintf(stderr, "Failed to allocate memory for the checks.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        trace->ops[trace->num_ops++] = cache_op;
+    }
+    close_trace(reader);
+
+    trace->is_measured = allocate_check_memory(trace->num_ops, sizeof(bool));
+    long phase_records = 0;
+    bool is_measured = true;
+    for (size_t i = 0; i < trace->num_ops; i++) {
+        if (phase_records == 0) {
+            phase_records = get_sampling_phase(sampling, (long)i, &is_measured);
+        }
+        phase_records--;
+        trace->is_measured[i] = is_measured;
+        if (is_measured) {
+            trace->instruction_count += (uint64_t)trace->ops[i].instructions;
+        }
+    }
+}
+
+/**
+ * @brief Checks all engines against the reference on a trace.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ * @param configs The configurations.
+ * @param num_configs Number of configurations, at most CHECK_MAX_CONFIGS.
+ * @return `true` if all engines match the reference, `false` otherwise.
+ */
+static bool check_trace(const CheckTrace *trace, const CheckConfig *configs, const int num_configs) {
+    CheckResult expected[CHECK_MAX_CONFIGS];
+    MissClassStats classes[CHECK_MAX_CONFIGS];
+    bool *hits = allocate_check_memory(trace->num_ops, sizeof(bool));
+    bool is_ok = true;
+
+    for (int c = 0; c < num_configs; c++) {
+        run_reference(trace, &configs[c], hits, &expected[c]);
+        is_ok = check_kernel(trace, &configs[c], hits, &expected[c]) && is_ok;
+        is_ok = check_batch(trace, &configs[c], hits, &expected[c]) && is_ok;
+        is_ok = check_library(trace, &configs[c], hits, &expected[c]) && is_ok;
+        is_ok = check_partitioned(trace, &configs[c], &expected[c]) && is_ok;
+        is_ok = check_stack_distance(trace, &configs[c], &expected[c]) && is_ok;
+        is_ok = check_classify(trace, &configs[c], hits, &classes[c]) && is_ok;
+        is_ok = check_prefetch(trace, &configs[c], c) && is_ok;
+        is_ok = check_timing(trace, &configs[c], hits, &expected[c]) && is_ok;
+    }
+    is_ok = check_sweep(trace, configs, expected, classes, num_configs) && is_ok;
+
+    free(hits);
+    return is_ok;
+}
+
+/**
+ * @brief Frees the records of a trace.
+ *
+ * @param trace Pointer to the CheckTrace object.
+ */
+static void free_check_trace(CheckTrace *trace) {
+    free(trace->ops);
+    free(trace->is_measured);
+}
+
+/**
+ * @brief Lists the fixed matrix of configurations of the bundled traces.
+ * Every associativity from direct mapped to fully associative is combined
+ * with every replacement policy, which covers the specialized, generic and
+ * line index kernels of all policies. The other write policies run on a
+ * direct-mapped, a set associative and a fully associative cache, with and
+ * without a write-combining buffer, and so do sectored lines, with a sector
+ * of a single byte on the fully associative cache.
+ *
+ * @param configs Array of at least CHECK_MAX_CONFIGS configurations receiving the matrix.
+ * @return Number of configurations.
+ */
+static int list_matrix_configs(CheckConfig *configs) {
+    static const int associativities[] = {2, 4, 8, 16, 32, 0};
+    int num_configs = 0;
+    configs[num_configs++] = (CheckConfig){1, 8, 64, REPLACEMENT_LRU};
+    for (size_t a = 0; a < sizeof(associativities) / sizeof(associativities[0]); a++) {
+        for (int policy = 0; policy < REPLACEMENT_POLICY_COUNT; policy++) {
+            configs[num_configs++] = (CheckConfig){associativities[a], 8, 64, (ReplacementPolicy)policy};
+        }
+    }
+    for (int write_policy = WRITE_BACK_NO_ALLOCATE; write_policy < WRITE_POLICY_COUNT; write_policy++) {
+        configs[num_configs++] = (CheckConfig){1, 8, 64, REPLACEMENT_LRU, (WritePolicy)write_policy, 0};
+        configs[num_configs++] = (CheckConfig){4, 8, 64, REPLACEMENT_PLRU, (WritePolicy)write_policy, 8};
+        configs[num_configs++] = (CheckConfig){0, 8, 64, REPLACEMENT_LRU, (WritePolicy)write_policy, 0};
+    }
+    configs[num_configs++] = (CheckConfig){1, 8, 64, REPLACEMENT_LRU, WRITE_BACK_ALLOCATE, 0, 4};
+    configs[num_configs++] = (CheckConfig){4, 8, 64, REPLACEMENT_SRRIP, WRITE_BACK_NO_ALLOCATE, 0, 8};
+    configs[num_configs++] = (CheckConfig){8, 8, 64, REPLACEMENT_PLRU, WRITE_THROUGH_ALLOCATE, 8, 16};
+    configs[num_configs++] = (CheckConfig){0, 8, 32, REPLACEMENT_LRU, WRITE_BACK_ALLOCATE, 0, 32};
+    return num_configs;
+}
+
+/**
+ * @brief Creates a random valid configuration of the fuzzer.
+ *
+ * @return The configuration.
+ */
+static CheckConfig create_fuzz_config(void) {
+    CheckConfig config;
+    config.line_size = 1 << fuzz_range(2, 7);
+    config.cache_size = 1 << fuzz_range(0, 6);
+    const int num_lines = config.cache_size * 1024 / config.line_size;
+
+    // Favor the specialized associativities and keep fully associative caches rare, they are slow to check
+    const long choice = fuzz_range(0, 9);
+    if (choice == 0 && num_lines <= 1024) {
+        config.associativity = 0;
+    } else if (choice == 1) {
+        config.associativity = 1;
+    } else {
+        config.associativity = 1 << fuzz_range(1, 6);
+        while (config.associativity > num_lines) {
+            config.associativity /= 2;
+        }
+    }
+    config.policy = (ReplacementPolicy)fuzz_range(0, REPLACEMENT_POLICY_COUNT - 1);
+
+    // Half of the configurations take another write policy, half of those with a write-combining buffer
+    config.write_policy = fuzz_range(0, 1) ? WRITE_BACK_ALLOCATE
+                                           : (WritePolicy)fuzz_range(WRITE_BACK_NO_ALLOCATE, WRITE_POLICY_COUNT - 1);
+    config.combining_entries = config.write_policy != WRITE_BACK_ALLOCATE && fuzz_range(0, 1)
+                               ? (int)fuzz_range(1, CACHE_MAX_COMBINING_ENTRIES) : 0;
+
+    // A quarter of the configurations split their lines into sectors
+    const int max_sectors = config.line_size < CACHE_MAX_SECTORS ? config.line_size : CACHE_MAX_SECTORS;
+    config.sectors = fuzz_range(0, 3) == 0 ? 1 << fuzz_range(1, log2_check(max_sectors)) : 1;
+    return config;
+}
+
+/**
+ * @brief Writes a random text trace mixing a hot region, streams and random accesses.
+ * Terminates the program if the file can't be written.
+ *
+ * @param path Path of the trace file.
+ * @return Number of records written.
+ */
+static long write_fuzz_trace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror("Failed to create fuzz trace");
+        exit(EXIT_FAILURE);
+    }
+
+    const long num_records = fuzz_range(FUZZ_MIN_RECORDS, FUZZ_MAX_RECORDS);
+    const uint64_t base = (uint64_t)fuzz_range(0, 1L << 30) << 12;
+    const uint64_t hot_size = (uint64_t)1 << fuzz_range(8, 17);
+    const uint64_t cold_size = (uint64_t)1 << fuzz_range(14, 22);
+    uint64_t stream = base + cold_size;
+    for (long i = 0; i < num_records; i++) {
+        uint64_t address;
+        const long pattern = fuzz_range(0, 9);
+        if (pattern < 5) {
+            address = base + (uint64_t)fuzz_range(0, (long)hot_size - 1);
+        } else if (pattern < 8) {
+            stream += (uint64_t)fuzz_range(1, 16) * 4;
+            address = stream;
+        } else {
+            address = base + (uint64_t)fuzz_range(0, (long)cold_size - 1);
+        }
+        const long type = fuzz_range(0, 9);
+        fprintf(file, "%c 0x%" PRIx64 " %ld\n", type < 6 ? 'l' : type < 9 ? 's' : 'i', address, fuzz_range(0, 9));
+    }
+
+    if (fclose(file) != 0) {
+        perror("Failed to write fuzz trace");
+        exit(EXIT_FAILURE);
+    }
+    return num_records;
+}
+
+/**
+ * @brief Checks all engines on random traces, geometries, policies and sampling.
+ *
+ * @param num_traces Number of random traces.
+ * @return `true` if all engines match the reference, `false` otherwise.
+ */
+static bool run_fuzzer(const int num_traces) {
+    char path[] = "/tmp/calc-check-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("Failed to create fuzz trace");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    bool is_ok = true;
+    for (int t = 0; t < num_traces && is_ok; t++) {
+        const long num_records = write_fuzz_trace(path);
+
+        // Half of the traces warm the caches first and measure only in intervals
+        TraceSampling sampling = {0, 0, 0};
+        if (fuzz_range(0, 1)) {
+            sampling.warmup_records = fuzz_range(0, num_records / 4);
+            sampling.detail_records = fuzz_range(0, 2000);
+            sampling.fast_forward_records = sampling.detail_records > 0 ? fuzz_range(0, 2000) : 0;
+        }
+
+        CheckConfig configs[FUZZ_CONFIGS];
+        for (int c = 0; c < FUZZ_CONFIGS; c++) {
+            configs[c] = create_fuzz_config();
+        }
+
+        CheckTrace trace;
+        load_check_trace(path, &sampling, &trace);
+        is_ok = check_trace(&trace, configs, FUZZ_CONFIGS);
+        free_check_trace(&trace);
+    }
+
+    // Keep the trace of a failure for reproduction
+    if (is_ok) {
+        unlink(path);
+    } else {
+        fprintf(stderr, "The failing fuzz trace is kept in %s.\n", path);
+    }
+    return is_ok;
+}
+
+// --- Main Function ---
+
+/**
+ * @brief Runs the suite.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments.
+ * @return `EXIT_SUCCESS` if all engines match the reference, `EXIT_FAILURE` otherwise.
+ */
+int main(const int argc, const char *argv[]) {
+    int num_fuzz_traces = 0;
+    uint64_t seed = 1;
+
+    int first_trace = 1;
+    while (first_trace + 1 < argc && strncmp(argv[first_trace], "--", 2) == 0) {
+        char *endptr;
+        const long long value = strtoll(argv[first_trace + 1], &endptr, 10);
+        if (*endptr != '\0' || value < 0
+            || (strcmp(argv[first_trace], "--fuzz") != 0 && strcmp(argv[first_trace], "--seed") != 0)) {
+            break;
+        }
+        if (strcmp(argv[first_trace], "--fuzz") == 0) {
+            num_fuzz_traces = (int)value;
+        } else {
+            seed = (uint64_t)value;
+        }
+        first_trace += 2;
+    }
+    if ((first_trace < argc && strncmp(argv[first_trace], "--", 2) == 0)
+        || (first_trace == argc && num_fuzz_traces == 0)) {
+        printf("Usage: %s [--fuzz <traces>] [--seed <seed>] [<trace>...]\n"
+               "  checks every engine against the reference model on the traces and on <traces> random traces\n"
+               "  with %d random configurations each (default: 0); <seed> selects the random traces (default: 1)\n",
+               argv[0], FUZZ_CONFIGS);
+        return EXIT_FAILURE;
+    }
+
+    bool is_ok = true;
+    CheckConfig configs[CHECK_MAX_CONFIGS];
+    const int num_configs = list_matrix_configs(configs);
+    const TraceSampling no_sampling = {0, 0, 0};
+    for (int i = first_trace; i < argc; i++) {
+        CheckTrace trace;
+        load_check_trace(argv[i], &no_sampling, &trace);
+        const bool is_trace_ok = check_trace(&trace, configs, num_configs);
+        printf("%-24s %8zu records, %2d configurations: %s\n", argv[i], trace.num_ops, num_configs,
+               is_trace_ok ? "OK" : "FAILED");
+        free_check_trace(&trace);
+        is_ok = is_trace_ok && is_ok;
+    }
+
+    // Simulate the traces side by side on one core each
+    const int num_cores = argc - first_trace < MULTICORE_MAX_CORES ? argc - first_trace : MULTICORE_MAX_CORES;
+    if (num_cores > 1) {
+        static const CheckMulticoreConfig systems[] = {
+            {{1, 8, 64, REPLACEMENT_LRU}, {8, 64, 64, REPLACEMENT_LRU}, COHERENCE_NONE},
+            {{4, 16, 64, REPLACEMENT_PLRU}, {16, 256, 64, REPLACEMENT_SRRIP}, COHERENCE_NONE},
+            {{2, 8, 32, REPLACEMENT_BRRIP}, {0, 32, 32, REPLACEMENT_FIFO}, COHERENCE_NONE},
+            {{4, 8, 64, REPLACEMENT_LRU}, {8, 64, 64, REPLACEMENT_PLRU}, COHERENCE_MESI},
+            {{2, 16, 32, REPLACEMENT_FIFO}, {16, 128, 32, REPLACEMENT_LRU}, COHERENCE_MOESI},
+        };
+        const int num_systems = (int)(sizeof(systems) / sizeof(systems[0]));
+        CheckTrace traces[MULTICORE_MAX_CORES];
+        for (int c = 0; c < num_cores; c++) {
+            load_check_trace(argv[first_trace + c], &no_sampling, &traces[c]);
+        }
+        bool is_multicore_ok = true;
+        for (int s = 0; s < num_systems; s++) {
+            is_multicore_ok = check_multicore(traces, num_cores, &systems[s]) && is_multicore_ok;
+
+            // The first trace on two cores shares all of its lines
+            if (systems[s].protocol != COHERENCE_NONE) {
+                const CheckTrace twins[2] = {traces[0], traces[0]};
+                is_multicore_ok = check_multicore(twins, 2, &systems[s]) && is_multicore_ok;
+            }
+        }
+        for (int c = 0; c < num_cores; c++) {
+            free_check_trace(&traces[c]);
+        }
+        printf("%-24s %8d cores,   %2d systems: %s\n", "multicore", num_cores, num_systems,
+               is_multicore_ok ? "OK" : "FAILED");
+        is_ok = is_multicore_ok && is_ok;
+    }
+
+    if (num_fuzz_traces > 0) {
+        fuzz_state = seed * 0x9E3779B97F4A7C15ULL | 1;
+        const bool is_fuzz_ok = run_fuzzer(num_fuzz_traces);
+        printf("%-24s %8d traces,  %2d configurations each (seed %" PRIu64 "): %s\n", "fuzzer", num_fuzz_traces,
+               FUZZ_CONFIGS, seed, is_fuzz_ok ? "OK" : "FAILED");
+        is_ok = is_fuzz_ok && is_ok;
+    }
+
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
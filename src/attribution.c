@@ -0,0 +1,286 @@
+/***************************************************************************/
+/**
+ * @file attribution.c
+ * @brief Implementation of the miss attribution of the cache simulator.
+ *
+ * This source file provides the implementation for the attribution defined in
+ * attribution.h. The pages are kept in an open-addressing hash table
+ * (hashtable.h) that doubles its capacity before it gets more than half full.
+ * The report sorts all pages once at the end, which is negligible compared to
+ * the simulation.
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "attribution.h"
+#include "hashtable.h"
+
+/**
+ * @brief A page or region of the report with its counts.
+ */
+typedef struct AttributionEntry {
+    uint64_t address;               // First address of the page or region
+    const char *name;               // Name of the region, NULL for pages
+    AttributionCounts counts;       // Counts charged to the page or region
+} AttributionEntry;
+
+// --- Helper Functions ---
+
+/**
+ * @brief Finds the slot of a key in the page table, or the empty slot where it belongs.
+ *
+ * @param attribution Pointer to the Attribution object.
+ * @param key Page number + 1.
+ * @return The slot of the key.
+ */
+static size_t find_page_slot(const Attribution *attribution, const uint64_t key) {
+    return find_hash_slot(attribution->pages, sizeof(AttributionPage), attribution->capacity, key);
+}
+
+/**
+ * @brief Doubles the capacity of the page table and reinserts all pages.
+ *
+ * @param attribution Pointer to the Attribution object.
+ */
+static void grow_page_table(Attribution *attribution) {
+    AttributionPage *old_pages = attribution->pages;
+    const size_t old_capacity = attribution->capacity;
+
+    attribution->capacity *= 2;
+    attribution->pages = allocate_or_exit(attribution->capacity, sizeof(AttributionPage), "miss attribution");
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_pages[i].key != 0) {
+            attribution->pages[find_page_slot(attribution, old_pages[i].key)] = old_pages[i];
+        }
+    }
+
+    free(old_pages);
+}
+
+/**
+ * @brief Returns the counts of the page or region containing an address.
+ * Pages are added to the table on their first use.
+ *
+ * @param attribution Pointer to the Attribution object.
+ * @param address The address.
+ * @return Pointer to the counts of the page or region.
+ */
+static AttributionCounts* find_attribution_counts(Attribution *attribution, const uint64_t address) {
+    if (attribution->regions) {
+        // Binary search for the last region starting at or before the address
+        int low = 0;
+        int high = attribution->num_regions;
+        while (low < high) {
+            const int middle = low + (high - low) / 2;
+            if (attribution->regions[middle].start <= address) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low > 0 && address < attribution->regions[low - 1].end) {
+            return &attribution->regions[low - 1].counts;
+        }
+        return &attribution->other;
+    }
+
+    const uint64_t key = (address >> attribution->log_page_size) + 1;
+    size_t slot = find_page_slot(attribution, key);
+    if (attribution->pages[slot].key == 0) {
+        if (2 * (attribution->num_pages + 1) > attribution->capacity) {
+            grow_page_table(attribution);
+            slot = find_page_slot(attribution, key);
+        }
+        attribution->pages[slot].key = key;
+        attribution->num_pages++;
+    }
+    return &attribution->pages[slot].counts;
+}
+
+/**
+ * @brief Compares two regions by their start address for qsort.
+ *
+ * @param a Pointer to the first AttributionRegion.
+ * @param b Pointer to the second AttributionRegion.
+ * @return A negative, zero or positive value like strcmp.
+ */
+static int compare_regions(const void *a, const void *b) {
+    const AttributionRegion *region_a = (const AttributionRegion *)a;
+    const AttributionRegion *region_b = (const AttributionRegion *)b;
+    return (region_a->start > region_b->start) - (region_a->start < region_b->start);
+}
+
+/**
+ * @brief Reads the user-defined regions of a file.
+ * Every non-empty line that doesn't start with `#` has the form
+ * `<name> <start> <end>` with hexadecimal addresses, the end being exclusive.
+ * Terminates the program if the file is invalid or regions overlap.
+ *
+ * @param attribution Pointer to the Attribution object receiving the sorted regions.
+ * @param path Path of the region file.
+ */
+static void read_attribution_regions(Attribution *attribution, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Failed to open region file");
+        exit(EXIT_FAILURE);
+    }
+
+    int capacity = 16;
+    attribution->regions = allocate_or_exit((size_t)capacity, sizeof(AttributionRegion), "miss attribution");
+    attribution->num_regions = 0;
+
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        const char *start = line + strspn(line, " \t");
+        if (*start == '#' || *start == '\n' || *start == '\0') {
+            continue;
+        }
+
+        if (attribution->num_regions == capacity) {
+            capacity *= 2;
+            attribution->regions = reallocate_or_exit(attribution->regions, (size_t)capacity, sizeof(AttributionRegion),
+                                                      "miss attribution");
+        }
+
+        AttributionRegion *region = &attribution->regions[attribution->num_regions];
+        *region = (AttributionRegion){"", 0, 0, {0, 0}};
+        if (sscanf(start, "%63s %" SCNx64 " %" SCNx64, region->name, &region->start, &region->end) != 3
+            || region->start >= region->end) {
+            fprintf(stderr, "Invalid region in line %d of %s.\n", line_number, path);
+            exit(EXIT_FAILURE);
+        }
+        attribution->num_regions++;
+    }
+    fclose(file);
+
+    if (attribution->num_regions == 0) {
+        fprintf(stderr, "No regions defined in %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    qsort(attribution->regions, (size_t)attribution->num_regions, sizeof(AttributionRegion), compare_regions);
+    for (int i = 1; i < attribution->num_regions; i++) {
+        if (attribution->regions[i].start < attribution->regions[i - 1].end) {
+            fprintf(stderr, "Regions %s and %s of %s overlap.\n", attribution->regions[i - 1].name,
+                    attribution->regions[i].name, path);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * @brief Compares two report entries for qsort: most misses first, then most write-backs, then by address.
+ *
+ * @param a Pointer to the first AttributionEntry.
+ * @param b Pointer to the second AttributionEntry.
+ * @return A negative, zero or positive value like strcmp.
+ */
+static int compare_entries(const void *a, const void *b) {
+    const AttributionEntry *entry_a = (const AttributionEntry *)a;
+    const AttributionEntry *entry_b = (const AttributionEntry *)b;
+    if (entry_a->counts.misses != entry_b->counts.misses) {
+        return entry_a->counts.misses < entry_b->counts.misses ? 1 : -1;
+    }
+    if (entry_a->counts.dirty_write_backs != entry_b->counts.dirty_write_backs) {
+        return entry_a->counts.dirty_write_backs < entry_b->counts.dirty_write_backs ? 1 : -1;
+    }
+    return (entry_a->address > entry_b->address) - (entry_a->address < entry_b->address);
+}
+
+/**
+ * @brief Computes the share of a count in percent.
+ *
+ * @param count The count.
+ * @param total The total of all counts.
+ * @return The share in percent, `0` if the total is `0`.
+ */
+static double get_share(const uint64_t count, const uint64_t total) {
+    return total > 0 ? (double) count / total * 100 : 0;
+}
+
+// --- Attribution Functions ---
+
+Attribution* initialize_attribution(const AttributionOptions *options, const Cache *cache) {
+    Attribution *attribution = allocate_or_exit(1, sizeof(Attribution), "miss attribution");
+    attribution->log_page_size = __builtin_ctz((unsigned)options->page_size);
+    attribution->sample_rate = cache->sample_rate;
+
+    if (options->regions_path) {
+        read_attribution_regions(attribution, options->regions_path);
+    } else {
+        attribution->capacity = ATTRIBUTION_INITIAL_CAPACITY;
+        attribution->pages = allocate_or_exit(attribution->capacity, sizeof(AttributionPage), "miss attribution");
+    }
+    return attribution;
+}
+
+void free_attribution(Attribution *attribution) {
+    free(attribution->pages);
+    free(attribution->regions);
+    free(attribution);
+}
+
+void attribute_cache_miss(Attribution *attribution, const Cache *cache, const CacheOp *cache_op) {
+    find_attribution_counts(attribution, cache_op->address)->misses++;
+    attribution->total.misses++;
+
+    const CacheEviction *eviction = &cache->last_eviction;
+    if (eviction->is_valid && eviction->is_dirty) {
+        find_attribution_counts(attribution, eviction->address)->dirty_write_backs++;
+        attribution->total.dirty_write_backs++;
+    }
+}
+
+void print_attribution(const Attribution *attribution, const int top_count) {
+    // Collect all pages or regions with at least one miss or write-back
+    const size_t max_entries = attribution->regions ? (size_t)attribution->num_regions + 1 : attribution->num_pages;
+    AttributionEntry *entries = allocate_or_exit(max_entries, sizeof(AttributionEntry), "miss attribution");
+    size_t num_entries = 0;
+    if (attribution->regions) {
+        for (int i = 0; i < attribution->num_regions; i++) {
+            const AttributionRegion *region = &attribution->regions[i];
+            entries[num_entries++] = (AttributionEntry){region->start, region->name, region->counts};
+        }
+        entries[num_entries++] = (AttributionEntry){UINT64_MAX, "(other)", attribution->other};
+    } else {
+        for (size_t slot = 0; slot < attribution->capacity; slot++) {
+            const AttributionPage *page = &attribution->pages[slot];
+            if (page->key != 0) {
+                const uint64_t address = (page->key - 1) << attribution->log_page_size;
+                entries[num_entries++] = (AttributionEntry){address, NULL, page->counts};
+            }
+        }
+    }
+    qsort(entries, num_entries, sizeof(AttributionEntry), compare_entries);
+
+    const size_t num_printed = (size_t)top_count < num_entries ? (size_t)top_count : num_entries;
+    const uint64_t scale = (uint64_t)attribution->sample_rate;
+    if (attribution->regions) {
+        printf("\nMISS ATTRIBUTION (TOP %zu OF %zu REGIONS%s)\n", num_printed, num_entries,
+               scale > 1 ? ", EXTRAPOLATED" : "");
+    } else {
+        printf("\nMISS ATTRIBUTION (TOP %zu OF %zu PAGES OF %d BYTES%s)\n", num_printed, num_entries,
+               1 << attribution->log_page_size, scale > 1 ? ", EXTRAPOLATED" : "");
+    }
+    printf("%18s %12s %8s %12s %8s\n", attribution->regions ? "Region" : "Page", "Misses", "Share", "Dirty WBs",
+           "Share");
+
+    for (size_t i = 0; i < num_printed; i++) {
+        const AttributionEntry *entry = &entries[i];
+        if (entry->name) {
+            printf("%18s", entry->name);
+        } else {
+            printf("0x%016" PRIx64, entry->address);
+        }
+        printf(" %12" PRIu64 " %7.2f%% %12" PRIu64 " %7.2f%%\n", entry->counts.misses * scale,
+               get_share(entry->counts.misses, attribution->total.misses), entry->counts.dirty_write_backs * scale,
+               get_share(entry->counts.dirty_write_backs, attribution->total.dirty_write_backs));
+    }
+
+    free(entries);
+}
@@ -0,0 +1,126 @@
+/***************************************************************************/
+/**
+ * @file attribution.h
+ * @brief Header file for the miss attribution of the cache simulator.
+ *
+ * The attribution charges every miss of a cache to the page or user-defined
+ * address region of the missing address, and every dirty write-back to the
+ * region of the replaced line. At the end, the regions with the most misses
+ * are reported, which shows the data structures that cause the traffic.
+ *
+ * Pages are counted in an open-addressing hash table with linear probing that
+ * doubles whenever it gets half full. A slot holds the page and its counts,
+ * so charging a page that is already known touches a single cache line. User-defined regions are
+ * sorted by address and found by binary search.
+ *
+ * The attribution is fed with the result of every access and the eviction
+ * record of the cache (see CacheEviction). The access kernels are not
+ * changed, so runs without attribution don't pay anything for it.
+ ******************************************************************************/
+
+#ifndef ATTRIBUTION_H_INCLUDED
+#define ATTRIBUTION_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * @brief Defaults and limits of the attribution.
+ */
+enum {
+    ATTRIBUTION_DEFAULT_PAGE_SIZE = 4096,   // Default size of a page in bytes
+    ATTRIBUTION_INITIAL_CAPACITY = 1 << 16, // Initial number of slots of the page table (power of two)
+    ATTRIBUTION_MAX_NAME = 64,              // Maximum length of a region name including the terminating NUL
+};
+
+/**
+ * @brief Options of the attribution given on the command line.
+ */
+typedef struct AttributionOptions {
+    int top_count;              // Number of regions reported, 0 to disable the attribution
+    int page_size;              // Size of a page in bytes (power of two)
+    const char *regions_path;   // File with user-defined regions, NULL to attribute to pages
+} AttributionOptions;
+
+/**
+ * @brief Misses and dirty write-backs charged to a page or region.
+ */
+typedef struct AttributionCounts {
+    uint64_t misses;            // Number of misses of addresses in the region
+    uint64_t dirty_write_backs; // Number of dirty write-backs of lines in the region
+} AttributionCounts;
+
+/**
+ * @brief A slot of the page table.
+ */
+typedef struct AttributionPage {
+    uint64_t key;               // Page number + 1, 0 if the slot is empty
+    AttributionCounts counts;   // Counts charged to the page
+} AttributionPage;
+
+/**
+ * @brief A user-defined address region.
+ */
+typedef struct AttributionRegion {
+    char name[ATTRIBUTION_MAX_NAME];    // Name of the region
+    uint64_t start;             // First address of the region
+    uint64_t end;               // One past the last address of the region
+    AttributionCounts counts;   // Counts charged to the region
+} AttributionRegion;
+
+/**
+ * @brief State of the attribution.
+ */
+typedef struct Attribution {
+    int log_page_size;          // log2 of the page size
+    int sample_rate;            // Set sampling rate of the cache, the counts are multiplied by it
+    AttributionPage *pages;     // Slots of the page table
+    size_t capacity;            // Number of slots of the page table (power of two), 0 for regions
+    size_t num_pages;           // Number of pages in the table
+    AttributionRegion *regions; // User-defined regions sorted by address, NULL to attribute to pages
+    int num_regions;            // Number of user-defined regions
+    AttributionCounts other;    // Counts of addresses outside all user-defined regions
+    AttributionCounts total;    // Counts of all attributed misses and write-backs
+} Attribution;
+
+/**
+ * @brief Creates an empty attribution for a cache.
+ * Terminates the program if the region file can't be read or is invalid.
+ *
+ * @param options Pointer to the AttributionOptions object.
+ * @param cache Pointer to the simulated Cache object.
+ * @return Pointer to the initialized Attribution object.
+ */
+Attribution* initialize_attribution(const AttributionOptions *options, const Cache *cache);
+
+/**
+ * @brief Frees the memory allocated for the attribution.
+ *
+ * @param attribution Pointer to the Attribution object.
+ */
+void free_attribution(Attribution *attribution);
+
+/**
+ * @brief Charges a miss to the region of its address.
+ * Must be called directly after the missing access, so the eviction record of
+ * the cache still describes the line it replaced. A dirty replaced line is
+ * charged as a write-back to its own region.
+ *
+ * @param attribution Pointer to the Attribution object.
+ * @param cache Pointer to the simulated Cache object.
+ * @param cache_op Pointer to the CacheOp object of the missing access.
+ */
+void attribute_cache_miss(Attribution *attribution, const Cache *cache, const CacheOp *cache_op);
+
+/**
+ * @brief Prints the regions with the most misses.
+ *
+ * @param attribution Pointer to the Attribution object.
+ * @param top_count Maximum number of regions printed.
+ */
+void print_attribution(const Attribution *attribution, int top_count);
+
+#endif // ATTRIBUTION_H_INCLUDED
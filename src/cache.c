@@ -2,65 +2,315 @@
 /**
  * @file cache.c
  * @brief Implementation of a write-back cache simulator with a write allocate
- * policy and a LRU replacement strategy.
+ * policy and a pluggable replacement strategy (LRU by default).
  *
  * This source file provides the implementation for the cache simulator defined
  * in cache.h. The implementation focuses on simulating cache behavior
  * accurately to study the effects of different cache configurations on
  * performance metrics such as hit rate and the number of dirty write-backs.
  *
+ * The tags of a set are compared with AVX2, SSE2 or NEON instructions when the
+ * compiler targets them, and with a scalar loop otherwise. Sectored caches
+ * have kernels of their own, so the sector words cost nothing without sectors.
+ *
  * @note This simulator assumes that the cache size, line size, and
  *       associativity are all powers of two, which is a common requirement for
  *       real-world cache configurations.
  ******************************************************************************/
 
+#define _DEFAULT_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 #include "cache.h"
+#include "prefetch.h"
+
+/**
+ * @brief Layout constants of the cache arena and the batch kernels.
+ */
+enum {
+    TAG_VECTOR_WIDTH = 8,               // Padding of the line array in lines, covers the widest vector load
+    HUGE_PAGE_SIZE = 2 * 1024 * 1024,   // Size of a transparent huge page, arenas of this size are mapped
+    CACHE_BATCH_BLOCK = 64,             // Number of operations decoded at once by the batch kernels
+    CACHE_PREFETCH_DISTANCE = 8,        // Number of operations the batch kernels prefetch ahead
+};
+
+/**
+ * @brief Constants of the replacement policies.
+ */
+enum {
+    RRPV_DISTANT = 3,                   // Largest 2-bit RRPV: re-reference in the distant future
+    BRRIP_LONG_INSERTION_RATE = 32,     // BRRIP inserts one in this many lines with a long prediction
+};
+
+/**
+ * @brief Seed of the pseudo-random number generator of every cache.
+ */
+#define CACHE_RANDOM_SEED 0x9E3779B97F4A7C15ULL
+
+/**
+ * @brief Odd multiplier permuting the set indices of a sampled cache, and its inverse modulo 2^64.
+ * A set is simulated if its permuted index falls below the number of sampled
+ * sets; the permuted index is also its position in the arrays of the cache.
+ */
+#define SET_SAMPLE_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define SET_SAMPLE_INVERSE 0xF1DE83E19937733DULL
+
+/**
+ * @brief Quantile of the standard normal distribution for two-sided 95% confidence intervals.
+ */
+#define CONFIDENCE_Z 1.96
+
+/**
+ * @brief Marks the helpers of the access path, which are inlined into every kernel.
+ */
+#define CACHE_KERNEL_INLINE static inline __attribute__((always_inline))
 
 // --- Helper Functions ---
 
 /**
- * @brief Allocates memory for the cache sets and lines.
+ * @brief Computes the slot of a line address in the index.
  *
- * @param cache Pointer to the Cache object that holds the cache structure.
+ * @param key Line address + 1.
+ * @param capacity Number of slots of the index (power of two).
+ * @return The preferred slot of the key.
  */
-static void allocate_cache_memory(Cache *cache) {
-    cache->sets = (CacheSet *)malloc(cache->num_sets * sizeof(CacheSet));
-    if (!cache->sets) {
-        fprintf(stderr, "Failed to allocate memory for cache sets.\n");
+static size_t hash_line_address(const uint64_t key, const size_t capacity) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 17) & (capacity - 1);
+}
+
+/**
+ * @brief Reserves an aligned region of the cache arena.
+ *
+ * @param offset Pointer to the current size of the arena layout, advanced past the region.
+ * @param size Size of the region in bytes.
+ * @return Offset of the region from the start of the arena.
+ */
+static size_t reserve_arena_region(size_t *offset, const size_t size) {
+    const size_t start = *offset;
+    *offset += (size + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+    return start;
+}
+
+/**
+ * @brief Allocates the arena of a cache, either zero-initialized or as a copy.
+ * Arenas of at least one huge page are mapped anonymously and marked for
+ * transparent huge pages, so large caches need fewer TLB entries. Smaller
+ * arenas, or systems without anonymous mappings, use the aligned heap.
+ *
+ * @param cache Pointer to the Cache object receiving the arena.
+ * @param size Size of the arena in bytes.
+ * @param contents The `size` bytes copied into the arena, or `NULL` for a zeroed arena.
+ */
+static void allocate_cache_arena(Cache *cache, const size_t size, const void *contents) {
+    cache->arena_is_mapped = false;
+
+#if defined(MAP_ANONYMOUS)
+    if (size >= HUGE_PAGE_SIZE) {
+        cache->arena_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void *arena = mmap(NULL, cache->arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (arena != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(arena, cache->arena_size, MADV_HUGEPAGE);
+#endif
+            cache->arena = arena;
+            cache->arena_is_mapped = true;
+            if (contents) {
+                memcpy(arena, contents, size);
+            }
+            return;
+        }
+    }
+#endif
+
+    cache->arena_size = size;
+    cache->arena = aligned_alloc(CACHE_ALIGNMENT, size);
+    if (!cache->arena) {
+        fprintf(stderr, "Failed to allocate memory for cache arena.\n");
         exit(EXIT_FAILURE);
     }
+    if (contents) {
+        memcpy(cache->arena, contents, size);
+    } else {
+        memset(cache->arena, 0, size);
+    }
+}
 
-    // Allocate memory for each line in each set
-    for (int i = 0; i < cache->num_sets; i++) {
-        cache->sets[i].lines = (CacheLine *)malloc(cache->associativity * sizeof(CacheLine));
-        if (!cache->sets[i].lines) {
-            fprintf(stderr, "Failed to allocate memory for cache lines.\n");
-            exit(EXIT_FAILURE);
-        }
+/**
+ * @brief Releases the arena of a cache.
+ *
+ * @param cache Pointer to the Cache object.
+ */
+static void free_cache_arena(Cache *cache) {
+#if defined(MAP_ANONYMOUS)
+    if (cache->arena_is_mapped) {
+        munmap(cache->arena, cache->arena_size);
+    } else {
+        free(cache->arena);
+    }
+#else
+    free(cache->arena);
+#endif
+}
+
+/**
+ * @brief Lays out the lines and the replacement metadata in the arena of a cache.
+ * The layout only depends on the configuration, so a saved arena can be
+ * mapped back in place.
+ *
+ * @param cache Pointer to the configured Cache object.
+ * @param arena Start of the arena receiving the arrays, or `NULL` to only compute its size.
+ * @return Size of the arena in bytes.
+ */
+static size_t layout_cache_arena(Cache *cache, char *arena) {
+    const size_t num_sets = (size_t)cache->num_sampled_sets;
+    const size_t num_lines = num_sets * cache->associativity;
+    const size_t num_words = num_sets * cache->words_per_set;
+    const bool is_sampled = cache->sample_rate > 1;
+    const bool is_sectored = cache->log_sectors > 0;
+    const ReplacementPolicy policy = cache->replacement;
+    const bool is_lru = policy == REPLACEMENT_LRU && cache->associativity > 1;
+    const bool has_matrix = is_lru && cache->recency == RECENCY_BIT_MATRIX;
+    const bool has_list = is_lru && cache->recency == RECENCY_LIST;
+    const bool has_counts = policy != REPLACEMENT_LRU && cache->associativity > 1;
+    const bool has_plru = has_counts && policy == REPLACEMENT_PLRU;
+    const bool has_rrpv = has_counts && (policy == REPLACEMENT_SRRIP || policy == REPLACEMENT_BRRIP);
+    const bool has_fifo = has_counts && policy == REPLACEMENT_FIFO;
+
+    // Lay out all arrays; the line array is padded, so vector loads of the last set stay in bounds
+    size_t size = 0;
+    const size_t lines = reserve_arena_region(&size, (num_lines + TAG_VECTOR_WIDTH) * sizeof(uint64_t));
+    const size_t sector_masks = reserve_arena_region(&size, is_sectored ? num_lines * sizeof(uint64_t) : 0);
+    const size_t recency_matrix = reserve_arena_region(&size, has_matrix ? num_sets * sizeof(unsigned long) : 0);
+    const size_t lru_prev = reserve_arena_region(&size, has_list ? num_lines * sizeof(int) : 0);
+    const size_t lru_next = reserve_arena_region(&size, has_list ? num_lines * sizeof(int) : 0);
+    const size_t mru_way = reserve_arena_region(&size, has_list ? num_sets * sizeof(int) : 0);
+    const size_t lru_way = reserve_arena_region(&size, has_list ? num_sets * sizeof(int) : 0);
+    const size_t valid_counts = reserve_arena_region(&size, has_counts ? num_sets * sizeof(int) : 0);
+    const size_t plru_bits = reserve_arena_region(&size, has_plru ? num_words * sizeof(unsigned long) : 0);
+    const size_t rrpv = reserve_arena_region(&size, has_rrpv ? num_lines * sizeof(uint8_t) : 0);
+    const size_t fifo_next = reserve_arena_region(&size, has_fifo ? num_sets * sizeof(int) : 0);
+    const size_t index_keys = reserve_arena_region(&size, cache->index_capacity * sizeof(uint64_t));
+    const size_t index_ways = reserve_arena_region(&size, cache->index_capacity * sizeof(int));
+    const size_t set_stats = reserve_arena_region(&size, is_sampled ? num_sets * sizeof(CacheStats) : 0);
+    if (!arena) {
+        return size;
     }
+
+    cache->arena_used = size;
+    cache->lines = (uint64_t *)(arena + lines);
+    cache->sector_masks = is_sectored ? (uint64_t *)(arena + sector_masks) : NULL;
+    cache->recency_matrix = has_matrix ? (unsigned long *)(arena + recency_matrix) : NULL;
+    cache->lru_prev = has_list ? (int *)(arena + lru_prev) : NULL;
+    cache->lru_next = has_list ? (int *)(arena + lru_next) : NULL;
+    cache->mru_way = has_list ? (int *)(arena + mru_way) : NULL;
+    cache->lru_way = has_list ? (int *)(arena + lru_way) : NULL;
+    cache->valid_counts = has_counts ? (int *)(arena + valid_counts) : NULL;
+    cache->plru_bits = has_plru ? (unsigned long *)(arena + plru_bits) : NULL;
+    cache->rrpv = has_rrpv ? (uint8_t *)(arena + rrpv) : NULL;
+    cache->fifo_next = has_fifo ? (int *)(arena + fifo_next) : NULL;
+    cache->index_keys = cache->index_capacity != 0 ? (uint64_t *)(arena + index_keys) : NULL;
+    cache->index_ways = cache->index_capacity != 0 ? (int *)(arena + index_ways) : NULL;
+    cache->set_stats = is_sampled ? (CacheStats *)(arena + set_stats) : NULL;
+    return size;
+}
+
+/**
+ * @brief Allocates memory for the lines and the replacement metadata.
+ * All arrays are carved from a single arena, so a cache needs one allocation
+ * independent of its number of sets.
+ *
+ * @param cache Pointer to the Cache object that holds the cache structure.
+ */
+static void allocate_cache_memory(Cache *cache) {
+    allocate_cache_arena(cache, layout_cache_arena(cache, NULL), NULL);
+    layout_cache_arena(cache, (char *)cache->arena);
 }
 
 /**
  * @brief Initializes the cache lines in all sets with default values.
- * Sets the tag to 0, sets valid and dirty bits to false, and assigns an LRU order.
+ * The line words are expected to be zero (invalid) already, only the LRU
+ * lists need to be linked and the RRPVs set to the distant prediction. Lines
+ * that have never been used are always the least recently used ones, so they
+ * are filled before any valid line is replaced.
  *
  * @param cache Pointer to the Cache object to initialize.
  */
-static void initialize_cache_lines(const Cache *cache) {
-    for (int i = 0; i < cache->num_sets; i++) {
+static void initialize_cache_lines(Cache *cache) {
+    cache->random_state = CACHE_RANDOM_SEED;
+    if (cache->rrpv) {
+        memset(cache->rrpv, RRPV_DISTANT, (size_t)cache->num_sampled_sets * cache->associativity);
+    }
+    if (!cache->lru_prev) {
+        return;
+    }
+
+    for (int i = 0; i < cache->num_sampled_sets; i++) {
+        cache->mru_way[i] = 0;
+        cache->lru_way[i] = cache->associativity - 1;
+
+        const size_t base = (size_t)i * cache->associativity;
         for (int j = 0; j < cache->associativity; j++) {
-            CacheLine *line = &cache->sets[i].lines[j];
-            line->tag = 0;
-            line->is_valid = false;
-            line->is_dirty = false;
-            line->lru_order = j;
+            cache->lru_prev[base + j] = j - 1;
+            cache->lru_next[base + j] = j + 1 < cache->associativity ? j + 1 : -1;
         }
     }
 }
 
-// --- Utility Function ---
+/**
+ * @brief Returns the word of a line.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @param way The way of the line.
+ * @return Pointer to the tag and flags of the line.
+ */
+CACHE_KERNEL_INLINE uint64_t* get_line_word(const Cache *cache, const int set_index, const int ways, const int way) {
+    return &cache->lines[(size_t)set_index * ways + way];
+}
+
+/**
+ * @brief Builds the word of a valid line.
+ *
+ * @param tag The tag of the line.
+ * @param is_dirty Indicates if the line is modified.
+ * @return The tag and flags of the line.
+ */
+CACHE_KERNEL_INLINE uint64_t make_line_word(const uint64_t tag, const bool is_dirty) {
+    return (tag << CACHE_LINE_TAG_SHIFT) | CACHE_LINE_VALID | (is_dirty ? CACHE_LINE_DIRTY : 0);
+}
+
+// --- Utility Functions ---
+
+void* allocate_or_exit(const size_t count, const size_t size, const char *what) {
+    void *memory = calloc(count > 0 ? count : 1, size);
+    if (!memory) {
+        fprintf(stderr, "Failed to allocate memory for %s.\n", what);
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+void* reallocate_or_exit(void *memory, const size_t count, const size_t size, const char *what) {
+    void *resized = size > 0 && count > SIZE_MAX / size ? NULL : realloc(memory, count * size);
+    if (!resized) {
+        fprintf(stderr, "Failed to allocate memory for %s.\n", what);
+        exit(EXIT_FAILURE);
+    }
+    return resized;
+}
 
 /**
  * @brief Computes the logarithm base 2 of the given integer.
@@ -68,7 +318,7 @@ static void initialize_cache_lines(const Cache *cache) {
  * @param n The integer input.
  * @return The logarithm base 2 of the input.
  */
-static int log2(int n) {
+static int log2_int(int n) {
     int log_value = 0;
     while (n >>= 1) {
         log_value++;
@@ -76,24 +326,40 @@ static int log2(int n) {
     return log_value;
 }
 
+static void select_access_kernels(Cache *cache);
+
 // --- Cache Initialization and Cleanup ---
 
-Cache* initialize_cache(const int associativity, const int cache_size, const int line_size, const int miss_penalty,
-                const int dirty_wb_penalty) {
-    Cache *cache = (Cache *)malloc(sizeof(Cache));
-    if (!cache) {
-        fprintf(stderr, "Failed to allocate memory for cache.\n");
-        exit(EXIT_FAILURE);
-    }
+/**
+ * @brief Sets the configuration and the derived geometry of a cache.
+ * Neither memory nor kernels are set up yet.
+ *
+ * @param cache Pointer to the Cache object to configure.
+ * @param associativity Cache associativity (ways per set), 0 for fully associative.
+ * @param cache_size Cache size in KB.
+ * @param line_size Cache line size in bytes.
+ * @param miss_penalty Miss penalty in cycles.
+ * @param dirty_wb_penalty Dirty write-back penalty in cycles.
+ * @param replacement Replacement policy of the cache.
+ * @param sample_rate Simulate one in this many sets, 1 for all sets.
+ */
+static void configure_cache(Cache *cache, const int associativity, const int cache_size, const int line_size,
+                            const int miss_penalty, const int dirty_wb_penalty, const ReplacementPolicy replacement,
+                            const int sample_rate) {
 
     // Set cache parameters
     cache->cache_size = cache_size;
     cache->line_size = line_size;
     cache->miss_penalty = miss_penalty;
     cache->dirty_wb_penalty = dirty_wb_penalty;
+    cache->replacement = replacement;
 
     //Initialize cache statistics
-    cache->stats = (CacheStats){0, 0, 0};
+    cache->stats = (CacheStats){0};
+    cache->last_eviction = (CacheEviction){0, false, false};
+    cache->prefetcher = NULL;
+    cache->write_policy = WRITE_BACK_ALLOCATE;
+    cache->write_combining = NULL;
 
     // Configure cache as fully associative, direct-mapped, or set-associative
     if (associativity == 0) { // Fully Associative Cache
@@ -109,26 +375,125 @@ Cache* initialize_cache(const int associativity, const int cache_size, const int
         cache->num_sets = (cache_size * 1024) / (line_size * associativity);
     }
 
-    cache->log_line_size = log2(line_size);
-    cache->log_num_sets = log2(cache->num_sets);
+    cache->log_line_size = log2_int(line_size);
+    cache->log_sectors = 0;
+    cache->log_sector_size = cache->log_line_size;
+    cache->log_num_sets = log2_int(cache->num_sets);
+    cache->sample_rate = sample_rate;
+    cache->log_sample_rate = log2_int(sample_rate);
+    cache->num_sampled_sets = cache->num_sets / sample_rate;
+    cache->words_per_set = (cache->associativity + 63) / 64;
+    cache->recency = cache->associativity <= RECENCY_MATRIX_MAX_WAYS ? RECENCY_BIT_MATRIX : RECENCY_LIST;
+
+    // Large associativities find their lines through an index with at most 50% load
+    const size_t num_lines = (size_t)cache->num_sampled_sets * cache->associativity;
+    cache->index_capacity = 0;
+    if (cache->associativity >= RECENCY_INDEX_MIN_WAYS) {
+        cache->index_capacity = 1;
+        while (cache->index_capacity < num_lines * 2) {
+            cache->index_capacity *= 2;
+        }
+    }
+}
+
+Cache* initialize_cache(const int associativity, const int cache_size, const int line_size, const int miss_penalty,
+                const int dirty_wb_penalty, const ReplacementPolicy replacement, const int sample_rate) {
+    Cache *cache = allocate_or_exit(1, sizeof(Cache), "cache");
 
+    configure_cache(cache, associativity, cache_size, line_size, miss_penalty, dirty_wb_penalty, replacement,
+                    sample_rate);
     allocate_cache_memory(cache);
     initialize_cache_lines(cache);
+    select_access_kernels(cache);
 
     return cache;
 }
 
+void reset_cache(Cache *cache) {
+    cache->stats = (CacheStats){0};
+    cache->last_eviction = (CacheEviction){0, false, false};
+
+    // Clear all lines and metadata in place instead of reallocating them
+    memset(cache->arena, 0, cache->arena_used);
+    initialize_cache_lines(cache);
+    if (cache->prefetcher) {
+        reset_prefetcher(cache->prefetcher);
+    }
+    if (cache->write_combining) {
+        cache->write_combining->count = 0;
+        cache->write_combining->head = 0;
+    }
+}
+
+void reset_cache_stats(Cache *cache) {
+    cache->stats = (CacheStats){0};
+    if (cache->set_stats) {
+        memset(cache->set_stats, 0, (size_t)cache->num_sampled_sets * sizeof(CacheStats));
+    }
+}
+
+Cache* clone_cache(const Cache *cache) {
+    Cache *clone = allocate_or_exit(1, sizeof(Cache), "cache");
+
+    // The arena layout only depends on the configuration, so the arrays are carved at the same offsets
+    *clone = *cache;
+    allocate_cache_arena(clone, cache->arena_used, cache->arena);
+    layout_cache_arena(clone, (char *)clone->arena);
+    clone->prefetcher = NULL;
+    if (cache->write_combining) {
+        const size_t size = sizeof(WriteCombiningBuffer)
+                            + (size_t)cache->write_combining->capacity * sizeof(WriteCombiningEntry);
+        clone->write_combining = allocate_or_exit(1, size, "write-combining buffer");
+        memcpy(clone->write_combining, cache->write_combining, size);
+    }
+    select_access_kernels(clone);
+    return clone;
+}
+
 void free_cache(Cache *cache) {
-    for (int i = 0; i < cache->num_sets; i++) {
-        free(cache->sets[i].lines); // Free line in each set
+    // Free the cache arena with all lines and metadata
+    free_cache_arena(cache);
+    if (cache->prefetcher) {
+        free_prefetcher(cache->prefetcher);
     }
-    free(cache->sets); // Free the sets
+    free(cache->write_combining);
     free(cache); // Free cache structure itself
 }
 
+void set_cache_sectors(Cache *cache, const int sectors) {
+    // The sector words are part of the arena layout, so the empty arena is laid out again
+    free_cache_arena(cache);
+    cache->log_sectors = log2_int(sectors);
+    cache->log_sector_size = cache->log_line_size - cache->log_sectors;
+    allocate_cache_memory(cache);
+    initialize_cache_lines(cache);
+    select_access_kernels(cache);
+}
+
+void set_write_policy(Cache *cache, const WritePolicy write_policy, const int combining_entries) {
+    cache->write_policy = write_policy;
+    free(cache->write_combining);
+    cache->write_combining = NULL;
+
+    if (combining_entries > 0) {
+        WriteCombiningBuffer *buffer = allocate_or_exit(1, sizeof(WriteCombiningBuffer)
+                                                        + (size_t)combining_entries * sizeof(WriteCombiningEntry),
+                                                        "write-combining buffer");
+        const int log_store_size = log2_int(cache->line_size < CACHE_STORE_SIZE ? cache->line_size
+                                                                                : CACHE_STORE_SIZE);
+        buffer->capacity = combining_entries;
+        buffer->count = 0;
+        buffer->head = 0;
+        buffer->log_chunk_size = cache->log_line_size - 6 > log_store_size ? cache->log_line_size - 6
+                                                                             : log_store_size;
+        cache->write_combining = buffer;
+    }
+    select_access_kernels(cache);
+}
+
 // --- Initialize Cache Operations ---
 
-CacheOp initialize_cache_operation(const char access_type, const unsigned long address, const int instructions) {
+CacheOp initialize_cache_operation(const char access_type, const uint64_t address, const int instructions) {
     CacheOp cache_op;
 
     // Set cache operation parameters
@@ -143,16 +508,14 @@ CacheOp initialize_cache_operation(const char access_type, const unsigned long a
 
 /**
  * @brief Extracts the set index from the given memory address.
+ * Fully associative caches have a single set, so the mask is zero.
  *
  * @param address The memory address being accessed.
  * @param cache Pointer to the cache object.
  * @return The set index for the given address.
  */
-static int extract_set_index(const unsigned long address, const Cache *cache) {
-    if (cache->num_sets == 1) {
-        return 0; // Fully associative cache, only one set
-    }
-    return (address >> cache->log_line_size) & ((1 << cache->log_num_sets) - 1);
+CACHE_KERNEL_INLINE int extract_set_index(const uint64_t address, const Cache *cache) {
+    return (address >> cache->log_line_size) & (cache->num_sets - 1);
 }
 
 /**
@@ -162,10 +525,105 @@ static int extract_set_index(const unsigned long address, const Cache *cache) {
  * @param cache Pointer to the Cache object.
  * @return The tag number for the given address.
  */
-static int extract_tag_number(const unsigned long address, const Cache *cache) {
+CACHE_KERNEL_INLINE uint64_t extract_tag_number(const uint64_t address, const Cache *cache) {
     return address >> (cache->log_line_size + cache->log_num_sets);
 }
 
+/**
+ * @brief Maps a set index to the position of the set in a sampled cache.
+ * The set indices are permuted by a multiplication with an odd constant,
+ * which is a bijection modulo the number of sets. The sets with a permuted
+ * index below the number of sampled sets form the sample.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The set index of an address.
+ * @return The position of the set, `-1` if the set isn't sampled.
+ */
+CACHE_KERNEL_INLINE int find_sampled_set(const Cache *cache, const int set_index) {
+    const int position = (int)(((uint64_t)set_index * SET_SAMPLE_MULTIPLIER) & (cache->num_sets - 1));
+    return position < cache->num_sampled_sets ? position : -1;
+}
+
+/**
+ * @brief Maps the position of a set back to its set index.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The position of the set in the arrays of the cache.
+ * @return The set index of the addresses held by the set.
+ */
+CACHE_KERNEL_INLINE uint64_t get_address_set_index(const Cache *cache, const int set_index) {
+    if (cache->log_sample_rate == 0) {
+        return (uint64_t)set_index;
+    }
+    return ((uint64_t)set_index * SET_SAMPLE_INVERSE) & (cache->num_sets - 1);
+}
+
+/**
+ * @brief Finds the set of an address in the arrays of the cache.
+ *
+ * @param address The memory address being accessed.
+ * @param cache Pointer to the Cache object.
+ * @return The position of the set, `-1` if the set isn't part of the sample.
+ */
+CACHE_KERNEL_INLINE int locate_cache_set(const uint64_t address, const Cache *cache) {
+    const int set_index = extract_set_index(address, cache);
+    return cache->log_sample_rate == 0 ? set_index : find_sampled_set(cache, set_index);
+}
+
+// --- Line Index ---
+
+/**
+ * @brief Computes the key of a line in the line index.
+ * The key is derived from the stored tag, so lookups agree with tag comparisons.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set of the line.
+ * @param tag The tag of the line.
+ * @return The line number + 1 (never 0).
+ */
+static uint64_t line_index_key(const Cache *cache, const int set_index, const uint64_t tag) {
+    return ((tag << cache->log_num_sets) | (uint64_t)set_index) + 1;
+}
+
+/**
+ * @brief Finds the slot of a key in the line index, or the empty slot where it belongs.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param key The key of the line.
+ * @return The slot of the key.
+ */
+static size_t find_line_slot(const Cache *cache, const uint64_t key) {
+    size_t slot = hash_line_address(key, cache->index_capacity);
+    while (cache->index_keys[slot] != 0 && cache->index_keys[slot] != key) {
+        slot = (slot + 1) & (cache->index_capacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * @brief Removes a key from the line index.
+ * Later entries of the probe sequence are shifted back, so no tombstones are needed.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param key The key of the line.
+ */
+static void remove_line_from_index(const Cache *cache, const uint64_t key) {
+    const size_t mask = cache->index_capacity - 1;
+    size_t hole = find_line_slot(cache, key);
+    cache->index_keys[hole] = 0;
+
+    for (size_t slot = (hole + 1) & mask; cache->index_keys[slot] != 0; slot = (slot + 1) & mask) {
+        // Move the entry into the hole unless its preferred slot lies between the hole and itself
+        const size_t preferred = hash_line_address(cache->index_keys[slot], cache->index_capacity);
+        if (((slot - preferred) & mask) >= ((slot - hole) & mask)) {
+            cache->index_keys[hole] = cache->index_keys[slot];
+            cache->index_ways[hole] = cache->index_ways[slot];
+            cache->index_keys[slot] = 0;
+            hole = slot;
+        }
+    }
+}
+
 // --- LRU Handling ---
 
 /**
@@ -174,139 +632,1644 @@ static int extract_tag_number(const unsigned long address, const Cache *cache) {
  *
  * @param cache Pointer to the Cache object.
  * @param set_index The index of the set where the access occurred.
+ * @param ways Number of lines per set.
  * @param line_index The index of the cache line.
  */
-static void update_lru_order(const Cache *cache, const int set_index, const int line_index) {
-    CacheLine *lines = cache->sets[set_index].lines;
-    const int target_order = lines[line_index].lru_order;
+CACHE_KERNEL_INLINE void update_lru_order(const Cache *cache, const int set_index, const int ways,
+                                          const int line_index) {
+    if (ways == 1) {
+        return; // A direct-mapped set has no order
+    }
 
-    // Increment the LRU order for lines with lower priority
-    for (int i = 0; i < cache->associativity; i++) {
-        if (lines[i].lru_order < target_order) {
-            lines[i].lru_order++;
-        }
+    if (ways <= RECENCY_MATRIX_MAX_WAYS) {
+        // The line becomes more recent than all others (set its row, clear its column)
+        unsigned long *matrix = &cache->recency_matrix[set_index];
+        *matrix |= (0xFFUL >> (8 - ways)) << (line_index * 8);
+        *matrix &= ~(0x0101010101010101UL << line_index);
+        return;
+    }
+
+    const int mru_way = cache->mru_way[set_index];
+    if (mru_way == line_index) {
+        return;
+    }
+
+    // Unlink the line and move it to the front of the list
+    int *prev = &cache->lru_prev[(size_t)set_index * ways];
+    int *next = &cache->lru_next[(size_t)set_index * ways];
+    next[prev[line_index]] = next[line_index];
+    if (next[line_index] >= 0) {
+        prev[next[line_index]] = prev[line_index];
+    } else {
+        cache->lru_way[set_index] = prev[line_index];
     }
 
-    // Set the accessed/replaced line as the most recently used (highest priority)
-    lines[line_index].lru_order = 0;
+    prev[line_index] = -1;
+    next[line_index] = mru_way;
+    prev[mru_way] = line_index;
+    cache->mru_way[set_index] = line_index;
 }
 
 /**
  * @brief Finds the index of the least recently used line in the specified set.
- * The LRU line is the one with the highest LRU order value.
+ * Lines that have never been used are always older than all valid lines.
  *
  * @param cache Pointer to the Cache object.
  * @param set_index Index of the set where the replacement will occur.
+ * @param ways Number of lines per set.
  * @return Index of the least recently used line in the set.
  */
-static int find_lru_line_index(const Cache *cache, const int set_index) {
-    const CacheLine *lines = cache->sets[set_index].lines;
-    int max_order = 0;
-    int lru_index = 0;
+CACHE_KERNEL_INLINE int find_lru_line_index(const Cache *cache, const int set_index, const int ways) {
+    if (ways == 1) {
+        return 0;
+    }
 
-    // Find the line with the highest LRU order (least recently used)
-    for (int i = 0; i < cache->associativity; i++) {
-        if (!lines[i].is_valid) {
-            return i; // If an invalid line was found, use it immediately
-        }
-        if (lines[i].lru_order > max_order) {
-            max_order = lines[i].lru_order;
-            lru_index = i;
-        }
+    if (ways <= RECENCY_MATRIX_MAX_WAYS) {
+        // Find the lowest all-zero row; rows beyond the associativity are masked out
+        const unsigned long matrix = cache->recency_matrix[set_index];
+        const unsigned long rows = ways == 8 ? ~0UL : (1UL << (ways * 8)) - 1;
+        const unsigned long zero_rows = (matrix - 0x0101010101010101UL) & ~matrix & 0x8080808080808080UL & rows;
+        return __builtin_ctzl(zero_rows) / 8;
     }
 
-    return lru_index;
+    return cache->lru_way[set_index];
 }
 
-// --- Access Cache ---
-
 /**
- * @brief Checks whether a cache hit occurs in the specified set.
- * If a hit occurs, the LRU order is updated and relevant statistics are updated.
+ * @brief Moves a line to the least recently used position of its set.
  *
  * @param cache Pointer to the Cache object.
- * @param cache_op Pointer to the CacheOp object representing the cache operation.
- * @param set_index The index of the set to check.
- * @param tag The tag value of the memory address.
- * @param cache_set Pointer to the CacheSet object representing the current cache set.
- * @return `true` if cache hit, `false` otherwise.
+ * @param set_index The index of the set.
+ * @param line_index The index of the cache line.
  */
-static bool is_cache_hit(Cache *cache, const CacheOp *cache_op, const int set_index, const int tag,
-                         const CacheSet *cache_set) {
-    for (int i = 0; i < cache->associativity; i++) {
-        CacheLine *line = &cache_set->lines[i];
-        if (line->is_valid && line->tag == tag) {
-            // Cache hit: update LRU and dirty bit (if needed)
-            update_lru_order(cache, set_index, i);
-            if (cache_op->access_type == 's') {
-                line->is_dirty = true;
-            }
-            cache->stats.hits++;
-            return true;
-        }
+static void demote_lru_order(const Cache *cache, const int set_index, const int line_index) {
+    const int ways = cache->associativity;
+    if (ways == 1) {
+        return;
     }
-    return false;
+
+    if (ways <= RECENCY_MATRIX_MAX_WAYS) {
+        // All other lines become more recent (clear its row, set its column)
+        const unsigned long row = (0xFFUL >> (8 - ways)) << (line_index * 8);
+        const unsigned long rows = ways == 8 ? ~0UL : (1UL << (ways * 8)) - 1;
+        unsigned long *matrix = &cache->recency_matrix[set_index];
+        *matrix &= ~row;
+        *matrix |= (0x0101010101010101UL << line_index) & rows & ~row;
+        return;
+    }
+
+    const int lru_way = cache->lru_way[set_index];
+    if (lru_way == line_index) {
+        return;
+    }
+
+    // Unlink the line and move it to the end of the list
+    int *prev = &cache->lru_prev[(size_t)set_index * ways];
+    int *next = &cache->lru_next[(size_t)set_index * ways];
+    prev[next[line_index]] = prev[line_index];
+    if (prev[line_index] >= 0) {
+        next[prev[line_index]] = next[line_index];
+    } else {
+        cache->mru_way[set_index] = next[line_index];
+    }
+
+    next[line_index] = -1;
+    prev[line_index] = lru_way;
+    next[lru_way] = line_index;
+    cache->lru_way[set_index] = line_index;
 }
 
+// --- Replacement Policies ---
+
 /**
- * @brief Handles cache miss by replacing the least recently used line in a set and updating relevant cache statistics.
+ * @brief Advances the pseudo-random number generator of a cache (xorshift64*).
  *
  * @param cache Pointer to the Cache object.
- * @param cache_op Pointer to the CacheOp object representing the cache operation.
- * @param set_index The index of the set where the miss occurred.
- * @param tag The tag of the new memory address to store in the cache.
- * @param cache_set Pointer to the CacheSet object representing the current cache set.
+ * @return The next pseudo-random number.
  */
-static void handle_cache_miss(Cache *cache, const CacheOp *cache_op, const int set_index, const int tag,
-                       const CacheSet *cache_set) {
-    cache->stats.misses++;
-    const int lru_index = find_lru_line_index(cache, set_index);
-    CacheLine *lru_line = &cache_set->lines[lru_index];
+CACHE_KERNEL_INLINE uint64_t next_random(Cache *cache) {
+    uint64_t x = cache->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    cache->random_state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
 
-    // If the LRU line is dirty, perform a write-back
-    if (lru_line->is_dirty) {
-        cache->stats.dirty_write_backs++;
+/**
+ * @brief Points the tree-PLRU bits of a set away from a line.
+ * The tree has a node per inner vertex (1 to ways - 1, in heap order); a
+ * node's bit selects the child subtree that holds the next victim.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @param line_index The index of the accessed line.
+ */
+CACHE_KERNEL_INLINE void update_plru_tree(const Cache *cache, const int set_index, const int ways,
+                                          const int line_index) {
+    unsigned long *bits = &cache->plru_bits[(size_t)set_index * ((ways + 63) / 64)];
+    int node = 1;
+    for (int level = __builtin_ctz(ways) - 1; level >= 0; level--) {
+        const int direction = (line_index >> level) & 1;
+        const unsigned long mask = 1UL << (node % 64);
+        bits[node / 64] = direction ? (bits[node / 64] & ~mask) : (bits[node / 64] | mask);
+        node = 2 * node + direction;
     }
+}
 
-    // Replace the LRU line with the new tag and reset flags
-    lru_line->tag = tag;
-    lru_line->is_valid = true;
-    lru_line->is_dirty = (cache_op->access_type == 's');
-
-    // Update LRU order after the miss
-    update_lru_order(cache, set_index, lru_index);
+/**
+ * @brief Follows the tree-PLRU bits of a set to the victim line.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @return Index of the victim line.
+ */
+CACHE_KERNEL_INLINE int find_plru_line_index(const Cache *cache, const int set_index, const int ways) {
+    const unsigned long *bits = &cache->plru_bits[(size_t)set_index * ((ways + 63) / 64)];
+    int node = 1;
+    while (node < ways) {
+        node = 2 * node + (int)((bits[node / 64] >> (node % 64)) & 1UL);
+    }
+    return node - ways;
 }
 
-bool access_cache(Cache *cache, const CacheOp *cache_op) {
-    const int set_index = extract_set_index(cache_op->address, cache);
+/**
+ * @brief Finds the RRIP victim of a set: the first line with the largest re-reference prediction.
+ * If no line has the distant prediction yet, all lines of the set age until
+ * the victim reaches it.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @return Index of the victim line.
+ */
+CACHE_KERNEL_INLINE int find_rrip_line_index(const Cache *cache, const int set_index, const int ways) {
+    uint8_t *rrpv = &cache->rrpv[(size_t)set_index * ways];
+    int victim = 0;
+    for (int i = 1; i < ways; i++) {
+        if (rrpv[i] > rrpv[victim]) {
+            victim = i;
+        }
+    }
 
-    if (set_index > cache->num_sets) {
-        fprintf(stderr, "Set index is out of range");
-        exit(EXIT_FAILURE);
+    const uint8_t age = RRPV_DISTANT - rrpv[victim];
+    if (age != 0) {
+        for (int i = 0; i < ways; i++) {
+            rrpv[i] += age;
+        }
     }
+    return victim;
+}
 
-    const int tag = extract_tag_number(cache_op->address, cache);
-    const CacheSet *cache_set = &cache->sets[set_index];
+/**
+ * @brief Finds an invalid line of a set.
+ * Only called if the set isn't full, so an invalid line exists.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @return Index of the first invalid line.
+ */
+CACHE_KERNEL_INLINE int find_invalid_line_index(const Cache *cache, const int set_index, const int ways) {
+    const uint64_t *lines = get_line_word(cache, set_index, ways, 0);
+    int way = 0;
+    while (lines[way] & CACHE_LINE_VALID) {
+        way++;
+    }
+    return way;
+}
 
-    // Check for cache hit
-    if (is_cache_hit(cache, cache_op, set_index, tag, cache_set))
-        return true;
+/**
+ * @brief Finds the line of a set to be replaced by a miss.
+ * Invalid lines are always replaced first. LRU gets them for free, as they
+ * stay the least recently used lines; the other policies count the valid
+ * lines of every set instead.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index Index of the set where the replacement will occur.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @return Index of the line to be replaced.
+ */
+CACHE_KERNEL_INLINE int find_victim_line_index(Cache *cache, const int set_index, const int ways,
+                                               const ReplacementPolicy policy) {
+    if (ways == 1) {
+        return 0;
+    }
+    if (policy == REPLACEMENT_LRU) {
+        return find_lru_line_index(cache, set_index, ways);
+    }
+    if (cache->valid_counts[set_index] < ways) {
+        return find_invalid_line_index(cache, set_index, ways);
+    }
 
-    // Cache miss handling
-    handle_cache_miss(cache, cache_op, set_index, tag, cache_set);
-    return false;
+    switch (policy) {
+        case REPLACEMENT_PLRU: return find_plru_line_index(cache, set_index, ways);
+        case REPLACEMENT_SRRIP:
+        case REPLACEMENT_BRRIP: return find_rrip_line_index(cache, set_index, ways);
+        case REPLACEMENT_FIFO: return cache->fifo_next[set_index];
+        default: return (int)(next_random(cache) >> 32) & (ways - 1);
+    }
 }
 
-// --- Cache Statistics ---
+/**
+ * @brief Updates the replacement state of a set after a hit.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set where the access occurred.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param line_index The index of the hit line.
+ */
+CACHE_KERNEL_INLINE void update_replacement_on_hit(const Cache *cache, const int set_index, const int ways,
+                                                   const ReplacementPolicy policy, const int line_index) {
+    if (ways == 1) {
+        return;
+    }
 
-int get_cache_hits(const Cache *cache) {
-    return cache->stats.hits;
+    switch (policy) {
+        case REPLACEMENT_LRU: update_lru_order(cache, set_index, ways, line_index); break;
+        case REPLACEMENT_PLRU: update_plru_tree(cache, set_index, ways, line_index); break;
+        case REPLACEMENT_SRRIP:
+        case REPLACEMENT_BRRIP: cache->rrpv[(size_t)set_index * ways + line_index] = 0; break;
+        default: break; // FIFO and random ignore hits
+    }
 }
 
-int get_cache_misses(const Cache *cache) {
-    return cache->stats.misses;
+/**
+ * @brief Updates the replacement state of a set after a line has been filled.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param line_index The index of the filled line.
+ * @param was_valid Indicates if the filled line replaced a valid line.
+ */
+CACHE_KERNEL_INLINE void update_replacement_on_fill(Cache *cache, const int set_index, const int ways,
+                                                    const ReplacementPolicy policy, const int line_index,
+                                                    const bool was_valid) {
+    if (ways == 1) {
+        return;
+    }
+    if (policy != REPLACEMENT_LRU && !was_valid) {
+        cache->valid_counts[set_index]++;
+    }
+
+    switch (policy) {
+        case REPLACEMENT_LRU: update_lru_order(cache, set_index, ways, line_index); break;
+        case REPLACEMENT_PLRU: update_plru_tree(cache, set_index, ways, line_index); break;
+        case REPLACEMENT_SRRIP:
+            cache->rrpv[(size_t)set_index * ways + line_index] = RRPV_DISTANT - 1;
+            break;
+        case REPLACEMENT_BRRIP:
+            // Mostly insert with a distant prediction, so lines without reuse leave quickly
+            cache->rrpv[(size_t)set_index * ways + line_index] =
+                (next_random(cache) >> 32) % BRRIP_LONG_INSERTION_RATE == 0 ? RRPV_DISTANT - 1 : RRPV_DISTANT;
+            break;
+        case REPLACEMENT_FIFO:
+            if (line_index == cache->fifo_next[set_index]) {
+                cache->fifo_next[set_index] = (line_index + 1) & (ways - 1);
+            }
+            break;
+        default: break;
+    }
 }
 
-int get_dirty_write_backs(const Cache *cache) {
+/**
+ * @brief Updates the replacement state of a set after a line has been invalidated.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param line_index The index of the invalidated line.
+ */
+static void update_replacement_on_invalidate(const Cache *cache, const int set_index, const int line_index) {
+    if (cache->associativity == 1) {
+        return;
+    }
+
+    if (cache->replacement == REPLACEMENT_LRU) {
+        demote_lru_order(cache, set_index, line_index);
+        return;
+    }
+
+    cache->valid_counts[set_index]--;
+    if (cache->replacement == REPLACEMENT_SRRIP || cache->replacement == REPLACEMENT_BRRIP) {
+        cache->rrpv[(size_t)set_index * cache->associativity + line_index] = RRPV_DISTANT;
+    }
+}
+
+// --- Access Cache ---
+
+/**
+ * @brief Compares a tag against the lines of a set.
+ * Only used for associativities below RECENCY_INDEX_MIN_WAYS, so the result
+ * fits into a single mask word. The dirty flag is masked out of every line,
+ * so a single comparison checks the tag and the valid flag. Lanes beyond the
+ * set are masked out.
+ *
+ * @param lines Pointer to the first line of the set.
+ * @param ways Number of lines per set.
+ * @param tag The tag to look for.
+ * @return Bitmask with bit i set if way i holds the tag and is valid.
+ */
+CACHE_KERNEL_INLINE unsigned long match_set_tags(const uint64_t *lines, const int ways, const uint64_t tag) {
+    const uint64_t needle = (tag << CACHE_LINE_TAG_SHIFT) | CACHE_LINE_VALID;
+    const uint64_t flag_mask = ~(uint64_t)CACHE_LINE_DIRTY;
+    unsigned long matches = 0;
+
+    if (ways == 1) {
+        return (lines[0] & flag_mask) == needle;
+    }
+
+#if defined(__AVX2__)
+    const __m256i needles = _mm256_set1_epi64x((long long)needle);
+    const __m256i flag_masks = _mm256_set1_epi64x((long long)flag_mask);
+    for (int i = 0; i < ways; i += 4) {
+        const __m256i lanes = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&lines[i]), flag_masks);
+        const __m256i equal = _mm256_cmpeq_epi64(lanes, needles);
+        matches |= (unsigned long)_mm256_movemask_pd(_mm256_castsi256_pd(equal)) << i;
+    }
+#elif defined(__SSE2__)
+    // SSE2 only compares 32-bit lanes, a 64-bit lane is equal if both of its halves are
+    const __m128i needles = _mm_set1_epi64x((long long)needle);
+    const __m128i flag_masks = _mm_set1_epi64x((long long)flag_mask);
+    for (int i = 0; i < ways; i += 2) {
+        const __m128i lanes = _mm_and_si128(_mm_loadu_si128((const __m128i *)&lines[i]), flag_masks);
+        const __m128i halves = _mm_cmpeq_epi32(lanes, needles);
+        const __m128i equal = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        matches |= (unsigned long)_mm_movemask_pd(_mm_castsi128_pd(equal)) << i;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t needles = vdupq_n_u64(needle);
+    const uint64x2_t flag_masks = vdupq_n_u64(flag_mask);
+    const uint64x2_t lane_bits = {1, 2};
+    for (int i = 0; i < ways; i += 2) {
+        const uint64x2_t lanes = vandq_u64(vld1q_u64(&lines[i]), flag_masks);
+        const uint64x2_t equal = vandq_u64(vceqq_u64(lanes, needles), lane_bits);
+        matches |= (unsigned long)vaddvq_u64(equal) << i;
+    }
+#else
+    for (int i = 0; i < ways; i++) {
+        matches |= (unsigned long)((lines[i] & flag_mask) == needle) << i;
+    }
+#endif
+
+    return matches & ((1UL << ways) - 1);
+}
+
+/**
+ * @brief Finds the way holding the given tag in the specified set.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set to check.
+ * @param ways Number of lines per set.
+ * @param tag The tag value of the memory address.
+ * @return The way holding the tag, `-1` if the tag isn't cached.
+ */
+CACHE_KERNEL_INLINE int find_line_way(const Cache *cache, const int set_index, const int ways, const uint64_t tag) {
+    if (ways >= RECENCY_INDEX_MIN_WAYS) {
+        // Large associativities look the line up in the line index instead of scanning the set
+        const size_t slot = find_line_slot(cache, line_index_key(cache, set_index, tag));
+        return cache->index_keys[slot] != 0 ? cache->index_ways[slot] : -1;
+    }
+
+    const unsigned long hits = match_set_tags(get_line_word(cache, set_index, ways, 0), ways, tag);
+    return hits != 0 ? __builtin_ctzl(hits) : -1;
+}
+
+/**
+ * @brief Checks if a write policy keeps stores in the lines until they are replaced.
+ *
+ * @param write_policy The write policy of the cache.
+ * @return `true` for write-back policies, `false` for write-through policies.
+ */
+CACHE_KERNEL_INLINE bool is_write_back(const WritePolicy write_policy) {
+    return write_policy == WRITE_BACK_ALLOCATE || write_policy == WRITE_BACK_NO_ALLOCATE;
+}
+
+/**
+ * @brief Checks if a write policy fills the line of a store miss.
+ *
+ * @param write_policy The write policy of the cache.
+ * @return `true` for write-allocate policies, `false` for no-write-allocate policies.
+ */
+CACHE_KERNEL_INLINE bool is_write_allocate(const WritePolicy write_policy) {
+    return write_policy == WRITE_BACK_ALLOCATE || write_policy == WRITE_THROUGH_ALLOCATE;
+}
+
+/**
+ * @brief Writes a store that bypasses the lines to memory.
+ * With a write-combining buffer, the store is merged into the pending write
+ * of its line, or allocates an entry after the oldest pending write was
+ * written to memory if the buffer is full.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param address The address of the store.
+ */
+static void write_store_to_memory(Cache *cache, const uint64_t address) {
+    WriteCombiningBuffer *buffer = cache->write_combining;
+    if (!buffer) {
+        cache->stats.memory_writes++;
+        cache->stats.memory_write_bytes += (uint64_t)(cache->line_size < CACHE_STORE_SIZE ? cache->line_size
+                                                                                          : CACHE_STORE_SIZE);
+        return;
+    }
+
+    const uint64_t line = address >> cache->log_line_size;
+    const uint64_t chunk = 1ULL << ((address & (uint64_t)(cache->line_size - 1)) >> buffer->log_chunk_size);
+    for (int i = 0, entry = buffer->head; i < buffer->count; i++, entry = (entry + 1) % buffer->capacity) {
+        if (buffer->entries[entry].line == line) {
+            buffer->entries[entry].chunks |= chunk;
+            cache->stats.combined_writes++;
+            return;
+        }
+    }
+
+    if (buffer->count == buffer->capacity) {
+        cache->stats.memory_writes++;
+        cache->stats.memory_write_bytes += (uint64_t)__builtin_popcountll(buffer->entries[buffer->head].chunks)
+                                           << buffer->log_chunk_size;
+        buffer->head = (buffer->head + 1) % buffer->capacity;
+        buffer->count--;
+    }
+    buffer->entries[(buffer->head + buffer->count) % buffer->capacity] = (WriteCombiningEntry){line, chunk};
+    buffer->count++;
+}
+
+/**
+ * @brief Checks whether a cache hit occurs in the specified set.
+ * If a hit occurs, the replacement state and relevant statistics are updated.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param set_index The index of the set to check.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param write_policy The write policy of the cache.
+ * @param tag The tag value of the memory address.
+ * @return `true` if cache hit, `false` otherwise.
+ */
+CACHE_KERNEL_INLINE bool is_cache_hit(Cache *cache, const CacheOp *cache_op, const int set_index, const int ways,
+                                      const ReplacementPolicy policy, const WritePolicy write_policy,
+                                      const uint64_t tag) {
+    const int way = find_line_way(cache, set_index, ways, tag);
+    if (way < 0) {
+        return false;
+    }
+
+    // Cache hit: update replacement state and dirty bit (if needed), write-through stores go to memory instead
+    update_replacement_on_hit(cache, set_index, ways, policy, way);
+    if (cache_op->access_type == 's') {
+        if (is_write_back(write_policy)) {
+            *get_line_word(cache, set_index, ways, way) |= CACHE_LINE_DIRTY;
+        } else {
+            write_store_to_memory(cache, cache_op->address);
+        }
+    }
+    cache->stats.hits++;
+    return true;
+}
+
+/**
+ * @brief Replaces the victim line of a set with a new line.
+ * The replaced line is recorded as the last eviction of the cache. The
+ * sectors of the new line are left to the caller.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param tag The tag of the new line.
+ * @param is_dirty Indicates if the new line is modified.
+ * @param sectored Indicates if the lines of the cache are split into sectors.
+ * @return The way of the new line.
+ */
+CACHE_KERNEL_INLINE int replace_cache_line(Cache *cache, const int set_index, const int ways,
+                                           const ReplacementPolicy policy, const uint64_t tag, const bool is_dirty,
+                                           const bool sectored) {
+    const int lru_index = find_victim_line_index(cache, set_index, ways, policy);
+    uint64_t *lru_line = get_line_word(cache, set_index, ways, lru_index);
+    const uint64_t lru_tag = *lru_line >> CACHE_LINE_TAG_SHIFT;
+    const bool was_valid = (*lru_line & CACHE_LINE_VALID) != 0;
+    const bool was_dirty = (*lru_line & CACHE_LINE_DIRTY) != 0;
+
+    // If the victim line is dirty, perform a write-back of the line or of its dirty sectors
+    if (was_dirty) {
+        const uint64_t dirty_sectors = sectored ? cache->sector_masks[(size_t)set_index * ways + lru_index]
+                                                  >> CACHE_SECTOR_DIRTY_SHIFT : 0;
+        cache->stats.dirty_write_backs++;
+        cache->stats.write_back_bytes += sectored ? (uint64_t)__builtin_popcountll(dirty_sectors)
+                                                    << cache->log_sector_size
+                                                  : (uint64_t)cache->line_size;
+        if (cache->set_stats) {
+            cache->set_stats[set_index].dirty_write_backs++;
+        }
+    }
+
+    // Remember the replaced line, so a hierarchy can pass it on to the next level
+    cache->last_eviction.is_valid = was_valid;
+    cache->last_eviction.is_dirty = was_dirty;
+    cache->last_eviction.address = (lru_tag << (cache->log_line_size + cache->log_num_sets))
+                                   | (get_address_set_index(cache, set_index) << cache->log_line_size);
+
+    // Keep the line index in sync with the replaced line
+    if (ways >= RECENCY_INDEX_MIN_WAYS) {
+        if (was_valid) {
+            remove_line_from_index(cache, line_index_key(cache, set_index, lru_tag));
+        }
+        const size_t slot = find_line_slot(cache, line_index_key(cache, set_index, tag));
+        cache->index_keys[slot] = line_index_key(cache, set_index, tag);
+        cache->index_ways[slot] = lru_index;
+    }
+
+    // Replace the victim line with the new tag and reset flags
+    *lru_line = make_line_word(tag, is_dirty);
+
+    // Update replacement state after the miss
+    update_replacement_on_fill(cache, set_index, ways, policy, lru_index, was_valid);
+    return lru_index;
+}
+
+/**
+ * @brief Handles cache miss by replacing the victim line in a set and updating relevant cache statistics.
+ * Store misses of no-write-allocate caches are written to memory and leave
+ * the set unchanged.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param set_index The index of the set where the miss occurred.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param write_policy The write policy of the cache.
+ * @param tag The tag of the new memory address to store in the cache.
+ */
+CACHE_KERNEL_INLINE void handle_cache_miss(Cache *cache, const CacheOp *cache_op, const int set_index,
+                                           const int ways, const ReplacementPolicy policy,
+                                           const WritePolicy write_policy, const uint64_t tag) {
+    const bool is_store = cache_op->access_type == 's';
+    cache->stats.misses++;
+    if (is_store && !is_write_allocate(write_policy)) {
+        cache->last_eviction.is_valid = false;
+        write_store_to_memory(cache, cache_op->address);
+        return;
+    }
+
+    replace_cache_line(cache, set_index, ways, policy, tag, is_store && is_write_back(write_policy), false);
+    if (is_store && !is_write_back(write_policy)) {
+        write_store_to_memory(cache, cache_op->address);
+    }
+}
+
+/**
+ * @brief Simulates an access to the sector of a line in a sectored cache.
+ * An access hits if its line is cached and holds the accessed sector. If only
+ * the tag is cached, the sector miss fills the sector without replacing a
+ * line; otherwise the victim is replaced by a line holding just the sector.
+ * Store misses of no-write-allocate caches are written to memory and leave
+ * the set unchanged.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param set_index The index of the set of the access.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param write_policy The write policy of the cache.
+ * @param tag The tag value of the memory address.
+ * @return `true` if the access is a hit, `false` if it's a miss.
+ */
+CACHE_KERNEL_INLINE bool access_cache_sector(Cache *cache, const CacheOp *cache_op, const int set_index,
+                                             const int ways, const ReplacementPolicy policy,
+                                             const WritePolicy write_policy, const uint64_t tag) {
+    const bool is_store = cache_op->access_type == 's';
+    const bool is_dirty = is_store && is_write_back(write_policy);
+    const uint64_t sector = 1ULL << ((cache_op->address & (uint64_t)(cache->line_size - 1)) >> cache->log_sector_size);
+    int way = find_line_way(cache, set_index, ways, tag);
+    const bool is_hit = way >= 0 && (cache->sector_masks[(size_t)set_index * ways + way] & sector) != 0;
+    if (is_hit) {
+        cache->stats.hits++;
+    } else {
+        cache->stats.misses++;
+        cache->stats.sector_misses += way >= 0;
+        if (is_store && !is_write_allocate(write_policy)) {
+            cache->last_eviction.is_valid = false;
+            write_store_to_memory(cache, cache_op->address);
+            return false;
+        }
+    }
+
+    if (way >= 0) {
+        // The line stays in place, a sector miss replaces nothing
+        update_replacement_on_hit(cache, set_index, ways, policy, way);
+        if (!is_hit) {
+            cache->last_eviction.is_valid = false;
+        }
+        if (is_dirty) {
+            *get_line_word(cache, set_index, ways, way) |= CACHE_LINE_DIRTY;
+        }
+    } else {
+        way = replace_cache_line(cache, set_index, ways, policy, tag, is_dirty, true);
+        cache->sector_masks[(size_t)set_index * ways + way] = 0;
+    }
+    cache->sector_masks[(size_t)set_index * ways + way] |= sector | (is_dirty ? sector << CACHE_SECTOR_DIRTY_SHIFT : 0);
+    if (is_store && !is_write_back(write_policy)) {
+        write_store_to_memory(cache, cache_op->address);
+    }
+    return is_hit;
+}
+
+/**
+ * @brief Simulates a cache access to a known set with the given number of lines.
+ * Kernels pass a constant associativity, replacement and write policy, so the
+ * compiler folds the dispatch on the replacement state and the store
+ * handling and fully unrolls the tag comparison.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param set_index The index of the set of the access.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param write_policy The write policy of the cache.
+ * @param sectored Indicates if the lines of the cache are split into sectors.
+ * @param tag The tag value of the memory address.
+ * @return `true` if the access is a hit, `false` if it's a miss.
+ */
+CACHE_KERNEL_INLINE bool access_cache_set(Cache *cache, const CacheOp *cache_op, const int set_index,
+                                          const int ways, const ReplacementPolicy policy,
+                                          const WritePolicy write_policy, const bool sectored, const uint64_t tag) {
+    if (sectored) {
+        const bool is_hit = access_cache_sector(cache, cache_op, set_index, ways, policy, write_policy, tag);
+        if (cache->set_stats) {
+            cache->set_stats[set_index].hits += is_hit;
+            cache->set_stats[set_index].misses += !is_hit;
+        }
+        return is_hit;
+    }
+
+    // Check for cache hit
+    if (is_cache_hit(cache, cache_op, set_index, ways, policy, write_policy, tag)) {
+        if (cache->set_stats) {
+            cache->set_stats[set_index].hits++;
+        }
+        return true;
+    }
+
+    // Cache miss handling
+    handle_cache_miss(cache, cache_op, set_index, ways, policy, write_policy, tag);
+    if (cache->set_stats) {
+        cache->set_stats[set_index].misses++;
+    }
+    return false;
+}
+
+/**
+ * @brief Simulates a cache access for a set with the given number of lines.
+ * Accesses to sets outside the sample of a sampled cache are skipped.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param write_policy The write policy of the cache.
+ * @param sectored Indicates if the lines of the cache are split into sectors.
+ * @return `true` if the access is a hit or skipped, `false` if it's a miss.
+ */
+CACHE_KERNEL_INLINE bool access_cache_lines(Cache *cache, const CacheOp *cache_op, const int ways,
+                                            const ReplacementPolicy policy, const WritePolicy write_policy,
+                                            const bool sectored) {
+    const int set_index = locate_cache_set(cache_op->address, cache);
+    if (set_index < 0) {
+        return true;
+    }
+    const uint64_t tag = extract_tag_number(cache_op->address, cache);
+    return access_cache_set(cache, cache_op, set_index, ways, policy, write_policy, sectored, tag);
+}
+
+/**
+ * @brief Prefetches the metadata an upcoming access to a set will read.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set, `-1` if it isn't part of the sample.
+ * @param ways Number of lines per set.
+ * @param tag The tag value of the memory address.
+ */
+CACHE_KERNEL_INLINE void prefetch_cache_set(const Cache *cache, const int set_index, const int ways,
+                                            const uint64_t tag) {
+    if (set_index < 0) {
+        return; // Not part of the sample
+    }
+    if (ways >= RECENCY_INDEX_MIN_WAYS) {
+        __builtin_prefetch(&cache->index_keys[hash_line_address(line_index_key(cache, set_index, tag),
+                                                                cache->index_capacity)]);
+        return;
+    }
+
+    // Sets are aligned, so a set of up to 8 lines never crosses a cache line
+    const uint64_t *lines = get_line_word(cache, set_index, ways, 0);
+    __builtin_prefetch(lines);
+    if (ways * sizeof(uint64_t) > CACHE_ALIGNMENT) {
+        __builtin_prefetch(&lines[CACHE_ALIGNMENT / sizeof(uint64_t)]);
+    }
+}
+
+/**
+ * @brief Simulates a batch of cache accesses for sets with the given number of lines.
+ * The batch is processed in blocks: the set indices and tags of a block are
+ * computed up front, and the sets of later accesses are prefetched while
+ * earlier ones are simulated.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ * @param hit_bitmap Bitmap receiving one bit per operation (set on a hit), may be `NULL`.
+ * @param ways Number of lines per set.
+ * @param policy The replacement policy of the cache.
+ * @param write_policy The write policy of the cache.
+ * @param sectored Indicates if the lines of the cache are split into sectors.
+ * @return The number of hits in the batch.
+ */
+CACHE_KERNEL_INLINE size_t access_cache_block(Cache *cache, const CacheOp *cache_ops, const size_t num_ops,
+                                              uint8_t *hit_bitmap, const int ways, const ReplacementPolicy policy,
+                                              const WritePolicy write_policy, const bool sectored) {
+    int set_indices[CACHE_BATCH_BLOCK];
+    uint64_t tags[CACHE_BATCH_BLOCK];
+    size_t hit_count = 0;
+
+    if (hit_bitmap) {
+        memset(hit_bitmap, 0, (num_ops + 7) / 8);
+    }
+
+    for (size_t start = 0; start < num_ops; start += CACHE_BATCH_BLOCK) {
+        const size_t count = num_ops - start < CACHE_BATCH_BLOCK ? num_ops - start : CACHE_BATCH_BLOCK;
+        const CacheOp *block = &cache_ops[start];
+
+        // Decode the addresses of the whole block
+        for (size_t i = 0; i < count; i++) {
+            set_indices[i] = locate_cache_set(block[i].address, cache);
+            tags[i] = extract_tag_number(block[i].address, cache);
+        }
+        for (size_t i = 0; i < count && i < CACHE_PREFETCH_DISTANCE; i++) {
+            prefetch_cache_set(cache, set_indices[i], ways, tags[i]);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (i + CACHE_PREFETCH_DISTANCE < count) {
+                const size_t next = i + CACHE_PREFETCH_DISTANCE;
+                prefetch_cache_set(cache, set_indices[next], ways, tags[next]);
+            }
+
+            // Skipped accesses of a sampled cache count like hits, as in access_cache_lines
+            if (set_indices[i] < 0
+                || access_cache_set(cache, &block[i], set_indices[i], ways, policy, write_policy, sectored,
+                                    tags[i])) {
+                hit_count++;
+                if (hit_bitmap) {
+                    hit_bitmap[(start + i) / 8] |= (uint8_t)(1U << ((start + i) % 8));
+                }
+            }
+        }
+    }
+
+    return hit_count;
+}
+
+// --- Access Kernels ---
+
+/**
+ * @brief Defines the single and batch access kernels for a cache with a fixed associativity, replacement policy,
+ * write policy and sectoring.
+ */
+#define DEFINE_ACCESS_KERNEL(name, ways, policy, write, sectored) \
+    static bool name(Cache *cache, const CacheOp *cache_op) { \
+        return access_cache_lines(cache, cache_op, ways, policy, write, sectored); \
+    } \
+    static size_t name##_batch(Cache *cache, const CacheOp *cache_ops, const size_t num_ops, \
+                               uint8_t *hit_bitmap) { \
+        return access_cache_block(cache, cache_ops, num_ops, hit_bitmap, ways, policy, write, sectored); \
+    }
+
+/**
+ * @brief Defines the kernels of a replacement policy for all specialized geometries.
+ * Fully associative caches use the line index and skip the set extraction;
+ * their batch kernel is the generic one. The associativity of the generic
+ * kernels is read at run time.
+ */
+#define DEFINE_POLICY_KERNELS(suffix, policy, write) \
+    DEFINE_ACCESS_KERNEL(access_cache_2_way_##suffix, 2, policy, write, false) \
+    DEFINE_ACCESS_KERNEL(access_cache_4_way_##suffix, 4, policy, write, false) \
+    DEFINE_ACCESS_KERNEL(access_cache_8_way_##suffix, 8, policy, write, false) \
+    DEFINE_ACCESS_KERNEL(access_cache_16_way_##suffix, 16, policy, write, false) \
+    DEFINE_ACCESS_KERNEL(access_cache_generic_##suffix, cache->associativity, policy, write, false) \
+    static bool access_cache_fully_associative_##suffix(Cache *cache, const CacheOp *cache_op) { \
+        const uint64_t tag = extract_tag_number(cache_op->address, cache); \
+        return access_cache_set(cache, cache_op, 0, cache->associativity, policy, write, false, tag); \
+    }
+
+/**
+ * @brief Defines the kernels of a write policy for all replacement policies and geometries.
+ * Direct-mapped sets hold a single line, so they need no replacement policy.
+ * The kernels of the default policy keep the plain names.
+ */
+#define DEFINE_WRITE_POLICY_KERNELS(suffix, write) \
+    DEFINE_ACCESS_KERNEL(access_cache_direct_mapped##suffix, 1, REPLACEMENT_LRU, write, false) \
+    DEFINE_POLICY_KERNELS(lru##suffix, REPLACEMENT_LRU, write) \
+    DEFINE_POLICY_KERNELS(plru##suffix, REPLACEMENT_PLRU, write) \
+    DEFINE_POLICY_KERNELS(srrip##suffix, REPLACEMENT_SRRIP, write) \
+    DEFINE_POLICY_KERNELS(brrip##suffix, REPLACEMENT_BRRIP, write) \
+    DEFINE_POLICY_KERNELS(fifo##suffix, REPLACEMENT_FIFO, write) \
+    DEFINE_POLICY_KERNELS(random##suffix, REPLACEMENT_RANDOM, write)
+
+/**
+ * @brief Defines the kernels of sectored caches of a write policy for all replacement policies.
+ * Sectored caches are rare enough to read their associativity at run time,
+ * so a single generic kernel per policy covers all geometries.
+ */
+#define DEFINE_SECTORED_KERNELS(suffix, write) \
+    DEFINE_ACCESS_KERNEL(access_cache_sectored_lru##suffix, cache->associativity, REPLACEMENT_LRU, write, true) \
+    DEFINE_ACCESS_KERNEL(access_cache_sectored_plru##suffix, cache->associativity, REPLACEMENT_PLRU, write, true) \
+    DEFINE_ACCESS_KERNEL(access_cache_sectored_srrip##suffix, cache->associativity, REPLACEMENT_SRRIP, write, true) \
+    DEFINE_ACCESS_KERNEL(access_cache_sectored_brrip##suffix, cache->associativity, REPLACEMENT_BRRIP, write, true) \
+    DEFINE_ACCESS_KERNEL(access_cache_sectored_fifo##suffix, cache->associativity, REPLACEMENT_FIFO, write, true) \
+    DEFINE_ACCESS_KERNEL(access_cache_sectored_random##suffix, cache->associativity, REPLACEMENT_RANDOM, write, true)
+
+/**
+ * @brief Lists the kernels of a replacement policy in the order of AccessKernelGeometry.
+ */
+#define POLICY_KERNELS(suffix) { \
+    {access_cache_2_way_##suffix, access_cache_2_way_##suffix##_batch}, \
+    {access_cache_4_way_##suffix, access_cache_4_way_##suffix##_batch}, \
+    {access_cache_8_way_##suffix, access_cache_8_way_##suffix##_batch}, \
+    {access_cache_16_way_##suffix, access_cache_16_way_##suffix##_batch}, \
+    {access_cache_generic_##suffix, access_cache_generic_##suffix##_batch}, \
+    {access_cache_fully_associative_##suffix, access_cache_generic_##suffix##_batch}, \
+}
+
+/**
+ * @brief Lists the kernels of a write policy in the order of ReplacementPolicy.
+ */
+#define WRITE_POLICY_KERNELS(suffix) { \
+    POLICY_KERNELS(lru##suffix), \
+    POLICY_KERNELS(plru##suffix), \
+    POLICY_KERNELS(srrip##suffix), \
+    POLICY_KERNELS(brrip##suffix), \
+    POLICY_KERNELS(fifo##suffix), \
+    POLICY_KERNELS(random##suffix), \
+}
+
+/**
+ * @brief Lists the sectored kernels of a write policy in the order of ReplacementPolicy.
+ */
+#define SECTORED_KERNELS(suffix) { \
+    {access_cache_sectored_lru##suffix, access_cache_sectored_lru##suffix##_batch}, \
+    {access_cache_sectored_plru##suffix, access_cache_sectored_plru##suffix##_batch}, \
+    {access_cache_sectored_srrip##suffix, access_cache_sectored_srrip##suffix##_batch}, \
+    {access_cache_sectored_brrip##suffix, access_cache_sectored_brrip##suffix##_batch}, \
+    {access_cache_sectored_fifo##suffix, access_cache_sectored_fifo##suffix##_batch}, \
+    {access_cache_sectored_random##suffix, access_cache_sectored_random##suffix##_batch}, \
+}
+
+/**
+ * @brief Geometries with specialized kernels for every replacement policy.
+ */
+typedef enum AccessKernelGeometry {
+    KERNEL_2_WAY,
+    KERNEL_4_WAY,
+    KERNEL_8_WAY,
+    KERNEL_16_WAY,
+    KERNEL_GENERIC,
+    KERNEL_FULLY_ASSOCIATIVE,
+    KERNEL_GEOMETRY_COUNT,
+} AccessKernelGeometry;
+
+/**
+ * @brief Single and batch access kernel of a geometry.
+ */
+typedef struct AccessKernels {
+    CacheAccessKernel access;
+    CacheBatchKernel batch;
+} AccessKernels;
+
+DEFINE_WRITE_POLICY_KERNELS(, WRITE_BACK_ALLOCATE)
+DEFINE_WRITE_POLICY_KERNELS(_wb_nwa, WRITE_BACK_NO_ALLOCATE)
+DEFINE_WRITE_POLICY_KERNELS(_wt, WRITE_THROUGH_ALLOCATE)
+DEFINE_WRITE_POLICY_KERNELS(_wt_nwa, WRITE_THROUGH_NO_ALLOCATE)
+DEFINE_SECTORED_KERNELS(, WRITE_BACK_ALLOCATE)
+DEFINE_SECTORED_KERNELS(_wb_nwa, WRITE_BACK_NO_ALLOCATE)
+DEFINE_SECTORED_KERNELS(_wt, WRITE_THROUGH_ALLOCATE)
+DEFINE_SECTORED_KERNELS(_wt_nwa, WRITE_THROUGH_NO_ALLOCATE)
+
+/**
+ * @brief Direct-mapped kernels of every write policy.
+ */
+static const AccessKernels direct_mapped_kernels[WRITE_POLICY_COUNT] = {
+    {access_cache_direct_mapped, access_cache_direct_mapped_batch},
+    {access_cache_direct_mapped_wb_nwa, access_cache_direct_mapped_wb_nwa_batch},
+    {access_cache_direct_mapped_wt, access_cache_direct_mapped_wt_batch},
+    {access_cache_direct_mapped_wt_nwa, access_cache_direct_mapped_wt_nwa_batch},
+};
+
+/**
+ * @brief Kernels of every write and replacement policy, indexed by write policy, replacement policy and geometry.
+ */
+static const AccessKernels access_kernels[WRITE_POLICY_COUNT][REPLACEMENT_POLICY_COUNT][KERNEL_GEOMETRY_COUNT] = {
+    WRITE_POLICY_KERNELS(),
+    WRITE_POLICY_KERNELS(_wb_nwa),
+    WRITE_POLICY_KERNELS(_wt),
+    WRITE_POLICY_KERNELS(_wt_nwa),
+};
+
+/**
+ * @brief Kernels of sectored caches, indexed by write policy and replacement policy.
+ */
+static const AccessKernels sectored_kernels[WRITE_POLICY_COUNT][REPLACEMENT_POLICY_COUNT] = {
+    SECTORED_KERNELS(),
+    SECTORED_KERNELS(_wb_nwa),
+    SECTORED_KERNELS(_wt),
+    SECTORED_KERNELS(_wt_nwa),
+};
+
+/**
+ * @brief Selects the access kernels matching the geometry, the replacement and the write policy of a cache.
+ * Uncommon geometries and sectored caches use the generic kernels of the policy.
+ *
+ * @param cache Pointer to the Cache object receiving the kernels.
+ */
+static void select_access_kernels(Cache *cache) {
+    if (cache->sector_masks) {
+        cache->access_kernel = sectored_kernels[cache->write_policy][cache->replacement].access;
+        cache->batch_kernel = sectored_kernels[cache->write_policy][cache->replacement].batch;
+        return;
+    }
+    if (cache->associativity == 1) {
+        cache->access_kernel = direct_mapped_kernels[cache->write_policy].access;
+        cache->batch_kernel = direct_mapped_kernels[cache->write_policy].batch;
+        return;
+    }
+
+    AccessKernelGeometry geometry;
+    if (cache->num_sets == 1 && cache->associativity >= RECENCY_INDEX_MIN_WAYS) {
+        geometry = KERNEL_FULLY_ASSOCIATIVE;
+    } else {
+        switch (cache->associativity) {
+            case 2: geometry = KERNEL_2_WAY; break;
+            case 4: geometry = KERNEL_4_WAY; break;
+            case 8: geometry = KERNEL_8_WAY; break;
+            case 16: geometry = KERNEL_16_WAY; break;
+            default: geometry = KERNEL_GENERIC; break;
+        }
+    }
+
+    cache->access_kernel = access_kernels[cache->write_policy][cache->replacement][geometry].access;
+    cache->batch_kernel = access_kernels[cache->write_policy][cache->replacement][geometry].batch;
+}
+
+bool access_cache(Cache *cache, const CacheOp *cache_op) {
+    return cache->access_kernel(cache, cache_op);
+}
+
+size_t access_cache_batch(Cache *cache, const CacheOp *cache_ops, const size_t num_ops, uint8_t *hit_bitmap_out) {
+    return cache->batch_kernel(cache, cache_ops, num_ops, hit_bitmap_out);
+}
+
+// --- Functional Warming ---
+
+void warm_cache(Cache *cache, const CacheOp *cache_op) {
+    // Run the regular kernel and roll back the statistics it touched
+    const CacheStats stats = cache->stats;
+    const int set_index = cache->set_stats ? locate_cache_set(cache_op->address, cache) : -1;
+    const CacheStats set_stats = set_index >= 0 ? cache->set_stats[set_index] : stats;
+
+    cache->access_kernel(cache, cache_op);
+
+    cache->stats = stats;
+    if (set_index >= 0) {
+        cache->set_stats[set_index] = set_stats;
+    }
+}
+
+void warm_cache_batch(Cache *cache, const CacheOp *cache_ops, const size_t num_ops) {
+    if (cache->set_stats) {
+        // The statistics of every sampled set would have to be rolled back
+        for (size_t i = 0; i < num_ops; i++) {
+            warm_cache(cache, &cache_ops[i]);
+        }
+        return;
+    }
+
+    const CacheStats stats = cache->stats;
+    cache->batch_kernel(cache, cache_ops, num_ops, NULL);
+    cache->stats = stats;
+}
+
+// --- Set Partitions ---
+
+int get_max_cache_partitions(const Cache *cache) {
+    // The prefetcher and the write-combining buffer observe the accesses of all sets in trace order
+    return cache->index_capacity != 0 || cache->prefetcher || cache->write_combining ? 1 : cache->num_sampled_sets;
+}
+
+Cache* initialize_cache_partition(const Cache *cache, const int partition) {
+    Cache *view = allocate_or_exit(1, sizeof(Cache), "cache partition");
+    *view = *cache;
+    view->stats = (CacheStats){0};
+    view->last_eviction = (CacheEviction){0, false, false};
+
+    // Derive a distinct, non-zero generator state for every partition
+    view->random_state = (cache->random_state ^ ((uint64_t)partition * CACHE_RANDOM_SEED)) | 1;
+    return view;
+}
+
+void merge_cache_partition(Cache *cache, Cache *partition) {
+    cache->stats.hits += partition->stats.hits;
+    cache->stats.misses += partition->stats.misses;
+    cache->stats.dirty_write_backs += partition->stats.dirty_write_backs;
+    cache->stats.memory_writes += partition->stats.memory_writes;
+    cache->stats.memory_write_bytes += partition->stats.memory_write_bytes;
+    cache->stats.combined_writes += partition->stats.combined_writes;
+    cache->stats.write_back_bytes += partition->stats.write_back_bytes;
+    cache->stats.sector_misses += partition->stats.sector_misses;
+    free(partition);
+}
+
+size_t select_cache_partition(const Cache *cache, const CacheOp *cache_ops, const size_t num_ops,
+                              const int first_set, const int end_set, CacheOp *selected_ops) {
+    size_t count = 0;
+    for (size_t i = 0; i < num_ops; i++) {
+        const int set_index = locate_cache_set(cache_ops[i].address, cache);
+        if (set_index >= first_set && set_index < end_set) {
+            selected_ops[count++] = cache_ops[i];
+        }
+    }
+    return count;
+}
+
+// --- Line Management ---
+
+bool invalidate_cache_line(Cache *cache, const uint64_t address, bool *was_dirty) {
+    const int ways = cache->associativity;
+    const int set_index = locate_cache_set(address, cache);
+    const uint64_t tag = extract_tag_number(address, cache);
+    const int way = set_index < 0 ? -1 : find_line_way(cache, set_index, ways, tag);
+    if (way < 0) {
+        *was_dirty = false;
+        return false;
+    }
+
+    uint64_t *line = get_line_word(cache, set_index, ways, way);
+    *was_dirty = (*line & CACHE_LINE_DIRTY) != 0;
+    if (ways >= RECENCY_INDEX_MIN_WAYS) {
+        remove_line_from_index(cache, line_index_key(cache, set_index, tag));
+    }
+
+    // The free line is the first one to be replaced
+    *line = 0;
+    if (cache->sector_masks) {
+        cache->sector_masks[(size_t)set_index * ways + way] = 0;
+    }
+    update_replacement_on_invalidate(cache, set_index, way);
+    return true;
+}
+
+bool contains_cache_line(const Cache *cache, const uint64_t address) {
+    const int set_index = locate_cache_set(address, cache);
+    if (set_index < 0) {
+        return true; // Not part of the sample
+    }
+    return find_line_way(cache, set_index, cache->associativity, extract_tag_number(address, cache)) >= 0;
+}
+
+bool clean_cache_line(Cache *cache, const uint64_t address) {
+    const int ways = cache->associativity;
+    const int set_index = locate_cache_set(address, cache);
+    const int way = set_index < 0 ? -1 : find_line_way(cache, set_index, ways, extract_tag_number(address, cache));
+    if (way < 0) {
+        return false;
+    }
+
+    uint64_t *line = get_line_word(cache, set_index, ways, way);
+    const bool was_dirty = (*line & CACHE_LINE_DIRTY) != 0;
+    *line &= ~(uint64_t)CACHE_LINE_DIRTY;
+    if (cache->sector_masks) {
+        cache->sector_masks[(size_t)set_index * ways + way] &= (1ULL << CACHE_SECTOR_DIRTY_SHIFT) - 1;
+    }
+    return was_dirty;
+}
+
+/**
+ * @brief Fills all sectors of a line installed as a whole.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param set_index The index of the set.
+ * @param way The way of the line.
+ * @param is_dirty Indicates if the installed line is modified.
+ */
+static void fill_line_sectors(const Cache *cache, const int set_index, const int way, const bool is_dirty) {
+    if (!cache->sector_masks) {
+        return;
+    }
+    const uint64_t sectors = (1ULL << (1 << cache->log_sectors)) - 1;
+    cache->sector_masks[(size_t)set_index * cache->associativity + way] |=
+        sectors | (is_dirty ? sectors << CACHE_SECTOR_DIRTY_SHIFT : 0);
+}
+
+void install_cache_line(Cache *cache, const uint64_t address, const bool is_dirty) {
+    const int ways = cache->associativity;
+    const int set_index = locate_cache_set(address, cache);
+    const uint64_t tag = extract_tag_number(address, cache);
+    if (set_index < 0) {
+        cache->last_eviction.is_valid = false; // Not part of the sample
+        return;
+    }
+    const int way = find_line_way(cache, set_index, ways, tag);
+
+    if (way >= 0) {
+        // The line is already cached, only its state changes
+        cache->last_eviction.is_valid = false;
+        update_replacement_on_hit(cache, set_index, ways, cache->replacement, way);
+        if (is_dirty) {
+            *get_line_word(cache, set_index, ways, way) |= CACHE_LINE_DIRTY;
+        }
+        fill_line_sectors(cache, set_index, way, is_dirty);
+        return;
+    }
+
+    const bool sectored = cache->sector_masks != NULL;
+    const int new_way = replace_cache_line(cache, set_index, ways, cache->replacement, tag, is_dirty, sectored);
+    if (sectored) {
+        cache->sector_masks[(size_t)set_index * ways + new_way] = 0;
+    }
+    fill_line_sectors(cache, set_index, new_way, is_dirty);
+}
+
+bool extract_cache_line(Cache *cache, const CacheOp *cache_op, bool *was_dirty) {
+    if (invalidate_cache_line(cache, cache_op->address, was_dirty)) {
+        cache->stats.hits++;
+        return true;
+    }
+    cache->stats.misses++;
+    return false;
+}
+
+bool parse_replacement_policy(const char *name, ReplacementPolicy *replacement) {
+    for (int policy = 0; policy < REPLACEMENT_POLICY_COUNT; policy++) {
+        if (strcmp(name, get_replacement_policy_name((ReplacementPolicy)policy)) == 0) {
+            *replacement = (ReplacementPolicy)policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* get_replacement_policy_name(const ReplacementPolicy replacement) {
+    static const char *const names[REPLACEMENT_POLICY_COUNT] = {"lru", "plru", "srrip", "brrip", "fifo", "random"};
+    return names[replacement];
+}
+
+bool parse_write_policy(const char *name, WritePolicy *write_policy) {
+    for (int policy = 0; policy < WRITE_POLICY_COUNT; policy++) {
+        if (strcmp(name, get_write_policy_name((WritePolicy)policy)) == 0) {
+            *write_policy = (WritePolicy)policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* get_write_policy_name(const WritePolicy write_policy) {
+    static const char *const names[WRITE_POLICY_COUNT] = {"wb", "wb-nwa", "wt", "wt-nwa"};
+    return names[write_policy];
+}
+
+// --- Cache State Files ---
+
+void save_cache_state(const Cache *cache, const char *path) {
+    FILE *output = fopen(path, "wb");
+    if (output == NULL) {
+        perror("Failed to open cache state file");
+        exit(EXIT_FAILURE);
+    }
+
+    // The header is padded to CACHE_STATE_DATA_OFFSET, so the arena starts on a page boundary
+    static char header_page[CACHE_STATE_DATA_OFFSET];
+    const WriteCombiningBuffer *buffer = cache->write_combining;
+    CacheStateHeader header = {
+        CACHE_STATE_MAGIC, CACHE_STATE_VERSION, sizeof(CacheStateHeader),
+        cache->associativity, cache->cache_size, cache->line_size, cache->miss_penalty, cache->dirty_wb_penalty,
+        (int32_t)cache->replacement, cache->sample_rate, (int32_t)cache->write_policy, 1 << cache->log_sectors,
+        buffer ? buffer->capacity : 0, buffer ? buffer->count : 0, cache->stats, cache->random_state,
+        cache->arena_used,
+    };
+    for (int i = 0; i < header.combining_count; i++) {
+        header.combining_writes[i] = buffer->entries[(buffer->head + i) % buffer->capacity];
+    }
+    memset(header_page, 0, sizeof(header_page));
+    memcpy(header_page, &header, sizeof(header));
+
+    if (fwrite(header_page, sizeof(header_page), 1, output) != 1
+        || fwrite(cache->arena, 1, cache->arena_used, output) != cache->arena_used || fclose(output) != 0) {
+        perror("Failed to write cache state file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Checks the configuration stored in a cache state header.
+ * The checks only guard the layout computation against corrupt files; the
+ * configuration was validated when the state was saved.
+ *
+ * @param header Pointer to the CacheStateHeader object.
+ * @return `true` if the configuration describes a cache, `false` otherwise.
+ */
+static bool is_valid_state_configuration(const CacheStateHeader *header) {
+    const int32_t values[] = {header->associativity, header->cache_size, header->line_size, header->sample_rate,
+                              header->sectors};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        if (values[i] <= 0 || (values[i] & (values[i] - 1)) != 0) {
+            return false;
+        }
+    }
+    return header->replacement >= 0 && header->replacement < REPLACEMENT_POLICY_COUNT
+           && header->write_policy >= 0 && header->write_policy < WRITE_POLICY_COUNT
+           && header->combining_entries >= 0 && header->combining_entries <= CACHE_MAX_COMBINING_ENTRIES
+           && (header->combining_entries == 0 || header->write_policy != WRITE_BACK_ALLOCATE)
+           && header->combining_count >= 0 && header->combining_count <= header->combining_entries
+           && header->sectors <= CACHE_MAX_SECTORS && header->sectors <= header->line_size
+           && (int64_t)header->line_size * header->associativity <= (int64_t)header->cache_size * 1024;
+}
+
+Cache* load_cache_state(const char *path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open cache state file");
+        exit(EXIT_FAILURE);
+    }
+
+    CacheStateHeader header;
+    if (read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)
+        || memcmp(header.magic, CACHE_STATE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s is not a cache state file.\n", path);
+        exit(EXIT_FAILURE);
+    }
+    if (header.version != CACHE_STATE_VERSION || header.header_size != sizeof(CacheStateHeader)) {
+        fprintf(stderr, "Unsupported cache state version %u (header size %u).\n", header.version,
+                header.header_size);
+        exit(EXIT_FAILURE);
+    }
+    if (!is_valid_state_configuration(&header)) {
+        fprintf(stderr, "Corrupt cache state file %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    Cache *cache = allocate_or_exit(1, sizeof(Cache), "cache");
+    configure_cache(cache, header.associativity, header.cache_size, header.line_size, header.miss_penalty,
+                    header.dirty_wb_penalty, (ReplacementPolicy)header.replacement, header.sample_rate);
+    cache->log_sectors = log2_int(header.sectors);
+    cache->log_sector_size = cache->log_line_size - cache->log_sectors;
+
+    // The arena layout is recomputed from the configuration, so it must match the saved one
+    const size_t size = layout_cache_arena(cache, NULL);
+    struct stat file_stat;
+    if (header.arena_size != size || fstat(fd, &file_stat) != 0
+        || (uint64_t)file_stat.st_size < CACHE_STATE_DATA_OFFSET + header.arena_size) {
+        fprintf(stderr, "Corrupt cache state file %s.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    // Map the arena copy-on-write, so every process continuing from the same state shares its pages
+    cache->arena_size = size;
+    cache->arena = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, CACHE_STATE_DATA_OFFSET);
+    cache->arena_is_mapped = cache->arena != MAP_FAILED;
+    if (!cache->arena_is_mapped) {
+        // Systems whose pages are larger than the header read the arena instead
+        allocate_cache_arena(cache, size, NULL);
+        if (pread(fd, cache->arena, size, CACHE_STATE_DATA_OFFSET) != (ssize_t)size) {
+            perror("Failed to read cache state file");
+            exit(EXIT_FAILURE);
+        }
+    }
+    close(fd);
+
+    layout_cache_arena(cache, (char *)cache->arena);
+    cache->stats = header.stats;
+    cache->random_state = header.random_state;
+    set_write_policy(cache, (WritePolicy)header.write_policy, header.combining_entries);
+    if (cache->write_combining) {
+        cache->write_combining->count = header.combining_count;
+        memcpy(cache->write_combining->entries, header.combining_writes,
+               (size_t)header.combining_count * sizeof(WriteCombiningEntry));
+    }
+    return cache;
+}
+
+// --- Cache Statistics ---
+
+/**
+ * @brief Computes the half-width of the 95% confidence interval of an extrapolated counter.
+ * The sampled sets are clusters of a simple random sample without
+ * replacement, so the variance of the extrapolated total is
+ * `N^2 * (1 - n / N) / n * S^2`, where `S^2` is the variance of the counter
+ * between the sampled sets.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param sum Sum of the counter over the sampled sets.
+ * @param sum_of_squares Sum of the squared counter over the sampled sets.
+ * @return The half-width of the confidence interval of the extrapolated total.
+ */
+static double get_sample_error(const Cache *cache, const double sum, const double sum_of_squares) {
+    const double n = cache->num_sampled_sets;
+    const double num_sets = cache->num_sets;
+    const double set_variance = (sum_of_squares - sum * sum / n) / (n - 1);
+    const double variance = num_sets * num_sets * (1.0 - n / num_sets) / n * set_variance;
+    return CONFIDENCE_Z * sqrt(variance > 0 ? variance : 0);
+}
+
+CacheSampleEstimate estimate_sampled_stats(const Cache *cache) {
+    CacheSampleEstimate estimate = {cache->stats.misses, 0, cache->stats.dirty_write_backs, 0};
+    if (!cache->set_stats) {
+        return estimate; // Every set is simulated, the counts are exact
+    }
+
+    // The misses of a set hardly depend on its number of accesses, so the counts are expanded by the sample rate
+    double miss_squares = 0;
+    double write_back_squares = 0;
+    for (int i = 0; i < cache->num_sampled_sets; i++) {
+        const CacheStats *stats = &cache->set_stats[i];
+        miss_squares += (double) stats->misses * stats->misses;
+        write_back_squares += (double) stats->dirty_write_backs * stats->dirty_write_backs;
+    }
+
+    estimate.misses = (double) cache->stats.misses * cache->sample_rate;
+    estimate.misses_error = get_sample_error(cache, cache->stats.misses, miss_squares);
+    estimate.dirty_write_backs = (double) cache->stats.dirty_write_backs * cache->sample_rate;
+    estimate.dirty_write_backs_error = get_sample_error(cache, cache->stats.dirty_write_backs, write_back_squares);
+    return estimate;
+}
+
+uint64_t get_cache_hits(const Cache *cache) {
+    return cache->stats.hits;
+}
+
+uint64_t get_cache_misses(const Cache *cache) {
+    return cache->stats.misses;
+}
+
+uint64_t get_dirty_write_backs(const Cache *cache) {
     return cache->stats.dirty_write_backs;
 }
+
+uint64_t get_memory_writes(const Cache *cache) {
+    const uint64_t pending = cache->write_combining ? (uint64_t)cache->write_combining->count : 0;
+    return cache->stats.dirty_write_backs + cache->stats.memory_writes + pending;
+}
+
+uint64_t get_write_back_bytes(const Cache *cache) {
+    return cache->stats.write_back_bytes;
+}
+
+uint64_t get_memory_write_bytes(const Cache *cache) {
+    uint64_t bytes = cache->stats.write_back_bytes + cache->stats.memory_write_bytes;
+    const WriteCombiningBuffer *buffer = cache->write_combining;
+    for (int i = 0; buffer && i < buffer->count; i++) {
+        const uint64_t chunks = buffer->entries[(buffer->head + i) % buffer->capacity].chunks;
+        bytes += (uint64_t)__builtin_popcountll(chunks) << buffer->log_chunk_size;
+    }
+    return bytes;
+}
+
+// --- Stack Distance Analysis ---
+
+/**
+ * @brief Initial number of time stamps of a set and initial number of index slots.
+ */
+enum {
+    STACK_DISTANCE_INITIAL_CAPACITY = 16,
+    STACK_DISTANCE_INITIAL_INDEX = 1 << 12,
+};
+
+/**
+ * @brief Finds the slot of a line address in the index, or the empty slot where it belongs.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ * @param key Line address + 1.
+ * @return The slot of the key.
+ */
+static size_t find_index_slot(const StackDistance *stack_distance, const uint64_t key) {
+    size_t slot = hash_line_address(key, stack_distance->index_capacity);
+    while (stack_distance->index_keys[slot] != 0 && stack_distance->index_keys[slot] != key) {
+        slot = (slot + 1) & (stack_distance->index_capacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * @brief Doubles the number of slots of the index and rehashes all lines.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ */
+static void grow_line_index(StackDistance *stack_distance) {
+    uint64_t *old_keys = stack_distance->index_keys;
+    int *old_times = stack_distance->index_times;
+    const size_t old_capacity = stack_distance->index_capacity;
+
+    stack_distance->index_capacity *= 2;
+    stack_distance->index_keys = allocate_or_exit(stack_distance->index_capacity, sizeof(uint64_t),
+                                                  "stack distance index");
+    stack_distance->index_times = allocate_or_exit(stack_distance->index_capacity, sizeof(int),
+                                                   "stack distance index");
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_keys[i] != 0) {
+            const size_t slot = find_index_slot(stack_distance, old_keys[i]);
+            stack_distance->index_keys[slot] = old_keys[i];
+            stack_distance->index_times[slot] = old_times[i];
+        }
+    }
+
+    free(old_keys);
+    free(old_times);
+}
+
+/**
+ * @brief Adds a value to a time stamp of the Fenwick tree of a set.
+ *
+ * @param set Pointer to the StackDistanceSet object.
+ * @param time The 0-based time stamp.
+ * @param delta The value to add.
+ */
+static void update_stack_tree(const StackDistanceSet *set, const int time, const int delta) {
+    for (int i = time + 1; i <= set->capacity; i += i & -i) {
+        set->tree[i] += delta;
+    }
+}
+
+/**
+ * @brief Counts the live time stamps up to and including the given one.
+ *
+ * @param set Pointer to the StackDistanceSet object.
+ * @param time The 0-based time stamp.
+ * @return The number of live time stamps in `[0, time]`.
+ */
+static int query_stack_tree(const StackDistanceSet *set, const int time) {
+    int count = 0;
+    for (int i = time + 1; i > 0; i -= i & -i) {
+        count += set->tree[i];
+    }
+    return count;
+}
+
+/**
+ * @brief Renumbers the live time stamps of a set densely from 0 and rebuilds its tree.
+ * The capacity is doubled whenever the set is more than half full afterward.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ * @param set Pointer to the StackDistanceSet object to compact.
+ */
+static void compact_stack_set(StackDistance *stack_distance, StackDistanceSet *set) {
+    int capacity = set->capacity;
+    while ((set->live_count + 1) * 2 > capacity) {
+        capacity *= 2;
+    }
+
+    uint64_t *lines = allocate_or_exit(capacity, sizeof(uint64_t), "stack distance set");
+    int *tree = allocate_or_exit(capacity + 1, sizeof(int), "stack distance set");
+
+    // Keep the recency order of the live lines while dropping all stale time stamps
+    int time = 0;
+    for (int old_time = 0; old_time < set->next_time; old_time++) {
+        const uint64_t key = set->lines[old_time];
+        if (key != 0) {
+            lines[time] = key;
+            stack_distance->index_times[find_index_slot(stack_distance, key)] = time;
+            tree[time + 1] = 1;
+            time++;
+        }
+    }
+
+    // Build the Fenwick tree in linear time
+    for (int i = 1; i <= capacity; i++) {
+        const int parent = i + (i & -i);
+        if (parent <= capacity) {
+            tree[parent] += tree[i];
+        }
+    }
+
+    free(set->lines);
+    free(set->tree);
+    set->lines = lines;
+    set->tree = tree;
+    set->capacity = capacity;
+    set->next_time = time;
+}
+
+/**
+ * @brief Counts an access with the given stack distance in the histogram.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ * @param distance Number of distinct lines accessed in the set since the last access to the line.
+ */
+static void record_stack_distance(StackDistance *stack_distance, const int distance) {
+    if (distance >= stack_distance->histogram_size) {
+        int size = stack_distance->histogram_size > 0 ? stack_distance->histogram_size : STACK_DISTANCE_INITIAL_CAPACITY;
+        while (distance >= size) {
+            size *= 2;
+        }
+        stack_distance->histogram = reallocate_or_exit(stack_distance->histogram, (size_t)size, sizeof(uint64_t),
+                                                       "stack distance histogram");
+        for (int i = stack_distance->histogram_size; i < size; i++) {
+            stack_distance->histogram[i] = 0;
+        }
+        stack_distance->histogram_size = size;
+    }
+    stack_distance->histogram[distance]++;
+}
+
+StackDistance* initialize_stack_distance(const int num_sets, const int line_size) {
+    StackDistance *stack_distance = allocate_or_exit(1, sizeof(StackDistance), "stack distance engine");
+
+    stack_distance->num_sets = num_sets;
+    stack_distance->line_size = line_size;
+    stack_distance->log_line_size = log2_int(line_size);
+    stack_distance->sets = allocate_or_exit(num_sets, sizeof(StackDistanceSet), "stack distance sets");
+    stack_distance->index_capacity = STACK_DISTANCE_INITIAL_INDEX;
+    stack_distance->index_keys = allocate_or_exit(STACK_DISTANCE_INITIAL_INDEX, sizeof(uint64_t),
+                                                  "stack distance index");
+    stack_distance->index_times = allocate_or_exit(STACK_DISTANCE_INITIAL_INDEX, sizeof(int),
+                                                   "stack distance index");
+
+    return stack_distance;
+}
+
+void free_stack_distance(StackDistance *stack_distance) {
+    for (int i = 0; i < stack_distance->num_sets; i++) {
+        free(stack_distance->sets[i].tree);
+        free(stack_distance->sets[i].lines);
+    }
+    free(stack_distance->sets);
+    free(stack_distance->index_keys);
+    free(stack_distance->index_times);
+    free(stack_distance->histogram);
+    free(stack_distance);
+}
+
+void access_stack_distance(StackDistance *stack_distance, const CacheOp *cache_op) {
+    const uint64_t line_address = cache_op->address >> stack_distance->log_line_size;
+    const uint64_t key = line_address + 1;
+    StackDistanceSet *set = &stack_distance->sets[line_address & (stack_distance->num_sets - 1)];
+
+    // Sets are allocated lazily, most of them are never touched by short traces
+    if (set->capacity == 0) {
+        set->capacity = STACK_DISTANCE_INITIAL_CAPACITY;
+        set->lines = allocate_or_exit(set->capacity, sizeof(uint64_t), "stack distance set");
+        set->tree = allocate_or_exit(set->capacity + 1, sizeof(int), "stack distance set");
+    }
+
+    stack_distance->accesses++;
+    size_t slot = find_index_slot(stack_distance, key);
+
+    if (stack_distance->index_keys[slot] != 0) {
+        // Reuse: the distance is the number of distinct lines accessed after the previous access
+        const int previous_time = stack_distance->index_times[slot];
+        record_stack_distance(stack_distance, set->live_count - query_stack_tree(set, previous_time));
+        update_stack_tree(set, previous_time, -1);
+        set->lines[previous_time] = 0;
+    } else {
+        // First access to the line: a cold miss for every associativity
+        stack_distance->cold_misses++;
+        set->live_count++;
+        stack_distance->index_keys[slot] = key;
+        if (++stack_distance->index_size * 2 > stack_distance->index_capacity) {
+            grow_line_index(stack_distance);
+            slot = find_index_slot(stack_distance, key);
+        }
+    }
+
+    if (set->next_time == set->capacity) {
+        set->live_count--; // The accessed line doesn't hold a live time stamp right now
+        compact_stack_set(stack_distance, set);
+        set->live_count++;
+    }
+
+    const int time = set->next_time++;
+    set->lines[time] = key;
+    update_stack_tree(set, time, 1);
+    stack_distance->index_times[slot] = time;
+}
+
+uint64_t get_stack_distance_misses(const StackDistance *stack_distance, const int associativity) {
+    uint64_t misses = stack_distance->cold_misses;
+    for (int distance = associativity; distance < stack_distance->histogram_size; distance++) {
+        misses += stack_distance->histogram[distance];
+    }
+    return misses;
+}
+
+int get_max_stack_distance(const StackDistance *stack_distance) {
+    for (int distance = stack_distance->histogram_size - 1; distance >= 0; distance--) {
+        if (stack_distance->histogram[distance] != 0) {
+            return distance;
+        }
+    }
+    return -1;
+}
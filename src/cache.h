@@ -2,47 +2,242 @@
 /**
  * @file cache.h
  * @brief Header file for a write-back cache simulator with a write allocate
- * policy and a LRU replacement strategy.
+ * policy and a pluggable replacement strategy (LRU by default).
  * 
  * This file defines structures and functions for simulating cache operations,
  * including calculating the number of cache hits, misses, and dirty
  * write-backs.
+ *
+ * Stores can also be written through to memory, and store misses can bypass
+ * the cache instead of allocating a line. Such writes optionally pass a
+ * write-combining buffer, which merges stores to the same line before they
+ * reach memory.
+ *
+ * The lines of a cache can be split into sectors, which are filled and
+ * written back on their own under the single tag of their line, so large
+ * lines don't overstate the memory traffic.
+ *
+ * A cache can simulate a sample of its sets only. Accesses to the other sets
+ * are skipped, and the counts of the whole cache are extrapolated with
+ * confidence intervals.
+ *
+ * The complete state of a cache can be saved to a file and loaded again, so a
+ * single warm-up can be continued by many simulations.
+ *
+ * Sets never influence each other, so a cache can also be split into
+ * partitions of consecutive sets that are simulated by separate threads. Each
+ * partition is a view sharing the lines of the cache with its own statistics.
+ *
+ * Additionally, a stack distance (Mattson) engine is provided. Thanks to the
+ * inclusion property of LRU, it yields the hits and misses of every
+ * associativity at a fixed number of sets in a single pass over the trace.
  ******************************************************************************/
 
 #ifndef CACHE_H_INCLUDED
 #define CACHE_H_INCLUDED
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Cache statistics for tracking hits, misses, and dirty write-backs.
+ * The prefetch counts stay zero unless a prefetcher is attached (see
+ * prefetch.h), the memory writes unless stores bypass the lines (see
+ * WritePolicy). Only the cache-wide statistics track them.
  */
 typedef struct CacheStats {
-    int hits;               // Number of cache hits
-    int misses;             // Number of cache misses
-    int dirty_write_backs;  // Number of dirty write-backs
+    uint64_t hits;              // Number of cache hits
+    uint64_t misses;            // Number of cache misses
+    uint64_t dirty_write_backs; // Number of dirty write-backs
+    uint64_t prefetches;        // Number of lines installed by the prefetcher
+    uint64_t useful_prefetches; // Number of prefetched lines hit by a demand access after their fill
+    uint64_t late_prefetches;   // Number of prefetched lines hit by a demand access before their fill completed
+    uint64_t useless_prefetches;    // Number of prefetched lines replaced without a demand access
+    uint64_t prefetch_wait_cycles;  // Cycles demand accesses waited for the fills of late prefetches
+    uint64_t memory_writes;     // Writes of stores to memory besides the write-backs (see WritePolicy)
+    uint64_t memory_write_bytes;    // Bytes of these writes
+    uint64_t combined_writes;   // Stores merged into a pending write of the write-combining buffer
+    uint64_t write_back_bytes;  // Bytes of the dirty write-backs, only the dirty sectors of sectored lines
+    uint64_t sector_misses;     // Misses of sectored lines whose tag was cached, but not the accessed sector
 } CacheStats;
 
 /**
- * @brief Cache structure representing a cache line.
+ * @brief Line replaced by the most recent miss or installation of a cache.
+ */
+typedef struct CacheEviction {
+    uint64_t address;       // Address of the first byte of the replaced line
+    bool is_valid;          // Indicates if a valid line was replaced (otherwise the other fields are meaningless)
+    bool is_dirty;          // Indicates if the replaced line was modified
+} CacheEviction;
+
+/**
+ * @brief Statistics of a sampled cache extrapolated to all of its sets.
+ * Every count comes with the half-width of its 95% confidence interval.
+ */
+typedef struct CacheSampleEstimate {
+    double misses;                  // Estimated number of cache misses
+    double misses_error;            // Half-width of the confidence interval of the misses (and hits)
+    double dirty_write_backs;       // Estimated number of dirty write-backs
+    double dirty_write_backs_error; // Half-width of the confidence interval of the dirty write-backs
+} CacheSampleEstimate;
+
+/**
+ * @brief Structures keeping track of the LRU order of the lines in a set.
+ *
+ * Both structures update the order in O(1), independent of the associativity:
+ * - RECENCY_BIT_MATRIX stores an n x n bit matrix per set in a single 64-bit
+ *   word (one byte per row). Row i has bit j set if line i was used more
+ *   recently than line j, so the LRU line is the one with an all-zero row.
+ * - RECENCY_LIST links the lines of a set into a doubly-linked list ordered
+ *   from the most to the least recently used line.
+ */
+typedef enum RecencyKind {
+    RECENCY_BIT_MATRIX, // Bit matrix for small associativities
+    RECENCY_LIST,       // Intrusive doubly-linked list for large associativities
+} RecencyKind;
+
+/**
+ * @brief Replacement policies of a cache.
+ *
+ * - REPLACEMENT_LRU replaces the least recently used line.
+ * - REPLACEMENT_PLRU approximates LRU with a binary tree of `ways - 1` bits
+ *   per set, every node pointing to the half of its subtree to replace next.
+ * - REPLACEMENT_SRRIP and REPLACEMENT_BRRIP keep a 2-bit re-reference
+ *   prediction value (RRPV) per line and replace a line predicted to be
+ *   re-referenced in the distant future. SRRIP inserts lines with a long
+ *   prediction, BRRIP mostly with a distant one, which resists scans.
+ * - REPLACEMENT_FIFO replaces the lines of a set in the order they were filled.
+ * - REPLACEMENT_RANDOM replaces a pseudo-random line with a fixed seed, so runs
+ *   are reproducible.
+ *
+ * All policies fill invalid lines before replacing a valid one.
+ */
+typedef enum ReplacementPolicy {
+    REPLACEMENT_LRU,
+    REPLACEMENT_PLRU,
+    REPLACEMENT_SRRIP,
+    REPLACEMENT_BRRIP,
+    REPLACEMENT_FIFO,
+    REPLACEMENT_RANDOM,
+    REPLACEMENT_POLICY_COUNT,   // Number of replacement policies
+} ReplacementPolicy;
+
+/**
+ * @brief Handling of stores by a cache.
+ *
+ * - Write-back caches mark a stored line as modified and write it to memory
+ *   when it is replaced, write-through caches write every store to memory and
+ *   keep their lines clean.
+ * - Write-allocate caches fill the line of a store miss, no-write-allocate
+ *   caches write the store to memory around the cache.
+ *
+ * Traces carry no access sizes, so every store writes CACHE_STORE_SIZE bytes
+ * (at most a line). All store misses count as misses.
+ */
+typedef enum WritePolicy {
+    WRITE_BACK_ALLOCATE,        // Write-back, write-allocate (default)
+    WRITE_BACK_NO_ALLOCATE,     // Write-back, store misses are written around the cache
+    WRITE_THROUGH_ALLOCATE,     // Write-through, store misses fill a clean line
+    WRITE_THROUGH_NO_ALLOCATE,  // Write-through, store misses are written around the cache
+    WRITE_POLICY_COUNT,         // Number of write policies
+} WritePolicy;
+
+enum {
+    CACHE_STORE_SIZE = 4,           // Bytes written by a store that bypasses the lines
+    CACHE_MAX_COMBINING_ENTRIES = 64,   // Largest number of entries of a write-combining buffer
+};
+
+/**
+ * @brief A pending write of the write-combining buffer.
+ */
+typedef struct WriteCombiningEntry {
+    uint64_t line;          // Line number of the write
+    uint64_t chunks;        // Written chunks of the line, bit i for chunk i
+} WriteCombiningEntry;
+
+/**
+ * @brief Buffer merging the stores to memory of a cache that bypass its lines.
+ * A store to a line without a pending write allocates an entry, a store to a
+ * line with one only adds its chunk. When the buffer is full, the oldest
+ * entry is written to memory as one write of its written chunks. A line is
+ * split into at most 64 chunks of at least CACHE_STORE_SIZE bytes.
+ */
+typedef struct WriteCombiningBuffer {
+    int capacity;           // Number of entries
+    int count;              // Number of pending writes
+    int head;               // Entry of the oldest pending write
+    int log_chunk_size;     // log2 of the size of a chunk in bytes
+    WriteCombiningEntry entries[]; // Pending writes, a ring starting at `head`
+} WriteCombiningBuffer;
+
+enum {
+    RECENCY_MATRIX_MAX_WAYS = 8,    // Largest associativity handled by the bit matrix
+    RECENCY_INDEX_MIN_WAYS = 32,    // Smallest associativity that looks up tags through the line index
+    CACHE_ALIGNMENT = 64,           // Alignment of the line and metadata arrays in bytes
+};
+
+/**
+ * @brief Layout of the sector word stored next to the word of every line of a sectored cache.
+ * Bit i of the low half is set if sector i is valid, bit i of the high half
+ * if it is modified. A sectored line is valid as soon as one of its sectors
+ * is, and modified as soon as one of its sectors is.
+ */
+enum {
+    CACHE_MAX_SECTORS = 32,         // Largest number of sectors of a line
+    CACHE_SECTOR_DIRTY_SHIFT = 32,  // Position of the dirty mask in the sector word
+};
+
+/**
+ * @brief Layout of the 64-bit word stored per cache line.
+ * The tag occupies the bits above the flags. An address has at least
+ * CACHE_LINE_TAG_SHIFT offset and set index bits, so no tag bit is lost.
  */
-typedef struct CacheLine {
-    int tag;        // Tag to identify a line
-    bool is_valid;  // Indicates if the line contains valid data
-    bool is_dirty;  // Indicates if the line has been written to
-    int lru_order;  // Stores the LRU order for the line
-}   CacheLine;
+enum {
+    CACHE_LINE_VALID = 1,           // Line contains valid data
+    CACHE_LINE_DIRTY = 2,           // Line has been written to
+    CACHE_LINE_TAG_SHIFT = 2,       // Position of the lowest tag bit
+};
+
+struct Cache;
+struct CacheOp;
+struct Prefetcher;
 
 /**
- * @brief Cache structure representing a set (composed of multiple cache lines)
+ * @brief Function simulating a single access, specialized for a cache geometry.
  */
-typedef struct CacheSet {
-    CacheLine *lines; // Array of cache lines
-} CacheSet;
+typedef bool (*CacheAccessKernel)(struct Cache *cache, const struct CacheOp *cache_op);
 
+/**
+ * @brief Function simulating a batch of accesses, specialized for a cache geometry.
+ */
+typedef size_t (*CacheBatchKernel)(struct Cache *cache, const struct CacheOp *cache_ops, size_t num_ops,
+                                   uint8_t *hit_bitmap_out);
 
 /**
  * @brief Main structure representing the cache itself.
+ *
+ * The lines are stored as a structure of arrays. Every line is a single 64-bit
+ * word holding its tag and its valid and dirty flags. All words live in one
+ * contiguous, aligned array indexed by `set * associativity + way`, so the
+ * lines of a set can be compared with SIMD instructions, and a lookup checks
+ * the tag and the valid flag with the same comparison. Sectored caches keep the
+ * valid and dirty sectors of every line in a second array of 64-bit words with
+ * the same indices (see CACHE_SECTOR_DIRTY_SHIFT).
+ *
+ * All arrays are carved from a single aligned arena, which is backed by
+ * transparent huge pages when it is large enough.
+ *
+ * Accesses are dispatched to a kernel selected at initialization. Kernels for
+ * 1, 2, 4, 8 and 16 ways and for fully associative caches are specialized at
+ * compile time for every replacement and write policy; other geometries use a
+ * generic kernel of the policies. Sectored caches use generic kernels of
+ * every replacement and write policy. Only the metadata of the selected
+ * replacement policy is allocated.
+ *
+ * With set sampling, only the sets selected by a hash of the set index are
+ * stored, so the arrays shrink by the sample rate. A sampled set is stored at
+ * its permuted index, and all sizes of the arrays refer to `num_sampled_sets`.
  */
 typedef struct Cache {
     int associativity;      // Number of lines per set (ways)
@@ -51,21 +246,154 @@ typedef struct Cache {
     int miss_penalty;       // Penalty in cycles for a cache miss
     int dirty_wb_penalty;   // Penalty in cycles for a dirty write-back
     int num_sets;           // Number of sets in the cache
-    CacheSet *sets;         // Array of cache sets
+    int sample_rate;        // One in this many sets is simulated (1 to simulate all sets)
+    int log_sample_rate;    // Precomputed log2(sample_rate)
+    int num_sampled_sets;   // Number of simulated and stored sets (num_sets / sample_rate)
     CacheStats stats;       // Cache statistics (hits, misses, dirty write-backs)
+    CacheEviction last_eviction;    // Line replaced by the most recent miss or installation
     int log_line_size;      // Precomputed log2(line_size)
     int log_num_sets;       // Precomputed log2(num_sets)
+    int words_per_set;      // Number of 64-bit words of the per-set bitmasks (ways / 64, rounded up)
+    uint64_t *lines;        // Tag and flags of every line (CACHE_LINE_VALID, CACHE_LINE_DIRTY)
+    int log_sectors;        // log2 of the number of sectors per line, 0 for lines without sectors
+    int log_sector_size;    // log2 of the size of a sector in bytes (log_line_size without sectors)
+    uint64_t *sector_masks; // Valid and dirty sectors of every line, NULL for lines without sectors
+    ReplacementPolicy replacement;  // Policy selecting the line replaced by a miss
+    RecencyKind recency;    // Structure tracking the LRU order (REPLACEMENT_LRU)
+    unsigned long *recency_matrix;  // LRU bit matrix of every set (RECENCY_BIT_MATRIX)
+    int *lru_prev;          // Next more recently used way of every line (RECENCY_LIST), -1 for the MRU line
+    int *lru_next;          // Next less recently used way of every line (RECENCY_LIST), -1 for the LRU line
+    int *mru_way;           // Most recently used way of every set (RECENCY_LIST)
+    int *lru_way;           // Least recently used way of every set (RECENCY_LIST)
+    int *valid_counts;      // Number of valid lines of every set (all policies but REPLACEMENT_LRU)
+    unsigned long *plru_bits;   // PLRU tree of every set in `words_per_set` words, node i at bit i (REPLACEMENT_PLRU)
+    uint8_t *rrpv;          // Re-reference prediction value of every line (REPLACEMENT_SRRIP, REPLACEMENT_BRRIP)
+    int *fifo_next;         // Next way to be replaced of every set (REPLACEMENT_FIFO)
+    uint64_t random_state;  // State of the pseudo-random number generator (REPLACEMENT_RANDOM, REPLACEMENT_BRRIP)
+    uint64_t *index_keys;       // Line index for large associativities: line number + 1, 0 if empty
+    int *index_ways;            // Way holding the indexed line
+    size_t index_capacity;      // Number of slots of the line index (power of two), 0 if unused
+    CacheStats *set_stats;  // Statistics of every sampled set, NULL if all sets are simulated
+    void *arena;            // Single allocation holding all arrays above
+    size_t arena_size;      // Size of the arena in bytes
+    size_t arena_used;      // Bytes of the arena holding the arrays, arena_size may be rounded up
+    bool arena_is_mapped;   // Indicates if the arena is an anonymous mapping instead of heap memory
+    CacheAccessKernel access_kernel;    // Kernel simulating an access to this cache
+    CacheBatchKernel batch_kernel;      // Kernel simulating a batch of accesses to this cache
+    struct Prefetcher *prefetcher;      // Prefetcher wrapping the kernels, NULL if there is none
+    WritePolicy write_policy;           // Handling of stores
+    WriteCombiningBuffer *write_combining;  // Buffer in front of memory, NULL if stores are written one by one
 } Cache;
 
+/**
+ * @brief Identification and layout of cache state files.
+ */
+#define CACHE_STATE_MAGIC "CSIMSTA"  // Magic string including the terminating NUL (8 bytes)
+enum {
+    CACHE_STATE_VERSION = 5,            // Version of the header and the arena layout
+    CACHE_STATE_DATA_OFFSET = 4096,     // Offset of the arena in the file, a multiple of the page size
+};
+
+/**
+ * @brief Header at the start of a cache state file.
+ *
+ * The header is followed by padding up to CACHE_STATE_DATA_OFFSET and the
+ * arena of the cache, byte for byte. The arena layout only depends on the
+ * configuration, so it is mapped back without conversion. Like binary traces,
+ * state files use the byte order of the host that wrote them; a foreign byte
+ * order is rejected because its version and header size don't match.
+ */
+typedef struct CacheStateHeader {
+    char magic[8];              // CACHE_STATE_MAGIC
+    uint32_t version;           // CACHE_STATE_VERSION
+    uint32_t header_size;       // sizeof(CacheStateHeader)
+    int32_t associativity;      // Number of lines per set (resolved, also for fully associative caches)
+    int32_t cache_size;         // Cache size in KB
+    int32_t line_size;          // Cache line size in bytes
+    int32_t miss_penalty;       // Penalty in cycles for a cache miss
+    int32_t dirty_wb_penalty;   // Penalty in cycles for a dirty write-back
+    int32_t replacement;        // ReplacementPolicy of the cache
+    int32_t sample_rate;        // One in this many sets is simulated
+    int32_t write_policy;       // WritePolicy of the cache
+    int32_t sectors;            // Number of sectors per line, 1 for lines without sectors
+    int32_t combining_entries;  // Number of entries of the write-combining buffer, 0 without a buffer
+    int32_t combining_count;    // Number of pending writes of the write-combining buffer
+    CacheStats stats;           // Statistics at the time the state was saved
+    uint64_t random_state;      // State of the pseudo-random number generator
+    uint64_t arena_size;        // Number of arena bytes following the header
+    WriteCombiningEntry combining_writes[CACHE_MAX_COMBINING_ENTRIES]; // Pending writes, the oldest first
+} CacheStateHeader;
+
+_Static_assert(sizeof(CacheStateHeader) <= CACHE_STATE_DATA_OFFSET, "cache state header exceeds its padding");
+
 /**
  * @brief Represents a cache operation (either LOAD or STORE).
  */
 typedef struct CacheOp {
-    char access_type;       // 'l' for LOAD, 's' for STORE
-    unsigned long address;  // Address to access
+    char access_type;       // 'l' for LOAD, 's' for STORE, 'i' for an instruction fetch
+    uint64_t address;       // Address to access
     int instructions;       // Number of instructions in the operation
 } CacheOp;
 
+/**
+ * @brief LRU stack of a single set used by the stack distance engine.
+ *
+ * Every access receives a set-local time stamp. A Fenwick tree counts the
+ * time stamps that are still the latest access of their line, so the number of
+ * distinct lines accessed since a given time stamp is found in O(log n).
+ */
+typedef struct StackDistanceSet {
+    int *tree;              // Fenwick tree over the time stamps (1-based)
+    uint64_t *lines;        // Line address + 1 per time stamp, 0 if the time stamp is stale
+    int capacity;           // Number of time stamps before the set is compacted
+    int next_time;          // Next unused time stamp
+    int live_count;         // Number of distinct lines in the set
+} StackDistanceSet;
+
+/**
+ * @brief Stack distance engine for all LRU associativities at a fixed set count.
+ */
+typedef struct StackDistance {
+    int num_sets;               // Number of sets
+    int line_size;              // Cache line size in bytes
+    int log_line_size;          // Precomputed log2(line_size)
+    StackDistanceSet *sets;     // LRU stack per set
+    uint64_t *index_keys;       // Open-addressing index: line address + 1, 0 if empty
+    int *index_times;           // Latest time stamp per indexed line
+    size_t index_capacity;      // Number of slots of the index (power of two)
+    size_t index_size;          // Number of occupied slots of the index
+    uint64_t *histogram;        // Number of accesses per stack distance
+    int histogram_size;         // Number of entries of the histogram
+    uint64_t cold_misses;       // Number of first accesses to a line
+    uint64_t accesses;          // Number of simulated accesses
+} StackDistance;
+
+// --- Utility Functions ---
+
+/**
+ * @brief Allocates a zero-initialized array or terminates the program if that fails.
+ * Like calloc, an array whose size overflows size_t counts as a failure.
+ *
+ * @param count Number of elements, 0 is allocated like 1.
+ * @param size Size of an element in bytes.
+ * @param what Description of the allocation for the error message.
+ * @return Pointer to the zero-initialized memory.
+ */
+void* allocate_or_exit(size_t count, size_t size, const char *what);
+
+/**
+ * @brief Resizes an array or terminates the program if that fails.
+ * An array whose size overflows size_t counts as a failure. Elements beyond
+ * the previous size are not initialized.
+ *
+ * @param memory Pointer to the array, or `NULL` to allocate a new one.
+ * @param count New number of elements, at least 1.
+ * @param size Size of an element in bytes.
+ * @param what Description of the allocation for the error message.
+ * @return Pointer to the resized array.
+ */
+void* reallocate_or_exit(void *memory, size_t count, size_t size, const char *what);
+
 // --- Cache Initialization and Cleanup ---
 /**
  * @brief Initializes the cache with the given configuration.
@@ -75,37 +403,305 @@ typedef struct CacheOp {
  * @param line_size Cache line size in bytes.
  * @param miss_penalty Miss penalty in cycles.
  * @param dirty_wb_penalty Dirty write-back penalty in cycles.
+ * @param replacement Replacement policy of the cache.
+ * @param sample_rate Simulate one in this many sets (power of two below the number of sets), 1 for all sets.
  * @return Pointer to the initialized Cache object
  */
-Cache* initialize_cache(int associativity, int cache_size, int line_size, int miss_penalty, int dirty_wb_penalty);
+Cache* initialize_cache(int associativity, int cache_size, int line_size, int miss_penalty, int dirty_wb_penalty,
+                        ReplacementPolicy replacement, int sample_rate);
+
+/**
+ * @brief Resets the cache to its initial, empty state.
+ * All lines are invalidated and the statistics are cleared, but the arena is
+ * reused, so consecutive simulations of the same configuration don't need to
+ * reallocate the cache. An attached prefetcher forgets its predictions.
+ *
+ * @param cache Pointer to the Cache object.
+ */
+void reset_cache(Cache *cache);
+
+/**
+ * @brief Clears the statistics of the cache, but keeps its lines.
+ *
+ * @param cache Pointer to the Cache object.
+ */
+void reset_cache_stats(Cache *cache);
+
+/**
+ * @brief Creates an independent copy of a cache with its lines, replacement state and statistics.
+ * The arena is duplicated with a single copy, so a warmed cache can be cloned
+ * cheaply for every simulation continuing from it. Like a state file, the
+ * copy includes the write policy and the write-combining buffer with its
+ * pending writes, but not an attached prefetcher.
+ *
+ * @param cache Pointer to the Cache object.
+ * @return Pointer to the copy, to be freed with free_cache.
+ */
+Cache* clone_cache(const Cache *cache);
+
+/**
+ * @brief Selects the write policy of a cache and its write-combining buffer.
+ * Must be called before a prefetcher is attached. The buffer only takes the
+ * stores bypassing the lines, so it requires another policy than
+ * WRITE_BACK_ALLOCATE.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param write_policy The write policy.
+ * @param combining_entries Number of entries of the write-combining buffer (up to CACHE_MAX_COMBINING_ENTRIES),
+ *        `0` for none.
+ */
+void set_write_policy(Cache *cache, WritePolicy write_policy, int combining_entries);
+
+/**
+ * @brief Splits the lines of an empty cache into sectors with their own valid and dirty flags.
+ * A miss to a line whose tag is cached only fills the accessed sector (and
+ * counts as a sector miss), a replaced line only writes back its dirty
+ * sectors. The arena is allocated again, so the cache must not have been
+ * accessed yet. Must be called before set_write_policy and before a
+ * prefetcher is attached; lines installed by a prefetcher or an upper level
+ * are filled with all of their sectors.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param sectors Number of sectors per line, a power of two up to CACHE_MAX_SECTORS and the line size.
+ */
+void set_cache_sectors(Cache *cache, int sectors);
 
 /**
- * @brief Frees the memory allocated for the cache.
+ * @brief Frees the memory allocated for the cache, its prefetcher and its write-combining buffer.
  *
  * @param cache Pointer to the Cache object.
  */
 void free_cache(Cache *cache);
 
+// --- Cache State Files ---
+/**
+ * @brief Saves the complete state of a cache to a file.
+ * The file holds the configuration including the write policy and the
+ * write-combining buffer, the statistics, the lines, the replacement metadata
+ * and the pending writes of the buffer, but not the state of an attached
+ * prefetcher.
+ * Terminates the program if the file can't be written.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param path Path of the state file to be written.
+ */
+void save_cache_state(const Cache *cache, const char *path);
+
+/**
+ * @brief Creates a cache from a state file written by save_cache_state.
+ * The arena is mapped copy-on-write from the file, so loading doesn't copy
+ * the lines and changes never reach the file. Terminates the program if the
+ * file is missing, corrupt or of another version.
+ *
+ * @param path Path of the state file.
+ * @return Pointer to the restored Cache object, to be freed with free_cache.
+ */
+Cache* load_cache_state(const char *path);
+
 // --- Cache Access Operations ---
 /**
  * @brief Initializes a cache operation with the given parameters.
  *
- * @param access_type Either 'l' for LOAD or 's' for STORE.
+ * @param access_type Either 'l' for LOAD, 's' for STORE or 'i' for an instruction fetch.
  * @param address A virtual address.
  * @param instructions Number of instructions performed in cache operation.
  * @return The initialized CacheOp object.
  */
-CacheOp initialize_cache_operation(char access_type, unsigned long address, int instructions);
+CacheOp initialize_cache_operation(char access_type, uint64_t address, int instructions);
 
 /**
  * @brief Simulates a cache access operation (LOAD or STORE).
+ * Accesses to sets outside the sample of a sampled cache are skipped: they
+ * count neither as hit nor as miss, but return `true` like a hit.
  *
  * @param cache Pointer to the Cache object.
  * @param cache_op Pointer to the CacheOp object representing the cache operation.
- * @return `true` if the access is a hit, `false` if it's a miss.
+ * @return `true` if the access is a hit (or skipped), `false` if it's a miss.
  */
 bool access_cache(Cache *cache, const CacheOp *cache_op);
 
+/**
+ * @brief Simulates a batch of cache access operations in trace order.
+ *
+ * The results are identical to calling access_cache for every operation, but
+ * the set indices of a block are computed up front and upcoming sets are
+ * prefetched, which amortizes the cost per operation.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ * @param hit_bitmap_out Bitmap of at least `(num_ops + 7) / 8` bytes receiving bit `i % 8` of byte `i / 8` set if
+ *        operation `i` hits, or `NULL` if only the number of hits is needed.
+ * @return The number of hits in the batch.
+ */
+size_t access_cache_batch(Cache *cache, const CacheOp *cache_ops, size_t num_ops, uint8_t *hit_bitmap_out);
+
+// --- Functional Warming ---
+/**
+ * @brief Simulates an access that only warms the cache.
+ * Tags, flags and replacement state are updated like by access_cache, but
+ * no hit, miss or dirty write-back is counted.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ */
+void warm_cache(Cache *cache, const CacheOp *cache_op);
+
+/**
+ * @brief Simulates a batch of accesses that only warm the cache.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ */
+void warm_cache_batch(Cache *cache, const CacheOp *cache_ops, size_t num_ops);
+
+// --- Set Partitions ---
+/**
+ * @brief Returns the largest number of partitions a cache can be split into.
+ * Caches that look up tags through the line index share it between all sets
+ * and can't be split at all, neither can caches with a prefetcher, which
+ * learns from the accesses of all sets, or with a write-combining buffer,
+ * which merges the stores of all sets.
+ *
+ * @param cache Pointer to the Cache object.
+ * @return The number of simulated sets, or `1` if the cache can't be split.
+ */
+int get_max_cache_partitions(const Cache *cache);
+
+/**
+ * @brief Creates a view of a cache for simulating a partition of its sets.
+ * The view shares the lines and the replacement state of `cache` but counts
+ * its own statistics and draws from its own random number generator. The
+ * first partition is simulated with `cache` itself.
+ *
+ * @param cache Pointer to the Cache object being split.
+ * @param partition Index of the partition, at least `1`.
+ * @return Pointer to the view, to be released with merge_cache_partition.
+ */
+Cache* initialize_cache_partition(const Cache *cache, int partition);
+
+/**
+ * @brief Adds the statistics of a partition to its cache and frees the view.
+ *
+ * @param cache Pointer to the Cache object that was split.
+ * @param partition Pointer to the view created by initialize_cache_partition.
+ */
+void merge_cache_partition(Cache *cache, Cache *partition);
+
+/**
+ * @brief Copies the operations that access a range of sets.
+ * The range refers to the simulated sets, so operations on sets outside the
+ * sample of a sampled cache are never selected.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ * @param first_set The first set of the range.
+ * @param end_set One past the last set of the range.
+ * @param selected_ops Array receiving the selected operations, with room for `num_ops` entries.
+ * @return The number of selected operations.
+ */
+size_t select_cache_partition(const Cache *cache, const CacheOp *cache_ops, size_t num_ops, int first_set,
+                              int end_set, CacheOp *selected_ops);
+
+// --- Line Management ---
+/**
+ * @brief Removes the line containing an address from the cache.
+ * Neither hits nor misses are counted. Used for back-invalidations of
+ * inclusive hierarchies.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param address An address within the line.
+ * @param was_dirty Pointer receiving whether the removed line was modified.
+ * @return `true` if the line was cached, `false` otherwise.
+ */
+bool invalidate_cache_line(Cache *cache, uint64_t address, bool *was_dirty);
+
+/**
+ * @brief Checks if the line containing an address is cached.
+ * Neither the statistics nor the replacement state change. Lines of sets
+ * outside the sample of a sampled cache are reported as cached, so they are
+ * never installed. Used by prefetchers to drop redundant prefetches.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param address An address within the line.
+ * @return `true` if the line is cached or not part of the sample, `false` otherwise.
+ */
+bool contains_cache_line(const Cache *cache, uint64_t address);
+
+/**
+ * @brief Clears the modified flag of the line containing an address.
+ * Neither the statistics nor the replacement state change. Used when a
+ * coherence protocol writes a modified line back and keeps a clean copy.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param address An address within the line.
+ * @return `true` if the line is cached and was modified, `false` otherwise.
+ */
+bool clean_cache_line(Cache *cache, uint64_t address);
+
+/**
+ * @brief Inserts the line containing an address as the most recently used line.
+ * Neither hits nor misses are counted, but replacing a dirty line counts as a
+ * dirty write-back. If the line is already cached, it is only marked as most
+ * recently used (and modified if `is_dirty` is set). The replaced line is
+ * available through `last_eviction`. Used for write-backs and victims coming
+ * from a higher level of a hierarchy.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param address An address within the line.
+ * @param is_dirty Indicates if the inserted line is modified.
+ */
+void install_cache_line(Cache *cache, uint64_t address, bool is_dirty);
+
+/**
+ * @brief Looks up the line of an access and removes it from the cache on a hit.
+ * Counts a hit or a miss. Used by exclusive hierarchies, where a line moves to
+ * the higher level when it is hit.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param was_dirty Pointer receiving whether the removed line was modified.
+ * @return `true` if the access is a hit, `false` if it's a miss.
+ */
+bool extract_cache_line(Cache *cache, const CacheOp *cache_op, bool *was_dirty);
+
+// --- Replacement Policies ---
+/**
+ * @brief Looks up a replacement policy by its name.
+ *
+ * @param name Name of the policy ("lru", "plru", "srrip", "brrip", "fifo" or "random").
+ * @param replacement Pointer receiving the policy.
+ * @return `true` if the name is known, `false` otherwise.
+ */
+bool parse_replacement_policy(const char *name, ReplacementPolicy *replacement);
+
+/**
+ * @brief Returns the name of a replacement policy.
+ *
+ * @param replacement The replacement policy.
+ * @return The name of the policy.
+ */
+const char* get_replacement_policy_name(ReplacementPolicy replacement);
+
+/**
+ * @brief Looks up a write policy by its name.
+ *
+ * @param name Name of the policy ("wb", "wb-nwa", "wt" or "wt-nwa").
+ * @param write_policy Pointer receiving the policy.
+ * @return `true` if the name is known, `false` otherwise.
+ */
+bool parse_write_policy(const char *name, WritePolicy *write_policy);
+
+/**
+ * @brief Returns the name of a write policy.
+ *
+ * @param write_policy The write policy.
+ * @return The name of the policy.
+ */
+const char* get_write_policy_name(WritePolicy write_policy);
+
 // --- Cache Statistic Functions---
 /**
  * @brief Returns the number of cache hits that have occurred.
@@ -113,7 +709,7 @@ bool access_cache(Cache *cache, const CacheOp *cache_op);
  * @param cache Pointer to the Cache object.
  * @return The number of cache hits.
  */
-int get_cache_hits(const Cache *cache);
+uint64_t get_cache_hits(const Cache *cache);
 
 /**
  * @brief Returns the number of cache misses that have occurred.
@@ -121,7 +717,7 @@ int get_cache_hits(const Cache *cache);
  * @param cache Pointer to the Cache object.
  * @return The number of cache misses.
  */
-int get_cache_misses(const Cache *cache);
+uint64_t get_cache_misses(const Cache *cache);
 
 /**
  * @brief Returns the number of dirty write-backs that have occurred.
@@ -129,6 +725,87 @@ int get_cache_misses(const Cache *cache);
  * @param cache Pointer to the Cache object.
  * @return The number of dirty write-backs.
  */
-int get_dirty_write_backs(const Cache *cache);
+uint64_t get_dirty_write_backs(const Cache *cache);
+
+/**
+ * @brief Returns the number of writes to memory, including the write-backs and the pending writes.
+ * The pending writes of the write-combining buffer reach memory eventually,
+ * so they are counted as if the buffer was drained.
+ *
+ * @param cache Pointer to the Cache object.
+ * @return The number of memory writes.
+ */
+uint64_t get_memory_writes(const Cache *cache);
+
+/**
+ * @brief Returns the number of bytes written back by the dirty write-backs.
+ * A write-back writes a whole line, or only the dirty sectors of a sectored line.
+ *
+ * @param cache Pointer to the Cache object.
+ * @return The number of bytes written back.
+ */
+uint64_t get_write_back_bytes(const Cache *cache);
+
+/**
+ * @brief Returns the number of bytes written to memory, including the write-backs and the pending writes.
+ * The write-backs count with get_write_back_bytes.
+ *
+ * @param cache Pointer to the Cache object.
+ * @return The number of bytes written to memory.
+ */
+uint64_t get_memory_write_bytes(const Cache *cache);
+
+/**
+ * @brief Extrapolates the statistics of a sampled cache to all of its sets.
+ * The counts of the sampled sets are scaled by the sample rate. If all sets
+ * are simulated, the exact counts are returned without error.
+ *
+ * @param cache Pointer to the Cache object.
+ * @return The estimated statistics with their confidence intervals.
+ */
+CacheSampleEstimate estimate_sampled_stats(const Cache *cache);
+
+// --- Stack Distance Analysis ---
+/**
+ * @brief Initializes a stack distance engine.
+ *
+ * @param num_sets Number of sets (1 for fully associative caches).
+ * @param line_size Cache line size in bytes.
+ * @return Pointer to the initialized StackDistance object.
+ */
+StackDistance* initialize_stack_distance(int num_sets, int line_size);
+
+/**
+ * @brief Frees the memory allocated for the stack distance engine.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ */
+void free_stack_distance(StackDistance *stack_distance);
+
+/**
+ * @brief Records an access and its stack distance in O(log n).
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ */
+void access_stack_distance(StackDistance *stack_distance, const CacheOp *cache_op);
+
+/**
+ * @brief Returns the number of misses an LRU cache with the given associativity would have had.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ * @param associativity Number of lines per set.
+ * @return The number of cache misses.
+ */
+uint64_t get_stack_distance_misses(const StackDistance *stack_distance, int associativity);
+
+/**
+ * @brief Returns the largest stack distance observed so far.
+ * Every associativity above this value only suffers cold misses.
+ *
+ * @param stack_distance Pointer to the StackDistance object.
+ * @return The largest stack distance, `-1` if no line was reused.
+ */
+int get_max_stack_distance(const StackDistance *stack_distance);
 
 #endif // CACHE_H_INCLUDED
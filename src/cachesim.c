@@ -0,0 +1,229 @@
+/***************************************************************************/
+/**
+ * @file cachesim.c
+ * @brief Implementation of libcachesim, the embeddable cache simulator.
+ *
+ * This source file implements the interface of cachesim.h on top of the
+ * cache of cache.h. A handle wraps a Cache with the counters the cache
+ * doesn't keep itself. The library translates the accesses of the caller into
+ * cache operations in small blocks on the stack, so the layout of CacheOp
+ * stays private.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cache.h"
+#include "cachesim.h"
+
+/**
+ * @brief Sizes of the library.
+ */
+enum {
+    CACHESIM_BLOCK_SIZE = 256,      // Accesses translated at once, a multiple of 8 so bitmap bytes aren't shared
+};
+
+_Static_assert(CACHESIM_BLOCK_SIZE % 8 == 0, "Blocks must cover whole bytes of the hit bitmap");
+_Static_assert(CACHESIM_REPLACEMENT_LRU == (int)REPLACEMENT_LRU && CACHESIM_REPLACEMENT_PLRU == (int)REPLACEMENT_PLRU
+               && CACHESIM_REPLACEMENT_SRRIP == (int)REPLACEMENT_SRRIP
+               && CACHESIM_REPLACEMENT_BRRIP == (int)REPLACEMENT_BRRIP
+               && CACHESIM_REPLACEMENT_FIFO == (int)REPLACEMENT_FIFO
+               && CACHESIM_REPLACEMENT_RANDOM == (int)REPLACEMENT_RANDOM,
+               "The replacement constants of the library must match the simulator");
+
+/**
+ * @brief Size of the first version of CachesimConfig, the smallest size callers may pass.
+ */
+#define CACHESIM_CONFIG_MIN_SIZE (offsetof(CachesimConfig, sample_rate) + sizeof(int32_t))
+
+/**
+ * @brief A simulated cache behind the opaque handle of the library.
+ */
+struct CachesimCache {
+    Cache *cache;               // The simulated cache
+    uint64_t accesses;          // Accesses since the last reset
+    uint64_t instructions;      // Instructions of the accesses since the last reset
+};
+
+// --- Helper Functions ---
+
+/**
+ * @brief Checks if a value is a power of two.
+ *
+ * @param n The value.
+ * @return `true` if `n` is a power of two, `false` otherwise.
+ */
+static bool is_power_of_two(const int64_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+/**
+ * @brief Checks a configuration with the rules of the command line of `calc`.
+ *
+ * @param config Pointer to the CachesimConfig object.
+ * @return CACHESIM_OK, or the reason why the configuration is rejected.
+ */
+static int32_t validate_config(const CachesimConfig *config) {
+    const int64_t size = (int64_t)config->cache_size * 1024;
+    const int64_t associativity = config->associativity;
+    if (!is_power_of_two(config->cache_size) || !is_power_of_two(config->line_size) || size < config->line_size
+        || (associativity != 0 && !is_power_of_two(associativity)) || associativity > size / config->line_size
+        || size > INT32_MAX) {
+        return CACHESIM_INVALID_GEOMETRY;
+    }
+
+    // The line words keep their flags in the bits of the offset and the set index
+    const int64_t way_size = associativity == 0 ? config->line_size : size / associativity;
+    if (way_size < (1 << CACHE_LINE_TAG_SHIFT)) {
+        return CACHESIM_INVALID_GEOMETRY;
+    }
+    if (config->replacement < 0 || config->replacement >= REPLACEMENT_POLICY_COUNT) {
+        return CACHESIM_INVALID_POLICY;
+    }
+    if (config->miss_penalty < 0 || config->dirty_wb_penalty < 0) {
+        return CACHESIM_INVALID_PENALTY;
+    }
+
+    // Sampling has to leave two sets for the confidence interval
+    const int64_t num_sets = associativity == 0 ? 1 : size / config->line_size / associativity;
+    if (!is_power_of_two(config->sample_rate) || (config->sample_rate > 1 && num_sets / config->sample_rate < 2)) {
+        return CACHESIM_INVALID_SAMPLING;
+    }
+    return CACHESIM_OK;
+}
+
+/**
+ * @brief Translates accesses of the library into cache operations.
+ *
+ * @param accesses Array of accesses.
+ * @param num_accesses Number of accesses.
+ * @param cache_ops Array receiving the cache operations.
+ * @return The sum of the instructions of the accesses.
+ */
+static uint64_t translate_accesses(const CachesimAccess *accesses, const size_t num_accesses, CacheOp *cache_ops) {
+    uint64_t instructions = 0;
+    for (size_t i = 0; i < num_accesses; i++) {
+        cache_ops[i] = initialize_cache_operation((char)accesses[i].type, accesses[i].address,
+                                                  (int)accesses[i].instructions);
+        instructions += accesses[i].instructions;
+    }
+    return instructions;
+}
+
+// --- Library Information ---
+
+uint32_t cachesim_get_version(void) {
+    return (uint32_t)CACHESIM_VERSION_MAJOR << 16 | (uint32_t)CACHESIM_VERSION_MINOR;
+}
+
+const char* cachesim_get_status_message(const int32_t status) {
+    switch (status) {
+        case CACHESIM_OK: return "success";
+        case CACHESIM_INVALID_ARGUMENT: return "invalid argument";
+        case CACHESIM_INVALID_GEOMETRY: return "invalid cache geometry";
+        case CACHESIM_INVALID_POLICY: return "unknown replacement policy";
+        case CACHESIM_INVALID_SAMPLING: return "invalid sample rate";
+        case CACHESIM_INVALID_PENALTY: return "negative penalty";
+        default: return "unknown status";
+    }
+}
+
+// --- Cache Lifecycle ---
+
+void cachesim_config_init(CachesimConfig *config) {
+    *config = (CachesimConfig){1, 16, 16, 30, 2, CACHESIM_REPLACEMENT_LRU, 1};
+}
+
+int32_t cachesim_create(const CachesimConfig *config, const size_t config_size, CachesimCache **cache) {
+    if (!cache) {
+        return CACHESIM_INVALID_ARGUMENT;
+    }
+    *cache = NULL;
+    if (!config || config_size < CACHESIM_CONFIG_MIN_SIZE) {
+        return CACHESIM_INVALID_ARGUMENT;
+    }
+
+    // Fields appended after the caller was built keep their defaults
+    CachesimConfig resolved;
+    cachesim_config_init(&resolved);
+    memcpy(&resolved, config, config_size < sizeof(resolved) ? config_size : sizeof(resolved));
+    const int32_t status = validate_config(&resolved);
+    if (status != CACHESIM_OK) {
+        return status;
+    }
+
+    CachesimCache *handle = allocate_or_exit(1, sizeof(CachesimCache), "cache");
+    handle->cache = initialize_cache(resolved.associativity, resolved.cache_size, resolved.line_size,
+                                     resolved.miss_penalty, resolved.dirty_wb_penalty,
+                                     (ReplacementPolicy)resolved.replacement, resolved.sample_rate);
+    handle->accesses = 0;
+    handle->instructions = 0;
+    *cache = handle;
+    return CACHESIM_OK;
+}
+
+CachesimCache* cachesim_clone(const CachesimCache *cache) {
+    CachesimCache *clone = allocate_or_exit(1, sizeof(CachesimCache), "cache");
+    *clone = *cache;
+    clone->cache = clone_cache(cache->cache);
+    return clone;
+}
+
+void cachesim_destroy(CachesimCache *cache) {
+    if (!cache) {
+        return;
+    }
+    free_cache(cache->cache);
+    free(cache);
+}
+
+void cachesim_reset(CachesimCache *cache) {
+    reset_cache(cache->cache);
+    cache->accesses = 0;
+    cache->instructions = 0;
+}
+
+void cachesim_reset_stats(CachesimCache *cache) {
+    reset_cache_stats(cache->cache);
+    cache->accesses = 0;
+    cache->instructions = 0;
+}
+
+// --- Accesses ---
+
+bool cachesim_access(CachesimCache *cache, const CachesimAccess *access) {
+    CacheOp cache_op;
+    cache->instructions += translate_accesses(access, 1, &cache_op);
+    cache->accesses++;
+    return access_cache(cache->cache, &cache_op);
+}
+
+size_t cachesim_access_batch(CachesimCache *cache, const CachesimAccess *accesses, const size_t num_accesses,
+                             uint8_t *hit_bitmap) {
+    CacheOp cache_ops[CACHESIM_BLOCK_SIZE];
+    size_t hits = 0;
+    for (size_t first = 0; first < num_accesses; first += CACHESIM_BLOCK_SIZE) {
+        const size_t count = num_accesses - first < CACHESIM_BLOCK_SIZE ? num_accesses - first : CACHESIM_BLOCK_SIZE;
+        cache->instructions += translate_accesses(&accesses[first], count, cache_ops);
+        hits += access_cache_batch(cache->cache, cache_ops, count, hit_bitmap ? &hit_bitmap[first / 8] : NULL);
+    }
+    cache->accesses += num_accesses;
+    return hits;
+}
+
+// --- Statistics ---
+
+void cachesim_get_stats(const CachesimCache *cache, CachesimStats *stats, const size_t stats_size) {
+    const Cache *simulated = cache->cache;
+    const CacheSampleEstimate estimate = estimate_sampled_stats(simulated);
+    const CachesimStats snapshot = {
+        cache->accesses, get_cache_hits(simulated), get_cache_misses(simulated), get_dirty_write_backs(simulated),
+        cache->instructions,
+        cache->instructions + get_cache_misses(simulated) * (uint64_t)simulated->miss_penalty
+            + get_dirty_write_backs(simulated) * (uint64_t)simulated->dirty_wb_penalty,
+        estimate.misses, estimate.misses_error, estimate.dirty_write_backs, estimate.dirty_write_backs_error,
+    };
+
+    // Callers built against an older header receive the fields they know
+    memcpy(stats, &snapshot, stats_size < sizeof(snapshot) ? stats_size : sizeof(snapshot));
+}
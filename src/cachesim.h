@@ -0,0 +1,252 @@
+/***************************************************************************/
+/**
+ * @file cachesim.h
+ * @brief Public interface of libcachesim, the embeddable cache simulator.
+ *
+ * The library simulates a write-back, write-allocate cache behind an opaque
+ * handle, so trace-driven tools can feed accesses straight from memory
+ * instead of writing trace files and running `calc`. The header only depends
+ * on the standard library; the internal cache structures can change
+ * without breaking programs linked against the shared library.
+ *
+ * ABI stability:
+ * - The structures of this header only use fixed-width types. New fields are
+ *   only ever appended, and every function taking a structure also takes its
+ *   size, so a program built against an older header keeps working.
+ * - Enumerations are passed as `int32_t` values of the constants below,
+ *   whose values never change.
+ * - The major version is part of the soname (`libcachesim.so.1`) and only
+ *   changes with incompatible changes.
+ *
+ * A typical use configures, warms and clones a cache:
+ * ```
+ * CachesimConfig config;
+ * cachesim_config_init(&config);
+ * config.associativity = 8;
+ * CachesimCache *warm;
+ * if (cachesim_create(&config, sizeof(config), &warm) != CACHESIM_OK) { ... }
+ * cachesim_access_batch(warm, warmup, num_warmup, NULL);
+ * cachesim_reset_stats(warm);
+ * CachesimCache *run = cachesim_clone(warm);
+ * cachesim_access_batch(run, accesses, num_accesses, NULL);
+ * CachesimStats stats;
+ * cachesim_get_stats(run, &stats, sizeof(stats));
+ * ```
+ *
+ * A handle must not be used by several threads at the same time, but distinct
+ * handles are independent. Like the simulator, the library terminates the
+ * process if it runs out of memory.
+ ******************************************************************************/
+
+#ifndef CACHESIM_H_INCLUDED
+#define CACHESIM_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Marks the functions exported by the shared library.
+ */
+#if defined(__GNUC__)
+#define CACHESIM_API __attribute__((visibility("default")))
+#else
+#define CACHESIM_API
+#endif
+
+/**
+ * @brief Version of the interface, the major version is the soname of the shared library.
+ */
+enum {
+    CACHESIM_VERSION_MAJOR = 1,     // Changes with incompatible changes of the interface
+    CACHESIM_VERSION_MINOR = 0,     // Changes with compatible additions to the interface
+};
+
+/**
+ * @brief Results of the functions that can fail.
+ */
+enum {
+    CACHESIM_OK = 0,                // Success
+    CACHESIM_INVALID_ARGUMENT = 1,  // A pointer is NULL or a structure size is too small
+    CACHESIM_INVALID_GEOMETRY = 2,  // Associativity, cache size or line size don't describe a cache
+    CACHESIM_INVALID_POLICY = 3,    // Unknown replacement policy
+    CACHESIM_INVALID_SAMPLING = 4,  // Sample rate isn't a power of two leaving at least two sets
+    CACHESIM_INVALID_PENALTY = 5,   // Miss or write-back penalty is negative
+};
+
+/**
+ * @brief Replacement policies (see cache.h of the simulator for their behavior).
+ */
+enum {
+    CACHESIM_REPLACEMENT_LRU = 0,
+    CACHESIM_REPLACEMENT_PLRU = 1,
+    CACHESIM_REPLACEMENT_SRRIP = 2,
+    CACHESIM_REPLACEMENT_BRRIP = 3,
+    CACHESIM_REPLACEMENT_FIFO = 4,
+    CACHESIM_REPLACEMENT_RANDOM = 5,
+};
+
+/**
+ * @brief Types of an access, equal to the first column of a text trace.
+ */
+enum {
+    CACHESIM_LOAD = 'l',            // Data load
+    CACHESIM_STORE = 's',           // Data store, marks the line as modified
+    CACHESIM_FETCH = 'i',           // Instruction fetch, behaves like a load
+};
+
+/**
+ * @brief A simulated cache. Created by cachesim_create or cachesim_clone, freed by cachesim_destroy.
+ */
+typedef struct CachesimCache CachesimCache;
+
+/**
+ * @brief Configuration of a cache, initialized with the defaults of `calc` by cachesim_config_init.
+ */
+typedef struct CachesimConfig {
+    int32_t associativity;      // Lines per set: 0 for fully associative, 1 for direct-mapped or a power of two
+    int32_t cache_size;         // Cache size in KB, a power of two
+    int32_t line_size;          // Line size in bytes, a power of two
+    int32_t miss_penalty;       // Cycles of a miss
+    int32_t dirty_wb_penalty;   // Cycles of a dirty write-back
+    int32_t replacement;        // One of the CACHESIM_REPLACEMENT_* constants
+    int32_t sample_rate;        // Simulate one in this many sets (power of two), 1 for all sets
+} CachesimConfig;
+
+/**
+ * @brief A memory access, as in one record of a trace.
+ */
+typedef struct CachesimAccess {
+    uint64_t address;           // Accessed address
+    uint32_t instructions;      // Instructions executed since the previous access, including this one
+    uint8_t type;               // CACHESIM_LOAD, CACHESIM_STORE or CACHESIM_FETCH
+    uint8_t reserved[3];        // Padding, ignored
+} CachesimAccess;
+
+/**
+ * @brief Snapshot of the statistics of a cache since its creation or its last reset.
+ * With set sampling, hits, misses and dirty write-backs only count the
+ * accesses to the sampled sets; the estimated counts extrapolate them to all
+ * sets.
+ */
+typedef struct CachesimStats {
+    uint64_t accesses;                  // Simulated accesses, including those to sets outside the sample
+    uint64_t hits;                      // Hits
+    uint64_t misses;                    // Misses
+    uint64_t dirty_write_backs;         // Replaced modified lines
+    uint64_t instructions;              // Sum of the instructions of all accesses
+    uint64_t cycles;                    // Instructions plus the penalties of the misses and dirty write-backs
+    double estimated_misses;            // Misses extrapolated to all sets, equal to `misses` without sampling
+    double estimated_misses_error;      // Half-width of the 95% confidence interval of the estimated misses
+    double estimated_write_backs;       // Dirty write-backs extrapolated to all sets
+    double estimated_write_backs_error; // Half-width of the 95% confidence interval of the estimated write-backs
+} CachesimStats;
+
+/**
+ * @brief Returns the version of the library the program runs with.
+ *
+ * @return `CACHESIM_VERSION_MAJOR << 16 | CACHESIM_VERSION_MINOR` of the library.
+ */
+CACHESIM_API uint32_t cachesim_get_version(void);
+
+/**
+ * @brief Returns a description of a result.
+ *
+ * @param status One of the CACHESIM_* results.
+ * @return A static, human-readable description.
+ */
+CACHESIM_API const char* cachesim_get_status_message(int32_t status);
+
+/**
+ * @brief Fills a configuration with the defaults of `calc`.
+ * A direct-mapped, 16 KB cache with 16-byte lines, LRU replacement, a miss
+ * penalty of 30 and a write-back penalty of 2 cycles, simulating all sets.
+ *
+ * @param config Pointer to the CachesimConfig object.
+ */
+CACHESIM_API void cachesim_config_init(CachesimConfig *config);
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param config Pointer to the configuration.
+ * @param config_size `sizeof(CachesimConfig)` of the caller.
+ * @param cache Pointer receiving the new cache, NULL on failure.
+ * @return CACHESIM_OK, or the reason why the configuration was rejected.
+ */
+CACHESIM_API int32_t cachesim_create(const CachesimConfig *config, size_t config_size, CachesimCache **cache);
+
+/**
+ * @brief Creates an independent copy of a cache with its lines, replacement state and statistics.
+ * All state of a cache lives in one arena, which is copied with a single
+ * memcpy, so a warmed cache can be cloned for every simulation continuing
+ * from it.
+ *
+ * @param cache The cache to copy.
+ * @return The copy, to be freed with cachesim_destroy.
+ */
+CACHESIM_API CachesimCache* cachesim_clone(const CachesimCache *cache);
+
+/**
+ * @brief Frees a cache.
+ *
+ * @param cache The cache, may be NULL.
+ */
+CACHESIM_API void cachesim_destroy(CachesimCache *cache);
+
+/**
+ * @brief Empties a cache and clears its statistics, keeping its memory.
+ *
+ * @param cache The cache.
+ */
+CACHESIM_API void cachesim_reset(CachesimCache *cache);
+
+/**
+ * @brief Clears the statistics of a cache, keeping its lines, e.g. after warming it.
+ *
+ * @param cache The cache.
+ */
+CACHESIM_API void cachesim_reset_stats(CachesimCache *cache);
+
+/**
+ * @brief Simulates a single access.
+ *
+ * @param cache The cache.
+ * @param access Pointer to the access.
+ * @return `true` if the access hits (or its set isn't sampled), `false` if it misses.
+ */
+CACHESIM_API bool cachesim_access(CachesimCache *cache, const CachesimAccess *access);
+
+/**
+ * @brief Simulates accesses in order, with the same results as cachesim_access for each of them.
+ * The batch is handed to the batch kernels of the simulator, which amortize
+ * the cost per access.
+ *
+ * @param cache The cache.
+ * @param accesses Array of accesses.
+ * @param num_accesses Number of accesses.
+ * @param hit_bitmap Bitmap of at least `(num_accesses + 7) / 8` bytes receiving bit `i % 8` of byte `i / 8` set if
+ *        access `i` hits, or NULL if only the number of hits is needed.
+ * @return The number of hits in the batch.
+ */
+CACHESIM_API size_t cachesim_access_batch(CachesimCache *cache, const CachesimAccess *accesses, size_t num_accesses,
+                                          uint8_t *hit_bitmap);
+
+/**
+ * @brief Takes a snapshot of the statistics of a cache.
+ *
+ * @param cache The cache.
+ * @param stats Pointer receiving the statistics.
+ * @param stats_size `sizeof(CachesimStats)` of the caller, only this many bytes are written.
+ */
+CACHESIM_API void cachesim_get_stats(const CachesimCache *cache, CachesimStats *stats, size_t stats_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CACHESIM_H_INCLUDED
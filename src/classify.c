@@ -0,0 +1,209 @@
+/***************************************************************************/
+/**
+ * @file classify.c
+ * @brief Implementation of the miss classification of the cache simulator.
+ *
+ * This source file provides the implementation for the classifier defined in
+ * classify.h. All bits of a line lie in one block of the Bloom filter, so a
+ * probe touches a single host cache line. The block is selected by the low
+ * bits of a hash of the line number and the bits within the block by its high
+ * bits, which never overlap for the largest filter.
+ ******************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "classify.h"
+
+/**
+ * @brief Layout of a block of the Bloom filter.
+ */
+enum {
+    CLASSIFY_BLOCK_BITS = CLASSIFY_BLOCK_WORDS * 64,    // Bits of a block
+    CLASSIFY_BIT_INDEX_BITS = 9,                        // Hash bits selecting a bit within a block
+    CLASSIFY_BATCH_SIZE = 256,                          // Accesses handed to the batch kernel of the shadow at once
+};
+
+_Static_assert(CLASSIFY_BLOCK_BITS == 1 << CLASSIFY_BIT_INDEX_BITS, "A bit index must address a whole block");
+_Static_assert(CLASSIFY_BATCH_SIZE % 8 == 0, "Batches must cover whole bytes of the hit bitmaps");
+_Static_assert(CLASSIFY_FILTER_HASHES * CLASSIFY_BIT_INDEX_BITS + 24 <= 64,
+               "The bit indices must not overlap the block index of the largest filter");
+
+// --- Helper Functions ---
+
+/**
+ * @brief Mixes the bits of a line number (the finalizer of SplitMix64).
+ *
+ * @param line The line number.
+ * @return The hash of the line.
+ */
+static uint64_t hash_line(uint64_t line) {
+    line ^= line >> 30;
+    line *= 0xBF58476D1CE4E5B9ULL;
+    line ^= line >> 27;
+    line *= 0x94D049BB133111EBULL;
+    return line ^ (line >> 31);
+}
+
+/**
+ * @brief Returns the block of the Bloom filter holding the bits of a line.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param hash The hash of the line.
+ * @return Pointer to the first word of the block.
+ */
+static uint64_t* get_filter_block(const MissClassifier *classifier, const uint64_t hash) {
+    return &classifier->filter[(hash & (classifier->num_blocks - 1)) * CLASSIFY_BLOCK_WORDS];
+}
+
+/**
+ * @brief Inserts a line into the Bloom filter.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param hash The hash of the line.
+ * @return `true` if all bits of the line were already set (the line was probably seen), `false` otherwise.
+ */
+static bool insert_seen_line(MissClassifier *classifier, const uint64_t hash) {
+    uint64_t *block = get_filter_block(classifier, hash);
+    bool was_seen = true;
+    for (int i = 1; i <= CLASSIFY_FILTER_HASHES; i++) {
+        const unsigned bit = (unsigned)(hash >> (64 - i * CLASSIFY_BIT_INDEX_BITS)) & (CLASSIFY_BLOCK_BITS - 1);
+        const uint64_t mask = 1ULL << (bit % 64);
+        if (!(block[bit / 64] & mask)) {
+            block[bit / 64] |= mask;
+            classifier->filter_bits_set++;
+            was_seen = false;
+        }
+    }
+    return was_seen;
+}
+
+/**
+ * @brief Computes the hash of the line of an access.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param cache_op Pointer to the CacheOp object of the access.
+ * @return The hash of the line.
+ */
+static uint64_t hash_access_line(const MissClassifier *classifier, const CacheOp *cache_op) {
+    return hash_line(cache_op->address >> classifier->shadow->log_line_size);
+}
+
+/**
+ * @brief Counts a miss of the classified cache and the shadow as compulsory or capacity miss.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param hash The hash of the line of the miss.
+ */
+static void count_shadow_miss(MissClassifier *classifier, const uint64_t hash) {
+    if (insert_seen_line(classifier, hash)) {
+        classifier->stats.capacity++;
+    } else {
+        classifier->stats.compulsory++;
+    }
+}
+
+// --- Classifier Functions ---
+
+MissClassifier* initialize_classifier(const ClassifyOptions *options, const Cache *cache) {
+    MissClassifier *classifier = allocate_or_exit(1, sizeof(MissClassifier), "the miss classification");
+    const size_t filter_bytes = (size_t)options->filter_size * 1024;
+    classifier->filter = (uint64_t *)aligned_alloc(CLASSIFY_BLOCK_WORDS * sizeof(uint64_t), filter_bytes);
+    if (!classifier->filter) {
+        fprintf(stderr, "Failed to allocate memory for the miss classification.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(classifier->filter, 0, filter_bytes);
+    classifier->num_blocks = filter_bytes / (CLASSIFY_BLOCK_WORDS * sizeof(uint64_t));
+    classifier->filter_size = options->filter_size;
+
+    // The penalties of the shadow are never used, store misses of no-write-allocate caches leave it unchanged as well
+    classifier->shadow = initialize_cache(0, cache->cache_size, cache->line_size, 0, 0, REPLACEMENT_LRU, 1);
+    if (cache->write_policy != WRITE_BACK_ALLOCATE) {
+        set_write_policy(classifier->shadow, cache->write_policy, 0);
+    }
+    return classifier;
+}
+
+void free_classifier(MissClassifier *classifier) {
+    free_cache(classifier->shadow);
+    free(classifier->filter);
+    free(classifier);
+}
+
+// --- Classification ---
+
+void classify_cache_access(MissClassifier *classifier, const CacheOp *cache_op, const bool is_hit) {
+    // A first access always misses the shadow, so only misses of the shadow need the filter
+    const bool is_shadow_hit = access_cache(classifier->shadow, cache_op);
+    if (is_hit) {
+        return;
+    }
+    if (is_shadow_hit) {
+        classifier->stats.conflict++;
+    } else {
+        count_shadow_miss(classifier, hash_access_line(classifier, cache_op));
+    }
+}
+
+void classify_cache_batch(MissClassifier *classifier, const CacheOp *cache_ops, const size_t num_ops,
+                          const uint8_t *hit_bitmap) {
+    uint8_t shadow_bitmap[CLASSIFY_BATCH_SIZE / 8];
+    uint64_t hashes[CLASSIFY_BATCH_SIZE];
+    for (size_t start = 0; start < num_ops; start += CLASSIFY_BATCH_SIZE) {
+        const size_t count = num_ops - start < CLASSIFY_BATCH_SIZE ? num_ops - start : CLASSIFY_BATCH_SIZE;
+        access_cache_batch(classifier->shadow, &cache_ops[start], count, shadow_bitmap);
+
+        // The filter blocks of all misses of the shadow are prefetched before the first one is probed
+        size_t num_probes = 0;
+        for (size_t i = 0; i < count; i++) {
+            const size_t op = start + i;
+            if ((hit_bitmap[op / 8] >> (op % 8)) & 1) {
+                continue;
+            }
+            if ((shadow_bitmap[i / 8] >> (i % 8)) & 1) {
+                classifier->stats.conflict++;
+            } else {
+                hashes[num_probes] = hash_access_line(classifier, &cache_ops[op]);
+                __builtin_prefetch(get_filter_block(classifier, hashes[num_probes]), 1);
+                num_probes++;
+            }
+        }
+        for (size_t p = 0; p < num_probes; p++) {
+            count_shadow_miss(classifier, hashes[p]);
+        }
+    }
+}
+
+void warm_classifier(MissClassifier *classifier, const CacheOp *cache_op) {
+    if (!access_cache(classifier->shadow, cache_op)) {
+        insert_seen_line(classifier, hash_access_line(classifier, cache_op));
+    }
+}
+
+void warm_classifier_batch(MissClassifier *classifier, const CacheOp *cache_ops, const size_t num_ops) {
+    uint8_t shadow_bitmap[CLASSIFY_BATCH_SIZE / 8];
+    uint64_t hashes[CLASSIFY_BATCH_SIZE];
+    for (size_t start = 0; start < num_ops; start += CLASSIFY_BATCH_SIZE) {
+        const size_t count = num_ops - start < CLASSIFY_BATCH_SIZE ? num_ops - start : CLASSIFY_BATCH_SIZE;
+        access_cache_batch(classifier->shadow, &cache_ops[start], count, shadow_bitmap);
+
+        size_t num_probes = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!((shadow_bitmap[i / 8] >> (i % 8)) & 1)) {
+                hashes[num_probes] = hash_access_line(classifier, &cache_ops[start + i]);
+                __builtin_prefetch(get_filter_block(classifier, hashes[num_probes]), 1);
+                num_probes++;
+            }
+        }
+        for (size_t p = 0; p < num_probes; p++) {
+            insert_seen_line(classifier, hashes[p]);
+        }
+    }
+}
+
+double estimate_classifier_error(const MissClassifier *classifier) {
+    const double fill = (double) classifier->filter_bits_set / ((double) classifier->num_blocks * CLASSIFY_BLOCK_BITS);
+    return pow(fill, CLASSIFY_FILTER_HASHES);
+}
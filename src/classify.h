@@ -0,0 +1,146 @@
+/***************************************************************************/
+/**
+ * @file classify.h
+ * @brief Header file for the classification of cache misses into compulsory,
+ * capacity and conflict misses (3C) of the cache simulator.
+ *
+ * Every miss of the classified cache falls into exactly one class:
+ * - A compulsory miss is the first access to its line.
+ * - A conflict miss hits a fully associative LRU cache of the same capacity
+ *   and line size, which runs next to the classified cache as a shadow.
+ * - All other misses are capacity misses.
+ *
+ * The shadow is a regular cache of cache.h, whose fully associative kernel
+ * finds a line through the line index and keeps the LRU order in a linked
+ * list, so it costs O(1) per access at any size. The lines seen so far are
+ * kept in a Bloom filter of fixed size, blocked into host cache lines, which
+ * is only probed by accesses missing the shadow. The memory of a classifier
+ * is therefore bounded by the size of the cache plus the filter, independent
+ * of the trace, and every access costs a constant amount of work.
+ *
+ * A Bloom filter never forgets a line, but may report a line as seen that
+ * wasn't. Such a false positive counts a compulsory miss as a capacity miss,
+ * so the compulsory misses are a lower bound; the conflict misses are exact.
+ * The estimated false positive rate is reported with the classes.
+ *
+ * The shadow has to see every access since the cache was empty, so
+ * classification supports neither set sampling, nor partitioned simulation,
+ * nor caches continued from a saved state. Prefetching would mix prefetched
+ * lines into the classes and is not supported either.
+ ******************************************************************************/
+
+#ifndef CLASSIFY_H_INCLUDED
+#define CLASSIFY_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * @brief Defaults, limits and layout of the miss classification.
+ */
+enum {
+    CLASSIFY_DEFAULT_FILTER_SIZE = 1024,    // Default size of the Bloom filter in KB
+    CLASSIFY_MAX_FILTER_SIZE = 1 << 20,     // Largest size of the Bloom filter in KB
+    CLASSIFY_BLOCK_WORDS = 8,               // 64-bit words of a filter block, one host cache line
+    CLASSIFY_FILTER_HASHES = 4,             // Bits set per line within its block
+};
+
+/**
+ * @brief Options of the miss classification given on the command line.
+ */
+typedef struct ClassifyOptions {
+    bool is_enabled;        // Indicates if the misses are classified
+    int filter_size;        // Size of the Bloom filter in KB, a power of two
+} ClassifyOptions;
+
+/**
+ * @brief Number of misses of every class.
+ */
+typedef struct MissClassStats {
+    uint64_t compulsory;    // First accesses to a line
+    uint64_t capacity;      // Misses of the fully associative LRU cache of the same capacity as well
+    uint64_t conflict;      // Hits of the fully associative LRU cache of the same capacity
+} MissClassStats;
+
+/**
+ * @brief State of the classification of the misses of one cache.
+ */
+typedef struct MissClassifier {
+    Cache *shadow;              // Fully associative LRU cache with the capacity and line size of the classified cache
+    uint64_t *filter;           // Bloom filter of the lines seen so far, CLASSIFY_BLOCK_WORDS words per block
+    size_t num_blocks;          // Number of blocks of the filter (power of two)
+    uint64_t filter_bits_set;   // Number of set bits of the filter
+    int filter_size;            // Size of the filter in KB
+    MissClassStats stats;       // Misses of every class
+} MissClassifier;
+
+/**
+ * @brief Creates a classifier for the misses of an empty cache.
+ *
+ * @param options Pointer to the ClassifyOptions object.
+ * @param cache Pointer to the classified Cache object, which must simulate all sets.
+ * @return Pointer to the initialized MissClassifier object.
+ */
+MissClassifier* initialize_classifier(const ClassifyOptions *options, const Cache *cache);
+
+/**
+ * @brief Frees the memory allocated for the classifier and its shadow.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ */
+void free_classifier(MissClassifier *classifier);
+
+/**
+ * @brief Simulates an access in the shadow and classifies it if it missed the classified cache.
+ * Must be called for every measured access, after the classified cache has
+ * simulated it.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param is_hit Indicates if the access hit the classified cache.
+ */
+void classify_cache_access(MissClassifier *classifier, const CacheOp *cache_op, bool is_hit);
+
+/**
+ * @brief Classifies a batch of accesses, with the same results as classify_cache_access for each of them.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ * @param hit_bitmap Bitmap of the hits of the classified cache as written by access_cache_batch.
+ */
+void classify_cache_batch(MissClassifier *classifier, const CacheOp *cache_ops, size_t num_ops,
+                          const uint8_t *hit_bitmap);
+
+/**
+ * @brief Simulates an access that only warms the cache in the shadow and the filter.
+ * Must be called for every access warming the classified cache, so a line
+ * first accessed while warming doesn't cause a compulsory miss later.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ */
+void warm_classifier(MissClassifier *classifier, const CacheOp *cache_op);
+
+/**
+ * @brief Simulates a batch of accesses that only warm the cache in the shadow and the filter.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ */
+void warm_classifier_batch(MissClassifier *classifier, const CacheOp *cache_ops, size_t num_ops);
+
+/**
+ * @brief Estimates the probability that the filter reports an unseen line as seen.
+ * The estimate assumes the set bits to be spread evenly over the filter.
+ *
+ * @param classifier Pointer to the MissClassifier object.
+ * @return The estimated false positive rate between 0 and 1.
+ */
+double estimate_classifier_error(const MissClassifier *classifier);
+
+#endif // CLASSIFY_H_INCLUDED
@@ -0,0 +1,241 @@
+/***************************************************************************/
+/**
+ * @file coherence.c
+ * @brief Implementation of the coherence directory of the multi-core
+ * simulation of the cache simulator.
+ *
+ * This source file provides the implementation for the directory defined in
+ * coherence.h. The entries are kept in an open-addressing hash table
+ * (hashtable.h) keyed by the line number + 1. An entry is removed as soon as
+ * no private cache holds its line, so the table never grows beyond half its
+ * capacity.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "coherence.h"
+#include "hashtable.h"
+
+// --- Helper Functions ---
+
+/**
+ * @brief Finds the slot of a key in the directory, or the empty slot where it belongs.
+ *
+ * @param directory Pointer to the Directory object.
+ * @param key Line number + 1.
+ * @return The slot of the key.
+ */
+static size_t find_directory_slot(const Directory *directory, const uint64_t key) {
+    return find_hash_slot(directory->entries, sizeof(DirectoryEntry), directory->capacity, key);
+}
+
+/**
+ * @brief Returns the entry of a line, creating an entry without holders if the line isn't tracked yet.
+ *
+ * @param directory Pointer to the Directory object.
+ * @param line The line number.
+ * @return Pointer to the DirectoryEntry object of the line.
+ */
+static DirectoryEntry* get_directory_entry(Directory *directory, const uint64_t line) {
+    DirectoryEntry *entry = &directory->entries[find_directory_slot(directory, line + 1)];
+    if (entry->key == 0) {
+        *entry = (DirectoryEntry){line + 1, 0, 0, -1, COHERENCE_SHARED};
+        if (++directory->num_entries > directory->max_entries) {
+            directory->max_entries = directory->num_entries;
+        }
+    }
+    return entry;
+}
+
+/**
+ * @brief Removes the entry in a slot of the directory.
+ *
+ * @param directory Pointer to the Directory object.
+ * @param slot The slot of the entry.
+ */
+static void remove_directory_entry(Directory *directory, const size_t slot) {
+    remove_hash_slot(directory->entries, sizeof(DirectoryEntry), directory->capacity, slot);
+    directory->num_entries--;
+}
+
+/**
+ * @brief Removes a core from the holders of a line it has replaced.
+ * The entry is removed with the last holder, together with the cores that
+ * lost the line to an invalidation.
+ *
+ * @param directory Pointer to the Directory object.
+ * @param line The line number.
+ * @param core Number of the core.
+ */
+static void remove_sharer(Directory *directory, const uint64_t line, const int core) {
+    const size_t slot = find_directory_slot(directory, line + 1);
+    DirectoryEntry *entry = &directory->entries[slot];
+    if (entry->key == 0) {
+        return;
+    }
+
+    entry->sharers &= ~(1ULL << core);
+    if (entry->owner == core) {
+        entry->owner = -1;
+        entry->state = COHERENCE_SHARED;
+    }
+    if (entry->sharers == 0) {
+        remove_directory_entry(directory, slot);
+    }
+}
+
+/**
+ * @brief Invalidates the copies of a line in a set of cores.
+ * The invalidated copies are not written back: the storing core receives
+ * their data and holds the only, modified copy afterwards.
+ *
+ * @param entry Pointer to the DirectoryEntry object of the line.
+ * @param caches The private caches.
+ * @param cores Bit vector of the cores whose copies are invalidated.
+ * @param address An address within the line.
+ * @param stats Pointer to the CoherenceStats object of the storing core.
+ */
+static void invalidate_sharers(DirectoryEntry *entry, Cache *const *caches, uint64_t cores, const uint64_t address,
+                               CoherenceStats *stats) {
+    while (cores != 0) {
+        const int core = __builtin_ctzll(cores);
+        cores &= cores - 1;
+
+        bool was_dirty;
+        invalidate_cache_line(caches[core], address, &was_dirty);
+        entry->lost |= 1ULL << core;
+        stats->invalidations++;
+    }
+}
+
+// --- Directory Functions ---
+
+bool parse_coherence_protocol(const char *name, CoherenceProtocol *protocol) {
+    if (strcmp(name, "mesi") == 0) {
+        *protocol = COHERENCE_MESI;
+    } else if (strcmp(name, "moesi") == 0) {
+        *protocol = COHERENCE_MOESI;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* get_coherence_protocol_name(const CoherenceProtocol protocol) {
+    switch (protocol) {
+        case COHERENCE_MESI: return "mesi";
+        case COHERENCE_MOESI: return "moesi";
+        default: return "none";
+    }
+}
+
+Directory* initialize_directory(const CoherenceProtocol protocol, Cache *const *caches, const int num_caches) {
+    Directory *directory = allocate_or_exit(1, sizeof(Directory), "the coherence directory");
+    directory->protocol = protocol;
+    directory->log_line_size = caches[0]->log_line_size;
+
+    // Every entry belongs to a line of at least one private cache, so the table stays at most half full
+    size_t num_lines = 0;
+    for (int c = 0; c < num_caches; c++) {
+        num_lines += (size_t)caches[c]->cache_size * 1024 / (size_t)caches[c]->line_size;
+    }
+    directory->capacity = 1;
+    while (directory->capacity < num_lines * 2) {
+        directory->capacity *= 2;
+    }
+    directory->entries = allocate_or_exit(directory->capacity, sizeof(DirectoryEntry), "the coherence directory");
+
+    return directory;
+}
+
+void free_directory(Directory *directory) {
+    free(directory->entries);
+    free(directory);
+}
+
+// --- Coherent Accesses ---
+
+CoherenceAccess access_coherent(Directory *directory, Cache *const *caches, const int core, const CacheOp *cache_op,
+                                CoherenceStats *stats) {
+    const bool is_store = cache_op->access_type == 's';
+    const uint64_t line = cache_op->address >> directory->log_line_size;
+    const uint64_t line_address = line << directory->log_line_size;
+    const uint64_t core_bit = 1ULL << core;
+    Cache *cache = caches[core];
+
+    CoherenceAccess access = {access_cache(cache, cache_op), false, 0, {0, 0}};
+    if (access.is_hit && !is_store) {
+        return access; // Every state may be read
+    }
+
+    DirectoryEntry *entry;
+    if (access.is_hit) {
+        entry = &directory->entries[find_directory_slot(directory, line + 1)];
+    } else {
+        // The replaced line leaves the directory first, which may move the entries of other lines
+        const CacheEviction victim = cache->last_eviction;
+        if (victim.is_valid) {
+            remove_sharer(directory, victim.address >> directory->log_line_size, core);
+            if (victim.is_dirty) {
+                access.write_backs[access.num_write_backs++] = victim.address;
+            }
+        }
+
+        entry = get_directory_entry(directory, line);
+        if (entry->lost & core_bit) {
+            stats->coherence_misses++;
+            entry->lost &= ~core_bit;
+        }
+    }
+
+    const bool has_dirty_owner = entry->owner >= 0 && entry->owner != core
+                                 && (entry->state == COHERENCE_MODIFIED || entry->state == COHERENCE_OWNED);
+    if (is_store) {
+        // Exclusive and Modified copies are written silently, all others need the only copy first
+        if (access.is_hit && (entry->owner != core || entry->state == COHERENCE_OWNED)) {
+            stats->upgrades++;
+        } else if (!access.is_hit && has_dirty_owner) {
+            stats->transfers++;
+        } else if (!access.is_hit) {
+            access.needs_fill = true;
+        }
+
+        invalidate_sharers(entry, caches, entry->sharers & ~core_bit, line_address, stats);
+        entry->sharers = core_bit;
+        entry->owner = (int8_t)core;
+        entry->state = COHERENCE_MODIFIED;
+        return access;
+    }
+
+    // A load miss takes the exclusive state away from the owner
+    if (has_dirty_owner) {
+        stats->transfers++;
+        if (entry->state == COHERENCE_MODIFIED) {
+            stats->downgrades++;
+            if (directory->protocol == COHERENCE_MOESI) {
+                entry->state = COHERENCE_OWNED;
+            } else {
+                clean_cache_line(caches[entry->owner], line_address);
+                stats->write_backs++;
+                access.write_backs[access.num_write_backs++] = line_address;
+                entry->owner = -1;
+                entry->state = COHERENCE_SHARED;
+            }
+        }
+    } else {
+        if (entry->owner >= 0) {
+            stats->downgrades++;
+            entry->owner = -1;
+            entry->state = COHERENCE_SHARED;
+        }
+        access.needs_fill = true;
+    }
+
+    if (entry->sharers == 0) {
+        entry->owner = (int8_t)core;
+        entry->state = COHERENCE_EXCLUSIVE;
+    }
+    entry->sharers |= core_bit;
+    return access;
+}
@@ -0,0 +1,168 @@
+/***************************************************************************/
+/**
+ * @file coherence.h
+ * @brief Header file for the coherence directory of the multi-core simulation
+ * of the cache simulator.
+ *
+ * With a coherence protocol, the private caches of a multi-core system keep
+ * their copies of a line consistent. Every private copy is in one of the
+ * states of MESI (or MOESI):
+ *
+ * - Modified: the only copy, changed by the core.
+ * - Owned (MOESI only): a changed copy that other cores share. The owner
+ *   supplies the line to other cores and writes it back when it's replaced.
+ * - Exclusive: the only copy, unchanged.
+ * - Shared: one of several unchanged copies (or the copies of an owner).
+ *
+ * A store to a line that other cores hold invalidates their copies; a store
+ * hit to a shared copy is an upgrade. A load miss to a line another core holds
+ * exclusively downgrades that copy. Under MESI, a modified copy is written
+ * back to the shared cache when it's downgraded; under MOESI, it becomes owned
+ * instead. A miss to a line that another core holds modified or owned is
+ * served by a cache-to-cache transfer instead of the shared cache.
+ *
+ * The states aren't stored in the private caches, whose lines only know valid
+ * and dirty. A sparse directory at the shared level keeps one entry per line
+ * held by at least one private cache: a bit vector of the cores holding it,
+ * the owner (the core with the Exclusive, Modified or Owned copy, if any) and
+ * the state of the owner; all other holders are Shared. The directory is an
+ * open-addressing hash table with twice as many slots as there are lines in
+ * all private caches, so its size is fixed and it never overflows.
+ *
+ * A miss to a line that the core lost to an invalidation is a coherence miss.
+ * The invalidated cores are remembered in a second bit vector of the entry, so
+ * a coherence miss is only recognized while another core still holds the line.
+ ******************************************************************************/
+
+#ifndef COHERENCE_H_INCLUDED
+#define COHERENCE_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * @brief Limits of the coherence directory.
+ */
+enum {
+    COHERENCE_MAX_CORES = 64,   // Number of cores a bit vector of the directory can hold
+};
+
+/**
+ * @brief Coherence protocol of a multi-core system.
+ */
+typedef enum CoherenceProtocol {
+    COHERENCE_NONE,     // Private caches aren't kept coherent
+    COHERENCE_MESI,     // Modified, Exclusive, Shared, Invalid
+    COHERENCE_MOESI,    // MESI with an Owned state, downgraded modified lines aren't written back
+} CoherenceProtocol;
+
+/**
+ * @brief State of the owner of a line in the directory.
+ */
+typedef enum CoherenceState {
+    COHERENCE_SHARED,       // No owner, all holders are Shared
+    COHERENCE_EXCLUSIVE,    // The owner holds the only, unchanged copy
+    COHERENCE_MODIFIED,     // The owner holds the only, changed copy
+    COHERENCE_OWNED,        // The owner holds a changed copy that others share
+} CoherenceState;
+
+/**
+ * @brief Coherence statistics of a core.
+ */
+typedef struct CoherenceStats {
+    uint64_t coherence_misses;  // Misses to lines the core lost to an invalidation by another core
+    uint64_t invalidations;     // Copies of other cores invalidated by stores of the core
+    uint64_t upgrades;          // Store hits to Shared or Owned copies
+    uint64_t downgrades;        // Exclusive or Modified copies of other cores downgraded by loads of the core
+    uint64_t transfers;         // Misses served by a Modified or Owned copy of another core
+    uint64_t write_backs;       // Modified copies of other cores written back when downgraded (MESI only)
+} CoherenceStats;
+
+/**
+ * @brief A line tracked by the directory.
+ */
+typedef struct DirectoryEntry {
+    uint64_t key;           // Line number + 1, 0 if the slot is empty
+    uint64_t sharers;       // Bit vector of the cores holding the line
+    uint64_t lost;          // Bit vector of the cores that lost the line to an invalidation
+    int8_t owner;           // Core holding the line Exclusive, Modified or Owned, -1 if none
+    uint8_t state;          // CoherenceState of the owner, COHERENCE_SHARED without owner
+} DirectoryEntry;
+
+/**
+ * @brief The coherence directory of a multi-core system.
+ */
+typedef struct Directory {
+    CoherenceProtocol protocol; // Coherence protocol
+    int log_line_size;          // log2 of the line size shared by all private caches
+    DirectoryEntry *entries;    // Open-addressing hash table of the tracked lines
+    size_t capacity;            // Number of slots (power of two, at least twice the lines of all private caches)
+    size_t num_entries;         // Number of tracked lines
+    size_t max_entries;         // Largest number of tracked lines so far
+} Directory;
+
+/**
+ * @brief Result of a coherent access of a core.
+ * The shared cache receives the write-backs first, then the fill.
+ */
+typedef struct CoherenceAccess {
+    bool is_hit;                // Indicates if the private cache hit
+    bool needs_fill;            // Indicates if the line has to be fetched from the shared cache
+    int num_write_backs;        // Number of dirty lines written back into the shared cache
+    uint64_t write_backs[2];    // Addresses of the lines written back: the private victim and a downgraded copy
+} CoherenceAccess;
+
+/**
+ * @brief Looks up a coherence protocol by its name.
+ *
+ * @param name Name of the protocol ("mesi" or "moesi").
+ * @param protocol Pointer receiving the protocol.
+ * @return `true` if the name is known, `false` otherwise.
+ */
+bool parse_coherence_protocol(const char *name, CoherenceProtocol *protocol);
+
+/**
+ * @brief Returns the name of a coherence protocol.
+ *
+ * @param protocol The coherence protocol.
+ * @return The name of the protocol.
+ */
+const char* get_coherence_protocol_name(CoherenceProtocol protocol);
+
+/**
+ * @brief Creates an empty directory for a set of private caches.
+ *
+ * @param protocol The coherence protocol, not COHERENCE_NONE.
+ * @param caches The private caches, all with the same line size and without set sampling.
+ * @param num_caches Number of private caches, at most COHERENCE_MAX_CORES.
+ * @return Pointer to the initialized Directory object.
+ */
+Directory* initialize_directory(CoherenceProtocol protocol, Cache *const *caches, int num_caches);
+
+/**
+ * @brief Frees the memory allocated for a directory.
+ *
+ * @param directory Pointer to the Directory object.
+ */
+void free_directory(Directory *directory);
+
+/**
+ * @brief Simulates an access of a core to its private cache and keeps the other private caches coherent.
+ * Copies of other cores are invalidated, downgraded and cleaned as the
+ * protocol requires. The requests to the shared cache are returned to the
+ * caller, which simulates them.
+ *
+ * @param directory Pointer to the Directory object.
+ * @param caches The private caches the directory was created for.
+ * @param core Number of the accessing core.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param stats Pointer to the CoherenceStats object of the accessing core.
+ * @return The result of the access with the requests to the shared cache.
+ */
+CoherenceAccess access_coherent(Directory *directory, Cache *const *caches, int core, const CacheOp *cache_op,
+                                CoherenceStats *stats);
+
+#endif // COHERENCE_H_INCLUDED
@@ -0,0 +1,69 @@
+/***************************************************************************/
+/**
+ * @file hashtable.c
+ * @brief Implementation of the open-addressing hash tables of the cache
+ * simulator.
+ *
+ * This source file provides the implementation for the probing and deletion
+ * defined in hashtable.h.
+ ******************************************************************************/
+
+#include <string.h>
+#include "hashtable.h"
+
+/**
+ * @brief Multiplier of the hash selecting the home slot of a key (2^64 / golden ratio).
+ */
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+// --- Helper Functions ---
+
+/**
+ * @brief Returns the key of a slot.
+ *
+ * @param slots The slots of the table.
+ * @param slot_size Size of a slot in bytes.
+ * @param slot The slot.
+ * @return The key of the slot, 0 if it's empty.
+ */
+static uint64_t get_slot_key(const void *slots, const size_t slot_size, const size_t slot) {
+    uint64_t key;
+    memcpy(&key, (const char *)slots + slot * slot_size, sizeof(key));
+    return key;
+}
+
+/**
+ * @brief Computes the home slot of a key.
+ *
+ * @param capacity Number of slots (power of two, at least two).
+ * @param key The nonzero key.
+ * @return The first slot probed for the key.
+ */
+static size_t get_home_slot(const size_t capacity, const uint64_t key) {
+    return (size_t)((key * HASH_MULTIPLIER) >> (64 - __builtin_ctzll(capacity)));
+}
+
+// --- Table Operations ---
+
+size_t find_hash_slot(const void *slots, const size_t slot_size, const size_t capacity, const uint64_t key) {
+    const size_t mask = capacity - 1;
+    size_t slot = get_home_slot(capacity, key);
+    for (uint64_t slot_key; (slot_key = get_slot_key(slots, slot_size, slot)) != 0 && slot_key != key;) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void remove_hash_slot(void *slots, const size_t slot_size, const size_t capacity, size_t hole) {
+    const size_t mask = capacity - 1;
+    char *bytes = slots;
+    for (size_t slot = (hole + 1) & mask; get_slot_key(slots, slot_size, slot) != 0; slot = (slot + 1) & mask) {
+        // An entry may move into the hole if the hole lies between its home slot and its slot
+        const size_t home = get_home_slot(capacity, get_slot_key(slots, slot_size, slot));
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            memcpy(bytes + hole * slot_size, bytes + slot * slot_size, slot_size);
+            hole = slot;
+        }
+    }
+    memset(bytes + hole * slot_size, 0, sizeof(uint64_t));
+}
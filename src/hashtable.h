@@ -0,0 +1,50 @@
+/***************************************************************************/
+/**
+ * @file hashtable.h
+ * @brief Header file for the open-addressing hash tables of the cache
+ * simulator.
+ *
+ * The prefetcher, the coherence directory and the miss attribution keep their
+ * entries in hash tables with linear probing and backward-shift deletion. A
+ * table is an array of slots of equal size whose first member is a `uint64_t`
+ * key, 0 marks an empty slot. The number of slots is a power of two of at least
+ * two, and the owner keeps the table at most half full, so probe sequences stay
+ * short and always end.
+ *
+ * The line index of highly associative caches and the index of the stack
+ * distance engine keep their own probes in cache.c. Both are searched on every
+ * access, the line index from the inlined access kernels, and their keys sit
+ * in an array of their own next to the ways or time stamps, so one host cache
+ * line holds eight keys of a probe sequence.
+ ******************************************************************************/
+
+#ifndef HASHTABLE_H_INCLUDED
+#define HASHTABLE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Finds the slot of a key, or the empty slot where it belongs.
+ *
+ * @param slots The slots of the table.
+ * @param slot_size Size of a slot in bytes.
+ * @param capacity Number of slots (power of two, at least two).
+ * @param key The nonzero key.
+ * @return The slot of the key.
+ */
+size_t find_hash_slot(const void *slots, size_t slot_size, size_t capacity, uint64_t key);
+
+/**
+ * @brief Empties an occupied slot.
+ * The following entries of the probe sequence are shifted back into the hole,
+ * so lookups never need tombstones.
+ *
+ * @param slots The slots of the table.
+ * @param slot_size Size of a slot in bytes.
+ * @param capacity Number of slots (power of two, at least two).
+ * @param hole The slot to empty.
+ */
+void remove_hash_slot(void *slots, size_t slot_size, size_t capacity, size_t hole);
+
+#endif // HASHTABLE_H_INCLUDED
@@ -0,0 +1,242 @@
+/***************************************************************************/
+/**
+ * @file hierarchy.c
+ * @brief Implementation of the multi-level cache hierarchy of the cache
+ * simulator.
+ *
+ * This source file provides the implementation for the hierarchy defined in
+ * hierarchy.h. Every level is a regular Cache; the hierarchy only forwards
+ * misses and replaced lines between the levels, using the eviction record and
+ * the line management functions of cache.h.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "hierarchy.h"
+
+// --- Helper Functions ---
+
+/**
+ * @brief Returns the level of the hierarchy an access reaches at the given depth.
+ * Instruction fetches use the L1I (if any) as their first level.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @param depth Depth of the level, `0` for the first level.
+ * @return Pointer to the HierarchyLevel object.
+ */
+static HierarchyLevel* get_hierarchy_level(Hierarchy *hierarchy, const CacheOp *cache_op, const int depth) {
+    if (depth == 0 && cache_op->access_type == 'i' && hierarchy->has_instruction_level) {
+        return &hierarchy->instruction_level;
+    }
+    return &hierarchy->levels[depth];
+}
+
+/**
+ * @brief Invalidates a line in all levels above the given depth (back-invalidation).
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param address An address within the line.
+ * @param depth Depth of the level that evicted the line.
+ * @return `true` if one of the invalidated copies was modified, `false` otherwise.
+ */
+static bool invalidate_higher_levels(Hierarchy *hierarchy, const uint64_t address, const int depth) {
+    bool any_dirty = false;
+    bool was_dirty;
+
+    for (int d = 0; d < depth; d++) {
+        if (invalidate_cache_line(hierarchy->levels[d].cache, address, &was_dirty)) {
+            hierarchy->levels[d].back_invalidations++;
+            any_dirty |= was_dirty;
+        }
+    }
+    if (hierarchy->has_instruction_level
+        && invalidate_cache_line(hierarchy->instruction_level.cache, address, &was_dirty)) {
+        hierarchy->instruction_level.back_invalidations++;
+        any_dirty |= was_dirty;
+    }
+
+    return any_dirty;
+}
+
+static void write_hierarchy_line(Hierarchy *hierarchy, uint64_t address, bool is_dirty, int depth);
+
+/**
+ * @brief Passes the line a level has just replaced on to the next level.
+ * NINE and inclusive hierarchies only write back dirty lines, exclusive
+ * hierarchies move every replaced line down.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param level Pointer to the level that replaced the line.
+ * @param depth Depth of the level.
+ */
+static void pass_eviction(Hierarchy *hierarchy, const HierarchyLevel *level, const int depth) {
+    CacheEviction victim = level->cache->last_eviction;
+    if (!victim.is_valid) {
+        return;
+    }
+
+    if (hierarchy->inclusion == INCLUSION_INCLUSIVE && depth > 0) {
+        // Modified copies of higher levels are written back together with the line
+        victim.is_dirty |= invalidate_higher_levels(hierarchy, victim.address, depth);
+    }
+
+    if (hierarchy->inclusion == INCLUSION_EXCLUSIVE || victim.is_dirty) {
+        write_hierarchy_line(hierarchy, victim.address, victim.is_dirty, depth + 1);
+    }
+}
+
+/**
+ * @brief Writes a line coming from a higher level into the level at the given depth.
+ * Lines written below the last level go to memory.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param address An address within the line.
+ * @param is_dirty Indicates if the line is modified.
+ * @param depth Depth of the receiving level.
+ */
+static void write_hierarchy_line(Hierarchy *hierarchy, const uint64_t address, const bool is_dirty,
+                                 const int depth) {
+    if (depth == hierarchy->num_levels) {
+        if (is_dirty) {
+            hierarchy->memory_writes++;
+        }
+        return;
+    }
+
+    HierarchyLevel *level = &hierarchy->levels[depth];
+    if (is_dirty) {
+        level->write_backs_in++;
+    }
+    install_cache_line(level->cache, address, is_dirty);
+    pass_eviction(hierarchy, level, depth);
+}
+
+/**
+ * @brief Simulates an access in an exclusive hierarchy.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @return The number of cycles spent for the access.
+ */
+static int access_exclusive_hierarchy(Hierarchy *hierarchy, const CacheOp *cache_op) {
+    HierarchyLevel *first_level = get_hierarchy_level(hierarchy, cache_op, 0);
+    int cycle_count = first_level->latency;
+    if (access_cache(first_level->cache, cache_op)) {
+        return cycle_count;
+    }
+    const CacheEviction victim = first_level->cache->last_eviction;
+
+    // Look the line up in the lower levels, it moves to the first level on a hit
+    const CacheOp fill_op = initialize_cache_operation('l', cache_op->address, 0);
+    bool is_found = false;
+    bool was_dirty = false;
+    for (int depth = 1; depth < hierarchy->num_levels && !is_found; depth++) {
+        HierarchyLevel *level = &hierarchy->levels[depth];
+        cycle_count += level->latency;
+        is_found = extract_cache_line(level->cache, &fill_op, &was_dirty);
+    }
+
+    if (!is_found) {
+        hierarchy->memory_reads++;
+        cycle_count += hierarchy->memory_latency;
+    } else if (was_dirty) {
+        install_cache_line(first_level->cache, cache_op->address, true);
+    }
+
+    // The line replaced by the first level moves down
+    if (victim.is_valid) {
+        write_hierarchy_line(hierarchy, victim.address, victim.is_dirty, 1);
+    }
+
+    return cycle_count;
+}
+
+// --- Hierarchy Initialization and Cleanup ---
+
+Hierarchy* initialize_hierarchy(const InclusionPolicy inclusion, const int memory_latency,
+                                const int dirty_wb_penalty) {
+    Hierarchy *hierarchy = allocate_or_exit(1, sizeof(Hierarchy), "cache hierarchy");
+
+    hierarchy->inclusion = inclusion;
+    hierarchy->memory_latency = memory_latency;
+    hierarchy->dirty_wb_penalty = dirty_wb_penalty;
+
+    return hierarchy;
+}
+
+void add_hierarchy_level(Hierarchy *hierarchy, const char *name, Cache *cache, const int latency) {
+    HierarchyLevel *level;
+    if (strcmp(name, "L1I") == 0) {
+        level = &hierarchy->instruction_level;
+        hierarchy->has_instruction_level = true;
+    } else {
+        if (hierarchy->num_levels == HIERARCHY_MAX_LEVELS) {
+            fprintf(stderr, "A cache hierarchy can't have more than %d levels.\n", HIERARCHY_MAX_LEVELS);
+            exit(EXIT_FAILURE);
+        }
+        level = &hierarchy->levels[hierarchy->num_levels++];
+    }
+
+    *level = (HierarchyLevel){name, cache, latency, 0, 0};
+}
+
+void free_hierarchy(Hierarchy *hierarchy) {
+    for (int depth = 0; depth < hierarchy->num_levels; depth++) {
+        free_cache(hierarchy->levels[depth].cache);
+    }
+    if (hierarchy->has_instruction_level) {
+        free_cache(hierarchy->instruction_level.cache);
+    }
+    free(hierarchy);
+}
+
+// --- Access Hierarchy ---
+
+int access_hierarchy(Hierarchy *hierarchy, const CacheOp *cache_op) {
+    if (hierarchy->inclusion == INCLUSION_EXCLUSIVE) {
+        return access_exclusive_hierarchy(hierarchy, cache_op);
+    }
+
+    // Lower levels only fetch the line, the store itself is absorbed by the first level
+    const CacheOp fill_op = initialize_cache_operation('l', cache_op->address, 0);
+    int cycle_count = 0;
+
+    for (int depth = 0; depth < hierarchy->num_levels; depth++) {
+        HierarchyLevel *level = get_hierarchy_level(hierarchy, cache_op, depth);
+        cycle_count += level->latency;
+
+        if (access_cache(level->cache, depth == 0 ? cache_op : &fill_op)) {
+            return cycle_count;
+        }
+        pass_eviction(hierarchy, level, depth);
+    }
+
+    // Missed in every level, read the line from memory
+    hierarchy->memory_reads++;
+    return cycle_count + hierarchy->memory_latency;
+}
+
+// --- Inclusion Policies ---
+
+bool parse_inclusion_policy(const char *name, InclusionPolicy *inclusion) {
+    if (strcmp(name, "nine") == 0) {
+        *inclusion = INCLUSION_NINE;
+    } else if (strcmp(name, "inclusive") == 0) {
+        *inclusion = INCLUSION_INCLUSIVE;
+    } else if (strcmp(name, "exclusive") == 0) {
+        *inclusion = INCLUSION_EXCLUSIVE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* get_inclusion_policy_name(const InclusionPolicy inclusion) {
+    switch (inclusion) {
+        case INCLUSION_INCLUSIVE: return "inclusive";
+        case INCLUSION_EXCLUSIVE: return "exclusive";
+        default: return "nine";
+    }
+}
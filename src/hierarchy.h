@@ -0,0 +1,127 @@
+/***************************************************************************/
+/**
+ * @file hierarchy.h
+ * @brief Header file for the multi-level cache hierarchy of the cache
+ * simulator.
+ *
+ * A hierarchy stacks several caches: split first-level caches for instruction
+ * fetches (L1I, optional) and data accesses (L1D), followed by optional
+ * unified L2 and last-level (LLC) caches. Misses of a level become accesses to
+ * the next level, and dirty lines replaced by a level are written back to the
+ * next level. Misses and write-backs of the last level go to memory.
+ *
+ * All levels use the same line size. The inclusion policy decides how lines
+ * are shared between levels:
+ * - INCLUSION_NINE (non-inclusive, non-exclusive): every level is filled on a
+ *   miss, evictions don't affect other levels.
+ * - INCLUSION_INCLUSIVE: like NINE, but a line evicted from a lower level is
+ *   also invalidated in all higher levels (back-invalidation).
+ * - INCLUSION_EXCLUSIVE: a line lives in at most one level. Misses only fill
+ *   the first level, lines hit in a lower level move up, and lines replaced by
+ *   a level move down to the next one.
+ ******************************************************************************/
+
+#ifndef HIERARCHY_H_INCLUDED
+#define HIERARCHY_H_INCLUDED
+
+#include "cache.h"
+#include "trace.h"
+
+/**
+ * @brief Maximum number of unified levels (L1D, L2 and LLC).
+ */
+enum {
+    HIERARCHY_MAX_LEVELS = 3,
+};
+
+/**
+ * @brief Policy deciding which levels may hold the same line.
+ */
+typedef enum InclusionPolicy {
+    INCLUSION_NINE,         // Non-inclusive, non-exclusive
+    INCLUSION_INCLUSIVE,    // Lower levels contain all lines of higher levels
+    INCLUSION_EXCLUSIVE,    // Every line is cached in at most one level
+} InclusionPolicy;
+
+/**
+ * @brief A single level of the hierarchy and its statistics.
+ */
+typedef struct HierarchyLevel {
+    const char *name;       // Name printed in the statistics ("L1I", "L1D", "L2", "LLC")
+    Cache *cache;           // Cache of this level
+    int latency;            // Cycles spent for every access to this level
+    uint64_t write_backs_in;        // Number of lines written back to this level by higher levels
+    uint64_t back_invalidations;    // Number of lines invalidated in this level by lower levels
+} HierarchyLevel;
+
+/**
+ * @brief Main structure representing the cache hierarchy.
+ */
+typedef struct Hierarchy {
+    HierarchyLevel instruction_level;           // L1I, only used if `has_instruction_level` is set
+    bool has_instruction_level;                 // Indicates if fetches use a separate L1I
+    HierarchyLevel levels[HIERARCHY_MAX_LEVELS]; // L1D followed by the unified lower levels
+    int num_levels;                             // Number of entries in `levels`
+    InclusionPolicy inclusion;                  // Inclusion policy between all levels
+    int memory_latency;                         // Cycles spent for a read from memory
+    int dirty_wb_penalty;                       // Cycles spent for a write-back to memory
+    uint64_t memory_reads;                      // Number of lines read from memory
+    uint64_t memory_writes;                     // Number of lines written back to memory
+} Hierarchy;
+
+/**
+ * @brief Initializes an empty hierarchy.
+ * Levels are added with add_hierarchy_level, starting with L1D.
+ *
+ * @param inclusion Inclusion policy between all levels.
+ * @param memory_latency Cycles spent for a read from memory.
+ * @param dirty_wb_penalty Cycles spent for a write-back to memory.
+ * @return Pointer to the initialized Hierarchy object.
+ */
+Hierarchy* initialize_hierarchy(InclusionPolicy inclusion, int memory_latency, int dirty_wb_penalty);
+
+/**
+ * @brief Adds a unified level below the existing ones, or the L1I.
+ * The hierarchy takes ownership of the cache.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param name Name of the level, "L1I" adds the instruction cache.
+ * @param cache Pointer to the Cache object of the level.
+ * @param latency Cycles spent for every access to the level.
+ */
+void add_hierarchy_level(Hierarchy *hierarchy, const char *name, Cache *cache, int latency);
+
+/**
+ * @brief Frees the hierarchy and the caches of all levels.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ */
+void free_hierarchy(Hierarchy *hierarchy);
+
+/**
+ * @brief Simulates an access (LOAD, STORE or instruction fetch) in the hierarchy.
+ *
+ * @param hierarchy Pointer to the Hierarchy object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @return The number of cycles spent for the access, excluding write-backs to memory.
+ */
+int access_hierarchy(Hierarchy *hierarchy, const CacheOp *cache_op);
+
+/**
+ * @brief Parses the name of an inclusion policy.
+ *
+ * @param name "nine", "inclusive" or "exclusive".
+ * @param inclusion Pointer receiving the policy.
+ * @return `true` if the name is valid, `false` otherwise.
+ */
+bool parse_inclusion_policy(const char *name, InclusionPolicy *inclusion);
+
+/**
+ * @brief Returns the name of an inclusion policy.
+ *
+ * @param inclusion The inclusion policy.
+ * @return "nine", "inclusive" or "exclusive".
+ */
+const char* get_inclusion_policy_name(InclusionPolicy inclusion);
+
+#endif // HIERARCHY_H_INCLUDED
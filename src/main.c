@@ -3,11 +3,12 @@
  * @file main.c
  * @brief Entry point for the write-back cache simulator program.
  *
- * This program simulates a write-back cache with a write allocate policy,
- * processing memory access traces to calculate and report cache performance
- * statistics, such as hit rate and the number of dirty write-backs. It accepts
- * several command-line options to configure the cache parameters and requires a
- * trace file containing the memory accesses to be simulated.
+ * This program simulates a write-back cache with a write allocate policy (or
+ * one of the write-through and no-write-allocate variants), processing memory
+ * access traces to calculate and report cache performance statistics, such as
+ * hit rate and the number of dirty write-backs. It accepts several
+ * command-line options to configure the cache parameters and requires a trace
+ * file containing the memory accesses to be simulated.
  *
  * The main process flow includes:
  * - Parsing command-line arguments to set cache configuration or display usage
@@ -31,7 +32,132 @@
  * - `-d <dirty write-back penalty>`: Set the penalty in cycles for writing back
  *     dirty lines.
  *     Default is 2 cycles.
- * - `<trace file>`: Specify the memory trace file to be processed.
+ * - `-r <policy>`: Set the replacement policy: `lru`, `plru`, `srrip`, `brrip`,
+ *     `fifo` or `random`.
+ *     Default is `lru`.
+ * - `-w <policy>`: Set the write policy: `wb` (write-back, write-allocate),
+ *     `wb-nwa` (write-back, no-write-allocate), `wt` (write-through,
+ *     write-allocate) or `wt-nwa` (write-through, no-write-allocate). The
+ *     memory write traffic is printed for all but the default.
+ *     Default is `wb`.
+ * - `--write-combining <entries>`: Merge the stores written to memory in a
+ *     write-combining buffer of `entries` lines (at most 64). Requires a
+ *     write-through or no-write-allocate policy.
+ * - `--sectors <count>`: Split every line into `count` sectors (a power of two
+ *     up to 32 and the line size) with their own valid and dirty bits. A miss
+ *     fills only its sector and a write-back writes only the dirty sectors.
+ *     Not supported with `--classify`.
+ * - `-k <rate>`: Simulate only one in `rate` sets, selected by a hash of the set
+ *     index, and extrapolate the statistics with 95% confidence intervals.
+ *     Default is 1 (all sets).
+ * - `--warmup <records>`: Only warm the cache with the first records of the
+ *     trace, without counting them.
+ *     Default is 0.
+ * - `--intervals <fast-forward>:<detail>`: After the warmup, alternately warm
+ *     the cache with `fast-forward` records and measure `detail` records.
+ *     Default is to measure all records.
+ * - `--load-state <file>`: Continue from a cache state saved by `--save-state`
+ *     instead of an empty cache. The configuration, including the penalties,
+ *     the write policy and the write-combining buffer with its pending
+ *     writes, is taken from the file; the other cache options, `-w` and
+ *     `--write-combining` among them, are ignored.
+ * - `--save-state <file>`: Save the state of the cache after the trace.
+ * - `-j <threads>`: Simulate the sets in partitions on several threads, `0`
+ *     for one thread per online core. The statistics are the same as with a
+ *     single thread (except for the random number sequence of the random and
+ *     BRRIP policies). Caches with 32 or more ways always use one thread.
+ *     Default is 1.
+ * - `--timeline <file>`: Write the statistics of every interval of the
+ *     measured records to a CSV file. Not supported with `--mlp`.
+ * - `--timeline-interval <count>[i]`: Length of a timeline interval in
+ *     accesses, or in instructions with the suffix `i`. Default is 100000
+ *     accesses.
+ * - `--attribute <count>`: Charge every miss to the page of its address and
+ *     every dirty write-back to the page of the replaced line, and print the
+ *     `count` pages with the most misses.
+ * - `--attribute-page <bytes>`: Size of an attributed page, a power of two.
+ *     Default is 4096 bytes.
+ * - `--attribute-regions <file>`: Attribute to the regions of a file instead
+ *     of pages, one `<name> <start> <end>` line with hexadecimal addresses per
+ *     region.
+ * - `--prefetch <model>`: Prefetch into the cache with the `next-line`,
+ *     `stride` or `stream` model and count the useful, late and useless
+ *     prefetches. A cache with a prefetcher always uses one thread. Not
+ *     supported with `--classify` or `--mlp`.
+ * - `--prefetch-degree <lines>`: Number of lines fetched per prefetch trigger,
+ *     at most 64. Requires `--prefetch`.
+ *     Default is 1.
+ * - `--prefetch-distance <lines>`: Distance of the first fetched line from the
+ *     trigger, in strides for `stride`, at most 1024. Requires `--prefetch`.
+ *     Default is 1.
+ * - `--mlp <mshrs>`: Time the misses with a core that keeps running while up
+ *     to `mshrs` misses (at most 1024) are in flight, instead of adding every
+ *     miss penalty to the cycles. Only supported with the default write
+ *     policy and not with `-j`, `-k`, `--timeline` or `--prefetch`.
+ * - `--mlp-window <instructions>`: Number of instructions the core runs past
+ *     the oldest outstanding miss before it waits for its fill. Requires
+ *     `--mlp`.
+ *     Default is 128.
+ * - `--write-buffer <entries>`: Number of dirty write-backs buffered before the
+ *     core waits for them, at most 1024. Requires `--mlp`.
+ *     Default is 8.
+ * - `--classify`: Classify every miss as a compulsory, capacity or conflict
+ *     miss with a fully associative LRU shadow cache of the same capacity.
+ * - `--classify-filter <KB>`: Size of the Bloom filter remembering the lines
+ *     seen by the classification, a power of two. Default is 1024 KB.
+ * - `<trace file>`: Specify the memory trace file to be processed, `-` for
+ *     stdin. Text traces and binary traces are detected automatically, gzip,
+ *     zstd and xz compressed files are decompressed on the fly.
+ *
+ * Alternatively, `--convert <trace file> <binary file>` converts a text trace
+ * into the packed binary trace format, which is decoded much faster on
+ * subsequent runs.
+ *
+ * With `--sweep` as the first argument, several cache configurations are
+ * simulated over a single pass of the trace:
+ * - `-a`, `-s` and `-l` accept comma-separated lists of values whose cartesian
+ *   product forms a grid of configurations.
+ * - `-c <assoc>:<size>:<line>` adds a single configuration and can be repeated.
+ *   If only `-c` options are given, no grid is added.
+ * - `-p`, `-d`, `-r`, `-w`, `--write-combining`, `--sectors`, `-k`, `--warmup`
+ *   and `--intervals` apply to all configurations. Configurations whose lines
+ *   are smaller than the sectors are skipped.
+ * - `-j <threads>` simulates the configurations on several worker threads.
+ *   Default is one thread per online core.
+ * - `--classify` and `--classify-filter` classify the misses of every
+ *   configuration (not with `-k` or `--sectors`).
+ * The results are printed as one table with one row per configuration.
+ *
+ * With `--mrc` as the first argument, the stack distance engine computes the
+ * LRU miss-ratio curve of all associativities at the number of sets given by
+ * `-a`, `-s` and `-l` (a single set for `-a 0`) in one pass over the trace.
+ * The curve only exists for LRU and all sets, so `-r` must be `lru` and `-k`
+ * must be 1 if given; `--warmup`, `--intervals`, `--sectors` and the cache
+ * states aren't supported.
+ *
+ * With `--hierarchy` as the first argument, a multi-level hierarchy is
+ * simulated:
+ * - `-L1I`, `-L1D`, `-L2` and `-LLC` take `<assoc>:<size>:<line>[:<latency>]`
+ *   and add the level. L1D is always present and uses the default cache if not
+ *   given. Instruction fetches (`i` records) use the L1I if one is given.
+ * - `-i <policy>` selects the inclusion policy: `nine`, `inclusive` or
+ *   `exclusive`. Default is `nine`.
+ * - `-p` and `-d` set the latency of memory reads and write-backs.
+ * - `-r <policy>` selects the replacement policy of all levels.
+ * Per-level statistics are printed in addition to the CPI.
+ *
+ * With `--multicore` as the first argument, every trace given after the
+ * options runs on its own core:
+ * - `-L1 <assoc>:<size>:<line>[:<latency>]` configures the private cache of
+ *   every core. Default is the default cache.
+ * - `-LLC <assoc>:<size>:<line>[:<latency>]` configures the shared last-level
+ *   cache. Default is an 8-way, 256 KB cache with the default line size.
+ * - `-c <protocol>` keeps the private caches coherent: `mesi` or `moesi`.
+ *   Default is no coherence.
+ * - `-p`, `-d` and `-r` work like for a hierarchy.
+ * The misses of the private caches reach the shared cache in the order of the
+ * instruction counts of the cores. Per-core and shared statistics are printed,
+ * with a coherence protocol also the coherence traffic of every core.
  *
  * Usage example:
  * ```
@@ -42,11 +168,22 @@
  * penalty of 5 cycles, and process the accesses recorded in "traces/gcc.trace".
  ******************************************************************************/
 
+#include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "attribution.h"
+#include "prefetch.h"
+#include "timing.h"
 #include "cache.h"
+#include "classify.h"
+#include "hierarchy.h"
+#include "multicore.h"
+#include "sweep.h"
+#include "timeline.h"
+#include "trace.h"
 
 /**
  * Useful default values for cache shape and cache overhead in case the
@@ -74,28 +211,92 @@ enum {
 	 * The performance penalty of commiting a modified cache line to memory.
 	 */
 	DIRTY_WB_PENALTY = 2,
+	/**
+	 * The latency in cycles of a first-level cache of a hierarchy. Hits in the
+	 * first level are part of the base CPI, like in the single cache model.
+	 */
+	L1_LATENCY = 0,
+	/**
+	 * The latency in cycles of the L2 cache of a hierarchy.
+	 */
+	L2_LATENCY = 10,
+	/**
+	 * The latency in cycles of the last-level cache of a hierarchy.
+	 */
+	LLC_LATENCY = 20,
+	/**
+	 * The associativity of the shared last-level cache of a multi-core system.
+	 */
+	LLC_ASSOCIATIVITY = 8,
+	/**
+	 * The size in kilobytes of the shared last-level cache of a multi-core system.
+	 */
+	LLC_CACHE_SIZE = 256,
 };
 
-typedef struct TraceStats {
-    int memory_access_count;    // Number of memory accesses
-    int load_count;             // Number of load operations
-    int store_count;            // Number of store operations
-    int instruction_count;      // Number of instructions
-    int cycle_count;            // Number of cycles
-} TraceStats;
-
 // Function Prototypes
 static void printUsage(const char *prog);
 static bool is_pow2(int n);
 static bool validate_args(int associativity, int line_size, int cache_size, int miss_penalty, int dirty_wb_penalty);
-static Cache* set_cache_configuration(int argc, const char *argv[]);
-static void process_trace_line(char access_type, unsigned long address, int instructions, Cache *cache,
-                               TraceStats *trace_stats);
-static void simulate_cache(Cache *cache, const char *trace_file);
-static void print_cache_settings(int associativity, int cache_size, int line_size, int miss_penalty, int dirty_wb_penalty);
-static void print_access_stats(int memory_access_count, int load_count, int store_count);
-static void print_hit_miss_stats(float miss_rate, int cache_miss_count, int cache_hit_count);
-static void print_cpi_stats(int instruction_count, int cycle_count, int dirty_write_backs);
+static bool validate_sample_rate(int associativity, int line_size, int cache_size, int sample_rate);
+static void parse_replacement_argument(const char *prog, const char *arg, ReplacementPolicy *replacement);
+static bool is_write_option(const char *option);
+static void parse_write_argument(const char *prog, const char *option, const char *arg, WritePolicy *write_policy,
+                                 int *combining_entries);
+static void validate_write_arguments(const char *prog, WritePolicy write_policy, int combining_entries);
+static void parse_sectors_argument(const char *prog, const char *arg, int *sectors);
+static bool is_sampling_option(const char *option);
+static void parse_sampling_argument(const char *prog, const char *option, const char *arg, TraceSampling *sampling);
+static bool is_state_option(const char *option);
+static bool is_timeline_option(const char *option);
+static void parse_timeline_argument(const char *prog, const char *option, const char *arg, TimelineOptions *timeline);
+static bool is_attribution_option(const char *option);
+static void parse_attribution_argument(const char *prog, const char *option, const char *arg,
+                                       AttributionOptions *attribution);
+static bool is_prefetch_option(const char *option);
+static void parse_prefetch_argument(const char *prog, const char *option, const char *arg, PrefetchOptions *prefetch);
+static bool is_timing_option(const char *option);
+static void parse_timing_argument(const char *prog, const char *option, const char *arg, TimingOptions *timing);
+static void parse_classify_argument(const char *prog, const char *arg, ClassifyOptions *classify);
+static void parse_cache_arguments(int argc, const char *argv[], int first_arg, int *associativity, int *line_size,
+                                  int *cache_size, int *miss_penalty, int *dirty_wb_penalty,
+                                  ReplacementPolicy *replacement, WritePolicy *write_policy,
+                                  int *combining_entries, int *sectors, int *sample_rate, TraceSampling *sampling,
+                                  const char **load_state, const char **save_state, int *num_threads,
+                                  TimelineOptions *timeline, AttributionOptions *attribution,
+                                  PrefetchOptions *prefetch, TimingOptions *timing, ClassifyOptions *classify);
+static Cache* set_cache_configuration(int argc, const char *argv[], TraceSampling *sampling, const char **save_state,
+                                      int *num_threads, TimelineOptions *timeline, AttributionOptions *attribution,
+                                      TimingOptions *timing, ClassifyOptions *classify);
+static int parse_int_list(const char *prog, const char *option, const char *arg, int **values);
+static SweepPoint* set_sweep_configuration(int argc, const char *argv[], int *num_points, int *num_threads,
+                                           TraceSampling *sampling);
+static void run_sweep(int argc, const char *argv[]);
+static void run_stack_distance(int argc, const char *argv[]);
+static void parse_level_configuration(const char *prog, const char *option, const char *arg, int default_latency,
+                                      int config[4]);
+static Hierarchy* set_hierarchy_configuration(int argc, const char *argv[]);
+static void run_hierarchy(int argc, const char *argv[]);
+static Multicore* set_multicore_configuration(int argc, const char *argv[]);
+static void run_multicore(int argc, const char *argv[]);
+static void process_trace_line(const CacheOp *cache_op, Cache *cache, TraceStats *trace_stats, Timeline *timeline,
+                               Attribution *attribution, TimingModel *timing, MissClassifier *classifier);
+static void simulate_cache(Cache *cache, const char *trace_file, const TraceSampling *sampling, int num_threads,
+                           const TimelineOptions *timeline_options, const AttributionOptions *attribution_options,
+                           const TimingOptions *timing_options, const ClassifyOptions *classify_options);
+static void print_cache_settings(const Cache *cache, const TraceSampling *sampling);
+static void print_sampling_settings(const TraceSampling *sampling);
+static void print_access_stats(uint64_t memory_access_count, uint64_t load_count, uint64_t store_count,
+                               uint64_t fetch_count);
+static void print_hit_miss_stats(float miss_rate, uint64_t cache_miss_count, uint64_t cache_hit_count);
+static void print_sampled_stats(const CacheSampleEstimate *estimate, uint64_t memory_access_count);
+static void print_cpi_stats(uint64_t instruction_count, uint64_t cycle_count, uint64_t dirty_write_backs);
+static void print_write_stats(const Cache *cache);
+static void print_sector_stats(const Cache *cache);
+static void print_prefetch_stats(const Cache *cache);
+static void print_timing_stats(const TimingModel *timing);
+static void print_classifier_stats(const MissClassifier *classifier, uint64_t cache_miss_count);
+static void print_hierarchy_stats(const Hierarchy *hierarchy);
 
 /**
  * Prints a short usage dialog to the console.
@@ -104,14 +305,65 @@ static void print_cpi_stats(int instruction_count, int cycle_count, int dirty_wr
  */
 static void printUsage(const char *prog) {
 	printf(
-		"Usage: %s [-a <assoc>] [-l <line>] [-s <size>] [-p <miss>] [-d <dirty>] <trace>\n"
+		"Usage: %s [-a <assoc>] [-l <line>] [-s <size>] [-p <miss>] [-d <dirty>] [-r <policy>] [-w <policy>]\n"
+		"       [--write-combining <entries>] [--sectors <count>] [-k <rate>]\n"
+		"       [--warmup <records>] [--intervals <fast-forward>:<detail>] [--load-state <file>] [--save-state <file>]\n"
+		"       [-j <threads>] [--timeline <file>] [--timeline-interval <count>[i]]\n"
+		"       [--attribute <count>] [--attribute-page <bytes>] [--attribute-regions <file>]\n"
+		"       [--prefetch <model>] [--prefetch-degree <lines>] [--prefetch-distance <lines>]\n"
+		"       [--mlp <mshrs>] [--mlp-window <instructions>] [--write-buffer <entries>]\n"
+		"       [--classify] [--classify-filter <KB>] <trace>\n"
 		"  -a <assoc>: 0 for fully associative, 1 for direct mapped, n for n-way set associative (default: %u)\n"
 		"  -l <line> : blocksize in bytes of the cache (default: %u)\n"
 		"  -s <size> : size in KB of the cache (default: %u)\n"
 		"  -p <miss> : miss penalty in cycles of a cache miss (default: %u)\n"
 		"  -d <dirty>: penalty for writing back dirty lines (default :%u)\n"
-		"  <trace>   : memory trace file\n",
-		prog, ASSOCIATIVITY, CACHE_LINE, CACHE_SIZE, MISS_PENALTY, DIRTY_WB_PENALTY
+		"  -r <policy>: replacement policy lru, plru, srrip, brrip, fifo or random (default: lru)\n"
+		"  -w <policy>: write policy wb, wb-nwa, wt or wt-nwa (write-back/-through, -nwa: no write-allocate) (default: wb)\n"
+		"  --write-combining <entries>: merge the stores written to memory in <entries> lines (at most %d)\n"
+		"  --sectors <count>: split every line into <count> sectors with their own valid and dirty bits (at most %d)\n"
+		"  -k <rate> : simulate one in <rate> sets and extrapolate the statistics (default: 1)\n"
+		"  --warmup <records>: warm the cache with the first <records> records without measuring them\n"
+		"  --intervals <fast-forward>:<detail>: then alternately warm <fast-forward> and measure <detail> records\n"
+		"  --load-state <file>: continue from a saved cache state (with its configuration) instead of an empty cache\n"
+		"  --save-state <file>: save the cache state after the trace\n"
+		"  -j <threads>: simulate partitions of the sets on <threads> threads, 0 for one per core (default: 1)\n"
+		"  --timeline <file>: write hits, misses, write-backs, CPI and working set of every interval as CSV\n"
+		"  --timeline-interval <count>[i]: accesses (or instructions with i) per interval (default: %d)\n"
+		"  --attribute <count>: print the <count> pages or regions with the most misses and dirty write-backs\n"
+		"  --attribute-page <bytes>: size of an attributed page, a power of two (default: %d)\n"
+		"  --attribute-regions <file>: attribute to the '<name> <start> <end>' regions (hex) of <file> instead of pages\n"
+		"  --prefetch <model>: prefetch into the cache with the next-line, stride or stream model\n"
+		"  --prefetch-degree <lines>: lines fetched per prefetch trigger (default: %d)\n"
+		"  --prefetch-distance <lines>: distance of the first fetched line, in strides for stride (default: %d)\n"
+		"  --mlp <mshrs>: overlap misses in <mshrs> MSHRs instead of adding every miss penalty to the cycles\n"
+		"  --mlp-window <instructions>: instructions executed past the oldest outstanding miss (default: %d)\n"
+		"  --write-buffer <entries>: write-backs buffered before the core waits for them (default: %d)\n"
+		"  --classify: classify the misses as compulsory, capacity or conflict misses (3C)\n"
+		"  --classify-filter <KB>: size of the Bloom filter of the lines seen by --classify (default: %d)\n"
+		"  <trace>   : memory trace file (text or binary, optionally gzip/zstd/xz compressed), - for stdin\n"
+		"       %s --sweep [-a <list>] [-l <list>] [-s <list>] [-c <assoc>:<size>:<line>]... [-p <miss>] [-d <dirty>] [-r <policy>] [-w <policy>]\n"
+		"       [--write-combining <entries>] [--sectors <count>] [-k <rate>] [--warmup <records>] [--intervals <fast-forward>:<detail>] [-j <threads>] [--classify] [--classify-filter <KB>] <trace>\n"
+		"  simulates the grid of comma-separated -a/-l/-s values and every -c configuration in one pass\n"
+		"  on <threads> worker threads (default: one per online core)\n"
+		"       %s --mrc [-a <assoc>] [-l <line>] [-s <size>] <trace>\n"
+		"  prints the LRU miss-ratio curve of every associativity at the set count of the given cache\n"
+		"       %s --hierarchy [-L1I|-L1D|-L2|-LLC <assoc>:<size>:<line>[:<latency>]]... [-i <policy>] [-r <policy>] [-p <miss>] [-d <dirty>] <trace>\n"
+		"  simulates a cache hierarchy (default latencies: L1 %u, L2 %u, LLC %u cycles) with the inclusion\n"
+		"  policy nine, inclusive or exclusive (default: nine); -p and -d apply to memory\n"
+		"       %s --multicore [-L1|-LLC <assoc>:<size>:<line>[:<latency>]]... [-c <protocol>] [-r <policy>] [-p <miss>] [-d <dirty>] <trace>...\n"
+		"  simulates one core with a private L1 per trace and a shared LLC (default: %u:%u:%u), interleaving\n"
+		"  the LLC requests of the cores by their instruction counts; -c keeps the L1s coherent with mesi or moesi\n"
+		"       %s --convert <trace> <binary>\n"
+		"  converts a trace into the binary trace format\n",
+		prog, ASSOCIATIVITY, CACHE_LINE, CACHE_SIZE, MISS_PENALTY, DIRTY_WB_PENALTY, CACHE_MAX_COMBINING_ENTRIES,
+		CACHE_MAX_SECTORS,
+		TIMELINE_DEFAULT_INTERVAL,
+		ATTRIBUTION_DEFAULT_PAGE_SIZE, PREFETCH_DEFAULT_DEGREE, PREFETCH_DEFAULT_DISTANCE, TIMING_DEFAULT_WINDOW,
+		TIMING_DEFAULT_WRITE_BUFFER, CLASSIFY_DEFAULT_FILTER_SIZE,
+		prog, prog, prog,
+		L1_LATENCY, L2_LATENCY, LLC_LATENCY,
+		prog, LLC_ASSOCIATIVITY, LLC_CACHE_SIZE, CACHE_LINE, prog
 	);
 }
 
@@ -169,230 +421,1875 @@ static bool validate_args(const int associativity, const int line_size, const in
     	fprintf(stderr, "Associativity can't exceed the cache limits.\n");
 	    return false;
     }
+    // The line words store the flags below the tag, in the bits of the offset and the set index
+    const int way_size = associativity == 0 ? line_size : cache_size * 1024 / associativity;
+    if (way_size < (1 << CACHE_LINE_TAG_SHIFT)) {
+    	fprintf(stderr, "Line size times number of sets must be at least %d bytes.\n", 1 << CACHE_LINE_TAG_SHIFT);
+        return false;
+    }
 
     return true;
 }
 
 /**
- * @brief Sets the cache configuration given input arguments.
+ * @brief Validates the set sampling rate of a cache configuration.
+ * The configuration itself must already be valid.
  *
- * @param argc Number of command-line arguments.
- * @param argv Command-line arguments.
- * @return Initialized Cache object with the given constrains.
+ * @param associativity Cache associativity.
+ * @param line_size Cache line/block size in bytes.
+ * @param cache_size  Total cache size in KB.
+ * @param sample_rate One in this many sets is simulated.
+ * @return `true` if the validation succeeded, `false` otherwise.
  */
-static Cache *set_cache_configuration(const int argc, const char *argv[]) {
-	// Set default cache parameters
-	int associativity = ASSOCIATIVITY;
-	int line_size = CACHE_LINE;
-	int cache_size = CACHE_SIZE;
-	int miss_penalty = MISS_PENALTY;
-	int dirty_wb_penalty = DIRTY_WB_PENALTY;
-
-	// Parse command line arguments
-	for (int i = 1; i < argc - 1; i++) {
-        char *endptr;
-
-		if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
-            associativity = strtol(argv[++i], &endptr, 10);
-		} else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
-			line_size = strtol(argv[++i], &endptr, 10);
-		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
-			cache_size = strtol(argv[++i], &endptr, 10);
-		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
-			miss_penalty = strtol(argv[++i], &endptr, 10);
-		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
-			dirty_wb_penalty = strtol(argv[++i], &endptr, 10);
-		} else {
-			fprintf(stderr, "Invalid option or missing argument: %s.\n", argv[i]);
-			printUsage(argv[0]);
-			exit(EXIT_FAILURE);
-		}
+static bool validate_sample_rate(const int associativity, const int line_size, const int cache_size,
+                                 const int sample_rate) {
+	if (!is_pow2(sample_rate)) {
+		fprintf(stderr, "Sample rate must be a power of two.\n");
+		return false;
+	}
 
-        if (*endptr != '\0') {
-            fprintf(stderr, "Invalid numeric value for %s: %s\n", argv[i - 1], argv[i]);
-            printUsage(argv[0]);
-            exit(EXIT_FAILURE);
-        }
+	// At least two sets must remain, otherwise there is no confidence interval
+	const int num_sets = associativity == 0 ? 1 : cache_size * 1024 / line_size / associativity;
+	if (sample_rate > 1 && num_sets / sample_rate < 2) {
+		fprintf(stderr, "Sample rate must leave at least two of the %d sets.\n", num_sets);
+		return false;
 	}
 
-	// Validate the input parameters
-	if (!validate_args(associativity, line_size, cache_size, miss_penalty, dirty_wb_penalty)) {
-		printUsage(argv[0]);
+	return true;
+}
+
+/**
+ * @brief Parses the replacement policy given to `-r`.
+ * Terminates the program with a usage message if the policy is unknown.
+ *
+ * @param prog The name of the executable.
+ * @param arg The name of the policy.
+ * @param replacement Pointer receiving the replacement policy.
+ */
+static void parse_replacement_argument(const char *prog, const char *arg, ReplacementPolicy *replacement) {
+	if (!parse_replacement_policy(arg, replacement)) {
+		fprintf(stderr, "Invalid replacement policy: %s\n", arg);
+		printUsage(prog);
 		exit(EXIT_FAILURE);
 	}
+}
 
-	// Initialize cache with the provided configuration
-	Cache *cache =  initialize_cache(associativity, cache_size, line_size, miss_penalty, dirty_wb_penalty);
+/**
+ * @brief Checks if an option of the command line configures the handling of stores.
+ *
+ * @param option The option.
+ * @return `true` for `-w` and `--write-combining`, `false` otherwise.
+ */
+static bool is_write_option(const char *option) {
+	return strcmp(option, "-w") == 0 || strcmp(option, "--write-combining") == 0;
+}
 
-    // Print cache configuration
-	print_cache_settings(cache->associativity, cache->cache_size, cache->line_size, cache->miss_penalty,
-	                     cache->dirty_wb_penalty);
+/**
+ * @brief Parses the value of `-w` or `--write-combining`.
+ * Terminates the program with a usage message if the value is invalid.
+ *
+ * @param prog The name of the executable.
+ * @param option The option, either `-w` or `--write-combining`.
+ * @param arg The name of the write policy or the number of write-combining entries.
+ * @param write_policy Pointer receiving the write policy.
+ * @param combining_entries Pointer receiving the number of write-combining entries.
+ */
+static void parse_write_argument(const char *prog, const char *option, const char *arg, WritePolicy *write_policy,
+                                 int *combining_entries) {
+	if (strcmp(option, "-w") == 0) {
+		if (!parse_write_policy(arg, write_policy)) {
+			fprintf(stderr, "Invalid write policy: %s\n", arg);
+			printUsage(prog);
+			exit(EXIT_FAILURE);
+		}
+		return;
+	}
 
-    return cache;
+	char *endptr;
+	const long value = strtol(arg, &endptr, 10);
+	if (endptr == arg || *endptr != '\0' || value <= 0 || value > CACHE_MAX_COMBINING_ENTRIES) {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+	*combining_entries = (int)value;
 }
 
 /**
- * @brief Processes a single trace line from the trace file.
+ * @brief Validates the combination of the write policy and the write-combining buffer.
+ * Terminates the program with a usage message if they don't fit.
  *
- * @param access_type Type of memory access (`l` for LOAD or `s` for STORE).
- * @param address Memory address to access.
- * @param instructions Number of instructions in this trace line.
- * @param cache Pointer to the Cache object.
- * @param trace_stats Structure for saving trace statistics.
+ * @param prog The name of the executable.
+ * @param write_policy The write policy.
+ * @param combining_entries The number of write-combining entries, `0` without a buffer.
  */
-static void process_trace_line(const char access_type, const unsigned long address, const int instructions,
-                               Cache *cache, TraceStats *trace_stats) {
-	const CacheOp cache_op = initialize_cache_operation(access_type, address, instructions);
-
-    // Handling cache accesses
-	if (access_type == 'l') {
-		trace_stats->load_count++;
-	} else if (access_type == 's') {
-		trace_stats->store_count++;
-	} else {
-		fprintf(stderr, "Unrecognized trace operation: '%c'. Skipping line.\n", access_type);
+static void validate_write_arguments(const char *prog, const WritePolicy write_policy, const int combining_entries) {
+	// Only write-through stores and store misses of no-write-allocate caches reach memory without a line
+	if (combining_entries > 0 && write_policy == WRITE_BACK_ALLOCATE) {
+		fprintf(stderr, "--write-combining requires a write-through or no-write-allocate policy (-w).\n");
+		printUsage(prog);
+		exit(EXIT_FAILURE);
 	}
+}
 
-	// Simulate cache access
-	if (!access_cache(cache, &cache_op)) {
-		// If cache miss, add miss penalty to cycle count
-		trace_stats->cycle_count += cache->miss_penalty;
+/**
+ * @brief Parses the value of `--sectors`.
+ * Terminates the program with a usage message if the value is invalid.
+ *
+ * @param prog The name of the executable.
+ * @param arg The number of sectors per line.
+ * @param sectors Pointer receiving the number of sectors.
+ */
+static void parse_sectors_argument(const char *prog, const char *arg, int *sectors) {
+	char *endptr;
+	const long value = strtol(arg, &endptr, 10);
+	if (endptr == arg || *endptr != '\0' || value <= 0 || value > CACHE_MAX_SECTORS || !is_pow2((int)value)) {
+		fprintf(stderr, "Invalid value for --sectors: %s\n", arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
 	}
+	*sectors = (int)value;
+}
 
-    // Update statistics
-	trace_stats->instruction_count += instructions;
-	trace_stats->cycle_count += instructions;
-    trace_stats->memory_access_count++;
+/**
+ * @brief Checks if an option of the command line belongs to the trace sampling.
+ *
+ * @param option The option.
+ * @return `true` for `--warmup` and `--intervals`, `false` otherwise.
+ */
+static bool is_sampling_option(const char *option) {
+	return strcmp(option, "--warmup") == 0 || strcmp(option, "--intervals") == 0;
 }
 
 /**
- * @brief Simulates the cache based on the given trace file.
+ * @brief Parses the value of `--warmup` or `--intervals`.
+ * Terminates the program with a usage message if the value is invalid.
  *
- * @param cache Pointer to the Cache object being simulated.
- * @param trace_file The path to the trace file to be processed.
+ * @param prog The name of the executable.
+ * @param option The option, either `--warmup` or `--intervals`.
+ * @param arg The number of warmup records or `<fast-forward>:<detail>`.
+ * @param sampling Pointer to the TraceSampling object receiving the value.
  */
-static void simulate_cache(Cache *cache, const char *trace_file) {
-	FILE *file = fopen(trace_file, "r");
-	if (file == NULL) {
-		perror("Failed to open trace file");
+static void parse_sampling_argument(const char *prog, const char *option, const char *arg, TraceSampling *sampling) {
+	char *endptr;
+	bool is_valid;
+	if (strcmp(option, "--warmup") == 0) {
+		sampling->warmup_records = strtol(arg, &endptr, 10);
+		is_valid = endptr != arg && *endptr == '\0' && sampling->warmup_records >= 0;
+	} else {
+		sampling->fast_forward_records = strtol(arg, &endptr, 10);
+		is_valid = endptr != arg && *endptr == ':' && sampling->fast_forward_records >= 0;
+		if (is_valid) {
+			const char *start = endptr + 1;
+			sampling->detail_records = strtol(start, &endptr, 10);
+			is_valid = endptr != start && *endptr == '\0' && sampling->detail_records > 0;
+		}
+	}
+
+	if (!is_valid) {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+		printUsage(prog);
 		exit(EXIT_FAILURE);
 	}
+}
 
-	// Initialize cache operation variables
-	char access_type;
-	unsigned long address;
-	int instructions;
+/**
+ * @brief Checks if an option of the command line names a cache state file.
+ *
+ * @param option The option.
+ * @return `true` for `--load-state` and `--save-state`, `false` otherwise.
+ */
+static bool is_state_option(const char *option) {
+	return strcmp(option, "--load-state") == 0 || strcmp(option, "--save-state") == 0;
+}
 
-	// Initialize trace file statistic variables
-    TraceStats trace_stats = {0, 0, 0, 0, 0};
+/**
+ * @brief Checks if an option of the command line configures the timeline.
+ *
+ * @param option The option.
+ * @return `true` for `--timeline` and `--timeline-interval`, `false` otherwise.
+ */
+static bool is_timeline_option(const char *option) {
+	return strcmp(option, "--timeline") == 0 || strcmp(option, "--timeline-interval") == 0;
+}
 
-	// Read the trace line by line
-	while (fscanf(file, "%c %lx %d\n", &access_type, &address, &instructions) != EOF) {
-		process_trace_line(access_type, address, instructions, cache, &trace_stats);
+/**
+ * @brief Parses the value of `--timeline` or `--timeline-interval`.
+ * Terminates the program with a usage message if the value is invalid.
+ *
+ * @param prog The name of the executable.
+ * @param option The option, either `--timeline` or `--timeline-interval`.
+ * @param arg The path of the timeline or the interval length with an optional `i` suffix.
+ * @param timeline Pointer to the TimelineOptions object receiving the value.
+ */
+static void parse_timeline_argument(const char *prog, const char *option, const char *arg, TimelineOptions *timeline) {
+	if (strcmp(option, "--timeline") == 0) {
+		timeline->path = arg;
+		return;
 	}
 
-	fclose(file);
-
-	// Fetch final statistics from the cache
-	const int dirty_wb_count = get_dirty_write_backs(cache);
-	const int cache_hit_count = get_cache_hits(cache);
-	const int cache_miss_count = get_cache_misses(cache);
+	char *endptr;
+	const long long length = strtoll(arg, &endptr, 10);
+	timeline->counts_instructions = *endptr == 'i';
+	if (endptr == arg || length <= 0 || *(timeline->counts_instructions ? endptr + 1 : endptr) != '\0') {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+	timeline->interval_length = (uint64_t)length;
+}
 
-	// Adjust cycle count for dirty write-backs
-	trace_stats.cycle_count += dirty_wb_count * cache->dirty_wb_penalty;
+/**
+ * @brief Checks if an option of the command line configures the miss attribution.
+ *
+ * @param option The option.
+ * @return `true` for `--attribute`, `--attribute-page` and `--attribute-regions`, `false` otherwise.
+ */
+static bool is_attribution_option(const char *option) {
+	return strcmp(option, "--attribute") == 0 || strcmp(option, "--attribute-page") == 0
+	       || strcmp(option, "--attribute-regions") == 0;
+}
 
-	// Calculate miss rate
-	const float miss_rate = (float) cache_miss_count / trace_stats.memory_access_count;
+/**
+ * @brief Parses the value of `--attribute`, `--attribute-page` or `--attribute-regions`.
+ * Terminates the program with a usage message if the value is invalid.
+ *
+ * @param prog The name of the executable.
+ * @param option The option.
+ * @param arg The number of reported regions, the page size or the path of the region file.
+ * @param attribution Pointer to the AttributionOptions object receiving the value.
+ */
+static void parse_attribution_argument(const char *prog, const char *option, const char *arg,
+                                       AttributionOptions *attribution) {
+	if (strcmp(option, "--attribute-regions") == 0) {
+		attribution->regions_path = arg;
+		return;
+	}
 
-	// Print cache statistics
-	print_access_stats(trace_stats.memory_access_count, trace_stats.load_count, trace_stats.store_count);
-	print_hit_miss_stats(miss_rate, cache_miss_count, cache_hit_count);
-	print_cpi_stats(trace_stats.instruction_count, trace_stats.cycle_count, dirty_wb_count);
+	char *endptr;
+	const long value = strtol(arg, &endptr, 10);
+	const bool is_page_size = strcmp(option, "--attribute-page") == 0;
+	if (endptr == arg || *endptr != '\0' || value <= 0 || value > INT_MAX
+	    || (is_page_size && !is_pow2((int)value))) {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+	*(is_page_size ? &attribution->page_size : &attribution->top_count) = (int)value;
 }
 
+/**
+ * @brief Checks if an option of the command line configures the prefetcher.
+ *
+ * @param option The option.
+ * @return `true` for `--prefetch`, `--prefetch-degree` and `--prefetch-distance`, `false` otherwise.
+ */
+static bool is_prefetch_option(const char *option) {
+	return strcmp(option, "--prefetch") == 0 || strcmp(option, "--prefetch-degree") == 0
+	       || strcmp(option, "--prefetch-distance") == 0;
+}
 
 /**
- * @brief Prints the cache settings.
+ * @brief Parses the value of `--prefetch`, `--prefetch-degree` or `--prefetch-distance`.
+ * Terminates the program with a usage message if the value is invalid.
  *
- * @param associativity Cache associativity.
- * @param cache_size Cache size in kilobyte.
- * @param line_size Cache line size in bytes.
- * @param miss_penalty Miss penalty in cycles.
- * @param dirty_wb_penalty Dirty write-back penalty in cycles.
+ * @param prog The name of the executable.
+ * @param option The option.
+ * @param arg The name of the prefetcher model, the degree or the distance.
+ * @param prefetch Pointer to the PrefetchOptions object receiving the value.
  */
-static void print_cache_settings(const int associativity, const int cache_size, const int line_size, const int miss_penalty,
-                          const int dirty_wb_penalty) {
-	printf("CACHE SETTINGS\n");
-	printf("     %s%8d\n", "Associativity:", associativity);
-	printf("        %s%8d kilobyte\n", "Cache Size:", cache_size);
-	printf("        %s%8d byte\n", "Block Size:", line_size);
-	printf("      %s%8d cycles\n", "Miss Penalty:", miss_penalty);
-	printf("  %s%8d cycles\n\n", "Dirty WB Penalty:", dirty_wb_penalty);
+static void parse_prefetch_argument(const char *prog, const char *option, const char *arg,
+                                    PrefetchOptions *prefetch) {
+	if (strcmp(option, "--prefetch") == 0) {
+		if (!parse_prefetch_policy(arg, &prefetch->policy)) {
+			fprintf(stderr, "Unknown prefetcher: %s\n", arg);
+			printUsage(prog);
+			exit(EXIT_FAILURE);
+		}
+		return;
+	}
+
+	char *endptr;
+	const long value = strtol(arg, &endptr, 10);
+	const bool is_degree = strcmp(option, "--prefetch-degree") == 0;
+	if (endptr == arg || *endptr != '\0' || value <= 0
+	    || value > (is_degree ? PREFETCH_MAX_DEGREE : PREFETCH_MAX_DISTANCE)) {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+	*(is_degree ? &prefetch->degree : &prefetch->distance) = (int)value;
 }
 
 /**
- * @brief Prints the access statistics.
+ * @brief Checks if an option of the command line configures the timing model.
  *
- * @param memory_access_count Total number of memory accesses.
- * @param load_count Total number of load operations.
- * @param store_count Total number of store operations.
+ * @param option The option.
+ * @return `true` for `--mlp`, `--mlp-window` and `--write-buffer`, `false` otherwise.
  */
-static void print_access_stats(const int memory_access_count, const int load_count, const int store_count) {
-	printf("CACHE ACCESS STATS\n");
-	printf("   %s%12d\n", "Memory Accesses:", memory_access_count);
-	printf("             %s%12d\n", "Loads:", load_count);
-	printf("            %s%12d\n\n", "Stores:", store_count);
+static bool is_timing_option(const char *option) {
+	return strcmp(option, "--mlp") == 0 || strcmp(option, "--mlp-window") == 0
+	       || strcmp(option, "--write-buffer") == 0;
 }
 
 /**
- * @brief Prints the hit/miss statistics.
+ * @brief Parses the value of `--mlp`, `--mlp-window` or `--write-buffer`.
+ * Terminates the program with a usage message if the value is invalid.
  *
- * @param miss_rate Cache miss rate.
- * @param cache_miss_count Total number of cache misses.
- * @param cache_hit_count Total number of cache hits.
+ * @param prog The name of the executable.
+ * @param option The option.
+ * @param arg The number of MSHRs, the window in instructions or the number of write buffer entries.
+ * @param timing Pointer to the TimingOptions object receiving the value.
  */
-static void print_hit_miss_stats(const float miss_rate, const int cache_miss_count, const int cache_hit_count) {
-	printf("CACHE HIT-MISS STATS\n");
-	printf("         %s%12.5f%%\n", "Miss Rate:", miss_rate * 100); // Convert to percentage
-	printf("      %s%12d\n", "Cache Misses:", cache_miss_count);
-	printf("        %s%12d\n\n", "Cache Hits:", cache_hit_count);
+static void parse_timing_argument(const char *prog, const char *option, const char *arg, TimingOptions *timing) {
+	char *endptr;
+	const long value = strtol(arg, &endptr, 10);
+	const bool is_window = strcmp(option, "--mlp-window") == 0;
+	if (endptr == arg || *endptr != '\0' || value <= 0 || value > (is_window ? INT_MAX : TIMING_MAX_ENTRIES)) {
+		fprintf(stderr, "Invalid value for %s: %s\n", option, arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+
+	if (is_window) {
+		timing->window = (int)value;
+	} else {
+		*(strcmp(option, "--mlp") == 0 ? &timing->num_mshrs : &timing->write_buffer_size) = (int)value;
+	}
 }
 
 /**
- * @brief Prints the CPI (Cycles Per Instruction) statistics.
+ * @brief Parses the value of `--classify-filter`.
+ * Terminates the program with a usage message if the value is invalid.
  *
- * @param instruction_count Total number of instructions.
- * @param cycle_count Total number of cycles.
- * @param dirty_write_backs Total number of dirty write-backs.
+ * @param prog The name of the executable.
+ * @param arg The size of the Bloom filter in KB.
+ * @param classify Pointer to the ClassifyOptions object receiving the value.
  */
-static void print_cpi_stats(const int instruction_count, const int cycle_count, const int dirty_write_backs) {
-	printf("CACHE CPI STATS\n");
-	printf("Cycles/Instruction: %11.5f\n", (float) cycle_count / instruction_count); // Show CPI with 5 decimal places
-	printf("      %s%12d\n", "Instructions:", instruction_count);
-	printf("            %s%12d\n", "Cycles:", cycle_count);
-	printf(" %s%12d\n", "Dirty Write-Backs:", dirty_write_backs);
+static void parse_classify_argument(const char *prog, const char *arg, ClassifyOptions *classify) {
+	char *endptr;
+	const long value = strtol(arg, &endptr, 10);
+	if (endptr == arg || *endptr != '\0' || value <= 0 || value > CLASSIFY_MAX_FILTER_SIZE || !is_pow2((int)value)) {
+		fprintf(stderr, "Invalid value for --classify-filter: %s\n", arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+	classify->filter_size = (int)value;
 }
 
 /**
- * @brief Entry point for the cache simulation program.
+ * @brief Parses the cache configuration options of the command line.
+ * Terminates the program with a usage message if an option is invalid.
  *
  * @param argc Number of command-line arguments.
  * @param argv Command-line arguments.
- * @return Exit status of the program.
+ * @param first_arg Index of the first option to parse.
+ * @param associativity Pointer receiving the cache associativity.
+ * @param line_size Pointer receiving the cache line size in bytes.
+ * @param cache_size Pointer receiving the cache size in KB.
+ * @param miss_penalty Pointer receiving the miss penalty in cycles.
+ * @param dirty_wb_penalty Pointer receiving the dirty write-back penalty in cycles.
+ * @param replacement Pointer receiving the replacement policy.
+ * @param write_policy Pointer receiving the write policy.
+ * @param combining_entries Pointer receiving the number of write-combining entries, `0` without a buffer.
+ * @param sectors Pointer receiving the number of sectors per line, `1` for lines without sectors.
+ * @param sample_rate Pointer receiving the set sampling rate.
+ * @param sampling Pointer receiving the selection of the measured records.
+ * @param load_state Pointer receiving the path of the cache state to continue from, `NULL` if none.
+ * @param save_state Pointer receiving the path the cache state is saved to, `NULL` if none.
+ * @param num_threads Pointer receiving the number of threads simulating partitions of the sets, `0` for one per core.
+ * @param timeline Pointer receiving the timeline options, with a `NULL` path if there is no timeline.
+ * @param attribution Pointer receiving the attribution options, with a zero count if there is no attribution.
+ * @param prefetch Pointer receiving the prefetcher options, with PREFETCH_NONE if there is no prefetcher.
+ * @param timing Pointer receiving the timing model options, with zero MSHRs if misses are serialized.
+ * @param classify Pointer receiving the miss classification options.
  */
-int main(const int argc, const char *argv[]) {
-	if (argc < 2) {
+static void parse_cache_arguments(const int argc, const char *argv[], const int first_arg, int *associativity,
+                                  int *line_size, int *cache_size, int *miss_penalty, int *dirty_wb_penalty,
+                                  ReplacementPolicy *replacement, WritePolicy *write_policy,
+                                  int *combining_entries, int *sectors, int *sample_rate, TraceSampling *sampling,
+                                  const char **load_state, const char **save_state, int *num_threads,
+                                  TimelineOptions *timeline, AttributionOptions *attribution,
+                                  PrefetchOptions *prefetch, TimingOptions *timing, ClassifyOptions *classify) {
+	// Set default cache parameters
+	*associativity = ASSOCIATIVITY;
+	*line_size = CACHE_LINE;
+	*cache_size = CACHE_SIZE;
+	*miss_penalty = MISS_PENALTY;
+	*dirty_wb_penalty = DIRTY_WB_PENALTY;
+	*replacement = REPLACEMENT_LRU;
+	*write_policy = WRITE_BACK_ALLOCATE;
+	*combining_entries = 0;
+	*sectors = 1;
+	*sample_rate = 1;
+	*sampling = (TraceSampling){0, 0, 0};
+	*load_state = NULL;
+	*save_state = NULL;
+	*num_threads = 1;
+	*timeline = (TimelineOptions){NULL, TIMELINE_DEFAULT_INTERVAL, false};
+	*attribution = (AttributionOptions){0, ATTRIBUTION_DEFAULT_PAGE_SIZE, NULL};
+	*prefetch = (PrefetchOptions){PREFETCH_NONE, PREFETCH_DEFAULT_DEGREE, PREFETCH_DEFAULT_DISTANCE};
+	*timing = (TimingOptions){0, TIMING_DEFAULT_WINDOW, TIMING_DEFAULT_WRITE_BUFFER};
+	*classify = (ClassifyOptions){false, CLASSIFY_DEFAULT_FILTER_SIZE};
+
+	// Parse command line arguments
+	for (int i = first_arg; i < argc - 1; i++) {
+        char *endptr = "";
+
+		if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            *associativity = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+			*line_size = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			*cache_size = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			*miss_penalty = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			*dirty_wb_penalty = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			parse_replacement_argument(argv[0], argv[++i], replacement);
+		} else if (is_write_option(argv[i]) && i + 1 < argc) {
+			parse_write_argument(argv[0], argv[i], argv[i + 1], write_policy, combining_entries);
+			i++;
+		} else if (strcmp(argv[i], "--sectors") == 0 && i + 1 < argc) {
+			parse_sectors_argument(argv[0], argv[++i], sectors);
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			*sample_rate = strtol(argv[++i], &endptr, 10);
+		} else if (is_sampling_option(argv[i]) && i + 1 < argc) {
+			parse_sampling_argument(argv[0], argv[i], argv[i + 1], sampling);
+			i++;
+		} else if (is_state_option(argv[i]) && i + 1 < argc) {
+			*(strcmp(argv[i], "--load-state") == 0 ? load_state : save_state) = argv[i + 1];
+			i++;
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			*num_threads = strtol(argv[++i], &endptr, 10);
+		} else if (is_timeline_option(argv[i]) && i + 1 < argc) {
+			parse_timeline_argument(argv[0], argv[i], argv[i + 1], timeline);
+			i++;
+		} else if (is_attribution_option(argv[i]) && i + 1 < argc) {
+			parse_attribution_argument(argv[0], argv[i], argv[i + 1], attribution);
+			i++;
+		} else if (is_prefetch_option(argv[i]) && i + 1 < argc) {
+			parse_prefetch_argument(argv[0], argv[i], argv[i + 1], prefetch);
+			i++;
+		} else if (is_timing_option(argv[i]) && i + 1 < argc) {
+			parse_timing_argument(argv[0], argv[i], argv[i + 1], timing);
+			i++;
+		} else if (strcmp(argv[i], "--classify") == 0) {
+			classify->is_enabled = true;
+		} else if (strcmp(argv[i], "--classify-filter") == 0 && i + 1 < argc) {
+			parse_classify_argument(argv[0], argv[++i], classify);
+		} else {
+			fprintf(stderr, "Invalid option or missing argument: %s.\n", argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+
+        if (*endptr != '\0') {
+            fprintf(stderr, "Invalid numeric value for %s: %s\n", argv[i - 1], argv[i]);
+            printUsage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+	}
+
+	// Validate the input parameters
+	if (!validate_args(*associativity, *line_size, *cache_size, *miss_penalty, *dirty_wb_penalty)
+	    || !validate_sample_rate(*associativity, *line_size, *cache_size, *sample_rate)) {
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (*num_threads < 0) {
+		fprintf(stderr, "Number of threads can't be less than zero.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (!*load_state) {
+		validate_write_arguments(argv[0], *write_policy, *combining_entries); // A loaded state brings its policy
+	}
+	if (!*load_state && *sectors > *line_size) {
+		fprintf(stderr, "A line of %d bytes can't be split into %d sectors.\n", *line_size, *sectors);
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timeline->path && *num_threads != 1) {
+		fprintf(stderr, "The timeline is only recorded by a single thread.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if ((attribution->page_size != ATTRIBUTION_DEFAULT_PAGE_SIZE || attribution->regions_path)
+	    && attribution->top_count == 0) {
+		fprintf(stderr, "--attribute-page and --attribute-regions require --attribute.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (attribution->top_count > 0 && *num_threads != 1) {
+		fprintf(stderr, "The miss attribution is only recorded by a single thread.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if ((prefetch->degree != PREFETCH_DEFAULT_DEGREE || prefetch->distance != PREFETCH_DEFAULT_DISTANCE)
+	    && prefetch->policy == PREFETCH_NONE) {
+		fprintf(stderr, "--prefetch-degree and --prefetch-distance require --prefetch.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if ((timing->window != TIMING_DEFAULT_WINDOW || timing->write_buffer_size != TIMING_DEFAULT_WRITE_BUFFER)
+	    && timing->num_mshrs == 0) {
+		fprintf(stderr, "--mlp-window and --write-buffer require --mlp.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timing->num_mshrs > 0 && (*num_threads != 1 || *sample_rate != 1)) {
+		fprintf(stderr, "The timing model needs all misses in trace order, so it supports neither -j nor -k.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timing->num_mshrs > 0 && timeline->path) {
+		fprintf(stderr, "The timeline only records serialized cycles, so it doesn't support the timing model.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timing->num_mshrs > 0 && !*load_state && *write_policy != WRITE_BACK_ALLOCATE) {
+		fprintf(stderr, "The timing model only buffers the write-backs of the default write policy (-w wb).\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timing->num_mshrs > 0 && prefetch->policy != PREFETCH_NONE) {
+		fprintf(stderr, "The timing model doesn't time prefetch fills, so it doesn't support --prefetch.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify->filter_size != CLASSIFY_DEFAULT_FILTER_SIZE && !classify->is_enabled) {
+		fprintf(stderr, "--classify-filter requires --classify.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify->is_enabled && (*num_threads != 1 || *sample_rate != 1)) {
+		fprintf(stderr, "The miss classification needs all accesses in trace order, so it supports neither -j nor -k.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify->is_enabled && (prefetch->policy != PREFETCH_NONE || *load_state)) {
+		fprintf(stderr, "The miss classification supports neither prefetching nor --load-state.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify->is_enabled && *sectors > 1) {
+		fprintf(stderr, "The miss classification doesn't support sectored lines (--sectors).\n");
 		printUsage(argv[0]);
 		exit(EXIT_FAILURE);
 	}
+}
 
-    // Initialize the cache based on command-line arguments
-	Cache *cache = set_cache_configuration(argc, argv);
+/**
+ * @brief Sets the cache configuration given input arguments.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments.
+ * @param sampling Pointer receiving the selection of the measured records.
+ * @param save_state Pointer receiving the path the cache state is saved to after the trace, `NULL` if none.
+ * @param num_threads Pointer receiving the number of threads simulating partitions of the sets.
+ * @param timeline Pointer receiving the timeline options.
+ * @param attribution Pointer receiving the attribution options.
+ * @param timing Pointer receiving the timing model options.
+ * @param classify Pointer receiving the miss classification options.
+ * @return Initialized Cache object with the given constrains.
+ */
+static Cache *set_cache_configuration(const int argc, const char *argv[], TraceSampling *sampling,
+                                      const char **save_state, int *num_threads, TimelineOptions *timeline,
+                                      AttributionOptions *attribution, TimingOptions *timing,
+                                      ClassifyOptions *classify) {
+	int associativity, line_size, cache_size, miss_penalty, dirty_wb_penalty;
+	ReplacementPolicy replacement;
+	WritePolicy write_policy;
+	int combining_entries;
+	int sectors;
+	int sample_rate;
+	const char *load_state;
+	PrefetchOptions prefetch;
+	parse_cache_arguments(argc, argv, 1, &associativity, &line_size, &cache_size, &miss_penalty, &dirty_wb_penalty,
+	                      &replacement, &write_policy, &combining_entries, &sectors, &sample_rate, sampling,
+	                      &load_state,
+	                      save_state, num_threads, timeline, attribution, &prefetch, timing, classify);
 
-	const char *trace_file = argv[argc - 1]; // Last argument is the trace file
+	// Initialize cache with the provided configuration, or continue from a saved state
+	Cache *cache;
+	if (load_state) {
+		cache = load_cache_state(load_state);
+		reset_cache_stats(cache); // The statistics only cover the new trace
+	} else {
+		cache = initialize_cache(associativity, cache_size, line_size, miss_penalty, dirty_wb_penalty,
+		                         replacement, sample_rate);
+		if (sectors > 1) {
+			set_cache_sectors(cache, sectors);
+		}
 
-    // Simulate cache using the provided trace file
-	simulate_cache(cache, trace_file);
+		// The write policy selects the kernels the prefetcher wraps, so it is set first
+		if (write_policy != WRITE_BACK_ALLOCATE || combining_entries > 0) {
+			set_write_policy(cache, write_policy, combining_entries);
+		}
+	}
+	if (prefetch.policy != PREFETCH_NONE) {
+		attach_prefetcher(cache, &prefetch);
+	}
+	if (timing->num_mshrs > 0 && cache->sample_rate > 1) {
+		fprintf(stderr, "The timing model doesn't support the set sampling of %s.\n", load_state);
+		exit(EXIT_FAILURE);
+	}
+	if (timing->num_mshrs > 0 && cache->write_policy != WRITE_BACK_ALLOCATE) {
+		fprintf(stderr, "The timing model doesn't support the write policy of %s.\n", load_state);
+		exit(EXIT_FAILURE);
+	}
+
+    // Print cache configuration
+	print_cache_settings(cache, sampling);
+
+    return cache;
+}
+
+/**
+ * @brief Parses a comma-separated list of integers.
+ *
+ * @param prog The name of the executable.
+ * @param option The option the list belongs to.
+ * @param arg The comma-separated list.
+ * @param values Pointer receiving the newly allocated array of values.
+ * @return The number of values in the list.
+ */
+static int parse_int_list(const char *prog, const char *option, const char *arg, int **values) {
+	int count = 1;
+	for (const char *c = arg; *c != '\0'; c++) {
+		if (*c == ',') {
+			count++;
+		}
+	}
+
+	free(*values);
+	*values = allocate_or_exit(count, sizeof(int), "option values");
+
+	const char *start = arg;
+	for (int i = 0; i < count; i++) {
+		char *endptr;
+		(*values)[i] = strtol(start, &endptr, 10);
+		if (endptr == start || (*endptr != ',' && *endptr != '\0')) {
+			fprintf(stderr, "Invalid numeric list for %s: %s\n", option, arg);
+			printUsage(prog);
+			exit(EXIT_FAILURE);
+		}
+		start = endptr + 1;
+	}
+
+	return count;
+}
+
+/**
+ * @brief Sets the configurations of a sweep given input arguments.
+ * Configurations that fail validation are reported and skipped.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--sweep`.
+ * @param num_points Pointer receiving the number of sweep points.
+ * @param num_threads Pointer receiving the number of worker threads.
+ * @param sampling Pointer receiving the selection of the measured records.
+ * @return Array of sweep points with initialized caches.
+ */
+static SweepPoint* set_sweep_configuration(const int argc, const char *argv[], int *num_points, int *num_threads,
+                                           TraceSampling *sampling) {
+	// Set default cache parameters
+	int *associativities = NULL;
+	int *line_sizes = NULL;
+	int *cache_sizes = NULL;
+	int num_associativities = 0;
+	int num_line_sizes = 0;
+	int num_cache_sizes = 0;
+	int *configs = NULL; // Triples of associativity, cache size and line size given by -c
+	int num_configs = 0;
+	int miss_penalty = MISS_PENALTY;
+	int dirty_wb_penalty = DIRTY_WB_PENALTY;
+	ReplacementPolicy replacement = REPLACEMENT_LRU;
+	WritePolicy write_policy = WRITE_BACK_ALLOCATE;
+	int combining_entries = 0;
+	int sectors = 1;
+	int sample_rate = 1;
+	ClassifyOptions classify = {false, CLASSIFY_DEFAULT_FILTER_SIZE};
+	*num_threads = 0;
+	*sampling = (TraceSampling){0, 0, 0};
+
+	// Parse command line arguments
+	for (int i = 2; i < argc - 1; i++) {
+		char *endptr = "";
+
+		if (strcmp(argv[i], "-a") == 0 && i + 1 < argc - 1) {
+			num_associativities = parse_int_list(argv[0], argv[i], argv[i + 1], &associativities);
+			i++;
+		} else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc - 1) {
+			num_line_sizes = parse_int_list(argv[0], argv[i], argv[i + 1], &line_sizes);
+			i++;
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc - 1) {
+			num_cache_sizes = parse_int_list(argv[0], argv[i], argv[i + 1], &cache_sizes);
+			i++;
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc - 1) {
+			configs = reallocate_or_exit(configs, ((size_t)num_configs + 1) * 3, sizeof(int), "sweep configurations");
+			const char *start = argv[++i];
+			for (int field = 0; field < 3; field++) {
+				configs[num_configs * 3 + field] = strtol(start, &endptr, 10);
+				if (endptr == start || *endptr != (field < 2 ? ':' : '\0')) {
+					fprintf(stderr, "Invalid configuration for -c: %s\n", argv[i]);
+					printUsage(argv[0]);
+					exit(EXIT_FAILURE);
+				}
+				start = endptr + 1;
+			}
+			num_configs++;
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc - 1) {
+			miss_penalty = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc - 1) {
+			dirty_wb_penalty = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc - 1) {
+			parse_replacement_argument(argv[0], argv[++i], &replacement);
+		} else if (is_write_option(argv[i]) && i + 1 < argc - 1) {
+			parse_write_argument(argv[0], argv[i], argv[i + 1], &write_policy, &combining_entries);
+			i++;
+		} else if (strcmp(argv[i], "--sectors") == 0 && i + 1 < argc - 1) {
+			parse_sectors_argument(argv[0], argv[++i], &sectors);
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc - 1) {
+			sample_rate = strtol(argv[++i], &endptr, 10);
+		} else if (is_sampling_option(argv[i]) && i + 1 < argc - 1) {
+			parse_sampling_argument(argv[0], argv[i], argv[i + 1], sampling);
+			i++;
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc - 1) {
+			*num_threads = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "--classify") == 0) {
+			classify.is_enabled = true;
+		} else if (strcmp(argv[i], "--classify-filter") == 0 && i + 1 < argc - 1) {
+			parse_classify_argument(argv[0], argv[++i], &classify);
+		} else {
+			fprintf(stderr, "Invalid option or missing argument: %s.\n", argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+
+		if (*endptr != '\0') {
+			fprintf(stderr, "Invalid numeric value for %s: %s\n", argv[i - 1], argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (*num_threads < 0) {
+		fprintf(stderr, "Number of threads can't be less than zero.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	validate_write_arguments(argv[0], write_policy, combining_entries);
+	if (classify.filter_size != CLASSIFY_DEFAULT_FILTER_SIZE && !classify.is_enabled) {
+		fprintf(stderr, "--classify-filter requires --classify.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify.is_enabled && sample_rate != 1) {
+		fprintf(stderr, "The miss classification needs all sets, so it doesn't support -k.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify.is_enabled && sectors > 1) {
+		fprintf(stderr, "The miss classification doesn't support sectored lines (--sectors).\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	// The grid is only added on its own or if one of its dimensions was given
+	const bool has_grid = num_configs == 0 || num_associativities > 0 || num_line_sizes > 0 || num_cache_sizes > 0;
+	if (has_grid) {
+		const int defaults[3] = {ASSOCIATIVITY, CACHE_SIZE, CACHE_LINE};
+		int **lists[3] = {&associativities, &cache_sizes, &line_sizes};
+		int *counts[3] = {&num_associativities, &num_cache_sizes, &num_line_sizes};
+		for (int d = 0; d < 3; d++) {
+			if (*counts[d] == 0) {
+				*lists[d] = allocate_or_exit(1, sizeof(int), "option values");
+				(*lists[d])[0] = defaults[d];
+				*counts[d] = 1;
+			}
+		}
+
+		const int grid_size = num_associativities * num_cache_sizes * num_line_sizes;
+		configs = reallocate_or_exit(configs, ((size_t)num_configs + grid_size) * 3, sizeof(int),
+		                             "sweep configurations");
+		for (int a = 0; a < num_associativities; a++) {
+			for (int s = 0; s < num_cache_sizes; s++) {
+				for (int l = 0; l < num_line_sizes; l++) {
+					configs[num_configs * 3] = associativities[a];
+					configs[num_configs * 3 + 1] = cache_sizes[s];
+					configs[num_configs * 3 + 2] = line_sizes[l];
+					num_configs++;
+				}
+			}
+		}
+	}
+
+	free(associativities);
+	free(cache_sizes);
+	free(line_sizes);
+
+	SweepPoint *points = allocate_or_exit(num_configs, sizeof(SweepPoint), "sweep points");
+
+	// Initialize a cache for every valid configuration
+	*num_points = 0;
+	for (int c = 0; c < num_configs; c++) {
+		const int associativity = configs[c * 3];
+		const int cache_size = configs[c * 3 + 1];
+		const int line_size = configs[c * 3 + 2];
+
+		if (!validate_args(associativity, line_size, cache_size, miss_penalty, dirty_wb_penalty)
+		    || !validate_sample_rate(associativity, line_size, cache_size, sample_rate) || sectors > line_size) {
+			fprintf(stderr, "Skipping configuration %d:%d:%d.\n", associativity, cache_size, line_size);
+			continue;
+		}
+
+		points[*num_points].cache = initialize_cache(associativity, cache_size, line_size, miss_penalty,
+		                                             dirty_wb_penalty, replacement, sample_rate);
+		if (sectors > 1) {
+			set_cache_sectors(points[*num_points].cache, sectors);
+		}
+		if (write_policy != WRITE_BACK_ALLOCATE || combining_entries > 0) {
+			set_write_policy(points[*num_points].cache, write_policy, combining_entries);
+		}
+		points[*num_points].cycle_count = 0;
+		points[*num_points].classifier = classify.is_enabled
+		                                 ? initialize_classifier(&classify, points[*num_points].cache) : NULL;
+		(*num_points)++;
+	}
+	free(configs);
+
+	if (*num_points == 0) {
+		fprintf(stderr, "No valid cache configuration to sweep.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	// Print sweep configuration
+	printf("CACHE SWEEP SETTINGS\n");
+	printf("    %s%8d\n", "Configurations:", *num_points);
+	if (replacement != REPLACEMENT_LRU) {
+		printf("       %s%8s\n", "Replacement:", get_replacement_policy_name(replacement));
+	}
+	if (write_policy != WRITE_BACK_ALLOCATE) {
+		printf("      %s%8s\n", "Write Policy:", get_write_policy_name(write_policy));
+	}
+	if (combining_entries > 0) {
+		printf("   %s%8d lines\n", "Write Combining:", combining_entries);
+	}
+	if (sectors > 1) {
+		printf("           %s%8d\n", "Sectors:", sectors);
+	}
+	if (sample_rate > 1) {
+		printf("       %s%8d\n", "Sample Rate:", sample_rate);
+	}
+	if (classify.is_enabled) {
+		printf("      %s%8d KB\n", "Class Filter:", classify.filter_size);
+	}
+	print_sampling_settings(sampling);
+	printf("      %s%8d cycles\n", "Miss Penalty:", miss_penalty);
+	printf("  %s%8d cycles\n\n", "Dirty WB Penalty:", dirty_wb_penalty);
+
+	return points;
+}
+
+/**
+ * @brief Processes a single trace line from the trace file.
+ *
+ * @param cache_op Pointer to the decoded CacheOp of this trace line.
+ * @param cache Pointer to the Cache object.
+ * @param trace_stats Structure for saving trace statistics.
+ * @param timeline Pointer to the Timeline object recording the access, `NULL` if there is none.
+ * @param attribution Pointer to the Attribution object charged with misses, `NULL` if there is none.
+ * @param timing Pointer to the TimingModel object timing the access, `NULL` to serialize all misses.
+ * @param classifier Pointer to the MissClassifier object classifying the misses, `NULL` if there is none.
+ */
+static void process_trace_line(const CacheOp *cache_op, Cache *cache, TraceStats *trace_stats, Timeline *timeline,
+                               Attribution *attribution, TimingModel *timing, MissClassifier *classifier) {
+    // Update access statistics
+	update_trace_stats(trace_stats, cache_op);
+
+	// Simulate cache access, the serialized cycles are replaced by those of a timing model at the end
+	const bool is_hit = timing ? access_cache_timed(timing, cache, cache_op) : access_cache(cache, cache_op);
+	if (classifier) {
+		classify_cache_access(classifier, cache_op, is_hit);
+	}
+	if (!is_hit) {
+		// If cache miss, add miss penalty to cycle count
+		trace_stats->cycle_count += cache->miss_penalty;
+
+		if (attribution) {
+			attribute_cache_miss(attribution, cache, cache_op);
+		}
+	}
+
+	trace_stats->cycle_count += cache_op->instructions;
+
+	if (timeline) {
+		record_timeline_access(timeline, cache, cache_op);
+	}
+}
+
+/**
+ * @brief Simulates the cache based on the given trace file.
+ * Records outside the measured phases of the trace sampling only warm the
+ * cache and are left out of all statistics. With more than one thread, every
+ * thread simulates a partition of the sets, which yields the same statistics.
+ *
+ * @param cache Pointer to the Cache object being simulated.
+ * @param trace_file The path to the trace file to be processed.
+ * @param sampling Pointer to the TraceSampling object selecting the measured records.
+ * @param num_threads Number of threads simulating partitions of the sets, `0` for one per online core.
+ * @param timeline_options Pointer to the TimelineOptions object, with a `NULL` path if there is no timeline.
+ * @param attribution_options Pointer to the AttributionOptions object, with a zero count if there is no attribution.
+ * @param timing_options Pointer to the TimingOptions object, with zero MSHRs if misses are serialized.
+ * @param classify_options Pointer to the ClassifyOptions object.
+ */
+static void simulate_cache(Cache *cache, const char *trace_file, const TraceSampling *sampling,
+                           const int num_threads, const TimelineOptions *timeline_options,
+                           const AttributionOptions *attribution_options, const TimingOptions *timing_options,
+                           const ClassifyOptions *classify_options) {
+	// Initialize trace file statistic variables
+    TraceStats trace_stats = {0, 0, 0, 0, 0, 0};
+	Attribution *attribution = NULL;
+	TimingModel *timing = NULL;
+	MissClassifier *classifier = NULL;
+
+	if (num_threads != 1 && get_max_cache_partitions(cache) > 1) {
+		simulate_partitioned(cache, trace_file, &trace_stats, sampling, num_threads);
+	} else {
+		TraceReader *reader = open_trace(trace_file);
+		Timeline *timeline = timeline_options->path ? open_timeline(timeline_options, cache) : NULL;
+		if (attribution_options->top_count > 0) {
+			attribution = initialize_attribution(attribution_options, cache);
+		}
+		if (timing_options->num_mshrs > 0) {
+			timing = initialize_timing_model(timing_options, cache);
+		}
+		if (classify_options->is_enabled) {
+			classifier = initialize_classifier(classify_options, cache);
+		}
+
+		// Initialize cache operation variable
+		CacheOp cache_op;
+
+		// Read the trace record by record
+		long record = 0;
+		long phase_records = 0; // Records left in the current phase of the sampling
+		bool is_measured = true;
+		while (read_trace_operation(reader, &cache_op)) {
+			if (phase_records == 0) {
+				phase_records = get_sampling_phase(sampling, record, &is_measured);
+			}
+			phase_records--;
+			record++;
+
+			if (is_measured) {
+				process_trace_line(&cache_op, cache, &trace_stats, timeline, attribution, timing, classifier);
+			} else {
+				warm_cache(cache, &cache_op);
+				if (classifier) {
+					warm_classifier(classifier, &cache_op);
+				}
+			}
+		}
+
+		close_trace(reader);
+		if (timeline) {
+			close_timeline(timeline, cache);
+		}
+	}
+
+	// Fetch final statistics from the cache, every write to memory costs the write-back penalty
+	const uint64_t dirty_wb_count = get_dirty_write_backs(cache);
+	const uint64_t memory_write_count = get_memory_writes(cache);
+	const uint64_t cache_hit_count = get_cache_hits(cache);
+	const uint64_t cache_miss_count = get_cache_misses(cache);
+
+	print_access_stats(trace_stats.memory_access_count, trace_stats.load_count, trace_stats.store_count,
+	                   trace_stats.fetch_count);
+
+	// A sampled cache only saw a part of the accesses, its counts are extrapolated
+	if (cache->sample_rate > 1) {
+		const CacheSampleEstimate estimate = estimate_sampled_stats(cache);
+		const uint64_t estimated_misses = (uint64_t)(estimate.misses + 0.5);
+		const uint64_t estimated_write_backs = (uint64_t)(estimate.dirty_write_backs + 0.5);
+		const uint64_t estimated_stores = (memory_write_count - dirty_wb_count) * cache->sample_rate;
+		const uint64_t cycle_count = trace_stats.instruction_count + estimated_misses * cache->miss_penalty
+		                        + (estimated_write_backs + estimated_stores) * cache->dirty_wb_penalty
+		                        + cache->stats.prefetch_wait_cycles * cache->sample_rate;
+
+		print_sampled_stats(&estimate, trace_stats.memory_access_count);
+		print_cpi_stats(trace_stats.instruction_count, cycle_count, estimated_write_backs);
+		print_write_stats(cache);
+		print_sector_stats(cache);
+		print_prefetch_stats(cache);
+		if (attribution) {
+			print_attribution(attribution, attribution_options->top_count);
+			free_attribution(attribution);
+		}
+		return;
+	}
+
+	// Add the cycles of dirty write-backs and late prefetches unless the timing model (never prefetching) has them
+	if (timing) {
+		trace_stats.cycle_count = finish_timing_model(timing);
+	} else {
+		trace_stats.cycle_count += memory_write_count * cache->dirty_wb_penalty + cache->stats.prefetch_wait_cycles;
+	}
+
+	// Calculate miss rate
+	const float miss_rate = (float) cache_miss_count / trace_stats.memory_access_count;
+
+	// Print cache statistics
+	print_hit_miss_stats(miss_rate, cache_miss_count, cache_hit_count);
+	print_cpi_stats(trace_stats.instruction_count, trace_stats.cycle_count, dirty_wb_count);
+	print_write_stats(cache);
+	print_sector_stats(cache);
+	print_prefetch_stats(cache);
+	if (classifier) {
+		print_classifier_stats(classifier, cache_miss_count);
+		free_classifier(classifier);
+	}
+	if (timing) {
+		print_timing_stats(timing);
+		free_timing_model(timing);
+	}
+	if (attribution) {
+		print_attribution(attribution, attribution_options->top_count);
+		free_attribution(attribution);
+	}
+}
+
+
+/**
+ * @brief Runs a sweep over several cache configurations and prints its results.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--sweep`.
+ */
+static void run_sweep(const int argc, const char *argv[]) {
+	int num_points;
+	int num_threads;
+	TraceSampling sampling;
+	SweepPoint *points = set_sweep_configuration(argc, argv, &num_points, &num_threads, &sampling);
+
+	const char *trace_file = argv[argc - 1]; // Last argument is the trace file
+
+	// Simulate all configurations using the provided trace file
+	TraceStats trace_stats = {0, 0, 0, 0, 0, 0};
+	simulate_sweep(points, num_points, trace_file, &trace_stats, &sampling, num_threads);
+
+	// Print trace and sweep statistics
+	print_access_stats(trace_stats.memory_access_count, trace_stats.load_count, trace_stats.store_count,
+	                   trace_stats.fetch_count);
+	print_sweep_results(points, num_points, &trace_stats);
+
+	// Free allocated cache memory
+	for (int p = 0; p < num_points; p++) {
+		free_cache(points[p].cache);
+		if (points[p].classifier) {
+			free_classifier(points[p].classifier);
+		}
+	}
+	free(points);
+}
+
+/**
+ * @brief Computes and prints the LRU miss-ratio curve with the stack distance engine.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--mrc`.
+ */
+static void run_stack_distance(const int argc, const char *argv[]) {
+	int associativity, line_size, cache_size, miss_penalty, dirty_wb_penalty;
+	ReplacementPolicy replacement;
+	WritePolicy write_policy;
+	int combining_entries;
+	int sectors;
+	int sample_rate;
+	TraceSampling sampling;
+	const char *load_state;
+	const char *save_state;
+	int num_threads;
+	TimelineOptions timeline;
+	AttributionOptions attribution;
+	PrefetchOptions prefetch;
+	TimingOptions timing;
+	ClassifyOptions classify;
+	parse_cache_arguments(argc, argv, 2, &associativity, &line_size, &cache_size, &miss_penalty, &dirty_wb_penalty,
+	                      &replacement, &write_policy, &combining_entries, &sectors, &sample_rate, &sampling,
+	                      &load_state, &save_state, &num_threads, &timeline, &attribution, &prefetch, &timing,
+	                      &classify);
+	if (replacement != REPLACEMENT_LRU) {
+		fprintf(stderr, "The miss-ratio curve is only defined for LRU replacement.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (write_policy != WRITE_BACK_ALLOCATE) {
+		fprintf(stderr, "The miss-ratio curve only supports the default write policy (-w wb).\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (sectors != 1) {
+		fprintf(stderr, "The miss-ratio curve doesn't support sectored lines.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (sample_rate != 1) {
+		fprintf(stderr, "The miss-ratio curve doesn't support set sampling.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (sampling.warmup_records != 0 || sampling.detail_records != 0) {
+		fprintf(stderr, "The miss-ratio curve doesn't support warmup or sampling intervals.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (num_threads != 1) {
+		fprintf(stderr, "The miss-ratio curve doesn't support parallel simulation.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timeline.path) {
+		fprintf(stderr, "The miss-ratio curve doesn't support a timeline.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (attribution.top_count > 0) {
+		fprintf(stderr, "The miss-ratio curve doesn't support miss attribution.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (prefetch.policy != PREFETCH_NONE) {
+		fprintf(stderr, "The miss-ratio curve doesn't support prefetching.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (timing.num_mshrs > 0) {
+		fprintf(stderr, "The miss-ratio curve doesn't support the timing model.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (classify.is_enabled) {
+		fprintf(stderr, "The miss-ratio curve doesn't support the miss classification.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (load_state || save_state) {
+		fprintf(stderr, "The miss-ratio curve doesn't support cache states.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	// The set count stays fixed along the curve, only the associativity varies
+	const int num_lines = cache_size * 1024 / line_size;
+	const int num_sets = associativity == 0 ? 1 : num_lines / associativity;
+	StackDistance *stack_distance = initialize_stack_distance(num_sets, line_size);
+
+	printf("STACK DISTANCE SETTINGS\n");
+	printf("              %s%8d\n", "Sets:", num_sets);
+	printf("        %s%8d byte\n\n", "Block Size:", line_size);
+
+	// Record the stack distance of every access of the trace
+	TraceReader *reader = open_trace(argv[argc - 1]);
+	TraceStats trace_stats = {0, 0, 0, 0, 0, 0};
+	CacheOp cache_op;
+	while (read_trace_operation(reader, &cache_op)) {
+		update_trace_stats(&trace_stats, &cache_op);
+		access_stack_distance(stack_distance, &cache_op);
+	}
+	close_trace(reader);
+
+	print_access_stats(trace_stats.memory_access_count, trace_stats.load_count, trace_stats.store_count,
+	                   trace_stats.fetch_count);
+
+	// Print the curve for power-of-two associativities until only cold misses remain
+	printf("LRU MISS-RATIO CURVE\n");
+	printf("%8s %12s %12s %12s %11s\n", "Assoc", "Size(KB)", "Hits", "Misses", "Miss Rate");
+	const int max_distance = get_max_stack_distance(stack_distance);
+	for (int ways = 1;; ways *= 2) {
+		const uint64_t misses = get_stack_distance_misses(stack_distance, ways);
+		const double size_kb = (double) num_sets * ways * line_size / 1024;
+		printf("%8d %12.3f %12" PRIu64 " %12" PRIu64 " %10.5f%%\n", ways, size_kb, trace_stats.memory_access_count - misses, misses,
+		       (float) misses / trace_stats.memory_access_count * 100);
+		if (ways > max_distance) {
+			break;
+		}
+	}
+
+	free_stack_distance(stack_distance);
+}
+
+/**
+ * @brief Parses the configuration of a hierarchy level.
+ * Terminates the program with a usage message if the configuration is invalid.
+ *
+ * @param prog The name of the executable.
+ * @param option The option the configuration belongs to.
+ * @param arg The configuration `<assoc>:<size>:<line>[:<latency>]`.
+ * @param default_latency The latency used if the configuration doesn't give one.
+ * @param config Array receiving associativity, cache size, line size and latency.
+ */
+static void parse_level_configuration(const char *prog, const char *option, const char *arg,
+                                      const int default_latency, int config[4]) {
+	const char *start = arg;
+	config[3] = default_latency;
+
+	// Three or four colon-separated fields, the latency is optional
+	int num_fields = 0;
+	char *endptr = NULL;
+	do {
+		config[num_fields++] = strtol(start, &endptr, 10);
+		if (endptr == start) {
+			break;
+		}
+		start = endptr + 1;
+	} while (*endptr == ':' && num_fields < 4);
+
+	if (endptr == start || *endptr != '\0' || num_fields < 3) {
+		fprintf(stderr, "Invalid configuration for %s: %s\n", option, arg);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+
+	if (config[3] < 0) {
+		fprintf(stderr, "Latency of %s can't be less than zero.\n", option);
+		printUsage(prog);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * @brief Sets the configuration of a cache hierarchy given input arguments.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--hierarchy`.
+ * @return Initialized Hierarchy object with the given levels.
+ */
+static Hierarchy* set_hierarchy_configuration(const int argc, const char *argv[]) {
+	// Levels in hierarchy order, only L1D is present by default
+	const char *names[4] = {"L1I", "L1D", "L2", "LLC"};
+	const int default_latencies[4] = {L1_LATENCY, L1_LATENCY, L2_LATENCY, LLC_LATENCY};
+	int configs[4][4] = {{0}};
+	bool is_present[4] = {false, true, false, false};
+	configs[1][0] = ASSOCIATIVITY;
+	configs[1][1] = CACHE_SIZE;
+	configs[1][2] = CACHE_LINE;
+	configs[1][3] = L1_LATENCY;
+
+	InclusionPolicy inclusion = INCLUSION_NINE;
+	ReplacementPolicy replacement = REPLACEMENT_LRU;
+	int miss_penalty = MISS_PENALTY;
+	int dirty_wb_penalty = DIRTY_WB_PENALTY;
+
+	// Parse command line arguments
+	for (int i = 2; i < argc - 1; i++) {
+		char *endptr = "";
+		int level = -1;
+		for (int l = 0; l < 4; l++) {
+			if (argv[i][0] == '-' && strcmp(argv[i] + 1, names[l]) == 0) {
+				level = l;
+			}
+		}
+
+		if (level >= 0 && i + 1 < argc - 1) {
+			parse_level_configuration(argv[0], argv[i], argv[i + 1], default_latencies[level], configs[level]);
+			is_present[level] = true;
+			i++;
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc - 1) {
+			if (!parse_inclusion_policy(argv[++i], &inclusion)) {
+				fprintf(stderr, "Invalid inclusion policy: %s\n", argv[i]);
+				printUsage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc - 1) {
+			parse_replacement_argument(argv[0], argv[++i], &replacement);
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc - 1) {
+			miss_penalty = strtol(argv[++i], &endptr, 10);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc - 1) {
+			dirty_wb_penalty = strtol(argv[++i], &endptr, 10);
+		} else {
+			fprintf(stderr, "Invalid option or missing argument: %s.\n", argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+
+		if (*endptr != '\0') {
+			fprintf(stderr, "Invalid numeric value for %s: %s\n", argv[i - 1], argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Validate every level, lines are passed between levels as a whole
+	for (int l = 0; l < 4; l++) {
+		if (!is_present[l]) {
+			continue;
+		}
+		if (!validate_args(configs[l][0], configs[l][2], configs[l][1], miss_penalty, dirty_wb_penalty)) {
+			fprintf(stderr, "Invalid configuration for %s.\n", names[l]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		if (configs[l][2] != configs[1][2]) {
+			fprintf(stderr, "All levels of a cache hierarchy must use the same line size.\n");
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	Hierarchy *hierarchy = initialize_hierarchy(inclusion, miss_penalty, dirty_wb_penalty);
+
+	// Print hierarchy configuration
+	printf("CACHE HIERARCHY SETTINGS\n");
+	printf("%5s %6s %9s %7s %8s\n", "Level", "Assoc", "Size(KB)", "Line(B)", "Latency");
+	for (int l = 0; l < 4; l++) {
+		if (!is_present[l]) {
+			continue;
+		}
+		Cache *cache = initialize_cache(configs[l][0], configs[l][1], configs[l][2], miss_penalty, dirty_wb_penalty,
+		                                replacement, 1);
+		add_hierarchy_level(hierarchy, names[l], cache, configs[l][3]);
+		printf("%5s %6d %9d %7d %8d\n", names[l], cache->associativity, cache->cache_size, cache->line_size,
+		       configs[l][3]);
+	}
+	printf("\n         %s%12s\n", "Inclusion:", get_inclusion_policy_name(inclusion));
+	if (replacement != REPLACEMENT_LRU) {
+		printf("       %s%12s\n", "Replacement:", get_replacement_policy_name(replacement));
+	}
+	printf("    %s%8d cycles\n", "Memory Latency:", miss_penalty);
+	printf("  %s%8d cycles\n\n", "Dirty WB Penalty:", dirty_wb_penalty);
+
+	return hierarchy;
+}
+
+/**
+ * @brief Simulates a cache hierarchy and prints its statistics.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--hierarchy`.
+ */
+static void run_hierarchy(const int argc, const char *argv[]) {
+	Hierarchy *hierarchy = set_hierarchy_configuration(argc, argv);
+
+	TraceReader *reader = open_trace(argv[argc - 1]);
+	TraceStats trace_stats = {0, 0, 0, 0, 0, 0};
+	CacheOp cache_op;
+	while (read_trace_operation(reader, &cache_op)) {
+		update_trace_stats(&trace_stats, &cache_op);
+		trace_stats.cycle_count += access_hierarchy(hierarchy, &cache_op);
+		trace_stats.cycle_count += cache_op.instructions;
+	}
+	close_trace(reader);
+
+	// Adjust cycle count for write-backs to memory
+	trace_stats.cycle_count += hierarchy->memory_writes * hierarchy->dirty_wb_penalty;
+
+	print_access_stats(trace_stats.memory_access_count, trace_stats.load_count, trace_stats.store_count,
+	                   trace_stats.fetch_count);
+	print_hierarchy_stats(hierarchy);
+	print_cpi_stats(trace_stats.instruction_count, trace_stats.cycle_count, hierarchy->memory_writes);
+
+	free_hierarchy(hierarchy);
+}
+
+/**
+ * @brief Sets the configuration of a multi-core system given input arguments.
+ * Every argument after the options is the trace of one core.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--multicore`.
+ * @return Initialized Multicore object with one core per trace.
+ */
+static Multicore* set_multicore_configuration(const int argc, const char *argv[]) {
+	int private_config[4] = {ASSOCIATIVITY, CACHE_SIZE, CACHE_LINE, L1_LATENCY};
+	int shared_config[4] = {LLC_ASSOCIATIVITY, LLC_CACHE_SIZE, CACHE_LINE, LLC_LATENCY};
+	bool has_shared_config = false;
+	ReplacementPolicy replacement = REPLACEMENT_LRU;
+	CoherenceProtocol protocol = COHERENCE_NONE;
+	int miss_penalty = MISS_PENALTY;
+	int dirty_wb_penalty = DIRTY_WB_PENALTY;
+
+	// Parse command line arguments up to the first trace, `-` alone is stdin
+	int first_trace = 2;
+	for (; first_trace < argc && argv[first_trace][0] == '-' && argv[first_trace][1] != '\0'; first_trace++) {
+		const int i = first_trace;
+		char *endptr = "";
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Invalid option or missing argument: %s.\n", argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+
+		if (strcmp(argv[i], "-L1") == 0) {
+			parse_level_configuration(argv[0], argv[i], argv[i + 1], L1_LATENCY, private_config);
+		} else if (strcmp(argv[i], "-LLC") == 0) {
+			parse_level_configuration(argv[0], argv[i], argv[i + 1], LLC_LATENCY, shared_config);
+			has_shared_config = true;
+		} else if (strcmp(argv[i], "-c") == 0) {
+			if (!parse_coherence_protocol(argv[i + 1], &protocol)) {
+				fprintf(stderr, "Invalid coherence protocol: %s\n", argv[i + 1]);
+				printUsage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+		} else if (strcmp(argv[i], "-r") == 0) {
+			parse_replacement_argument(argv[0], argv[i + 1], &replacement);
+		} else if (strcmp(argv[i], "-p") == 0) {
+			miss_penalty = strtol(argv[i + 1], &endptr, 10);
+		} else if (strcmp(argv[i], "-d") == 0) {
+			dirty_wb_penalty = strtol(argv[i + 1], &endptr, 10);
+		} else {
+			fprintf(stderr, "Invalid option or missing argument: %s.\n", argv[i]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		first_trace++;
+
+		if (*endptr != '\0') {
+			fprintf(stderr, "Invalid numeric value for %s: %s\n", argv[i], argv[i + 1]);
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	const int num_cores = argc - first_trace;
+	if (num_cores < 1 || num_cores > MULTICORE_MAX_CORES) {
+		fprintf(stderr, "A multi-core system needs between 1 and %d traces.\n", MULTICORE_MAX_CORES);
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	int num_stdin_traces = 0;
+	for (int i = first_trace; i < argc; i++) {
+		num_stdin_traces += strcmp(argv[i], "-") == 0;
+	}
+	if (num_stdin_traces > 1) {
+		fprintf(stderr, "Only one core can read its trace from stdin.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Without an explicit shared cache, the shared cache follows the line size of the private caches
+	if (!has_shared_config) {
+		shared_config[2] = private_config[2];
+	}
+	if (!validate_args(private_config[0], private_config[2], private_config[1], miss_penalty, dirty_wb_penalty)) {
+		fprintf(stderr, "Invalid configuration for -L1.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (!validate_args(shared_config[0], shared_config[2], shared_config[1], miss_penalty, dirty_wb_penalty)) {
+		fprintf(stderr, "Invalid configuration for -LLC.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (private_config[2] != shared_config[2]) {
+		fprintf(stderr, "The private and the shared caches must use the same line size.\n");
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	Cache *shared_cache = initialize_cache(shared_config[0], shared_config[1], shared_config[2], miss_penalty,
+	                                       dirty_wb_penalty, replacement, 1);
+	Multicore *multicore = initialize_multicore(shared_cache, private_config[3], shared_config[3], miss_penalty,
+	                                            dirty_wb_penalty, protocol);
+	for (int i = first_trace; i < argc; i++) {
+		add_multicore_core(multicore, argv[i], initialize_cache(private_config[0], private_config[1],
+		                                                        private_config[2], miss_penalty, dirty_wb_penalty,
+		                                                        replacement, 1));
+	}
+
+	// Print multi-core configuration
+	const Cache *private_cache = multicore->cores[0].cache;
+	printf("MULTI-CORE SETTINGS\n");
+	printf("%5s %6s %9s %7s %8s\n", "Level", "Assoc", "Size(KB)", "Line(B)", "Latency");
+	printf("%5s %6d %9d %7d %8d\n", "L1", private_cache->associativity, private_cache->cache_size,
+	       private_cache->line_size, multicore->private_latency);
+	printf("%5s %6d %9d %7d %8d\n", "LLC", shared_cache->associativity, shared_cache->cache_size,
+	       shared_cache->line_size, multicore->shared_latency);
+	printf("\n             %s%12d\n", "Cores:", num_cores);
+	if (protocol != COHERENCE_NONE) {
+		printf("         %s%12s\n", "Coherence:", get_coherence_protocol_name(protocol));
+	}
+	if (replacement != REPLACEMENT_LRU) {
+		printf("       %s%12s\n", "Replacement:", get_replacement_policy_name(replacement));
+	}
+	printf("    %s%8d cycles\n", "Memory Latency:", miss_penalty);
+	printf("  %s%8d cycles\n\n", "Dirty WB Penalty:", dirty_wb_penalty);
+	for (int c = 0; c < num_cores; c++) {
+		printf("%4s %d: %s\n", "Core", c, multicore->cores[c].trace_file);
+	}
+	printf("\n");
+
+	return multicore;
+}
+
+/**
+ * @brief Simulates a multi-core system with a shared last-level cache and prints its statistics.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, starting with `--multicore`.
+ */
+static void run_multicore(const int argc, const char *argv[]) {
+	Multicore *multicore = set_multicore_configuration(argc, argv);
+	simulate_multicore(multicore);
+	print_multicore_stats(multicore);
+	free_multicore(multicore);
+}
+
+/**
+ * @brief Prints the cache settings.
+ * The replacement and write policy, the sampled sets and the trace sampling
+ * are only printed if they differ from the defaults (LRU, write-back, all
+ * sets, all records).
+ *
+ * @param cache Pointer to the initialized Cache object.
+ * @param sampling Pointer to the TraceSampling object.
+ */
+static void print_cache_settings(const Cache *cache, const TraceSampling *sampling) {
+	printf("CACHE SETTINGS\n");
+	printf("     %s%8d\n", "Associativity:", cache->associativity);
+	printf("        %s%8d kilobyte\n", "Cache Size:", cache->cache_size);
+	printf("        %s%8d byte\n", "Block Size:", cache->line_size);
+	if (cache->replacement != REPLACEMENT_LRU) {
+		printf("       %s%8s\n", "Replacement:", get_replacement_policy_name(cache->replacement));
+	}
+	if (cache->write_policy != WRITE_BACK_ALLOCATE) {
+		printf("      %s%8s\n", "Write Policy:", get_write_policy_name(cache->write_policy));
+	}
+	if (cache->write_combining) {
+		printf("   %s%8d lines\n", "Write Combining:", cache->write_combining->capacity);
+	}
+	if (cache->sector_masks) {
+		printf("           %s%8d of %d byte\n", "Sectors:", 1 << cache->log_sectors, 1 << cache->log_sector_size);
+	}
+	if (cache->sample_rate > 1) {
+		printf("      %s%8d of %d\n", "Sampled Sets:", cache->num_sampled_sets, cache->num_sets);
+	}
+	if (cache->prefetcher) {
+		const Prefetcher *prefetcher = cache->prefetcher;
+		printf("       %s%9s\n", "Prefetcher:", get_prefetch_policy_name(prefetcher->policy));
+		printf("   %s%8d lines\n", "Prefetch Degree:", prefetcher->degree);
+		printf(" %s%8d %s\n", "Prefetch Distance:", prefetcher->distance,
+		       prefetcher->policy == PREFETCH_STRIDE ? "strides" : "lines");
+	}
+	print_sampling_settings(sampling);
+	printf("      %s%8d cycles\n", "Miss Penalty:", cache->miss_penalty);
+	printf("  %s%8d cycles\n\n", "Dirty WB Penalty:", cache->dirty_wb_penalty);
+}
+
+/**
+ * @brief Prints the warmup and the sampling intervals, if any.
+ *
+ * @param sampling Pointer to the TraceSampling object.
+ */
+static void print_sampling_settings(const TraceSampling *sampling) {
+	if (sampling->warmup_records > 0) {
+		printf("            %s%8ld records\n", "Warmup:", sampling->warmup_records);
+	}
+	if (sampling->detail_records > 0) {
+		printf("      %s%8ld records\n", "Fast-Forward:", sampling->fast_forward_records);
+		printf("            %s%8ld records\n", "Detail:", sampling->detail_records);
+	}
+}
+
+/**
+ * @brief Prints the access statistics.
+ *
+ * @param memory_access_count Total number of memory accesses.
+ * @param load_count Total number of load operations.
+ * @param store_count Total number of store operations.
+ * @param fetch_count Total number of instruction fetches, only printed if the trace contains any.
+ */
+static void print_access_stats(const uint64_t memory_access_count, const uint64_t load_count,
+                               const uint64_t store_count, const uint64_t fetch_count) {
+	printf("CACHE ACCESS STATS\n");
+	printf("   %s%12" PRIu64 "\n", "Memory Accesses:", memory_access_count);
+	printf("             %s%12" PRIu64 "\n", "Loads:", load_count);
+	if (fetch_count > 0) {
+		printf("            %s%12" PRIu64 "\n", "Stores:", store_count);
+		printf("           %s%12" PRIu64 "\n\n", "Fetches:", fetch_count);
+	} else {
+		printf("            %s%12" PRIu64 "\n\n", "Stores:", store_count);
+	}
+}
+
+/**
+ * @brief Prints the hit/miss statistics.
+ *
+ * @param miss_rate Cache miss rate.
+ * @param cache_miss_count Total number of cache misses.
+ * @param cache_hit_count Total number of cache hits.
+ */
+static void print_hit_miss_stats(const float miss_rate, const uint64_t cache_miss_count,
+                                 const uint64_t cache_hit_count) {
+	printf("CACHE HIT-MISS STATS\n");
+	printf("         %s%12.5f%%\n", "Miss Rate:", miss_rate * 100); // Convert to percentage
+	printf("      %s%12" PRIu64 "\n", "Cache Misses:", cache_miss_count);
+	printf("        %s%12" PRIu64 "\n\n", "Cache Hits:", cache_hit_count);
+}
+
+/**
+ * @brief Prints the extrapolated hit/miss statistics of a sampled cache with their 95% confidence intervals.
+ *
+ * @param estimate Pointer to the extrapolated statistics.
+ * @param memory_access_count Total number of memory accesses.
+ */
+static void print_sampled_stats(const CacheSampleEstimate *estimate, const uint64_t memory_access_count) {
+	printf("CACHE HIT-MISS STATS (EXTRAPOLATED, 95%% CONFIDENCE)\n");
+	printf("         %s%12.5f%% +- %.5f%%\n", "Miss Rate:", estimate->misses / memory_access_count * 100,
+	       estimate->misses_error / memory_access_count * 100);
+	printf("      %s%12.0f +- %.0f\n", "Cache Misses:", estimate->misses, estimate->misses_error);
+	printf("        %s%12.0f +- %.0f\n", "Cache Hits:", memory_access_count - estimate->misses,
+	       estimate->misses_error);
+	printf(" %s%12.0f +- %.0f\n\n", "Dirty Write-Backs:", estimate->dirty_write_backs,
+	       estimate->dirty_write_backs_error);
+}
+
+/**
+ * @brief Prints the CPI (Cycles Per Instruction) statistics.
+ *
+ * @param instruction_count Total number of instructions.
+ * @param cycle_count Total number of cycles.
+ * @param dirty_write_backs Total number of dirty write-backs.
+ */
+static void print_cpi_stats(const uint64_t instruction_count, const uint64_t cycle_count,
+                            const uint64_t dirty_write_backs) {
+	printf("CACHE CPI STATS\n");
+	printf("Cycles/Instruction: %11.5f\n", (float) cycle_count / instruction_count); // Show CPI with 5 decimal places
+	printf("      %s%12" PRIu64 "\n", "Instructions:", instruction_count);
+	printf("            %s%12" PRIu64 "\n", "Cycles:", cycle_count);
+	printf(" %s%12" PRIu64 "\n", "Dirty Write-Backs:", dirty_write_backs);
+}
+
+/**
+ * @brief Prints the memory write traffic of a cache with a non-default write policy, extrapolated for sampled caches.
+ * Nothing is printed for write-back, write-allocate caches, whose only writes
+ * are the dirty write-backs. The stores still pending in the write-combining
+ * buffer count as written.
+ *
+ * @param cache Pointer to the simulated Cache object.
+ */
+static void print_write_stats(const Cache *cache) {
+	if (cache->write_policy == WRITE_BACK_ALLOCATE) {
+		return;
+	}
+
+	const CacheStats *stats = &cache->stats;
+	const uint64_t scale = (uint64_t)cache->sample_rate;
+	const uint64_t memory_writes = get_memory_writes(cache);
+	printf("\nCACHE MEMORY WRITE STATS%s\n", scale > 1 ? " (EXTRAPOLATED)" : "");
+	printf("       %s%12" PRIu64 "\n", "Write-Backs:", stats->dirty_write_backs * scale);
+	printf("      %s%12" PRIu64 "\n", "Store Writes:", (memory_writes - stats->dirty_write_backs) * scale);
+	printf("   %s%12" PRIu64 "\n", "Combined Stores:", stats->combined_writes * scale);
+	printf("     %s%12" PRIu64 "\n", "Memory Writes:", memory_writes * scale);
+	printf("     %s%12" PRIu64 " byte\n", "Bytes Written:", get_memory_write_bytes(cache) * scale);
+}
+
+/**
+ * @brief Prints the sector statistics of a sectored cache, extrapolated for sampled caches.
+ * Nothing is printed if the lines of the cache have no sectors.
+ *
+ * @param cache Pointer to the simulated Cache object.
+ */
+static void print_sector_stats(const Cache *cache) {
+	if (!cache->sector_masks) {
+		return;
+	}
+
+	const CacheStats *stats = &cache->stats;
+	const uint64_t scale = (uint64_t)cache->sample_rate;
+	const double bytes_per_write_back = stats->dirty_write_backs > 0
+	                                    ? (double) stats->write_back_bytes / stats->dirty_write_backs : 0;
+	printf("\nCACHE SECTOR STATS%s\n", scale > 1 ? " (EXTRAPOLATED)" : "");
+	printf("        %s%12" PRIu64 "\n", "Tag Misses:", (stats->misses - stats->sector_misses) * scale);
+	printf("     %s%12" PRIu64 "\n", "Sector Misses:", stats->sector_misses * scale);
+	printf("  %s%12" PRIu64 " byte\n", "Write-Back Bytes:", get_write_back_bytes(cache) * scale);
+	printf("      %s%12.2f byte\n", "Bytes per WB:", bytes_per_write_back);
+}
+
+/**
+ * @brief Prints the prefetch statistics of a cache with a prefetcher, extrapolated for sampled caches.
+ * Nothing is printed if the cache has no prefetcher.
+ *
+ * @param cache Pointer to the simulated Cache object.
+ */
+static void print_prefetch_stats(const Cache *cache) {
+	if (!cache->prefetcher) {
+		return;
+	}
+
+	const CacheStats *stats = &cache->stats;
+	const uint64_t scale = (uint64_t)cache->sample_rate;
+	const double accuracy = stats->prefetches > 0
+	                        ? (double) (stats->useful_prefetches + stats->late_prefetches) / stats->prefetches * 100
+	                        : 0;
+	printf("\nCACHE PREFETCH STATS%s\n", scale > 1 ? " (EXTRAPOLATED)" : "");
+	printf("        %s%12" PRIu64 "\n", "Prefetches:", stats->prefetches * scale);
+	printf("            %s%12" PRIu64 "\n", "Useful:", stats->useful_prefetches * scale);
+	printf("              %s%12" PRIu64 "\n", "Late:", stats->late_prefetches * scale);
+	printf("           %s%12" PRIu64 "\n", "Useless:", stats->useless_prefetches * scale);
+	printf("       %s%12" PRIu64 "\n", "Wait Cycles:", stats->prefetch_wait_cycles * scale);
+	printf("          %s%12.5f%%\n", "Accuracy:", accuracy);
+}
+
+/**
+ * @brief Prints the statistics of the timing model.
+ * The average memory-level parallelism is the number of outstanding misses
+ * averaged over all cycles with at least one outstanding miss.
+ *
+ * @param timing Pointer to the finished TimingModel object.
+ */
+static void print_timing_stats(const TimingModel *timing) {
+	const TimingStats *stats = &timing->stats;
+	const double mlp = stats->miss_cycles > 0
+	                   ? (double) stats->issued_misses * timing->miss_penalty / stats->miss_cycles
+	                   : 0;
+	printf("\nCACHE TIMING STATS\n");
+	printf("   %s%12" PRIu64 "\n", "Merged Accesses:", stats->merged_accesses);
+	printf("       %s%12" PRIu64 " cycles\n", "MSHR Stalls:", stats->mshr_stall_cycles);
+	printf("     %s%12" PRIu64 " cycles\n", "Window Stalls:", stats->window_stall_cycles);
+	printf("  %s%12" PRIu64 " cycles\n", "Write Buf Stalls:", stats->write_buffer_stall_cycles);
+	printf("       %s%12.5f\n", "Average MLP:", mlp);
+}
+
+/**
+ * @brief Prints the misses of every class and their share of all misses.
+ * False positives of the filter count compulsory misses as capacity misses,
+ * so its estimated error is printed as well.
+ *
+ * @param classifier Pointer to the MissClassifier object of the simulated cache.
+ * @param cache_miss_count Total number of cache misses.
+ */
+static void print_classifier_stats(const MissClassifier *classifier, const uint64_t cache_miss_count) {
+	const MissClassStats *stats = &classifier->stats;
+	const double misses = cache_miss_count > 0 ? (double) cache_miss_count : 1;
+	printf("\nCACHE MISS CLASSES\n");
+	printf("        %s%12" PRIu64 " %9.5f%%\n", "Compulsory:", stats->compulsory, stats->compulsory / misses * 100);
+	printf("          %s%12" PRIu64 " %9.5f%%\n", "Capacity:", stats->capacity, stats->capacity / misses * 100);
+	printf("          %s%12" PRIu64 " %9.5f%%\n", "Conflict:", stats->conflict, stats->conflict / misses * 100);
+	printf("      %s%12.5f%% of %d KB\n", "Filter Error:", estimate_classifier_error(classifier) * 100,
+	       classifier->filter_size);
+}
+
+/**
+ * @brief Prints the statistics of every level of a hierarchy and of memory.
+ *
+ * @param hierarchy Pointer to the simulated Hierarchy object.
+ */
+static void print_hierarchy_stats(const Hierarchy *hierarchy) {
+	printf("CACHE HIERARCHY STATS\n");
+	printf("%5s %12s %12s %12s %11s %12s %12s %12s\n", "Level", "Accesses", "Hits", "Misses", "Miss Rate",
+	       "Dirty WBs", "WBs In", "Back Inv");
+
+	const HierarchyLevel *levels[HIERARCHY_MAX_LEVELS + 1];
+	int num_levels = 0;
+	if (hierarchy->has_instruction_level) {
+		levels[num_levels++] = &hierarchy->instruction_level;
+	}
+	for (int depth = 0; depth < hierarchy->num_levels; depth++) {
+		levels[num_levels++] = &hierarchy->levels[depth];
+	}
+
+	for (int l = 0; l < num_levels; l++) {
+		const Cache *cache = levels[l]->cache;
+		const uint64_t hits = get_cache_hits(cache);
+		const uint64_t misses = get_cache_misses(cache);
+		const uint64_t accesses = hits + misses;
+		printf("%5s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %10.5f%% %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n", levels[l]->name, accesses, hits, misses,
+		       accesses > 0 ? (float) misses / accesses * 100 : 0.0f, get_dirty_write_backs(cache),
+		       levels[l]->write_backs_in, levels[l]->back_invalidations);
+	}
+
+	printf("\n      %s%12" PRIu64 "\n", "Memory Reads:", hierarchy->memory_reads);
+	printf("     %s%12" PRIu64 "\n\n", "Memory Writes:", hierarchy->memory_writes);
+}
+
+/**
+ * @brief Entry point for the cache simulation program.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments.
+ * @return Exit status of the program.
+ */
+int main(const int argc, const char *argv[]) {
+	if (argc < 2) {
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	// Convert a trace into the binary format instead of simulating it
+	if (strcmp(argv[1], "--convert") == 0) {
+		if (argc != 4) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		const long record_count = convert_trace(argv[2], argv[3]);
+		fprintf(stderr, "Converted %ld records from %s to %s.\n", record_count, argv[2], argv[3]);
+		return EXIT_SUCCESS;
+	}
+
+	// Simulate several configurations in one pass over the trace
+	if (strcmp(argv[1], "--sweep") == 0) {
+		if (argc < 3) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		run_sweep(argc, argv);
+		return EXIT_SUCCESS;
+	}
+
+	// Compute the miss-ratio curve of all associativities in one pass
+	if (strcmp(argv[1], "--mrc") == 0) {
+		if (argc < 3) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		run_stack_distance(argc, argv);
+		return EXIT_SUCCESS;
+	}
+
+	// Simulate a multi-level cache hierarchy
+	if (strcmp(argv[1], "--hierarchy") == 0) {
+		if (argc < 3) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		run_hierarchy(argc, argv);
+		return EXIT_SUCCESS;
+	}
+
+	// Simulate several cores with private caches and a shared last-level cache
+	if (strcmp(argv[1], "--multicore") == 0) {
+		if (argc < 3) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+		run_multicore(argc, argv);
+		return EXIT_SUCCESS;
+	}
+
+    // Initialize the cache based on command-line arguments
+	TraceSampling sampling;
+	const char *save_state;
+	int num_threads;
+	TimelineOptions timeline;
+	AttributionOptions attribution;
+	TimingOptions timing;
+	ClassifyOptions classify;
+	Cache *cache = set_cache_configuration(argc, argv, &sampling, &save_state, &num_threads, &timeline,
+	                                       &attribution, &timing, &classify);
+
+	const char *trace_file = argv[argc - 1]; // Last argument is the trace file
+
+    // Simulate cache using the provided trace file
+	simulate_cache(cache, trace_file, &sampling, num_threads, &timeline, &attribution, &timing, &classify);
+
+	// Keep the warm cache for later continuations
+	if (save_state) {
+		save_cache_state(cache, save_state);
+	}
 
     // Free allocated cache memory
 	free_cache(cache);
@@ -0,0 +1,440 @@
+/***************************************************************************/
+/**
+ * @file multicore.c
+ * @brief Implementation of the multi-core simulation with a shared last-level
+ * cache of the cache simulator.
+ *
+ * This source file provides the implementation for the multi-core system
+ * defined in multicore.h. Every core thread decodes its trace, simulates its
+ * private cache and appends a request for every miss and every dirty
+ * write-back to the current batch of its queue. Only full batches are
+ * published, so the core threads and the merging thread touch the shared
+ * counters once per batch instead of once per request. With a coherence
+ * protocol, the core threads queue every access instead, and the merging
+ * thread also simulates the private caches.
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "multicore.h"
+#include "spin.h"
+
+_Static_assert((int)MULTICORE_MAX_CORES <= (int)COHERENCE_MAX_CORES, "Every core needs a bit in the directory");
+
+/**
+ * @brief Kind of a request of a core.
+ */
+typedef enum MulticoreRequestKind {
+    MULTICORE_FILL,         // A miss of the private cache fetches the line from the shared cache
+    MULTICORE_WRITE_BACK,   // The private cache writes a dirty line back into the shared cache
+    MULTICORE_LOAD,         // A load or instruction fetch to be simulated coherently
+    MULTICORE_STORE,        // A store to be simulated coherently
+} MulticoreRequestKind;
+
+/**
+ * @brief A request of a core to the shared level.
+ */
+typedef struct MulticoreRequest {
+    uint64_t instruction;   // Instructions executed by the core up to and including the access
+    uint64_t address;       // Address of the access, the missing line or the written back line
+    MulticoreRequestKind kind;  // Kind of the request
+} MulticoreRequest;
+
+/**
+ * @brief A batch of requests. A batch with a count of 0 marks the end of the trace.
+ */
+typedef struct MulticoreBatch {
+    size_t count;                                       // Number of valid requests
+    MulticoreRequest requests[MULTICORE_BATCH_SIZE];    // Requests in the order of the trace
+} MulticoreBatch;
+
+/**
+ * @brief Single-producer/single-consumer ring of batches between a core thread and the shared level.
+ * The counters and the state of the consumer are padded to their own host
+ * cache lines, so the producer and the consumer only share a line when a batch
+ * changes hands.
+ */
+typedef struct MulticoreQueue {
+    _Alignas(HOST_CACHE_LINE) atomic_size_t published;  // Number of batches published by the core thread
+    _Alignas(HOST_CACHE_LINE) atomic_size_t consumed;   // Number of batches consumed by the shared level
+    _Alignas(HOST_CACHE_LINE) MulticoreBatch *batches;  // MULTICORE_RING_SIZE batches
+    MulticoreCore *core;        // Core producing the requests
+    int private_latency;        // Latency of every access to the private cache
+    bool is_coherent;           // Indicates if the merging thread simulates the private cache
+    pthread_t thread;           // Handle of the core thread
+    size_t write_sequence;      // Sequence number of the batch being filled by the core thread
+    _Alignas(HOST_CACHE_LINE) size_t read_sequence;     // Sequence number of the batch being read by the shared level
+    size_t next_request;        // Index of the next request of the batch being read
+    bool is_done;               // Indicates if the shared level has read the end marker
+} MulticoreQueue;
+
+// --- Helper Functions ---
+
+/**
+ * @brief Returns the batch with the current sequence number once its slot is free again.
+ *
+ * @param queue Pointer to the MulticoreQueue object.
+ * @return Pointer to the empty MulticoreBatch object.
+ */
+static MulticoreBatch* acquire_batch(MulticoreQueue *queue) {
+    if (queue->write_sequence >= MULTICORE_RING_SIZE) {
+        unsigned spins = 0;
+        while (atomic_load_explicit(&queue->consumed, memory_order_acquire)
+               <= queue->write_sequence - MULTICORE_RING_SIZE) {
+            wait_for_counter(&spins);
+        }
+    }
+
+    MulticoreBatch *batch = &queue->batches[queue->write_sequence % MULTICORE_RING_SIZE];
+    batch->count = 0;
+    return batch;
+}
+
+/**
+ * @brief Hands the current batch to the shared level and advances to the next one.
+ *
+ * @param queue Pointer to the MulticoreQueue object.
+ */
+static void publish_batch(MulticoreQueue *queue) {
+    queue->write_sequence++;
+    atomic_store_explicit(&queue->published, queue->write_sequence, memory_order_release);
+}
+
+/**
+ * @brief Appends a request to the current batch, publishing the batch once it is full.
+ *
+ * @param queue Pointer to the MulticoreQueue object.
+ * @param batch Pointer to the current batch, replaced by the next one if it is published.
+ * @param request The request.
+ */
+static void push_request(MulticoreQueue *queue, MulticoreBatch **batch, const MulticoreRequest request) {
+    (*batch)->requests[(*batch)->count++] = request;
+    if ((*batch)->count == MULTICORE_BATCH_SIZE) {
+        publish_batch(queue);
+        *batch = acquire_batch(queue);
+    }
+}
+
+/**
+ * @brief Entry point of a core thread.
+ * Simulates the private cache over the trace of the core and queues its
+ * misses and dirty write-backs. A write-back is queued before the fetch of the
+ * miss that replaced the line, like in a NINE hierarchy. Coherent systems
+ * queue every access instead.
+ *
+ * @param arg Pointer to the MulticoreQueue object of the core.
+ * @return Always `NULL`.
+ */
+static void* run_multicore_core(void *arg) {
+    MulticoreQueue *queue = (MulticoreQueue *)arg;
+    MulticoreCore *core = queue->core;
+    Cache *cache = core->cache;
+
+    CacheOp *ops = allocate_or_exit(MULTICORE_BATCH_SIZE, sizeof(CacheOp), "multi-core batch");
+
+    TraceReader *reader = open_trace(core->trace_file);
+    MulticoreBatch *batch = acquire_batch(queue);
+    TraceStats trace_stats = {0, 0, 0, 0, 0, 0}; // Kept locally, the merging thread updates the core meanwhile
+    uint64_t instruction = 0;
+    size_t num_ops;
+    while ((num_ops = read_trace_batch(reader, ops, MULTICORE_BATCH_SIZE)) > 0) {
+        for (size_t i = 0; i < num_ops; i++) {
+            update_trace_stats(&trace_stats, &ops[i]);
+            instruction += (uint64_t)ops[i].instructions;
+            if (queue->is_coherent) {
+                const MulticoreRequestKind kind = ops[i].access_type == 's' ? MULTICORE_STORE : MULTICORE_LOAD;
+                push_request(queue, &batch, (MulticoreRequest){instruction, ops[i].address, kind});
+                continue;
+            }
+            if (access_cache(cache, &ops[i])) {
+                continue;
+            }
+
+            const CacheEviction victim = cache->last_eviction;
+            if (victim.is_valid && victim.is_dirty) {
+                push_request(queue, &batch, (MulticoreRequest){instruction, victim.address, MULTICORE_WRITE_BACK});
+            }
+            push_request(queue, &batch, (MulticoreRequest){instruction, ops[i].address, MULTICORE_FILL});
+        }
+    }
+    close_trace(reader);
+    free(ops);
+
+    // Publish the last requests and the end marker
+    if (batch->count > 0) {
+        publish_batch(queue);
+        batch = acquire_batch(queue);
+    }
+    publish_batch(queue);
+
+    trace_stats.cycle_count = trace_stats.instruction_count
+                              + trace_stats.memory_access_count * (uint64_t)queue->private_latency;
+    core->trace_stats = trace_stats;
+    return NULL;
+}
+
+/**
+ * @brief Returns the next request of a core without removing it.
+ * Waits until the core thread has published a batch with the request.
+ *
+ * @param queue Pointer to the MulticoreQueue object.
+ * @return Pointer to the next MulticoreRequest object, NULL at the end of the trace.
+ */
+static const MulticoreRequest* peek_request(MulticoreQueue *queue) {
+    if (queue->is_done) {
+        return NULL;
+    }
+
+    const MulticoreBatch *batch = &queue->batches[queue->read_sequence % MULTICORE_RING_SIZE];
+    if (queue->next_request == 0) {
+        unsigned spins = 0;
+        while (atomic_load_explicit(&queue->published, memory_order_acquire) <= queue->read_sequence) {
+            wait_for_counter(&spins);
+        }
+        if (batch->count == 0) {
+            queue->is_done = true;
+            return NULL;
+        }
+    }
+    return &batch->requests[queue->next_request];
+}
+
+/**
+ * @brief Removes the request returned by peek_request, handing a fully read batch back to the core thread.
+ *
+ * @param queue Pointer to the MulticoreQueue object.
+ */
+static void pop_request(MulticoreQueue *queue) {
+    const MulticoreBatch *batch = &queue->batches[queue->read_sequence % MULTICORE_RING_SIZE];
+    if (++queue->next_request == batch->count) {
+        queue->next_request = 0;
+        queue->read_sequence++;
+        atomic_store_explicit(&queue->consumed, queue->read_sequence, memory_order_release);
+    }
+}
+
+/**
+ * @brief Simulates a fill or a write-back of a core in the shared cache.
+ *
+ * @param multicore Pointer to the Multicore object.
+ * @param core Pointer to the MulticoreCore object issuing the request.
+ * @param kind MULTICORE_FILL or MULTICORE_WRITE_BACK.
+ * @param address An address within the line.
+ */
+static void access_shared_cache(Multicore *multicore, MulticoreCore *core, const MulticoreRequestKind kind,
+                                const uint64_t address) {
+    Cache *cache = multicore->shared_cache;
+    const uint64_t write_backs = cache->stats.dirty_write_backs;
+
+    if (kind == MULTICORE_WRITE_BACK) {
+        install_cache_line(cache, address, true);
+    } else {
+        const CacheOp fill_op = initialize_cache_operation('l', address, 0);
+        if (access_cache(cache, &fill_op)) {
+            core->shared_hits++;
+        } else {
+            core->shared_misses++;
+        }
+    }
+
+    core->memory_writes += cache->stats.dirty_write_backs - write_backs;
+}
+
+/**
+ * @brief Simulates a request of a core.
+ * Coherent accesses go through the private cache and the directory first,
+ * which decide about the requests to the shared cache.
+ *
+ * @param multicore Pointer to the Multicore object.
+ * @param caches The private caches of all cores.
+ * @param core_index Number of the core issuing the request.
+ * @param request Pointer to the MulticoreRequest object.
+ */
+static void simulate_request(Multicore *multicore, Cache *const *caches, const int core_index,
+                             const MulticoreRequest *request) {
+    MulticoreCore *core = &multicore->cores[core_index];
+    if (request->kind == MULTICORE_FILL || request->kind == MULTICORE_WRITE_BACK) {
+        access_shared_cache(multicore, core, request->kind, request->address);
+        return;
+    }
+
+    const CacheOp cache_op = initialize_cache_operation(request->kind == MULTICORE_STORE ? 's' : 'l',
+                                                        request->address, 0);
+    const CoherenceAccess access = access_coherent(multicore->directory, caches, core_index, &cache_op,
+                                                   &core->coherence);
+    for (int i = 0; i < access.num_write_backs; i++) {
+        access_shared_cache(multicore, core, MULTICORE_WRITE_BACK, access.write_backs[i]);
+    }
+    if (access.needs_fill) {
+        access_shared_cache(multicore, core, MULTICORE_FILL, request->address);
+    }
+}
+
+// --- Multi-Core Initialization and Cleanup ---
+
+Multicore* initialize_multicore(Cache *shared_cache, const int private_latency, const int shared_latency,
+                                const int memory_latency, const int dirty_wb_penalty,
+                                const CoherenceProtocol protocol) {
+    Multicore *multicore = allocate_or_exit(1, sizeof(Multicore), "multi-core system");
+
+    multicore->private_latency = private_latency;
+    multicore->shared_cache = shared_cache;
+    multicore->shared_latency = shared_latency;
+    multicore->memory_latency = memory_latency;
+    multicore->dirty_wb_penalty = dirty_wb_penalty;
+    multicore->protocol = protocol;
+
+    return multicore;
+}
+
+void add_multicore_core(Multicore *multicore, const char *trace_file, Cache *cache) {
+    if (multicore->num_cores == MULTICORE_MAX_CORES) {
+        fprintf(stderr, "A multi-core system can't have more than %d cores.\n", MULTICORE_MAX_CORES);
+        exit(EXIT_FAILURE);
+    }
+
+    MulticoreCore *core = &multicore->cores[multicore->num_cores++];
+    *core = (MulticoreCore){trace_file, cache, {0, 0, 0, 0, 0, 0}, 0, 0, 0, {0, 0, 0, 0, 0, 0}};
+}
+
+void free_multicore(Multicore *multicore) {
+    for (int c = 0; c < multicore->num_cores; c++) {
+        free_cache(multicore->cores[c].cache);
+    }
+    free_cache(multicore->shared_cache);
+    if (multicore->directory) {
+        free_directory(multicore->directory);
+    }
+    free(multicore);
+}
+
+// --- Multi-Core Simulation ---
+
+void simulate_multicore(Multicore *multicore) {
+    const int num_cores = multicore->num_cores;
+    Cache *caches[MULTICORE_MAX_CORES];
+    for (int c = 0; c < num_cores; c++) {
+        caches[c] = multicore->cores[c].cache;
+    }
+    if (multicore->protocol != COHERENCE_NONE && !multicore->directory) {
+        multicore->directory = initialize_directory(multicore->protocol, caches, num_cores);
+    }
+    MulticoreQueue *queues = (MulticoreQueue *)aligned_alloc(HOST_CACHE_LINE, num_cores * sizeof(MulticoreQueue));
+    if (!queues) {
+        fprintf(stderr, "Failed to allocate memory for multi-core queues.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int c = 0; c < num_cores; c++) {
+        MulticoreQueue *queue = &queues[c];
+        atomic_init(&queue->published, 0);
+        atomic_init(&queue->consumed, 0);
+        queue->batches = allocate_or_exit(MULTICORE_RING_SIZE, sizeof(MulticoreBatch), "multi-core queues");
+        queue->core = &multicore->cores[c];
+        queue->private_latency = multicore->private_latency;
+        queue->is_coherent = multicore->protocol != COHERENCE_NONE;
+        queue->write_sequence = 0;
+        queue->read_sequence = 0;
+        queue->next_request = 0;
+        queue->is_done = false;
+        if (pthread_create(&queue->thread, NULL, run_multicore_core, queue) != 0) {
+            fprintf(stderr, "Failed to create multi-core thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Merge the requests of all cores in instruction order, ties go to the lower core
+    for (;;) {
+        int next_core = -1;
+        const MulticoreRequest *next = NULL;
+        for (int c = 0; c < num_cores; c++) {
+            const MulticoreRequest *request = peek_request(&queues[c]);
+            if (request && (!next || request->instruction < next->instruction)) {
+                next_core = c;
+                next = request;
+            }
+        }
+        if (!next) {
+            break;
+        }
+
+        simulate_request(multicore, caches, next_core, next);
+        pop_request(&queues[next_core]);
+    }
+
+    for (int c = 0; c < num_cores; c++) {
+        pthread_join(queues[c].thread, NULL);
+        free(queues[c].batches);
+    }
+    free(queues);
+
+    // Add the shared and memory latencies to the cycles of every core
+    for (int c = 0; c < num_cores; c++) {
+        MulticoreCore *core = &multicore->cores[c];
+        const uint64_t shared_requests = core->shared_hits + core->shared_misses + core->coherence.transfers
+                                         + core->coherence.upgrades;
+        core->trace_stats.cycle_count += shared_requests * multicore->shared_latency
+                                         + core->shared_misses * multicore->memory_latency
+                                         + core->memory_writes * multicore->dirty_wb_penalty;
+    }
+}
+
+// --- Multi-Core Output ---
+
+void print_multicore_stats(const Multicore *multicore) {
+    printf("MULTI-CORE STATS\n");
+    printf("%4s %12s %12s %12s %11s %12s %12s %11s %12s %9s\n", "Core", "Instructions", "Accesses", "Misses",
+           "Miss Rate", "Dirty WBs", "LLC Misses", "LLC Rate", "Mem Writes", "CPI");
+
+    for (int c = 0; c < multicore->num_cores; c++) {
+        const MulticoreCore *core = &multicore->cores[c];
+        const TraceStats *stats = &core->trace_stats;
+        const uint64_t misses = get_cache_misses(core->cache);
+        const uint64_t requests = core->shared_hits + core->shared_misses;
+        printf("%4d %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %10.5f%% %12" PRIu64 " %12" PRIu64 " %10.5f%% %12"
+               PRIu64 " %9.5f\n", c, stats->instruction_count, stats->memory_access_count, misses,
+               stats->memory_access_count > 0 ? (float) misses / stats->memory_access_count * 100 : 0.0f,
+               get_dirty_write_backs(core->cache), core->shared_misses,
+               requests > 0 ? (float) core->shared_misses / requests * 100 : 0.0f, core->memory_writes,
+               stats->instruction_count > 0 ? (float) stats->cycle_count / stats->instruction_count : 0.0f);
+    }
+
+    const Cache *cache = multicore->shared_cache;
+    const uint64_t hits = get_cache_hits(cache);
+    const uint64_t misses = get_cache_misses(cache);
+    uint64_t write_backs_in = 0;
+    for (int c = 0; c < multicore->num_cores; c++) {
+        const MulticoreCore *core = &multicore->cores[c];
+        write_backs_in += get_dirty_write_backs(core->cache) + core->coherence.write_backs;
+    }
+
+    printf("\nSHARED CACHE STATS\n");
+    printf("          %s%12" PRIu64 "\n", "Requests:", hits + misses);
+    printf("              %s%12" PRIu64 "\n", "Hits:", hits);
+    printf("            %s%12" PRIu64 "\n", "Misses:", misses);
+    printf("         %s%12.5f%%\n", "Miss Rate:", hits + misses > 0 ? (float) misses / (hits + misses) * 100 : 0.0f);
+    printf("    %s%12" PRIu64 "\n", "Write-Backs In:", write_backs_in);
+    printf("     %s%12" PRIu64 "\n", "Memory Writes:", get_dirty_write_backs(cache));
+
+    const Directory *directory = multicore->directory;
+    if (!directory) {
+        return;
+    }
+
+    // Coherence misses are split off from the capacity and conflict misses of every core
+    printf("\nCOHERENCE STATS\n");
+    printf("%4s %12s %12s %12s %12s %12s %12s %12s\n", "Core", "Coh Misses", "Other Misses", "Invalidations",
+           "Upgrades", "Downgrades", "Transfers", "Downgr. WBs");
+    for (int c = 0; c < multicore->num_cores; c++) {
+        const MulticoreCore *core = &multicore->cores[c];
+        const CoherenceStats *stats = &core->coherence;
+        printf("%4d %12" PRIu64 " %12" PRIu64 " %13" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+               "\n", c, stats->coherence_misses, get_cache_misses(core->cache) - stats->coherence_misses,
+               stats->invalidations, stats->upgrades, stats->downgrades, stats->transfers, stats->write_backs);
+    }
+    printf("\n %s%12zu of %zu\n", "Directory Entries:", directory->max_entries, directory->capacity);
+    printf("    %s%12zu KB\n", "Directory Size:", directory->capacity * sizeof(DirectoryEntry) / 1024);
+}
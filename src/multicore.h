@@ -0,0 +1,130 @@
+/***************************************************************************/
+/**
+ * @file multicore.h
+ * @brief Header file for the multi-core simulation with a shared last-level
+ * cache of the cache simulator.
+ *
+ * Every simulated core runs its own trace through a private cache. The misses
+ * of all private caches go into one shared cache, interleaved by the number of
+ * instructions every core has executed so far (the third column of its trace),
+ * so the shared cache sees the accesses in the order the cores would issue them
+ * when running side by side at one instruction per cycle.
+ *
+ * The private caches form a NINE hierarchy with the shared cache: a miss
+ * fetches the line from the shared cache, and a replaced dirty line is written
+ * back into it. The shared cache never invalidates private lines, so the
+ * private caches don't depend on the shared one. This allows simulating every
+ * private cache on its own thread. The threads hand their requests to the
+ * shared level through one lock-free single-producer, single-consumer queue of
+ * batches per core, and the calling thread merges the queues in instruction
+ * order and simulates the shared cache. The results don't depend on the thread
+ * scheduling; ties between cores are broken by the core number.
+ *
+ * With a coherence protocol (see coherence.h), a store invalidates the copies
+ * of other cores, so the private caches depend on each other. The core threads
+ * then only decode their traces and queue every access, and the merging thread
+ * simulates the private caches, the directory and the shared cache in
+ * instruction order.
+ ******************************************************************************/
+
+#ifndef MULTICORE_H_INCLUDED
+#define MULTICORE_H_INCLUDED
+
+#include <stdint.h>
+
+#include "cache.h"
+#include "coherence.h"
+#include "trace.h"
+
+/**
+ * @brief Sizes of the multi-core simulation.
+ */
+enum {
+    MULTICORE_MAX_CORES = 64,       // Maximum number of simulated cores
+    MULTICORE_BATCH_SIZE = 1024,    // Number of requests handed to the shared level per batch
+    MULTICORE_RING_SIZE = 16,       // Number of batches in flight between a core and the shared level
+};
+
+/**
+ * @brief A simulated core with its private cache and results.
+ */
+typedef struct MulticoreCore {
+    const char *trace_file;     // Path of the trace executed by the core
+    Cache *cache;               // Private cache of the core
+    TraceStats trace_stats;     // Trace statistics, the cycle count includes all latencies of the core
+    uint64_t shared_hits;       // Misses of the private cache that hit the shared cache
+    uint64_t shared_misses;     // Misses of the private cache that missed the shared cache as well
+    uint64_t memory_writes;     // Dirty lines of the shared cache replaced by requests of the core
+    CoherenceStats coherence;   // Coherence traffic caused by the core, all zero without a protocol
+} MulticoreCore;
+
+/**
+ * @brief A multi-core system with private caches and a shared last-level cache.
+ */
+typedef struct Multicore {
+    MulticoreCore cores[MULTICORE_MAX_CORES];   // Simulated cores
+    int num_cores;              // Number of simulated cores
+    int private_latency;        // Latency in cycles of every access to a private cache
+    Cache *shared_cache;        // Cache shared by all cores
+    int shared_latency;         // Latency in cycles of a request to the shared cache
+    int memory_latency;         // Latency in cycles of a memory read
+    int dirty_wb_penalty;       // Penalty in cycles of a write-back to memory
+    CoherenceProtocol protocol; // Protocol keeping the private caches coherent
+    Directory *directory;       // Directory of the protocol, created by simulate_multicore, NULL without protocol
+} Multicore;
+
+/**
+ * @brief Creates a multi-core system without any cores.
+ * The system owns the shared cache and frees it in free_multicore.
+ *
+ * @param shared_cache Pointer to the shared Cache object.
+ * @param private_latency Latency in cycles of every access to a private cache.
+ * @param shared_latency Latency in cycles of a request to the shared cache.
+ * @param memory_latency Latency in cycles of a memory read.
+ * @param dirty_wb_penalty Penalty in cycles of a write-back to memory.
+ * @param protocol Protocol keeping the private caches coherent, COHERENCE_NONE for independent caches.
+ * @return Pointer to the initialized Multicore object.
+ */
+Multicore* initialize_multicore(Cache *shared_cache, int private_latency, int shared_latency, int memory_latency,
+                                int dirty_wb_penalty, CoherenceProtocol protocol);
+
+/**
+ * @brief Adds a core executing a trace.
+ * Terminates the program if the system already has MULTICORE_MAX_CORES cores.
+ * The system owns the private cache, which must use the line size of the
+ * shared cache.
+ *
+ * @param multicore Pointer to the Multicore object.
+ * @param trace_file The path to the trace file executed by the core.
+ * @param cache Pointer to the private Cache object of the core.
+ */
+void add_multicore_core(Multicore *multicore, const char *trace_file, Cache *cache);
+
+/**
+ * @brief Frees the memory allocated for a multi-core system and all of its caches.
+ *
+ * @param multicore Pointer to the Multicore object.
+ */
+void free_multicore(Multicore *multicore);
+
+/**
+ * @brief Simulates all cores over their traces, one thread per core.
+ * Afterwards, the statistics of every core and of the shared cache are
+ * complete, and the cycle count of every core includes its private, shared
+ * and memory latencies and the write-backs to memory caused by its requests.
+ * Cache-to-cache transfers and upgrades take the latency of the shared cache.
+ *
+ * @param multicore Pointer to the Multicore object.
+ */
+void simulate_multicore(Multicore *multicore);
+
+/**
+ * @brief Prints a table with one row per core and the statistics of the shared cache.
+ * With a coherence protocol, a second table shows the coherence traffic of
+ * every core and the occupancy of the directory.
+ *
+ * @param multicore Pointer to the simulated Multicore object.
+ */
+void print_multicore_stats(const Multicore *multicore);
+
+#endif // MULTICORE_H_INCLUDED
@@ -0,0 +1,350 @@
+/***************************************************************************/
+/**
+ * @file prefetch.c
+ * @brief Implementation of the hardware prefetcher models of the cache simulator.
+ *
+ * This source file provides the implementation for the prefetchers defined in
+ * prefetch.h. The pending lines are kept in an open-addressing hash table
+ * (hashtable.h). It holds at most one entry per line of the cache, so it never
+ * grows beyond half its capacity.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "hashtable.h"
+#include "prefetch.h"
+
+/**
+ * @brief Saturation limit of the confidence of a stride.
+ */
+#define PREFETCH_STRIDE_MAX_CONFIDENCE 3
+
+/**
+ * @brief Names of the prefetcher models, indexed by PrefetchPolicy.
+ */
+static const char *const prefetch_policy_names[] = {"none", "next-line", "stride", "stream"};
+
+// --- Helper Functions ---
+
+/**
+ * @brief Finds the slot of a key in the pending set, or the empty slot where it belongs.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param key Line number + 1.
+ * @return The slot of the key.
+ */
+static size_t find_pending_slot(const Prefetcher *prefetcher, const uint64_t key) {
+    return find_hash_slot(prefetcher->pending_lines, sizeof(PrefetchPendingLine), prefetcher->capacity, key);
+}
+
+/**
+ * @brief Removes a pending line and its clock from the pending set.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param line The line number.
+ * @param ready_cycle Pointer receiving the clock at which the fill of the line completes.
+ * @return `true` if the line was pending, `false` otherwise.
+ */
+static bool take_pending_line(Prefetcher *prefetcher, const uint64_t line, uint64_t *ready_cycle) {
+    const size_t slot = find_pending_slot(prefetcher, line + 1);
+    if (prefetcher->pending_lines[slot].key == 0) {
+        return false;
+    }
+    *ready_cycle = prefetcher->pending_lines[slot].ready_cycle;
+    remove_hash_slot(prefetcher->pending_lines, sizeof(PrefetchPendingLine), prefetcher->capacity, slot);
+    return true;
+}
+
+/**
+ * @brief Counts a useless prefetch if the line replaced by the last miss or installation was pending.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param cache Pointer to the Cache object.
+ */
+static void retire_evicted_line(Prefetcher *prefetcher, Cache *cache) {
+    const CacheEviction *eviction = &cache->last_eviction;
+    uint64_t ready_cycle;
+    if (eviction->is_valid && take_pending_line(prefetcher, eviction->address >> cache->log_line_size,
+                                                &ready_cycle)) {
+        cache->stats.useless_prefetches++;
+    }
+}
+
+/**
+ * @brief Installs a line into the cache unless it's already cached, and marks it as pending.
+ * Replacing a dirty line counts as a dirty write-back of the cache.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param cache Pointer to the Cache object.
+ * @param line The line number.
+ */
+static void issue_prefetch(Prefetcher *prefetcher, Cache *cache, const uint64_t line) {
+    // Predictions running past either end of the address space wrap around and are dropped
+    const uint64_t address = line << cache->log_line_size;
+    if (address >> cache->log_line_size != line || contains_cache_line(cache, address)) {
+        return;
+    }
+
+    install_cache_line(cache, address, false);
+    cache->stats.prefetches++;
+    retire_evicted_line(prefetcher, cache);
+
+    const uint64_t ready_cycle = prefetcher->clock + (uint64_t)cache->miss_penalty;
+    prefetcher->pending_lines[find_pending_slot(prefetcher, line + 1)] = (PrefetchPendingLine){line + 1, ready_cycle};
+}
+
+// --- Prediction Models ---
+
+/**
+ * @brief Fetches the lines following a triggering line.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param cache Pointer to the Cache object.
+ * @param line The triggering line number.
+ */
+static void prefetch_next_lines(Prefetcher *prefetcher, Cache *cache, const uint64_t line) {
+    for (int i = 0; i < prefetcher->degree; i++) {
+        issue_prefetch(prefetcher, cache, line + (uint64_t)(prefetcher->distance + i));
+    }
+}
+
+/**
+ * @brief Trains the stride of the region of an address and fetches along it once it repeats.
+ * A differing stride first lowers the confidence, so a single irregular access
+ * doesn't discard a stride that was seen many times.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param cache Pointer to the Cache object.
+ * @param address The accessed address.
+ */
+static void prefetch_stride(Prefetcher *prefetcher, Cache *cache, const uint64_t address) {
+    const uint64_t region = (address >> PREFETCH_REGION_SHIFT) + 1;
+    PrefetchStrideEntry *entry = &prefetcher->strides[region % PREFETCH_STRIDE_ENTRIES];
+    if (entry->region != region) {
+        *entry = (PrefetchStrideEntry){region, address, 0, 0};
+        return;
+    }
+
+    const int64_t stride = (int64_t)(address - entry->last_address);
+    if (stride == 0) {
+        return;
+    }
+    entry->last_address = address;
+    if (stride != entry->stride) {
+        if (entry->confidence > 0) {
+            entry->confidence--;
+        } else {
+            entry->stride = stride;
+        }
+        return;
+    }
+    if (entry->confidence < PREFETCH_STRIDE_MAX_CONFIDENCE) {
+        entry->confidence++;
+    }
+
+    // Consecutive steps of small strides fall into the same line, which is fetched once
+    uint64_t previous_line = address >> cache->log_line_size;
+    for (int i = 0; i < prefetcher->degree; i++) {
+        const uint64_t line = (address + (uint64_t)(stride * (prefetcher->distance + i))) >> cache->log_line_size;
+        if (line != previous_line) {
+            issue_prefetch(prefetcher, cache, line);
+            previous_line = line;
+        }
+    }
+}
+
+/**
+ * @brief Advances the stream buffer of a triggering line, or allocates a new one.
+ * An unconfirmed buffer takes the direction of the next trigger within
+ * PREFETCH_STREAM_WINDOW lines. A confirmed buffer accepts triggers ahead of
+ * its last line up to the window beyond its next line, and then fetches until
+ * it runs `distance` lines ahead of the trigger.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ * @param cache Pointer to the Cache object.
+ * @param line The triggering line number.
+ */
+static void prefetch_stream(Prefetcher *prefetcher, Cache *cache, const uint64_t line) {
+    PrefetchStream *stream = NULL;
+    PrefetchStream *victim = &prefetcher->streams[0];
+    for (int i = 0; i < PREFETCH_STREAMS && !stream; i++) {
+        PrefetchStream *candidate = &prefetcher->streams[i];
+        if (!candidate->is_valid) {
+            if (victim->is_valid) {
+                victim = candidate;
+            }
+            continue;
+        }
+        if (victim->is_valid && candidate->last_use < victim->last_use) {
+            victim = candidate;
+        }
+
+        const int64_t offset = (int64_t)(line - candidate->last_line);
+        if (candidate->direction == 0) {
+            if (offset != 0 && offset >= -PREFETCH_STREAM_WINDOW && offset <= PREFETCH_STREAM_WINDOW) {
+                candidate->direction = offset > 0 ? 1 : -1;
+                candidate->next_line = line;
+                stream = candidate;
+            }
+        } else {
+            const int64_t ahead = (int64_t)(candidate->next_line - candidate->last_line) * candidate->direction;
+            const int64_t advance = offset * candidate->direction;
+            if (advance > 0 && advance <= ahead + PREFETCH_STREAM_WINDOW) {
+                stream = candidate;
+            }
+        }
+    }
+
+    if (!stream) {
+        *victim = (PrefetchStream){line, line, 0, true, prefetcher->clock};
+        return;
+    }
+
+    const int direction = stream->direction;
+    stream->last_line = line;
+    stream->last_use = prefetcher->clock;
+    if ((int64_t)(stream->next_line - line) * direction <= 0) {
+        stream->next_line = line + (uint64_t)(int64_t)direction;
+    }
+    for (int i = 0; i < prefetcher->degree && (int64_t)(stream->next_line - line) * direction <= prefetcher->distance;
+         i++) {
+        issue_prefetch(prefetcher, cache, stream->next_line);
+        stream->next_line += (uint64_t)(int64_t)direction;
+    }
+}
+
+// --- Access Kernels ---
+
+/**
+ * @brief Simulates a demand access and lets the prefetcher react to its result.
+ * A hit to a pending line counts as a useful or late prefetch and, like a
+ * miss, triggers the next-line and stream models. The eviction record of the
+ * demand access is restored afterwards, so callers still see the line it
+ * replaced.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @return `true` if the demand access is a hit, `false` if it's a miss.
+ */
+static bool access_cache_prefetching(Cache *cache, const CacheOp *cache_op) {
+    Prefetcher *prefetcher = cache->prefetcher;
+    const bool is_hit = prefetcher->demand_access(cache, cache_op);
+    const CacheEviction eviction = cache->last_eviction;
+    const uint64_t line = cache_op->address >> cache->log_line_size;
+
+    bool is_trigger = !is_hit;
+    uint64_t ready_cycle;
+    if (!is_hit) {
+        retire_evicted_line(prefetcher, cache);
+        prefetcher->clock += (uint64_t)cache->miss_penalty;
+    } else if (take_pending_line(prefetcher, line, &ready_cycle)) {
+        // A late prefetch still saves the part of the miss penalty that elapsed since its issue
+        if (prefetcher->clock < ready_cycle) {
+            cache->stats.late_prefetches++;
+            cache->stats.prefetch_wait_cycles += ready_cycle - prefetcher->clock;
+            prefetcher->clock = ready_cycle;
+        } else {
+            cache->stats.useful_prefetches++;
+        }
+        is_trigger = true;
+    }
+    prefetcher->clock += (uint64_t)cache_op->instructions;
+
+    switch (prefetcher->policy) {
+        case PREFETCH_NEXT_LINE:
+            if (is_trigger) {
+                prefetch_next_lines(prefetcher, cache, line);
+            }
+            break;
+        case PREFETCH_STRIDE:
+            prefetch_stride(prefetcher, cache, cache_op->address);
+            break;
+        case PREFETCH_STREAM:
+            if (is_trigger) {
+                prefetch_stream(prefetcher, cache, line);
+            }
+            break;
+        case PREFETCH_NONE:
+            break;
+    }
+
+    cache->last_eviction = eviction;
+    return is_hit;
+}
+
+/**
+ * @brief Simulates a batch of demand accesses one by one through the prefetcher.
+ * Prefetches of an access can change the result of the next one, so the
+ * accesses can't be reordered like in the batch kernels of the cache.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param cache_ops Array of cache operations.
+ * @param num_ops Number of cache operations.
+ * @param hit_bitmap_out Bitmap receiving the hits, or `NULL` (see access_cache_batch).
+ * @return The number of hits in the batch.
+ */
+static size_t access_cache_prefetching_batch(Cache *cache, const CacheOp *cache_ops, const size_t num_ops,
+                                             uint8_t *hit_bitmap_out) {
+    if (hit_bitmap_out) {
+        memset(hit_bitmap_out, 0, (num_ops + 7) / 8);
+    }
+
+    size_t hits = 0;
+    for (size_t i = 0; i < num_ops; i++) {
+        if (access_cache_prefetching(cache, &cache_ops[i])) {
+            hits++;
+            if (hit_bitmap_out) {
+                hit_bitmap_out[i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+        }
+    }
+    return hits;
+}
+
+// --- Prefetcher Functions ---
+
+bool parse_prefetch_policy(const char *name, PrefetchPolicy *policy) {
+    for (int i = PREFETCH_NEXT_LINE; i <= PREFETCH_STREAM; i++) {
+        if (strcmp(name, prefetch_policy_names[i]) == 0) {
+            *policy = (PrefetchPolicy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* get_prefetch_policy_name(const PrefetchPolicy policy) {
+    return prefetch_policy_names[policy];
+}
+
+void attach_prefetcher(Cache *cache, const PrefetchOptions *options) {
+    Prefetcher *prefetcher = allocate_or_exit(1, sizeof(Prefetcher), "the prefetcher");
+    prefetcher->policy = options->policy;
+    prefetcher->degree = options->degree;
+    prefetcher->distance = options->distance;
+
+    // Every pending line is cached, so the set stays at most half full
+    const size_t num_lines = (size_t)cache->num_sampled_sets * cache->associativity;
+    prefetcher->capacity = 1;
+    while (prefetcher->capacity < num_lines * 2) {
+        prefetcher->capacity *= 2;
+    }
+    prefetcher->pending_lines = allocate_or_exit(prefetcher->capacity, sizeof(PrefetchPendingLine), "the prefetcher");
+
+    prefetcher->demand_access = cache->access_kernel;
+    cache->access_kernel = access_cache_prefetching;
+    cache->batch_kernel = access_cache_prefetching_batch;
+    cache->prefetcher = prefetcher;
+}
+
+void reset_prefetcher(Prefetcher *prefetcher) {
+    prefetcher->clock = 0;
+    memset(prefetcher->pending_lines, 0, prefetcher->capacity * sizeof(PrefetchPendingLine));
+    memset(prefetcher->strides, 0, sizeof(prefetcher->strides));
+    memset(prefetcher->streams, 0, sizeof(prefetcher->streams));
+}
+
+void free_prefetcher(Prefetcher *prefetcher) {
+    free(prefetcher->pending_lines);
+    free(prefetcher);
+}
@@ -0,0 +1,164 @@
+/***************************************************************************/
+/**
+ * @file prefetch.h
+ * @brief Header file for the hardware prefetcher models of the cache simulator.
+ *
+ * A prefetcher sits in front of a cache and observes every demand access with
+ * its result. From this stream it predicts lines that will be accessed soon and
+ * installs them into the cache ahead of time. Three models are provided:
+ *
+ * - next-line: a miss (or the first hit to a prefetched line) of line `L`
+ *   fetches the lines `L + distance` to `L + distance + degree - 1`.
+ * - stride: traces carry no program counters, so strides are detected per
+ *   address region. Once the same stride was seen twice in a row within a
+ *   region, every access fetches `degree` lines in steps of the stride,
+ *   starting `distance` strides ahead.
+ * - stream: a small set of stream buffers follows ascending or descending
+ *   sequences of misses. A confirmed stream runs ahead of its demand
+ *   accesses by up to `distance` lines and fetches at most `degree` lines per
+ *   trigger.
+ *
+ * Prefetched lines are installed into the cache itself, so they compete with
+ * demand lines, and replacing a dirty line counts as a regular dirty
+ * write-back. Every prefetched line is tracked until it is used or replaced:
+ * a demand hit before its fill could have completed (issue time plus the miss
+ * penalty on the clock of the CPI model) makes it late, a later demand hit
+ * makes it useful, and a replacement without any demand access makes it
+ * useless. A late hit waits for the rest of the fill, and these cycles are
+ * added to the CPI. The counts are kept in the CacheStats of the cache.
+ *
+ * The prefetcher is attached by wrapping the access kernels of the cache, so
+ * caches without a prefetcher don't pay anything for it.
+ ******************************************************************************/
+
+#ifndef PREFETCH_H_INCLUDED
+#define PREFETCH_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * @brief Defaults and sizes of the prefetchers.
+ */
+enum {
+    PREFETCH_DEFAULT_DEGREE = 1,        // Default number of lines fetched per trigger
+    PREFETCH_DEFAULT_DISTANCE = 1,      // Default distance of the first fetched line in lines (or strides)
+    PREFETCH_MAX_DEGREE = 64,           // Maximum number of lines fetched per trigger
+    PREFETCH_MAX_DISTANCE = 1024,       // Maximum distance in lines (or strides)
+    PREFETCH_REGION_SHIFT = 12,         // log2 of the size of a region of the stride prefetcher (4 KB)
+    PREFETCH_STRIDE_ENTRIES = 64,       // Number of regions tracked by the stride prefetcher
+    PREFETCH_STREAMS = 16,              // Number of stream buffers of the stream prefetcher
+    PREFETCH_STREAM_WINDOW = 16,        // Maximum distance in lines between two misses forming a stream
+};
+
+/**
+ * @brief Prediction model of a prefetcher.
+ */
+typedef enum PrefetchPolicy {
+    PREFETCH_NONE,          // No prefetching
+    PREFETCH_NEXT_LINE,     // Fetch the following lines on a miss
+    PREFETCH_STRIDE,        // Fetch ahead along the stride detected in an address region
+    PREFETCH_STREAM,        // Run ahead of ascending or descending miss streams
+} PrefetchPolicy;
+
+/**
+ * @brief Options of the prefetcher given on the command line.
+ */
+typedef struct PrefetchOptions {
+    PrefetchPolicy policy;  // Prediction model, PREFETCH_NONE to disable prefetching
+    int degree;             // Number of lines fetched per trigger
+    int distance;           // Distance of the first fetched line in lines (strides for PREFETCH_STRIDE)
+} PrefetchOptions;
+
+/**
+ * @brief Stride detected in an address region.
+ */
+typedef struct PrefetchStrideEntry {
+    uint64_t region;        // Region number + 1, 0 if the entry is unused
+    uint64_t last_address;  // Most recently accessed address of the region
+    int64_t stride;         // Predicted difference between consecutive addresses of the region
+    int confidence;         // Repetitions of the stride minus mismatches since (saturating), fetching starts at 1
+} PrefetchStrideEntry;
+
+/**
+ * @brief A stream buffer following a sequence of misses.
+ */
+typedef struct PrefetchStream {
+    uint64_t last_line;     // Most recently accessed line of the stream
+    uint64_t next_line;     // Next line to be fetched (confirmed streams only)
+    int direction;          // 1 for ascending, -1 for descending, 0 if not confirmed yet
+    bool is_valid;          // Indicates if the stream buffer is in use
+    uint64_t last_use;      // Clock of the last trigger, the least recently used buffer is replaced
+} PrefetchStream;
+
+/**
+ * @brief A prefetched line that hasn't been accessed yet.
+ */
+typedef struct PrefetchPendingLine {
+    uint64_t key;           // Line number + 1, 0 if the slot is empty
+    uint64_t ready_cycle;   // Clock at which the fill of the line completes
+} PrefetchPendingLine;
+
+/**
+ * @brief State of a prefetcher attached to a cache.
+ */
+typedef struct Prefetcher {
+    PrefetchPolicy policy;  // Prediction model
+    int degree;             // Number of lines fetched per trigger
+    int distance;           // Distance of the first fetched line
+    uint64_t clock;         // Cycles of the CPI model: instructions, miss penalties and waits of all demand accesses
+    PrefetchPendingLine *pending_lines; // Open-addressing hash table of the pending lines
+    size_t capacity;        // Number of slots of the pending set (power of two, at least twice the cache lines)
+    PrefetchStrideEntry strides[PREFETCH_STRIDE_ENTRIES];  // Strides of the tracked regions
+    PrefetchStream streams[PREFETCH_STREAMS];   // Stream buffers
+    CacheAccessKernel demand_access;    // Access kernel of the cache without the prefetcher
+} Prefetcher;
+
+/**
+ * @brief Looks up a prefetcher model by its name.
+ *
+ * @param name Name of the model ("next-line", "stride" or "stream").
+ * @param policy Pointer receiving the model.
+ * @return `true` if the name is known, `false` otherwise.
+ */
+bool parse_prefetch_policy(const char *name, PrefetchPolicy *policy);
+
+/**
+ * @brief Returns the name of a prefetcher model.
+ *
+ * @param policy The prefetcher model.
+ * @return The name of the model.
+ */
+const char* get_prefetch_policy_name(PrefetchPolicy policy);
+
+/**
+ * @brief Creates a prefetcher and attaches it to a cache.
+ * From now on, every access through access_cache, access_cache_batch or the
+ * warming functions also trains the prefetcher and may install prefetched
+ * lines. The cache owns the prefetcher and frees it in free_cache. A cache
+ * with a prefetcher is not split into partitions.
+ *
+ * @param cache Pointer to the Cache object.
+ * @param options Pointer to the PrefetchOptions object, its policy must not be PREFETCH_NONE.
+ */
+void attach_prefetcher(Cache *cache, const PrefetchOptions *options);
+
+/**
+ * @brief Clears the predictions and the pending lines of a prefetcher.
+ * Called by reset_cache, whose lines are gone.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ */
+void reset_prefetcher(Prefetcher *prefetcher);
+
+/**
+ * @brief Frees the memory allocated for a prefetcher.
+ *
+ * @param prefetcher Pointer to the Prefetcher object.
+ */
+void free_prefetcher(Prefetcher *prefetcher);
+
+#endif // PREFETCH_H_INCLUDED
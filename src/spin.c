@@ -0,0 +1,29 @@
+/***************************************************************************/
+/**
+ * @file spin.c
+ * @brief Implementation of the busy waiting of the worker threads of the cache
+ * simulator.
+ *
+ * This source file provides the implementation for the waiting defined in
+ * spin.h.
+ ******************************************************************************/
+
+#include <sched.h>
+#include "spin.h"
+
+/**
+ * @brief Number of polls that only pause the core before the waiting thread yields it.
+ */
+#define SPIN_PAUSE_POLLS 128
+
+// --- Waiting ---
+
+void wait_for_counter(unsigned *spins) {
+    if (++(*spins) < SPIN_PAUSE_POLLS) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        sched_yield();
+    }
+}
@@ -0,0 +1,34 @@
+/***************************************************************************/
+/**
+ * @file spin.h
+ * @brief Header file for the busy waiting of the worker threads of the cache
+ * simulator.
+ *
+ * The sweep and the multi-core simulation hand decoded records and requests
+ * between threads through rings of atomic counters. The counters are polled
+ * instead of waiting on condition variables, since the hand-offs are frequent
+ * and short. The counters of different threads live in separate host cache
+ * lines, so polling one doesn't slow down the thread updating another.
+ ******************************************************************************/
+
+#ifndef SPIN_H_INCLUDED
+#define SPIN_H_INCLUDED
+
+/**
+ * @brief Assumed size of a cache line of the host, used to avoid false sharing.
+ */
+enum {
+    HOST_CACHE_LINE = 64,
+};
+
+/**
+ * @brief Waits a little while polling an atomic counter.
+ * Spins briefly first and yields the core afterwards, so oversubscribed
+ * machines, including systems with more simulated cores than host cores, keep
+ * making progress.
+ *
+ * @param spins Pointer to the number of unsuccessful polls so far.
+ */
+void wait_for_counter(unsigned *spins);
+
+#endif // SPIN_H_INCLUDED
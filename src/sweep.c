@@ -0,0 +1,485 @@
+/***************************************************************************/
+/**
+ * @file sweep.c
+ * @brief Implementation of the multi-configuration sweep of the cache
+ * simulator.
+ *
+ * This source file provides the implementation for the sweep defined in
+ * sweep.h. Decoding the trace dominates the run time of small caches, so
+ * sharing one decoded batch between all configurations makes a sweep much
+ * cheaper than running one simulator process per configuration. The caches of
+ * a sweep are independent, which allows simulating them on separate threads
+ * without any synchronization besides the hand-off of decoded chunks. The
+ * same holds for the sets of a single cache, which partitioned simulations
+ * split between the workers.
+ ******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "sweep.h"
+#include "spin.h"
+
+/**
+ * @brief A decoded block of the trace shared read-only by all workers.
+ * A chunk with a count of 0 marks the end of the trace.
+ */
+typedef struct SweepChunk {
+    size_t count;                       // Number of valid records
+    long first_record;                  // Index of the first record in the trace
+    CacheOp ops[SWEEP_BATCH_SIZE];      // Decoded records
+} SweepChunk;
+
+/**
+ * @brief Sequence number padded to its own host cache line.
+ */
+typedef struct SweepCounter {
+    _Alignas(HOST_CACHE_LINE) atomic_size_t value;
+} SweepCounter;
+
+/**
+ * @brief Single-producer/multi-consumer ring in which every chunk is consumed by every worker.
+ */
+typedef struct SweepRing {
+    SweepChunk *chunks;         // SWEEP_RING_SIZE chunks
+    SweepCounter published;     // Number of chunks published by the reader
+    SweepCounter *consumed;     // Number of chunks consumed, one counter per worker
+    int num_workers;            // Number of consuming workers
+    const TraceSampling *sampling;  // Selection of the measured records
+} SweepRing;
+
+/**
+ * @brief State of a worker thread.
+ */
+typedef struct SweepWorker {
+    pthread_t thread;       // Handle of the thread
+    int index;              // Index of the worker, selects its configurations and its counter
+    int cpu;                // Core the worker is pinned to, `-1` to leave it unpinned
+    SweepRing *ring;        // Ring shared with the reader
+    SweepPoint *points;     // All sweep points
+    int num_points;         // Number of sweep points
+    int first_set;          // First set of the partition simulated by the worker (partitioned simulations)
+    int end_set;            // One past the last set of the partition
+    CacheOp *selected_ops;  // Records of a chunk accessing the partition, NULL for sweeps
+} SweepWorker;
+
+// --- Helper Functions ---
+
+/**
+ * @brief Simulates a batch of records for a single sweep point.
+ *
+ * @param point Pointer to the SweepPoint object.
+ * @param batch Array of decoded records.
+ * @param batch_size Number of records in the batch.
+ */
+static void simulate_sweep_batch(SweepPoint *point, const CacheOp *batch, const size_t batch_size) {
+    Cache *cache = point->cache;
+    uint8_t hit_bitmap[SWEEP_BATCH_SIZE / 8];
+    const size_t hit_count = access_cache_batch(cache, batch, batch_size, point->classifier ? hit_bitmap : NULL);
+    point->cycle_count += (uint64_t)(batch_size - hit_count) * cache->miss_penalty;
+    if (point->classifier) {
+        classify_cache_batch(point->classifier, batch, batch_size, hit_bitmap);
+    }
+}
+
+/**
+ * @brief Simulates a chunk of records for a single sweep point.
+ * Records outside the measured phases of the trace sampling only warm the cache.
+ *
+ * @param point Pointer to the SweepPoint object.
+ * @param batch Array of decoded records.
+ * @param batch_size Number of records in the batch.
+ * @param first_record Index of the first record of the batch in the trace.
+ * @param sampling Pointer to the TraceSampling object.
+ */
+static void simulate_sweep_chunk(SweepPoint *point, const CacheOp *batch, const size_t batch_size,
+                                 const long first_record, const TraceSampling *sampling) {
+    for (size_t start = 0; start < batch_size;) {
+        bool is_measured;
+        const long phase = get_sampling_phase(sampling, first_record + (long)start, &is_measured);
+        const size_t count = (size_t)phase < batch_size - start ? (size_t)phase : batch_size - start;
+
+        if (is_measured) {
+            simulate_sweep_batch(point, &batch[start], count);
+        } else {
+            warm_cache_batch(point->cache, &batch[start], count);
+            if (point->classifier) {
+                warm_classifier_batch(point->classifier, &batch[start], count);
+            }
+        }
+        start += count;
+    }
+}
+
+/**
+ * @brief Simulates the records of a chunk that access the partition of a worker.
+ * The records are selected per phase of the trace sampling, so each phase is
+ * simulated as one batch.
+ *
+ * @param worker Pointer to the SweepWorker object owning the partition.
+ * @param point Pointer to the SweepPoint object of the partition.
+ * @param batch Array of decoded records.
+ * @param batch_size Number of records in the batch.
+ * @param first_record Index of the first record of the batch in the trace.
+ * @param sampling Pointer to the TraceSampling object.
+ */
+static void simulate_partition_chunk(SweepWorker *worker, SweepPoint *point, const CacheOp *batch,
+                                     const size_t batch_size, const long first_record,
+                                     const TraceSampling *sampling) {
+    for (size_t start = 0; start < batch_size;) {
+        bool is_measured;
+        const long phase = get_sampling_phase(sampling, first_record + (long)start, &is_measured);
+        const size_t count = (size_t)phase < batch_size - start ? (size_t)phase : batch_size - start;
+
+        const size_t num_selected = select_cache_partition(point->cache, &batch[start], count, worker->first_set,
+                                                           worker->end_set, worker->selected_ops);
+        if (is_measured) {
+            simulate_sweep_batch(point, worker->selected_ops, num_selected);
+        } else {
+            warm_cache_batch(point->cache, worker->selected_ops, num_selected);
+        }
+        start += count;
+    }
+}
+
+/**
+ * @brief Adds the measured records of a batch to the trace statistics.
+ *
+ * @param trace_stats Pointer to the TraceStats object.
+ * @param batch Array of decoded records.
+ * @param batch_size Number of records in the batch.
+ * @param first_record Index of the first record of the batch in the trace.
+ * @param sampling Pointer to the TraceSampling object.
+ */
+static void update_sweep_stats(TraceStats *trace_stats, const CacheOp *batch, const size_t batch_size,
+                               const long first_record, const TraceSampling *sampling) {
+    for (size_t i = 0; i < batch_size;) {
+        bool is_measured;
+        const long phase = get_sampling_phase(sampling, first_record + (long)i, &is_measured);
+        const size_t end = (size_t)phase < batch_size - i ? i + (size_t)phase : batch_size;
+
+        if (is_measured) {
+            for (size_t j = i; j < end; j++) {
+                update_trace_stats(trace_stats, &batch[j]);
+            }
+        }
+        i = end;
+    }
+}
+
+/**
+ * @brief Entry point of a worker thread.
+ * Consumes every chunk of the ring and simulates it for the sweep points
+ * owned by the worker (every `num_workers`-th point), or for the partition
+ * of the worker in a partitioned simulation.
+ *
+ * @param arg Pointer to the SweepWorker object.
+ * @return Always `NULL`.
+ */
+static void* run_sweep_worker(void *arg) {
+    SweepWorker *worker = (SweepWorker *)arg;
+    SweepRing *ring = worker->ring;
+    atomic_size_t *consumed = &ring->consumed[worker->index].value;
+
+#ifdef __linux__
+    if (worker->cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(worker->cpu, &cpu_set);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+#endif
+
+    for (size_t sequence = 0;; sequence++) {
+        // Wait until the reader has published the next chunk
+        unsigned spins = 0;
+        while (atomic_load_explicit(&ring->published.value, memory_order_acquire) <= sequence) {
+            wait_for_counter(&spins);
+        }
+
+        const SweepChunk *chunk = &ring->chunks[sequence % SWEEP_RING_SIZE];
+        const size_t count = chunk->count;
+        if (worker->selected_ops) {
+            simulate_partition_chunk(worker, &worker->points[worker->index], chunk->ops, count,
+                                     chunk->first_record, ring->sampling);
+        } else {
+            for (int p = worker->index; p < worker->num_points; p += ring->num_workers) {
+                simulate_sweep_chunk(&worker->points[p], chunk->ops, count, chunk->first_record, ring->sampling);
+            }
+        }
+
+        // Hand the slot back to the reader
+        atomic_store_explicit(consumed, sequence + 1, memory_order_release);
+        if (count == 0) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * @brief Collects the cores the process may run on.
+ *
+ * @param cpus Array receiving the core numbers.
+ * @param max_cpus Capacity of `cpus`.
+ * @return The number of cores, `0` if they can't be determined.
+ */
+static int get_allowed_cpus(int *cpus, const int max_cpus) {
+    int num_cpus = 0;
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE && num_cpus < max_cpus; cpu++) {
+            if (CPU_ISSET(cpu, &cpu_set)) {
+                cpus[num_cpus++] = cpu;
+            }
+        }
+    }
+#else
+    (void)cpus;
+    (void)max_cpus;
+#endif
+    return num_cpus;
+}
+
+/**
+ * @brief Simulates all sweep points with one reader and several worker threads.
+ *
+ * @param points Array of sweep points with initialized caches.
+ * @param num_points Number of sweep points.
+ * @param reader Pointer to the TraceReader object of the open trace.
+ * @param trace_stats Structure receiving the trace statistics shared by all points.
+ * @param sampling Pointer to the TraceSampling object.
+ * @param num_workers Number of worker threads.
+ * @param set_bounds First set of the partition of every worker and the end of the last one (`num_workers + 1`
+ *        entries), NULL for a sweep. In a partitioned simulation, worker `w` simulates point `w`.
+ */
+static void simulate_sweep_parallel(SweepPoint *points, const int num_points, TraceReader *reader,
+                                    TraceStats *trace_stats, const TraceSampling *sampling, const int num_workers,
+                                    const int *set_bounds) {
+    SweepRing ring;
+    ring.num_workers = num_workers;
+    ring.sampling = sampling;
+    ring.chunks = allocate_or_exit(SWEEP_RING_SIZE, sizeof(SweepChunk), "sweep workers");
+    ring.consumed = (SweepCounter *)aligned_alloc(HOST_CACHE_LINE, num_workers * sizeof(SweepCounter));
+    if (!ring.consumed) {
+        fprintf(stderr, "Failed to allocate memory for sweep workers.\n");
+        exit(EXIT_FAILURE);
+    }
+    SweepWorker *workers = allocate_or_exit(num_workers, sizeof(SweepWorker), "sweep workers");
+    int *cpus = allocate_or_exit(num_workers + 1, sizeof(int), "sweep workers");
+
+    atomic_init(&ring.published.value, 0);
+    for (int w = 0; w < num_workers; w++) {
+        atomic_init(&ring.consumed[w].value, 0);
+    }
+
+    // Leave the first core to the reader if there are enough of them
+    const int num_cpus = get_allowed_cpus(cpus, num_workers + 1);
+    const int first_cpu = num_cpus > num_workers ? 1 : 0;
+
+    for (int w = 0; w < num_workers; w++) {
+        workers[w].index = w;
+        workers[w].cpu = num_cpus > 0 ? cpus[(first_cpu + w) % num_cpus] : -1;
+        workers[w].ring = &ring;
+        workers[w].points = points;
+        workers[w].num_points = num_points;
+        workers[w].first_set = set_bounds ? set_bounds[w] : 0;
+        workers[w].end_set = set_bounds ? set_bounds[w + 1] : 0;
+        workers[w].selected_ops = NULL;
+        if (set_bounds) {
+            workers[w].selected_ops = allocate_or_exit(SWEEP_BATCH_SIZE, sizeof(CacheOp), "sweep workers");
+        }
+        if (pthread_create(&workers[w].thread, NULL, run_sweep_worker, &workers[w]) != 0) {
+            fprintf(stderr, "Failed to create sweep worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Decode the trace into the ring until the end marker has been published
+    size_t count = SWEEP_BATCH_SIZE;
+    long record = 0;
+    for (size_t sequence = 0; count > 0; sequence++) {
+        // Wait until every worker is done with the slot that is about to be reused
+        if (sequence >= SWEEP_RING_SIZE) {
+            for (int w = 0; w < num_workers; w++) {
+                unsigned spins = 0;
+                while (atomic_load_explicit(&ring.consumed[w].value, memory_order_acquire)
+                       <= sequence - SWEEP_RING_SIZE) {
+                    wait_for_counter(&spins);
+                }
+            }
+        }
+
+        SweepChunk *chunk = &ring.chunks[sequence % SWEEP_RING_SIZE];
+        count = read_trace_batch(reader, chunk->ops, SWEEP_BATCH_SIZE);
+        chunk->count = count;
+        chunk->first_record = record;
+        update_sweep_stats(trace_stats, chunk->ops, count, record, sampling);
+        record += (long)count;
+
+        atomic_store_explicit(&ring.published.value, sequence + 1, memory_order_release);
+    }
+
+    for (int w = 0; w < num_workers; w++) {
+        pthread_join(workers[w].thread, NULL);
+        free(workers[w].selected_ops);
+    }
+
+    free(cpus);
+    free(workers);
+    free(ring.consumed);
+    free(ring.chunks);
+}
+
+// --- Sweep Simulation ---
+
+void simulate_sweep(SweepPoint *points, const int num_points, const char *trace_file, TraceStats *trace_stats,
+                    const TraceSampling *sampling, int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (num_threads > num_points) {
+        num_threads = num_points; // Every worker owns at least one configuration
+    }
+
+    TraceReader *reader = open_trace(trace_file);
+
+    if (num_threads > 1) {
+        simulate_sweep_parallel(points, num_points, reader, trace_stats, sampling, num_threads, NULL);
+    } else {
+        CacheOp *batch = allocate_or_exit(SWEEP_BATCH_SIZE, sizeof(CacheOp), "sweep batch");
+
+        // Decode the trace once and feed every batch to all caches
+        size_t batch_size;
+        long record = 0;
+        while ((batch_size = read_trace_batch(reader, batch, SWEEP_BATCH_SIZE)) > 0) {
+            update_sweep_stats(trace_stats, batch, batch_size, record, sampling);
+            for (int p = 0; p < num_points; p++) {
+                simulate_sweep_chunk(&points[p], batch, batch_size, record, sampling);
+            }
+            record += (long)batch_size;
+        }
+
+        free(batch);
+    }
+
+    close_trace(reader);
+
+    // Add the instructions and the penalties of the writes to memory to every point
+    for (int p = 0; p < num_points; p++) {
+        const Cache *cache = points[p].cache;
+        const uint64_t store_writes = get_memory_writes(cache) - get_dirty_write_backs(cache);
+        if (cache->sample_rate > 1) {
+            // Only the sampled sets were simulated, so the penalties follow from the extrapolated counts
+            const CacheSampleEstimate estimate = estimate_sampled_stats(cache);
+            const uint64_t memory_writes = (uint64_t)(estimate.dirty_write_backs + 0.5)
+                                           + store_writes * (uint64_t)cache->sample_rate;
+            points[p].cycle_count = trace_stats->instruction_count
+                                    + (uint64_t)(estimate.misses + 0.5) * cache->miss_penalty
+                                    + memory_writes * cache->dirty_wb_penalty;
+            continue;
+        }
+        points[p].cycle_count += trace_stats->instruction_count;
+        points[p].cycle_count += get_memory_writes(cache) * cache->dirty_wb_penalty;
+    }
+}
+
+// --- Partitioned Simulation ---
+
+void simulate_partitioned(Cache *cache, const char *trace_file, TraceStats *trace_stats,
+                          const TraceSampling *sampling, int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    const int max_partitions = get_max_cache_partitions(cache);
+    if (num_threads > max_partitions) {
+        num_threads = max_partitions; // Every worker owns at least one set
+    }
+
+    // Split the simulated sets into ranges of (almost) equal size
+    SweepPoint *points = allocate_or_exit(num_threads, sizeof(SweepPoint), "cache partitions");
+    int *set_bounds = allocate_or_exit(num_threads + 1, sizeof(int), "cache partitions");
+    for (int w = 0; w <= num_threads; w++) {
+        set_bounds[w] = (int)((int64_t)cache->num_sampled_sets * w / num_threads);
+    }
+    for (int w = 0; w < num_threads; w++) {
+        points[w].cache = w == 0 ? cache : initialize_cache_partition(cache, w);
+        points[w].cycle_count = 0;
+        points[w].classifier = NULL;
+    }
+
+    TraceReader *reader = open_trace(trace_file);
+    simulate_sweep_parallel(points, num_threads, reader, trace_stats, sampling, num_threads, set_bounds);
+    close_trace(reader);
+
+    trace_stats->cycle_count = trace_stats->instruction_count;
+    for (int w = 0; w < num_threads; w++) {
+        trace_stats->cycle_count += points[w].cycle_count;
+        if (w > 0) {
+            merge_cache_partition(cache, points[w].cache);
+        }
+    }
+
+    free(set_bounds);
+    free(points);
+}
+
+// --- Sweep Output ---
+
+void print_sweep_results(const SweepPoint *points, const int num_points, const TraceStats *trace_stats) {
+    // All points share the sample rate, the write policy, the sectors and the classification, sampled sweeps get an
+    // extra column with the confidence intervals
+    const bool is_sampled = points[0].cache->sample_rate > 1;
+    const bool has_write_traffic = points[0].cache->write_policy != WRITE_BACK_ALLOCATE
+                                   || points[0].cache->sector_masks;
+    double classifier_error = 0;
+
+    printf(is_sampled ? "CACHE SWEEP RESULTS (EXTRAPOLATED, 95%% CONFIDENCE)\n" : "CACHE SWEEP RESULTS\n");
+    printf("%6s %9s %7s %12s %12s %11s %12s %12s %9s", "Assoc", "Size(KB)", "Line(B)", "Hits", "Misses",
+           "Miss Rate", "Dirty WBs", "Cycles", "CPI");
+    if (has_write_traffic) {
+        printf(" %12s %14s", "Mem Writes", "Mem Bytes");
+    }
+    if (points[0].classifier) {
+        printf(" %12s %12s %12s", "Compulsory", "Capacity", "Conflict");
+    }
+    printf(is_sampled ? " %11s\n" : "\n", "+- MR");
+
+    for (int p = 0; p < num_points; p++) {
+        const Cache *cache = points[p].cache;
+        const CacheSampleEstimate estimate = estimate_sampled_stats(cache);
+        const uint64_t cache_miss_count = (uint64_t)(estimate.misses + 0.5);
+        const float miss_rate = (float) cache_miss_count / trace_stats->memory_access_count;
+
+        printf("%6d %9d %7d %12" PRIu64 " %12" PRIu64 " %10.5f%% %12" PRIu64 " %12" PRIu64 " %9.5f",
+               cache->associativity, cache->cache_size, cache->line_size,
+               trace_stats->memory_access_count - cache_miss_count, cache_miss_count, miss_rate * 100,
+               (uint64_t)(estimate.dirty_write_backs + 0.5), points[p].cycle_count,
+               (float) points[p].cycle_count / trace_stats->instruction_count);
+        if (has_write_traffic) {
+            const uint64_t scale = (uint64_t)cache->sample_rate;
+            printf(" %12" PRIu64 " %14" PRIu64, get_memory_writes(cache) * scale, get_memory_write_bytes(cache) * scale);
+        }
+        if (points[p].classifier) {
+            const MissClassStats *classes = &points[p].classifier->stats;
+            printf(" %12" PRIu64 " %12" PRIu64 " %12" PRIu64, classes->compulsory, classes->capacity,
+                   classes->conflict);
+            const double error = estimate_classifier_error(points[p].classifier);
+            classifier_error = error > classifier_error ? error : classifier_error;
+        }
+        if (is_sampled) {
+            printf(" %10.5f%%", estimate.misses_error / trace_stats->memory_access_count * 100);
+        }
+        printf("\n");
+    }
+    if (points[0].classifier) {
+        printf("\nLargest Filter Error: %.5f%% of the compulsory misses may count as capacity misses\n",
+               classifier_error * 100);
+    }
+}
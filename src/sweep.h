@@ -0,0 +1,86 @@
+/***************************************************************************/
+/**
+ * @file sweep.h
+ * @brief Header file for the multi-configuration sweep of the cache simulator.
+ *
+ * A sweep simulates several independent cache configurations over the same
+ * trace. The trace is decoded only once; every decoded batch of CacheOp
+ * records is fed to all caches before the next batch is read.
+ *
+ * With more than one thread, the calling thread only decodes the trace into a
+ * ring of read-only chunks. Worker threads, each pinned to a core, simulate a
+ * fixed subset of the configurations and consume every chunk of the ring. The
+ * ring is lock-free: the reader publishes chunks through an atomic sequence
+ * number and every worker acknowledges consumed chunks through its own one.
+ *
+ * The same ring simulates a single large cache in parallel. The sets are split
+ * into one partition of consecutive sets per worker, and every worker only
+ * simulates the records of a chunk that access its own sets.
+ ******************************************************************************/
+
+#ifndef SWEEP_H_INCLUDED
+#define SWEEP_H_INCLUDED
+
+#include "cache.h"
+#include "classify.h"
+#include "trace.h"
+
+/**
+ * @brief Number of records decoded per batch.
+ */
+enum {
+    SWEEP_BATCH_SIZE = 4096,
+    SWEEP_RING_SIZE = 16,   // Number of chunks in flight between reader and workers
+};
+
+/**
+ * @brief A single cache configuration of a sweep and its results.
+ */
+typedef struct SweepPoint {
+    Cache *cache;       // Cache simulated for this configuration
+    uint64_t cycle_count;   // Number of cycles spent with this configuration
+    MissClassifier *classifier; // Classifier of the misses of the cache, NULL if they aren't classified
+} SweepPoint;
+
+/**
+ * @brief Simulates all sweep points over the given trace file.
+ *
+ * @param points Array of sweep points with initialized caches and, optionally, classifiers.
+ * @param num_points Number of sweep points.
+ * @param trace_file The path to the trace file to be processed.
+ * @param trace_stats Structure receiving the trace statistics of the measured records, shared by all points.
+ * @param sampling Pointer to the TraceSampling object selecting the measured records.
+ * @param num_threads Number of worker threads, `0` for one per online core.
+ */
+void simulate_sweep(SweepPoint *points, int num_points, const char *trace_file, TraceStats *trace_stats,
+                    const TraceSampling *sampling, int num_threads);
+
+/**
+ * @brief Simulates a single cache over the given trace file with one thread per partition of its sets.
+ * The statistics of all partitions are merged into `cache` afterwards. They
+ * match a serial simulation exactly, except for the random and BRRIP
+ * policies, whose partitions draw from separate random number generators.
+ *
+ * @param cache Pointer to the Cache object, split into at most get_max_cache_partitions partitions.
+ * @param trace_file The path to the trace file to be processed.
+ * @param trace_stats Structure receiving the trace statistics of the measured records. The cycle count includes the
+ *        instructions and the miss penalties but not the dirty write-back penalties.
+ * @param sampling Pointer to the TraceSampling object selecting the measured records.
+ * @param num_threads Number of worker threads, `0` for one per online core.
+ */
+void simulate_partitioned(Cache *cache, const char *trace_file, TraceStats *trace_stats,
+                          const TraceSampling *sampling, int num_threads);
+
+/**
+ * @brief Prints a table with one row of results per sweep point.
+ * If the points classify their misses, the table has a column per class.
+ * Points with a non-default write policy or sectored lines get columns with
+ * their writes to memory and the bytes written.
+ *
+ * @param points Array of simulated sweep points.
+ * @param num_points Number of sweep points.
+ * @param trace_stats Trace statistics shared by all points.
+ */
+void print_sweep_results(const SweepPoint *points, int num_points, const TraceStats *trace_stats);
+
+#endif // SWEEP_H_INCLUDED
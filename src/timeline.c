@@ -0,0 +1,235 @@
+/***************************************************************************/
+/**
+ * @file timeline.c
+ * @brief Implementation of the interval statistics time series of the cache
+ * simulator.
+ *
+ * This source file provides the implementation for the timeline defined in
+ * timeline.h. The hit, miss, write-back and memory write counts of an interval
+ * are the differences of the cache statistics between its boundaries, so
+ * recording an access only counts the access, its instructions and the bit of
+ * its line.
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "timeline.h"
+
+/**
+ * @brief Multiplier of the hash selecting the bit of a line (2^64 / golden ratio).
+ */
+#define TIMELINE_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+// --- Helper Functions ---
+
+/**
+ * @brief Returns the size of the working set bitmap of a timeline in bytes.
+ *
+ * @param timeline Pointer to the Timeline object.
+ * @return The size of the bitmap in bytes.
+ */
+static size_t get_bitmap_size(const Timeline *timeline) {
+    return ((size_t)1 << timeline->log_bitmap_bits) / 8;
+}
+
+/**
+ * @brief Estimates the number of distinct lines of an interval from its bitmap (linear counting).
+ *
+ * @param timeline Pointer to the Timeline object.
+ * @return The estimated number of distinct lines.
+ */
+static uint64_t estimate_working_set(const Timeline *timeline) {
+    const size_t num_words = get_bitmap_size(timeline) / sizeof(uint64_t);
+    const double num_bits = (double)((size_t)1 << timeline->log_bitmap_bits);
+
+    uint64_t set_bits = 0;
+    for (size_t i = 0; i < num_words; i++) {
+        set_bits += (uint64_t)__builtin_popcountll(timeline->bitmap[i]);
+    }
+
+    // A full bitmap only bounds the working set, report the largest estimate it can express
+    const double clear_bits = num_bits - (double)set_bits;
+    return (uint64_t)(num_bits * log(num_bits / (clear_bits > 0 ? clear_bits : 1)) + 0.5);
+}
+
+/**
+ * @brief Completes the current interval, queues it for the writer and starts the next one.
+ * Waits if the queue is full, which only happens if the file is written much
+ * slower than the intervals are simulated.
+ *
+ * @param timeline Pointer to the Timeline object.
+ * @param cache Pointer to the simulated Cache object.
+ */
+static void finish_timeline_interval(Timeline *timeline, const Cache *cache) {
+    TimelineInterval *interval = &timeline->current;
+    interval->misses = (cache->stats.misses - timeline->start_stats.misses) * (uint64_t)timeline->sample_rate;
+    interval->dirty_write_backs = (cache->stats.dirty_write_backs - timeline->start_stats.dirty_write_backs)
+                                  * (uint64_t)timeline->sample_rate;
+    interval->prefetch_wait_cycles = (cache->stats.prefetch_wait_cycles - timeline->start_stats.prefetch_wait_cycles)
+                                     * (uint64_t)timeline->sample_rate;
+    interval->working_set_lines = estimate_working_set(timeline);
+
+    // The stores pending in the write-combining buffer count as written, like in the totals
+    interval->memory_writes = (get_memory_writes(cache) - timeline->start_memory_writes)
+                              * (uint64_t)timeline->sample_rate;
+    interval->memory_write_bytes = (get_memory_write_bytes(cache) - timeline->start_memory_write_bytes)
+                                   * (uint64_t)timeline->sample_rate;
+
+    pthread_mutex_lock(&timeline->lock);
+    while (timeline->queued_count - timeline->written_count >= TIMELINE_QUEUE_SIZE) {
+        pthread_cond_wait(&timeline->changed, &timeline->lock);
+    }
+    timeline->queue[timeline->queued_count % TIMELINE_QUEUE_SIZE] = *interval;
+    timeline->queued_count++;
+    pthread_cond_signal(&timeline->changed);
+    pthread_mutex_unlock(&timeline->lock);
+
+    const uint64_t first_access = interval->first_access + interval->accesses;
+    *interval = (TimelineInterval){first_access, 0, 0, 0, 0, 0, 0, 0, 0};
+    timeline->start_stats = cache->stats;
+    timeline->start_memory_writes = get_memory_writes(cache);
+    timeline->start_memory_write_bytes = get_memory_write_bytes(cache);
+    memset(timeline->bitmap, 0, get_bitmap_size(timeline));
+}
+
+/**
+ * @brief Writes one interval as a line of the CSV file.
+ *
+ * @param timeline Pointer to the Timeline object.
+ * @param index Index of the interval.
+ * @param interval Pointer to the TimelineInterval object.
+ */
+static void write_timeline_interval(const Timeline *timeline, const uint64_t index,
+                                    const TimelineInterval *interval) {
+    const uint64_t misses = interval->misses < interval->accesses ? interval->misses : interval->accesses;
+    const uint64_t cycles = interval->instructions + interval->misses * (uint64_t)timeline->miss_penalty
+                            + interval->memory_writes * (uint64_t)timeline->dirty_wb_penalty
+                            + interval->prefetch_wait_cycles;
+    const double miss_rate = interval->accesses > 0 ? (double)misses / interval->accesses : 0.0;
+    const double cpi = interval->instructions > 0 ? (double)cycles / interval->instructions : 0.0;
+
+    fprintf(timeline->file, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+            ",%" PRIu64 ",%.6f,%.5f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+            index, interval->first_access, interval->accesses, interval->instructions, interval->accesses - misses,
+            interval->misses, interval->dirty_write_backs, cycles, miss_rate, cpi,
+            interval->working_set_lines * (uint64_t)timeline->line_size, interval->memory_writes,
+            interval->memory_write_bytes);
+}
+
+/**
+ * @brief Entry point of the writer thread.
+ * Writes queued intervals in order until the timeline is closed and the queue is empty.
+ *
+ * @param arg Pointer to the Timeline object.
+ * @return Always `NULL`.
+ */
+static void* run_timeline_writer(void *arg) {
+    Timeline *timeline = (Timeline *)arg;
+
+    pthread_mutex_lock(&timeline->lock);
+    for (;;) {
+        while (timeline->written_count == timeline->queued_count && !timeline->is_closed) {
+            pthread_cond_wait(&timeline->changed, &timeline->lock);
+        }
+        if (timeline->written_count == timeline->queued_count) {
+            break; // Closed and drained
+        }
+
+        // Format the interval without holding the lock, its slot isn't reused before it is released
+        const uint64_t index = timeline->written_count;
+        const TimelineInterval *interval = &timeline->queue[index % TIMELINE_QUEUE_SIZE];
+        pthread_mutex_unlock(&timeline->lock);
+        write_timeline_interval(timeline, index, interval);
+        pthread_mutex_lock(&timeline->lock);
+
+        timeline->written_count++;
+        pthread_cond_signal(&timeline->changed);
+    }
+    pthread_mutex_unlock(&timeline->lock);
+    return NULL;
+}
+
+// --- Timeline Functions ---
+
+Timeline* open_timeline(const TimelineOptions *options, const Cache *cache) {
+    Timeline *timeline = allocate_or_exit(1, sizeof(Timeline), "timeline");
+
+    // About two bits per access of an interval keep the estimate accurate
+    timeline->log_bitmap_bits = TIMELINE_MIN_LOG_BITMAP_BITS;
+    while (timeline->log_bitmap_bits < TIMELINE_MAX_LOG_BITMAP_BITS
+           && ((uint64_t)1 << timeline->log_bitmap_bits) < 2 * options->interval_length) {
+        timeline->log_bitmap_bits++;
+    }
+    timeline->bitmap = allocate_or_exit(1, get_bitmap_size(timeline), "timeline");
+    timeline->queue = allocate_or_exit(TIMELINE_QUEUE_SIZE, sizeof(TimelineInterval), "timeline");
+
+    timeline->file = fopen(options->path, "w");
+    if (timeline->file == NULL) {
+        perror("Failed to open timeline file");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(timeline->file, "interval,first_access,accesses,instructions,hits,misses,dirty_write_backs,cycles,"
+            "miss_rate,cpi,working_set_bytes,memory_writes,memory_write_bytes\n");
+
+    timeline->options = *options;
+    timeline->miss_penalty = cache->miss_penalty;
+    timeline->dirty_wb_penalty = cache->dirty_wb_penalty;
+    timeline->line_size = cache->line_size;
+    timeline->log_line_size = cache->log_line_size;
+    timeline->sample_rate = cache->sample_rate;
+    timeline->current = (TimelineInterval){0, 0, 0, 0, 0, 0, 0, 0, 0};
+    timeline->start_stats = cache->stats;
+    timeline->start_memory_writes = get_memory_writes(cache);
+    timeline->start_memory_write_bytes = get_memory_write_bytes(cache);
+    timeline->queued_count = 0;
+    timeline->written_count = 0;
+    timeline->is_closed = false;
+    pthread_mutex_init(&timeline->lock, NULL);
+    pthread_cond_init(&timeline->changed, NULL);
+
+    if (pthread_create(&timeline->writer, NULL, run_timeline_writer, timeline) != 0) {
+        fprintf(stderr, "Failed to create timeline writer thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    return timeline;
+}
+
+void record_timeline_access(Timeline *timeline, const Cache *cache, const CacheOp *cache_op) {
+    TimelineInterval *interval = &timeline->current;
+    interval->accesses++;
+    interval->instructions += (uint64_t)cache_op->instructions;
+
+    const uint64_t line = cache_op->address >> timeline->log_line_size;
+    const uint64_t bit = (line * TIMELINE_HASH_MULTIPLIER) >> (64 - timeline->log_bitmap_bits);
+    timeline->bitmap[bit / 64] |= 1ULL << (bit % 64);
+
+    const uint64_t progress = timeline->options.counts_instructions ? interval->instructions : interval->accesses;
+    if (progress >= timeline->options.interval_length) {
+        finish_timeline_interval(timeline, cache);
+    }
+}
+
+void close_timeline(Timeline *timeline, const Cache *cache) {
+    if (timeline->current.accesses > 0) {
+        finish_timeline_interval(timeline, cache);
+    }
+
+    pthread_mutex_lock(&timeline->lock);
+    timeline->is_closed = true;
+    pthread_cond_signal(&timeline->changed);
+    pthread_mutex_unlock(&timeline->lock);
+    pthread_join(timeline->writer, NULL);
+
+    if (fclose(timeline->file) != 0) {
+        perror("Failed to write timeline file");
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_destroy(&timeline->lock);
+    pthread_cond_destroy(&timeline->changed);
+    free(timeline->queue);
+    free(timeline->bitmap);
+    free(timeline);
+}
@@ -0,0 +1,125 @@
+/***************************************************************************/
+/**
+ * @file timeline.h
+ * @brief Header file for the interval statistics time series of the cache
+ * simulator.
+ *
+ * A timeline splits the measured records of a trace into intervals of a fixed
+ * number of accesses or instructions. For every interval, the hits, misses,
+ * dirty write-backs, cycles and an estimate of the working set are written as
+ * one line of a CSV file, which shows the phases of a program that hurt the
+ * cache.
+ *
+ * The simulation loop only accumulates the counts of the current interval.
+ * Completed intervals are handed to a background writer thread through a
+ * queue, so formatting and writing the file never stall the simulation.
+ *
+ * The working set is the number of distinct lines accessed in an interval. It
+ * is estimated by linear counting: every line sets one bit of a bitmap chosen
+ * by a hash of its address, and the number of distinct lines follows from the
+ * fraction of bits that are still clear. The bitmap has about twice as many
+ * bits as an interval has accesses, so clearing it stays cheap for short
+ * intervals.
+ ******************************************************************************/
+
+#ifndef TIMELINE_H_INCLUDED
+#define TIMELINE_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "cache.h"
+
+/**
+ * @brief Sizes of the timeline buffers.
+ */
+enum {
+    TIMELINE_QUEUE_SIZE = 1024,         // Number of completed intervals waiting for the writer
+    TIMELINE_MIN_LOG_BITMAP_BITS = 10,  // log2 of the smallest number of bits of the working set bitmap
+    TIMELINE_MAX_LOG_BITMAP_BITS = 20,  // log2 of the largest number of bits of the working set bitmap
+    TIMELINE_DEFAULT_INTERVAL = 100000, // Default number of accesses per interval
+};
+
+/**
+ * @brief Options of a timeline given on the command line.
+ */
+typedef struct TimelineOptions {
+    const char *path;           // Path of the CSV file, NULL for no timeline
+    uint64_t interval_length;   // Number of accesses or instructions per interval
+    bool counts_instructions;   // Indicates if intervals are measured in instructions instead of accesses
+} TimelineOptions;
+
+/**
+ * @brief Statistics of a single interval of the timeline.
+ */
+typedef struct TimelineInterval {
+    uint64_t first_access;      // Index of the first measured access of the interval
+    uint64_t accesses;          // Number of accesses
+    uint64_t instructions;      // Number of instructions
+    uint64_t misses;            // Number of misses (extrapolated for sampled caches)
+    uint64_t dirty_write_backs; // Number of dirty write-backs (extrapolated for sampled caches)
+    uint64_t working_set_lines; // Estimated number of distinct lines accessed
+    uint64_t memory_writes;     // Writes to memory, write-backs included (extrapolated for sampled caches)
+    uint64_t memory_write_bytes; // Bytes written to memory (extrapolated for sampled caches)
+    uint64_t prefetch_wait_cycles; // Cycles waited for late prefetches (extrapolated for sampled caches)
+} TimelineInterval;
+
+/**
+ * @brief State of a timeline.
+ */
+typedef struct Timeline {
+    FILE *file;                 // CSV file written by the writer thread
+    TimelineOptions options;    // Interval length and unit
+    int miss_penalty;           // Penalty in cycles for a cache miss
+    int dirty_wb_penalty;       // Penalty in cycles for a dirty write-back
+    int line_size;              // Cache line size in bytes
+    int log_line_size;          // log2(line_size)
+    int sample_rate;            // Set sampling rate of the cache, the counts are multiplied by it
+    TimelineInterval current;   // Counts of the interval being recorded
+    CacheStats start_stats;     // Statistics of the cache at the start of the current interval
+    uint64_t start_memory_writes; // Writes to memory at the start of the current interval
+    uint64_t start_memory_write_bytes; // Bytes written to memory at the start of the current interval
+    uint64_t *bitmap;           // Working set bitmap of the current interval
+    int log_bitmap_bits;        // log2 of the number of bits of the bitmap
+    pthread_t writer;           // Thread writing completed intervals
+    pthread_mutex_t lock;       // Protects the queue
+    pthread_cond_t changed;     // Signaled when an interval is queued or written
+    TimelineInterval *queue;    // Ring of TIMELINE_QUEUE_SIZE completed intervals
+    uint64_t queued_count;      // Number of intervals queued so far
+    uint64_t written_count;     // Number of intervals written so far
+    bool is_closed;             // Set when no more intervals are queued
+} Timeline;
+
+/**
+ * @brief Opens a timeline and starts its writer thread.
+ * Terminates the program if the file can't be created.
+ *
+ * @param options Pointer to the TimelineOptions object with the path and the interval length.
+ * @param cache Pointer to the simulated Cache object.
+ * @return Pointer to the initialized Timeline object.
+ */
+Timeline* open_timeline(const TimelineOptions *options, const Cache *cache);
+
+/**
+ * @brief Adds a measured access to the current interval.
+ * Must be called after the access has been simulated, so its hit or miss is
+ * part of the statistics of the cache.
+ *
+ * @param timeline Pointer to the Timeline object.
+ * @param cache Pointer to the simulated Cache object.
+ * @param cache_op Pointer to the CacheOp object of the access.
+ */
+void record_timeline_access(Timeline *timeline, const Cache *cache, const CacheOp *cache_op);
+
+/**
+ * @brief Writes the last, partial interval, stops the writer thread and closes the file.
+ * Terminates the program if the file can't be written.
+ *
+ * @param timeline Pointer to the Timeline object.
+ * @param cache Pointer to the simulated Cache object.
+ */
+void close_timeline(Timeline *timeline, const Cache *cache);
+
+#endif // TIMELINE_H_INCLUDED
@@ -0,0 +1,207 @@
+/***************************************************************************/
+/**
+ * @file timing.c
+ * @brief Implementation of the memory-level-parallelism aware timing model of
+ * the cache simulator.
+ *
+ * This source file provides the implementation for the timing model defined in
+ * timing.h. The model keeps at most TIMING_MAX_ENTRIES MSHRs, so looking up a
+ * line in flight is a linear scan of a few cache lines.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include "timing.h"
+
+// --- Helper Functions ---
+
+/**
+ * @brief Lets the core wait until a cycle, if it lies in the future.
+ *
+ * @param timing Pointer to the TimingModel object.
+ * @param cycle The cycle to wait for.
+ * @param stall_cycles Pointer to the statistic counting the cycles waited.
+ */
+static void stall_until(TimingModel *timing, const uint64_t cycle, uint64_t *stall_cycles) {
+    if (cycle > timing->cycle) {
+        *stall_cycles += cycle - timing->cycle;
+        timing->cycle = cycle;
+    }
+}
+
+/**
+ * @brief Removes the oldest outstanding miss.
+ *
+ * @param timing Pointer to the TimingModel object.
+ */
+static void retire_oldest_miss(TimingModel *timing) {
+    timing->first_miss = (timing->first_miss + 1) % timing->num_mshrs;
+    timing->num_misses--;
+}
+
+/**
+ * @brief Removes the oldest queued write-back.
+ *
+ * @param timing Pointer to the TimingModel object.
+ */
+static void retire_oldest_write_back(TimingModel *timing) {
+    timing->first_write_back = (timing->first_write_back + 1) % timing->write_buffer_size;
+    timing->num_write_backs--;
+}
+
+/**
+ * @brief Frees the MSHRs and write buffer entries that completed by the current cycle.
+ *
+ * @param timing Pointer to the TimingModel object.
+ */
+static void retire_completed(TimingModel *timing) {
+    while (timing->num_misses > 0 && timing->misses[timing->first_miss].ready_cycle <= timing->cycle) {
+        retire_oldest_miss(timing);
+    }
+    while (timing->num_write_backs > 0 && timing->write_backs[timing->first_write_back] <= timing->cycle) {
+        retire_oldest_write_back(timing);
+    }
+}
+
+/**
+ * @brief Executes instructions at one per cycle.
+ * Whenever the core gets `window` instructions past the oldest outstanding
+ * miss, it waits for that fill before it continues.
+ *
+ * @param timing Pointer to the TimingModel object.
+ * @param count Number of instructions.
+ */
+static void execute_instructions(TimingModel *timing, const int count) {
+    const uint64_t end = timing->instructions + (uint64_t)count;
+    while (timing->num_misses > 0) {
+        const TimingMiss *oldest = &timing->misses[timing->first_miss];
+        const uint64_t limit = oldest->instruction + (uint64_t)timing->window;
+        if (limit > end) {
+            break;
+        }
+
+        // The core reaches the end of the window and waits there for the fill
+        const uint64_t limit_cycle = timing->cycle + (limit > timing->instructions ? limit - timing->instructions : 0);
+        if (oldest->ready_cycle > limit_cycle) {
+            timing->stats.window_stall_cycles += oldest->ready_cycle - limit_cycle;
+            timing->cycle += oldest->ready_cycle - limit_cycle;
+        }
+        retire_oldest_miss(timing);
+    }
+
+    timing->cycle += (uint64_t)count;
+    timing->instructions = end;
+}
+
+/**
+ * @brief Checks if the fill of a line is in flight.
+ *
+ * @param timing Pointer to the TimingModel object.
+ * @param line The line number, the sector number for sectored lines.
+ * @return `true` if an outstanding miss is fetching the line, `false` otherwise.
+ */
+static bool is_miss_outstanding(const TimingModel *timing, const uint64_t line) {
+    for (int i = 0; i < timing->num_misses; i++) {
+        if (timing->misses[(timing->first_miss + i) % timing->num_mshrs].line == line) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Allocates an MSHR for a miss, waiting for the oldest fill if all are busy.
+ *
+ * @param timing Pointer to the TimingModel object.
+ * @param line The line number of the miss, the sector number for sectored lines.
+ */
+static void issue_miss(TimingModel *timing, const uint64_t line) {
+    if (timing->num_misses == timing->num_mshrs) {
+        stall_until(timing, timing->misses[timing->first_miss].ready_cycle, &timing->stats.mshr_stall_cycles);
+        retire_oldest_miss(timing);
+    }
+
+    // Fills complete in issue order, so only the part after the previous fill adds busy cycles
+    const uint64_t ready_cycle = timing->cycle + (uint64_t)timing->miss_penalty;
+    const uint64_t busy_start = timing->last_ready_cycle > timing->cycle ? timing->last_ready_cycle : timing->cycle;
+    timing->stats.miss_cycles += ready_cycle - busy_start;
+    timing->stats.issued_misses++;
+    timing->last_ready_cycle = ready_cycle;
+
+    TimingMiss *miss = &timing->misses[(timing->first_miss + timing->num_misses) % timing->num_mshrs];
+    *miss = (TimingMiss){line, timing->instructions, ready_cycle};
+    timing->num_misses++;
+}
+
+/**
+ * @brief Queues a dirty write-back, waiting for the oldest one if the write buffer is full.
+ * The buffer writes one line per write-back penalty.
+ *
+ * @param timing Pointer to the TimingModel object.
+ */
+static void queue_write_back(TimingModel *timing) {
+    if (timing->num_write_backs == timing->write_buffer_size) {
+        stall_until(timing, timing->write_backs[timing->first_write_back],
+                    &timing->stats.write_buffer_stall_cycles);
+        retire_oldest_write_back(timing);
+    }
+
+    const uint64_t start = timing->last_drain_cycle > timing->cycle ? timing->last_drain_cycle : timing->cycle;
+    timing->last_drain_cycle = start + (uint64_t)timing->dirty_wb_penalty;
+    timing->write_backs[(timing->first_write_back + timing->num_write_backs) % timing->write_buffer_size]
+        = timing->last_drain_cycle;
+    timing->num_write_backs++;
+}
+
+// --- Timing Model Functions ---
+
+TimingModel* initialize_timing_model(const TimingOptions *options, const Cache *cache) {
+    TimingModel *timing = allocate_or_exit(1, sizeof(TimingModel), "the timing model");
+    timing->window = options->window;
+    timing->miss_penalty = cache->miss_penalty;
+    timing->dirty_wb_penalty = cache->dirty_wb_penalty;
+    timing->num_mshrs = options->num_mshrs;
+    timing->write_buffer_size = options->write_buffer_size;
+    timing->misses = allocate_or_exit((size_t)timing->num_mshrs, sizeof(TimingMiss), "the timing model");
+    timing->write_backs = allocate_or_exit((size_t)timing->write_buffer_size, sizeof(uint64_t), "the timing model");
+    return timing;
+}
+
+void free_timing_model(TimingModel *timing) {
+    free(timing->misses);
+    free(timing->write_backs);
+    free(timing);
+}
+
+bool access_cache_timed(TimingModel *timing, Cache *cache, const CacheOp *cache_op) {
+    execute_instructions(timing, cache_op->instructions);
+    retire_completed(timing);
+
+    const uint64_t write_backs = cache->stats.dirty_write_backs;
+    const bool is_hit = access_cache(cache, cache_op);
+
+    // The tags already hold a line whose fill is in flight, and a refetch of it would be merged as well. A sectored
+    // line is filled sector by sector, so a miss on another sector of it needs an MSHR of its own
+    const uint64_t block = cache_op->address >> cache->log_sector_size;
+    if (is_miss_outstanding(timing, block)) {
+        timing->stats.merged_accesses++;
+    } else if (!is_hit) {
+        issue_miss(timing, block);
+    }
+
+    for (uint64_t i = write_backs; i < cache->stats.dirty_write_backs; i++) {
+        queue_write_back(timing);
+    }
+    return is_hit;
+}
+
+uint64_t finish_timing_model(TimingModel *timing) {
+    if (timing->num_misses > 0 && timing->last_ready_cycle > timing->cycle) {
+        timing->cycle = timing->last_ready_cycle;
+    }
+    if (timing->num_write_backs > 0 && timing->last_drain_cycle > timing->cycle) {
+        timing->cycle = timing->last_drain_cycle;
+    }
+    timing->num_misses = 0;
+    timing->num_write_backs = 0;
+    return timing->cycle;
+}
@@ -0,0 +1,140 @@
+/***************************************************************************/
+/**
+ * @file timing.h
+ * @brief Header file for the memory-level-parallelism aware timing model of
+ * the cache simulator.
+ *
+ * Without a timing model, every miss stalls the core for the full miss
+ * penalty and every dirty write-back for the write-back penalty, one after
+ * another. Real cores keep executing behind a miss and overlap independent
+ * misses, so this overstates the cycles of miss-heavy traces.
+ *
+ * The timing model runs a simple clock next to the cache. Every instruction
+ * takes one cycle. A miss allocates one of a bounded number of miss status
+ * holding registers (MSHRs) for the miss penalty, and the core continues:
+ *
+ * - Accesses to a line whose fill is still in flight are merged into its
+ *   MSHR, whether the tags hit or not. Sectored lines are filled sector by
+ *   sector, so their MSHRs track sectors instead of lines.
+ * - If all MSHRs are busy, the core waits for the oldest fill.
+ * - The core runs at most `window` instructions past the oldest outstanding
+ *   miss, like a reorder buffer, and then waits for its fill.
+ * - Dirty write-backs go into a write buffer that drains one write-back per
+ *   write-back penalty. The core only waits if the buffer is full.
+ *
+ * All misses have the same latency, so fills complete in the order they were
+ * issued, and the MSHRs and the write buffer are rings in issue order. At the
+ * end of the trace, the outstanding fills and write-backs are drained.
+ *
+ * The cache itself is simulated exactly as without the model; only the cycles
+ * change. Set sampling and partitioned simulation would hide misses from the
+ * model, so they are not supported.
+ ******************************************************************************/
+
+#ifndef TIMING_H_INCLUDED
+#define TIMING_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * @brief Defaults and limits of the timing model.
+ */
+enum {
+    TIMING_DEFAULT_WINDOW = 128,        // Default number of instructions the core runs past an outstanding miss
+    TIMING_DEFAULT_WRITE_BUFFER = 8,    // Default number of write buffer entries
+    TIMING_MAX_ENTRIES = 1024,          // Maximum number of MSHRs and write buffer entries
+};
+
+/**
+ * @brief Options of the timing model given on the command line.
+ */
+typedef struct TimingOptions {
+    int num_mshrs;          // Number of MSHRs, 0 to disable the timing model
+    int window;             // Number of instructions the core runs past the oldest outstanding miss
+    int write_buffer_size;  // Number of write buffer entries
+} TimingOptions;
+
+/**
+ * @brief An outstanding miss.
+ */
+typedef struct TimingMiss {
+    uint64_t line;              // Line number of the miss, sector number for sectored lines
+    uint64_t instruction;       // Number of instructions executed when the miss was issued
+    uint64_t ready_cycle;       // Cycle at which the fill completes
+} TimingMiss;
+
+/**
+ * @brief Statistics of the timing model.
+ */
+typedef struct TimingStats {
+    uint64_t merged_accesses;           // Accesses merged into the MSHR of a fill in flight
+    uint64_t mshr_stall_cycles;         // Cycles waited for a free MSHR
+    uint64_t window_stall_cycles;       // Cycles waited because the window behind a miss was exhausted
+    uint64_t write_buffer_stall_cycles; // Cycles waited for a free write buffer entry
+    uint64_t miss_cycles;               // Cycles with at least one outstanding miss
+    uint64_t issued_misses;             // Misses that allocated an MSHR
+} TimingStats;
+
+/**
+ * @brief State of the timing model.
+ */
+typedef struct TimingModel {
+    int window;                 // Number of instructions the core runs past the oldest outstanding miss
+    int miss_penalty;           // Latency of a fill in cycles
+    int dirty_wb_penalty;       // Cycles the write buffer needs per write-back
+    uint64_t cycle;             // Current cycle of the core
+    uint64_t instructions;      // Number of instructions executed so far
+    TimingMiss *misses;         // Ring of outstanding misses in issue order
+    int num_mshrs;              // Capacity of the ring of outstanding misses
+    int first_miss;             // Index of the oldest outstanding miss
+    int num_misses;             // Number of outstanding misses
+    uint64_t *write_backs;      // Ring of the cycles at which the queued write-backs complete
+    int write_buffer_size;      // Capacity of the write buffer
+    int first_write_back;       // Index of the oldest queued write-back
+    int num_write_backs;        // Number of queued write-backs
+    uint64_t last_ready_cycle;  // Completion of the most recently issued fill
+    uint64_t last_drain_cycle;  // Completion of the most recently queued write-back
+    TimingStats stats;          // Statistics of the model
+} TimingModel;
+
+/**
+ * @brief Creates a timing model for a cache.
+ *
+ * @param options Pointer to the TimingOptions object, with a positive number of MSHRs.
+ * @param cache Pointer to the simulated Cache object providing the penalties.
+ * @return Pointer to the initialized TimingModel object.
+ */
+TimingModel* initialize_timing_model(const TimingOptions *options, const Cache *cache);
+
+/**
+ * @brief Frees the memory allocated for the timing model.
+ *
+ * @param timing Pointer to the TimingModel object.
+ */
+void free_timing_model(TimingModel *timing);
+
+/**
+ * @brief Executes the instructions of a cache operation, simulates its access and times it.
+ * The dirty write-backs of the access are queued in the write buffer. The
+ * cache must not have a prefetcher, whose fills would bypass the MSHRs.
+ *
+ * @param timing Pointer to the TimingModel object.
+ * @param cache Pointer to the simulated Cache object.
+ * @param cache_op Pointer to the CacheOp object representing the cache operation.
+ * @return `true` if the access is a hit, `false` if it's a miss.
+ */
+bool access_cache_timed(TimingModel *timing, Cache *cache, const CacheOp *cache_op);
+
+/**
+ * @brief Drains all outstanding fills and write-backs and returns the total number of cycles.
+ *
+ * @param timing Pointer to the TimingModel object.
+ * @return The cycle at which the last instruction, fill and write-back completed.
+ */
+uint64_t finish_timing_model(TimingModel *timing);
+
+#endif // TIMING_H_INCLUDED
@@ -0,0 +1,742 @@
+/***************************************************************************/
+/**
+ * @file trace.c
+ * @brief Implementation of the trace reader of the cache simulator.
+ *
+ * This source file provides the implementation for the trace reader defined
+ * in trace.h. Records have the form `<type> 0x<address> <instructions>` and
+ * are parsed character by character directly from the mapped file or the
+ * streaming buffer, which avoids the format string interpretation of
+ * `fscanf` on every line. Binary traces are decoded by copying the fixed-width
+ * records and accumulating their address deltas.
+ *
+ * Streamed inputs are read by a decode thread into two blocks. The thread
+ * fills one block while the parser decodes the other one; both sides only
+ * synchronize once per block. Compressed traces are recognized by their magic
+ * bytes and piped through the matching decompressor in a child process, so the
+ * decompression runs in parallel to the simulation as well.
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "trace.h"
+
+extern char **environ;
+
+/**
+ * @brief Layout of the block queue of streamed inputs.
+ */
+enum {
+    TRACE_QUEUE_SIZE = 2,       // Number of blocks, one being parsed while the other one is filled
+    TRACE_BLOCK_CARRY = 64,     // Bytes in front of every block for the unread end of the previous one
+};
+
+_Static_assert(TRACE_BLOCK_CARRY >= sizeof(TraceFileHeader) && TRACE_BLOCK_CARRY >= sizeof(TraceRecord),
+               "The carry area must hold a partial header or record");
+
+/**
+ * @brief Decompressor of a compressed trace format.
+ */
+typedef struct TraceDecompressor {
+    const char *magic;      // Magic bytes at the start of a compressed file
+    size_t magic_size;      // Number of magic bytes
+    char *command[3];       // Command line decompressing stdin to stdout
+} TraceDecompressor;
+
+static const TraceDecompressor trace_decompressors[] = {
+    {"\x1f\x8b", 2, {"gzip", "-dc", NULL}},
+    {"\x28\xb5\x2f\xfd", 4, {"zstd", "-dcq", NULL}},
+    {"\xfd" "7zXZ\0", 6, {"xz", "-dc", NULL}},
+};
+
+/**
+ * @brief State of the decode thread of a streamed trace.
+ *
+ * Blocks are numbered in the order they are read; block `n` is stored in
+ * buffer `n % TRACE_QUEUE_SIZE`. The decode thread may fill a block as soon as
+ * the parser has released the previous contents of its buffer.
+ */
+typedef struct TraceStream {
+    int fd;                     // Input read by the decode thread (the trace or the decompressor output)
+    pid_t decompressor;         // Child process decompressing the trace, 0 if it is not compressed
+    const char *decompressor_name;  // Command name of the decompressor
+    pthread_t decode_thread;    // Thread filling the blocks
+    pthread_mutex_t lock;       // Protects the counters and flags below
+    pthread_cond_t changed;     // Signaled whenever a block is filled or released
+    char *blocks[TRACE_QUEUE_SIZE];         // Buffers of TRACE_BLOCK_CARRY + TRACE_BUFFER_SIZE bytes
+    size_t block_sizes[TRACE_QUEUE_SIZE];   // Number of bytes read into each buffer after the carry area
+    long filled_count;          // Number of blocks filled by the decode thread
+    long released_count;        // Number of blocks the parser is done with
+    long current_block;         // Number of the block being parsed, -1 before the first one
+    bool is_finished;           // The decode thread has filled the last block of the input
+    bool is_stopped;            // The trace was closed, the decode thread must stop
+    int read_error;             // errno of a failed read, 0 if none
+} TraceStream;
+
+// --- Trace Streams ---
+
+/**
+ * @brief Reads the next block of the input.
+ * Reading stops when the block is full, or as soon as no more data is ready,
+ * so a slow producer such as a live tracer is not delayed by a whole block.
+ * The decode thread can only be canceled while it is blocked in `read`.
+ *
+ * @param fd File descriptor of the input.
+ * @param block Buffer receiving up to TRACE_BUFFER_SIZE bytes.
+ * @param error Pointer receiving the errno of a failed read.
+ * @param is_end Pointer receiving whether the end of the input was reached.
+ * @return The number of bytes read.
+ */
+static size_t read_trace_block(const int fd, char *block, int *error, bool *is_end) {
+    size_t size = 0;
+    while (size < TRACE_BUFFER_SIZE) {
+        struct pollfd poll_fd = {fd, POLLIN, 0};
+        if (size > 0 && poll(&poll_fd, 1, 0) <= 0) {
+            break; // Hand over what has arrived instead of waiting for more
+        }
+
+        int cancel_state;
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &cancel_state);
+        const ssize_t bytes_read = read(fd, block + size, TRACE_BUFFER_SIZE - size);
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read <= 0) {
+            *error = bytes_read < 0 ? errno : 0;
+            *is_end = true;
+            break;
+        }
+        size += (size_t)bytes_read;
+    }
+    return size;
+}
+
+/**
+ * @brief Main function of the decode thread, fills the blocks of a stream in order.
+ *
+ * @param arg Pointer to the TraceStream object.
+ * @return Always NULL.
+ */
+static void* decode_trace_stream(void *arg) {
+    TraceStream *stream = (TraceStream *)arg;
+    int cancel_state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+
+    for (long block_number = 0;; block_number++) {
+        // Wait until the parser has released the previous contents of the buffer
+        pthread_mutex_lock(&stream->lock);
+        while (block_number - stream->released_count >= TRACE_QUEUE_SIZE && !stream->is_stopped) {
+            pthread_cond_wait(&stream->changed, &stream->lock);
+        }
+        const bool is_stopped = stream->is_stopped;
+        pthread_mutex_unlock(&stream->lock);
+        if (is_stopped) {
+            return NULL;
+        }
+
+        const int index = (int)(block_number % TRACE_QUEUE_SIZE);
+        int error = 0;
+        bool is_end = false;
+        const size_t size = read_trace_block(stream->fd, stream->blocks[index] + TRACE_BLOCK_CARRY, &error, &is_end);
+
+        pthread_mutex_lock(&stream->lock);
+        stream->block_sizes[index] = size;
+        stream->filled_count = block_number + 1;
+        stream->is_finished = is_end;
+        stream->read_error = error;
+        pthread_cond_signal(&stream->changed);
+        pthread_mutex_unlock(&stream->lock);
+
+        if (is_end) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * @brief Finds the decompressor of a compressed regular file.
+ *
+ * @param fd File descriptor of the file, positioned at its start.
+ * @return Pointer to the matching TraceDecompressor, or NULL if the file is not compressed.
+ */
+static const TraceDecompressor* find_trace_decompressor(const int fd) {
+    char magic[8];
+    const ssize_t magic_size = pread(fd, magic, sizeof(magic), 0);
+
+    for (size_t i = 0; i < sizeof(trace_decompressors) / sizeof(trace_decompressors[0]); i++) {
+        const TraceDecompressor *decompressor = &trace_decompressors[i];
+        if (magic_size >= (ssize_t)decompressor->magic_size &&
+            memcmp(magic, decompressor->magic, decompressor->magic_size) == 0) {
+            return decompressor;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts a decompressor reading the trace on its stdin.
+ *
+ * @param reader Pointer to the TraceReader object of the compressed trace.
+ * @param decompressor Pointer to the TraceDecompressor of the trace format.
+ * @param pid Pointer receiving the process ID of the decompressor.
+ * @return File descriptor of the pipe carrying the decompressed trace.
+ */
+static int start_trace_decompressor(const TraceReader *reader, const TraceDecompressor *decompressor, pid_t *pid) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        perror("Failed to create decompression pipe");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, reader->fd, STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    const int error = posix_spawnp(pid, decompressor->command[0], &actions, NULL, decompressor->command, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipe_fds[1]);
+
+    if (error != 0) {
+        fprintf(stderr, "Failed to start %s to decompress the trace: %s\n", decompressor->command[0],
+                strerror(error));
+        exit(EXIT_FAILURE);
+    }
+    return pipe_fds[0];
+}
+
+/**
+ * @brief Starts the decode thread of a streamed trace.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param fd File descriptor of the input read by the decode thread.
+ * @param decompressor Pointer to the TraceDecompressor producing the input, NULL if there is none.
+ * @param pid Process ID of the decompressor.
+ */
+static void open_trace_stream(TraceReader *reader, const int fd, const TraceDecompressor *decompressor,
+                              const pid_t pid) {
+    TraceStream *stream = allocate_or_exit(1, sizeof(TraceStream), "trace stream");
+
+    for (int i = 0; i < TRACE_QUEUE_SIZE; i++) {
+        stream->blocks[i] = allocate_or_exit(1, TRACE_BLOCK_CARRY + TRACE_BUFFER_SIZE, "trace buffer");
+    }
+    stream->fd = fd;
+    stream->decompressor = decompressor ? pid : 0;
+    stream->decompressor_name = decompressor ? decompressor->command[0] : NULL;
+    stream->current_block = -1;
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->changed, NULL);
+
+    if (pthread_create(&stream->decode_thread, NULL, decode_trace_stream, stream) != 0) {
+        fprintf(stderr, "Failed to create trace decode thread.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    reader->stream = stream;
+    reader->data = NULL;
+    reader->data_size = 0;
+    reader->cursor = stream->blocks[0] + TRACE_BLOCK_CARRY;
+    reader->end = reader->cursor;
+}
+
+/**
+ * @brief Stops the decode thread of a streamed trace and frees the stream.
+ * A decompressor that is still running because the trace was not read to its
+ * end is terminated.
+ *
+ * @param stream Pointer to the TraceStream object.
+ */
+static void close_trace_stream(TraceStream *stream) {
+    pthread_mutex_lock(&stream->lock);
+    const bool is_finished = stream->is_finished;
+    stream->is_stopped = true;
+    pthread_cond_signal(&stream->changed);
+    pthread_mutex_unlock(&stream->lock);
+
+    if (stream->decompressor > 0 && !is_finished) {
+        kill(stream->decompressor, SIGTERM);
+    }
+    pthread_cancel(stream->decode_thread);
+    pthread_join(stream->decode_thread, NULL);
+
+    if (stream->decompressor > 0) {
+        close(stream->fd);
+        int status;
+        while (waitpid(stream->decompressor, &status, 0) < 0 && errno == EINTR) {
+        }
+        if (is_finished && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            fprintf(stderr, "Failed to decompress trace file with %s.\n", stream->decompressor_name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_mutex_destroy(&stream->lock);
+    pthread_cond_destroy(&stream->changed);
+    for (int i = 0; i < TRACE_QUEUE_SIZE; i++) {
+        free(stream->blocks[i]);
+    }
+    free(stream);
+}
+
+// --- Helper Functions ---
+
+/**
+ * @brief Switches a streamed trace to the next block filled by the decode thread.
+ * Unread bytes are copied into the carry area in front of the new block, so a
+ * binary record that crosses a block boundary stays contiguous.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @return `true` if new data is available, `false` at the end of the input.
+ */
+static bool refill_trace_buffer(TraceReader *reader) {
+    TraceStream *stream = reader->stream;
+    if (!stream) {
+        return false; // The whole file is already visible
+    }
+
+    const long next_block = stream->current_block + 1;
+    pthread_mutex_lock(&stream->lock);
+    while (stream->filled_count <= next_block && !stream->is_finished) {
+        pthread_cond_wait(&stream->changed, &stream->lock);
+    }
+    const bool has_block = stream->filled_count > next_block;
+    pthread_mutex_unlock(&stream->lock);
+
+    if (!has_block) {
+        if (stream->read_error != 0) {
+            errno = stream->read_error;
+            perror("Failed to read trace file");
+            exit(EXIT_FAILURE);
+        }
+        return false;
+    }
+
+    const int index = (int)(next_block % TRACE_QUEUE_SIZE);
+    const size_t remaining = (size_t)(reader->end - reader->cursor);
+    char *start = stream->blocks[index] + TRACE_BLOCK_CARRY - remaining;
+    memmove(start, reader->cursor, remaining);
+
+    // The buffer of the previous block can be refilled now
+    pthread_mutex_lock(&stream->lock);
+    stream->released_count = next_block;
+    pthread_cond_signal(&stream->changed);
+    pthread_mutex_unlock(&stream->lock);
+
+    stream->current_block = next_block;
+    reader->cursor = start;
+    reader->end = start + remaining + stream->block_sizes[index];
+    return stream->block_sizes[index] > 0;
+}
+
+/**
+ * @brief Makes sure that at least `count` unread bytes are buffered.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param count Number of bytes required.
+ * @return `true` if enough bytes are available, `false` at the end of the input.
+ */
+static bool ensure_available(TraceReader *reader, const size_t count) {
+    while ((size_t)(reader->end - reader->cursor) < count) {
+        if (!refill_trace_buffer(reader)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Detects a binary trace header at the start of the input and consumes it.
+ *
+ * @param reader Pointer to the TraceReader object.
+ */
+static void detect_trace_format(TraceReader *reader) {
+    reader->is_binary = false;
+    reader->record_limit = 0;
+    reader->previous_address = 0;
+
+    if (!ensure_available(reader, sizeof(TraceFileHeader))) {
+        return; // Too short for a binary header, must be text
+    }
+
+    TraceFileHeader header;
+    memcpy(&header, reader->cursor, sizeof(header));
+    if (memcmp(header.magic, TRACE_BINARY_MAGIC, sizeof(header.magic)) != 0) {
+        return;
+    }
+
+    if (header.version != TRACE_BINARY_VERSION || header.record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "Unsupported binary trace version %u (record size %u).\n", header.version,
+                header.record_size);
+        exit(EXIT_FAILURE);
+    }
+
+    reader->is_binary = true;
+    reader->record_limit = header.record_count;
+    reader->cursor += sizeof(header);
+}
+
+/**
+ * @brief Returns the next unread character without consuming it.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @return The next character, or `EOF` at the end of the input.
+ */
+static inline int peek_char(TraceReader *reader) {
+    if (reader->cursor == reader->end && !refill_trace_buffer(reader)) {
+        return EOF;
+    }
+    return (unsigned char)*reader->cursor;
+}
+
+/**
+ * @brief Checks if a character is whitespace in the "C" locale.
+ *
+ * @param c The character to be checked.
+ * @return `true` if `c` is whitespace, `false` otherwise.
+ */
+static inline bool is_space(const int c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief Consumes all whitespace up to the next non-whitespace character.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @return The next non-whitespace character, or `EOF`.
+ */
+static inline int skip_whitespace(TraceReader *reader) {
+    int c;
+    while ((c = peek_char(reader)) != EOF && is_space(c)) {
+        reader->cursor++;
+    }
+    return c;
+}
+
+/**
+ * @brief Consumes spaces and tabs between the fields of a record.
+ *
+ * @param reader Pointer to the TraceReader object.
+ */
+static inline void skip_blanks(TraceReader *reader) {
+    int c;
+    while ((c = peek_char(reader)) == ' ' || c == '\t') {
+        reader->cursor++;
+    }
+}
+
+/**
+ * @brief Consumes the remainder of the current line including the newline.
+ *
+ * @param reader Pointer to the TraceReader object.
+ */
+static void skip_line(TraceReader *reader) {
+    int c;
+    while ((c = peek_char(reader)) != EOF) {
+        reader->cursor++;
+        if (c == '\n') {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Converts a hexadecimal digit to its value.
+ *
+ * @param c The character to be converted.
+ * @return The value of the digit, or `-1` if `c` is not a hexadecimal digit.
+ */
+static inline int hex_digit_value(const int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parses a hexadecimal number with an optional `0x` prefix.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param value Pointer receiving the parsed value.
+ * @return `true` if at least one digit was parsed, `false` otherwise.
+ */
+static bool parse_hex(TraceReader *reader, uint64_t *value) {
+    bool has_digits = false;
+    uint64_t result = 0;
+
+    if (peek_char(reader) == '0') {
+        reader->cursor++;
+        has_digits = true; // A lone '0' is a valid number as well
+        const int c = peek_char(reader);
+        if (c == 'x' || c == 'X') {
+            reader->cursor++;
+            has_digits = false;
+        }
+    }
+
+    int digit;
+    while ((digit = hex_digit_value(peek_char(reader))) >= 0) {
+        result = (result << 4) | (uint64_t)digit;
+        reader->cursor++;
+        has_digits = true;
+    }
+
+    *value = result;
+    return has_digits;
+}
+
+/**
+ * @brief Parses a decimal number with an optional sign.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param value Pointer receiving the parsed value.
+ * @return `true` if at least one digit was parsed, `false` otherwise.
+ */
+static bool parse_decimal(TraceReader *reader, int *value) {
+    bool is_negative = false;
+    bool has_digits = false;
+    int result = 0;
+
+    int c = peek_char(reader);
+    if (c == '-' || c == '+') {
+        is_negative = (c == '-');
+        reader->cursor++;
+    }
+
+    while ((c = peek_char(reader)) >= '0' && c <= '9') {
+        result = result * 10 + (c - '0');
+        reader->cursor++;
+        has_digits = true;
+    }
+
+    *value = is_negative ? -result : result;
+    return has_digits;
+}
+
+// --- Trace Open and Close ---
+
+TraceReader* open_trace(const char *trace_file) {
+    TraceReader *reader = allocate_or_exit(1, sizeof(TraceReader), "trace reader");
+
+    reader->fd = strcmp(trace_file, "-") == 0 ? STDIN_FILENO : open(trace_file, O_RDONLY);
+    if (reader->fd < 0) {
+        perror("Failed to open trace file");
+        exit(EXIT_FAILURE);
+    }
+    reader->record_count = 0;
+
+    // Map uncompressed regular files directly, everything else is streamed
+    struct stat file_stat;
+    if (fstat(reader->fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+        const TraceDecompressor *decompressor = find_trace_decompressor(reader->fd);
+        if (decompressor) {
+            pid_t pid;
+            const int fd = start_trace_decompressor(reader, decompressor, &pid);
+            open_trace_stream(reader, fd, decompressor, pid);
+            detect_trace_format(reader);
+            return reader;
+        }
+
+        void *mapping = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (mapping != MAP_FAILED) {
+            posix_madvise(mapping, (size_t)file_stat.st_size, POSIX_MADV_SEQUENTIAL);
+            reader->stream = NULL;
+            reader->data = (char *)mapping;
+            reader->data_size = (size_t)file_stat.st_size;
+            reader->cursor = reader->data;
+            reader->end = reader->data + reader->data_size;
+            detect_trace_format(reader);
+            return reader;
+        }
+    }
+
+    open_trace_stream(reader, reader->fd, NULL, 0);
+    detect_trace_format(reader);
+    return reader;
+}
+
+void close_trace(TraceReader *reader) {
+    if (reader->stream) {
+        close_trace_stream(reader->stream);
+    } else {
+        munmap(reader->data, reader->data_size);
+    }
+    if (reader->fd != STDIN_FILENO) {
+        close(reader->fd);
+    }
+    free(reader);
+}
+
+// --- Trace Decoding ---
+
+/**
+ * @brief Decodes the next record of a binary trace.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param cache_op Pointer to the CacheOp object receiving the record.
+ * @return `true` if a record was decoded, `false` at the end of the trace.
+ */
+static bool read_binary_operation(TraceReader *reader, CacheOp *cache_op) {
+    if (reader->record_limit != 0 && (uint64_t)reader->record_count >= reader->record_limit) {
+        return false;
+    }
+    if (!ensure_available(reader, sizeof(TraceRecord))) {
+        if (reader->cursor != reader->end) {
+            fprintf(stderr, "Truncated binary trace record %ld. Ignoring it.\n", reader->record_count + 1);
+        }
+        return false;
+    }
+
+    TraceRecord record;
+    memcpy(&record, reader->cursor, sizeof(record));
+    reader->cursor += sizeof(record);
+    reader->record_count++;
+
+    reader->previous_address += (uint64_t)record.address_delta;
+    *cache_op = initialize_cache_operation(record.access_type, reader->previous_address, record.instructions);
+    return true;
+}
+
+bool read_trace_operation(TraceReader *reader, CacheOp *cache_op) {
+    if (reader->is_binary) {
+        return read_binary_operation(reader, cache_op);
+    }
+
+    for (;;) {
+        const int access_type = skip_whitespace(reader);
+        if (access_type == EOF) {
+            return false;
+        }
+        reader->cursor++;
+        reader->record_count++;
+
+        uint64_t address;
+        int instructions;
+        skip_blanks(reader);
+        const bool has_address = parse_hex(reader, &address);
+        skip_blanks(reader);
+        const bool has_instructions = parse_decimal(reader, &instructions);
+        skip_line(reader);
+
+        if (has_address && has_instructions) {
+            *cache_op = initialize_cache_operation((char)access_type, address, instructions);
+            return true;
+        }
+
+        fprintf(stderr, "Malformed trace record %ld. Skipping line.\n", reader->record_count);
+    }
+}
+
+size_t read_trace_batch(TraceReader *reader, CacheOp *cache_ops, const size_t max_ops) {
+    size_t count = 0;
+    while (count < max_ops && read_trace_operation(reader, &cache_ops[count])) {
+        count++;
+    }
+    return count;
+}
+
+// --- Trace Statistics ---
+
+void update_trace_stats(TraceStats *trace_stats, const CacheOp *cache_op) {
+    if (cache_op->access_type == 'l') {
+        trace_stats->load_count++;
+    } else if (cache_op->access_type == 's') {
+        trace_stats->store_count++;
+    } else if (cache_op->access_type == 'i') {
+        trace_stats->fetch_count++;
+    } else {
+        fprintf(stderr, "Unrecognized trace operation: '%c'. Skipping line.\n", cache_op->access_type);
+    }
+
+    trace_stats->instruction_count += cache_op->instructions;
+    trace_stats->memory_access_count++;
+}
+
+// --- Trace Sampling ---
+
+long get_sampling_phase(const TraceSampling *sampling, const long record, bool *is_measured) {
+    if (record < sampling->warmup_records) {
+        *is_measured = false;
+        return sampling->warmup_records - record;
+    }
+    if (sampling->detail_records <= 0) {
+        *is_measured = true;
+        return LONG_MAX; // Everything after the warmup is measured
+    }
+
+    // Every interval fast-forwards first and measures afterwards
+    const long interval = sampling->fast_forward_records + sampling->detail_records;
+    const long offset = (record - sampling->warmup_records) % interval;
+    *is_measured = offset >= sampling->fast_forward_records;
+    return *is_measured ? interval - offset : sampling->fast_forward_records - offset;
+}
+
+// --- Trace Conversion ---
+
+long convert_trace(const char *trace_file, const char *binary_file) {
+    TraceReader *reader = open_trace(trace_file);
+
+    FILE *output = fopen(binary_file, "wb");
+    if (output == NULL) {
+        perror("Failed to open binary trace file");
+        exit(EXIT_FAILURE);
+    }
+
+    // The record count is patched in once the whole trace has been converted
+    TraceFileHeader header = {TRACE_BINARY_MAGIC, TRACE_BINARY_VERSION, sizeof(TraceRecord), 0};
+    if (fwrite(&header, sizeof(header), 1, output) != 1) {
+        perror("Failed to write binary trace file");
+        exit(EXIT_FAILURE);
+    }
+
+    CacheOp cache_op;
+    uint64_t previous_address = 0;
+    long record_count = 0;
+
+    while (read_trace_operation(reader, &cache_op)) {
+        TraceRecord record = {(int64_t)(cache_op.address - previous_address), cache_op.instructions,
+                              cache_op.access_type, {0, 0, 0}};
+        if (fwrite(&record, sizeof(record), 1, output) != 1) {
+            perror("Failed to write binary trace file");
+            exit(EXIT_FAILURE);
+        }
+        previous_address = cache_op.address;
+        record_count++;
+    }
+
+    // Non-seekable outputs keep a record count of 0, which means "read until the end"
+    header.record_count = (uint64_t)record_count;
+    if (fseek(output, 0, SEEK_SET) == 0) {
+        fwrite(&header, sizeof(header), 1, output);
+    }
+
+    if (fclose(output) != 0) {
+        perror("Failed to write binary trace file");
+        exit(EXIT_FAILURE);
+    }
+    close_trace(reader);
+
+    return record_count;
+}
@@ -0,0 +1,188 @@
+/***************************************************************************/
+/**
+ * @file trace.h
+ * @brief Header file for the trace reader of the cache simulator.
+ *
+ * This file defines the structure and functions used to decode memory access
+ * traces. Regular files are memory-mapped and parsed in place. Pipes, stdin
+ * (`-`) and other non-seekable inputs are read by a separate decode thread
+ * into a double-buffered queue of large blocks, so reading the next block
+ * overlaps with parsing the current one. Traces compressed with gzip, zstd or
+ * xz are recognized by their magic bytes and streamed the same way from the
+ * output of the matching decompressor. In all cases the records are decoded
+ * by hand in a single pass, without per-line allocations or locale-dependent
+ * libc parsing.
+ *
+ * Besides the text format, a packed binary format is supported. It consists of
+ * a TraceFileHeader followed by fixed-width TraceRecord entries with
+ * delta-encoded addresses. The format is detected automatically when a trace
+ * is opened, so both formats can be passed to the simulator interchangeably.
+ *
+ * TraceSampling selects the records that are measured in detail. All other
+ * records only warm the simulated caches, which removes the cold-start bias
+ * of short traces and shortens the simulation of long ones.
+ ******************************************************************************/
+
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * @brief Size of a block of a non-mapped input in bytes.
+ */
+enum {
+    TRACE_BUFFER_SIZE = 1 << 20,
+};
+
+/**
+ * @brief Identification of the binary trace format.
+ */
+#define TRACE_BINARY_MAGIC "CSIMTRC"  // Magic string including the terminating NUL (8 bytes)
+enum {
+    TRACE_BINARY_VERSION = 1,         // Version of the binary record layout
+};
+
+/**
+ * @brief Header at the start of a binary trace file.
+ *
+ * All fields are stored in the byte order of the host that wrote the file. A
+ * file with a foreign byte order is rejected because its version and record
+ * size do not match.
+ */
+typedef struct TraceFileHeader {
+    char magic[8];          // TRACE_BINARY_MAGIC
+    uint32_t version;       // TRACE_BINARY_VERSION
+    uint32_t record_size;   // sizeof(TraceRecord)
+    uint64_t record_count;  // Number of records, 0 if unknown
+} TraceFileHeader;
+
+/**
+ * @brief Fixed-width record of a binary trace file.
+ */
+typedef struct TraceRecord {
+    int64_t address_delta;  // Difference to the address of the previous record
+    int32_t instructions;   // Number of instructions in the operation
+    char access_type;       // 'l' for LOAD, 's' for STORE, 'i' for an instruction fetch
+    uint8_t reserved[3];    // Padding, always zero
+} TraceRecord;
+
+/**
+ * @brief Trace file statistics, independent of the simulated cache.
+ */
+typedef struct TraceStats {
+    uint64_t memory_access_count;   // Number of memory accesses
+    uint64_t load_count;            // Number of load operations
+    uint64_t store_count;           // Number of store operations
+    uint64_t instruction_count;     // Number of instructions
+    uint64_t cycle_count;           // Number of cycles
+    uint64_t fetch_count;           // Number of instruction fetches
+} TraceStats;
+
+/**
+ * @brief Selection of the records of a trace that are measured in detail.
+ *
+ * The first `warmup_records` records only warm the caches. Afterwards, if
+ * `detail_records` is positive, SMARTS-style intervals of
+ * `fast_forward_records` warming records and `detail_records` measured records
+ * alternate until the end of the trace. Otherwise, all remaining records are
+ * measured.
+ */
+typedef struct TraceSampling {
+    long warmup_records;        // Number of records warming the caches before the first measurement
+    long fast_forward_records;  // Number of warming records at the start of every interval
+    long detail_records;        // Number of measured records at the end of every interval, 0 for no intervals
+} TraceSampling;
+
+/**
+ * @brief State of an open trace file.
+ */
+typedef struct TraceReader {
+    int fd;                 // File descriptor of the trace
+    bool is_binary;         // Indicates if the trace uses the binary format
+    char *data;             // Mapped file contents, NULL if the trace is streamed
+    size_t data_size;       // Size of the mapping
+    struct TraceStream *stream; // Decode thread and block queue of a streamed trace, NULL if mapped
+    const char *cursor;     // Next unread byte
+    const char *end;        // One past the last valid byte
+    long record_count;      // Number of records decoded so far
+    uint64_t record_limit;  // Number of records announced by a binary header, 0 if unknown
+    uint64_t previous_address;  // Last decoded address of a binary trace
+} TraceReader;
+
+/**
+ * @brief Opens a trace file for reading.
+ *
+ * Regular files are memory-mapped; every other kind of input is streamed by a
+ * decode thread. Compressed files are decompressed by a `gzip`, `zstd` or `xz`
+ * child process found in `PATH`. Text and binary traces are told apart by the
+ * magic string of the binary header.
+ *
+ * @param trace_file Path to the trace file, `-` for stdin.
+ * @return Pointer to the initialized TraceReader object.
+ */
+TraceReader* open_trace(const char *trace_file);
+
+/**
+ * @brief Decodes the next record of the trace.
+ *
+ * Malformed text records are reported on stderr and skipped.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param cache_op Pointer to the CacheOp object receiving the record.
+ * @return `true` if a record was decoded, `false` at the end of the trace.
+ */
+bool read_trace_operation(TraceReader *reader, CacheOp *cache_op);
+
+/**
+ * @brief Decodes up to `max_ops` consecutive records of the trace.
+ *
+ * @param reader Pointer to the TraceReader object.
+ * @param cache_ops Array receiving the decoded records.
+ * @param max_ops Capacity of `cache_ops`.
+ * @return The number of decoded records, `0` at the end of the trace.
+ */
+size_t read_trace_batch(TraceReader *reader, CacheOp *cache_ops, size_t max_ops);
+
+/**
+ * @brief Closes the trace and frees the memory allocated for the reader.
+ * Terminates the program if the decompressor of a fully read trace failed.
+ *
+ * @param reader Pointer to the TraceReader object.
+ */
+void close_trace(TraceReader *reader);
+
+/**
+ * @brief Adds a decoded record to the trace statistics.
+ * Updates the access, load, store, fetch and instruction counts, but not the
+ * cycle count, which depends on the simulated cache.
+ *
+ * @param trace_stats Pointer to the TraceStats object.
+ * @param cache_op Pointer to the decoded CacheOp.
+ */
+void update_trace_stats(TraceStats *trace_stats, const CacheOp *cache_op);
+
+/**
+ * @brief Finds the phase of the trace sampling a record belongs to.
+ *
+ * @param sampling Pointer to the TraceSampling object.
+ * @param record Index of the record in the trace (0-based).
+ * @param is_measured Pointer receiving whether the record is measured in detail (or only warms the caches).
+ * @return The number of consecutive records, starting with `record`, in the same phase.
+ */
+long get_sampling_phase(const TraceSampling *sampling, long record, bool *is_measured);
+
+/**
+ * @brief Converts a trace into the binary trace format.
+ *
+ * @param trace_file Path to the input trace (text or binary).
+ * @param binary_file Path to the binary trace to be written.
+ * @return The number of converted records.
+ */
+long convert_trace(const char *trace_file, const char *binary_file);
+
+#endif // TRACE_H_INCLUDED